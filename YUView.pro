@@ -7,7 +7,10 @@ CONFIG += c++11
 # Please keep the project file lists sorted by name.
 
 SOURCES += \
+    source/bitratePlotWidget.cpp \
+    source/decodedFrameRing.cpp \
     source/decoderBase.cpp \
+    source/diskFrameCache.cpp \
     source/FFmpegDecoder.cpp \
     source/FFMpegDecoderLibHandling.cpp \
     source/fileInfoWidget.cpp \
@@ -41,25 +44,33 @@ SOURCES += \
     source/propertiesWidget.cpp \
     source/separateWindow.cpp \
     source/settingsDialog.cpp \
+    source/sharedFrameStore.cpp \
     source/showColorFrame.cpp \
     source/singleInstanceHandler.cpp \
     source/splitViewWidget.cpp \
+    source/startupTrace.cpp \
     source/statisticHandler.cpp \
     source/statisticsExtensions.cpp \
     source/statisticsstylecontrol.cpp \
     source/statisticsStyleControl_ColorMapEditor.cpp \
     source/typedef.cpp \
     source/updateHandler.cpp \
+    source/valueLabelRenderer.cpp \
     source/videoCache.cpp \
     source/videoHandler.cpp \
     source/videoHandlerDifference.cpp \
     source/videoHandlerRGB.cpp \
     source/videoHandlerYUV.cpp \
+    source/videoScopes.cpp \
+    source/videoScopesWidget.cpp \
     source/viewStateHandler.cpp \
     source/yuviewapp.cpp
 
 HEADERS += \
+    source/bitratePlotWidget.h \
+    source/decodedFrameRing.h \
     source/decoderBase.h \
+    source/diskFrameCache.h \
     source/FFmpegDecoder.h \
     source/FFMpegDecoderLibHandling.h \
     source/FFMpegDecoderCommonDefs.h \
@@ -96,20 +107,25 @@ HEADERS += \
     source/propertiesWidget.h \
     source/separateWindow.h \
     source/settingsDialog.h \
+    source/sharedFrameStore.h \
     source/showColorFrame.h \
     source/splitViewWidget.h \
     source/singleInstanceHandler.h \
+    source/startupTrace.h \
     source/statisticHandler.h \
     source/statisticsExtensions.h \
     source/statisticsstylecontrol.h \
     source/statisticsStyleControl_ColorMapEditor.h \
     source/typedef.h \
     source/updateHandler.h \
+    source/valueLabelRenderer.h \
     source/videoCache.h \
     source/videoHandler.h \
     source/videoHandlerDifference.h \
     source/videoHandlerRGB.h \
     source/videoHandlerYUV.h \
+    source/videoScopes.h \
+    source/videoScopesWidget.h \
     source/viewStateHandler.h \
     source/yuviewapp.h
 
@@ -57,7 +57,6 @@ namespace FFmpeg
   struct AVBufferRef;
   struct AVPacketSideData;
   struct AVIOContext;
-  struct AVIndexEntry;
   struct AVStreamInternal;
   struct AVFrameSideData;
   struct AVMotionVector;
@@ -119,6 +118,18 @@ namespace FFmpeg
     int64_t val, num, den;
   } AVFrac;
 
+  // One entry of the index that the demuxer builds for a stream (e.g. from the sample table of an MP4 file)
+  #define AVINDEX_KEYFRAME 0x0001
+  #define AVINDEX_DISCARD_FRAME 0x0002
+  typedef struct AVIndexEntry
+  {
+    int64_t pos;
+    int64_t timestamp;  ///< Timestamp in AVStream.time_base units
+    int flags:2;
+    int size:30;
+    int min_distance;
+  } AVIndexEntry;
+
   enum AVPictureType {
     AV_PICTURE_TYPE_NONE = 0, ///< Undefined
     AV_PICTURE_TYPE_I,     ///< Intra
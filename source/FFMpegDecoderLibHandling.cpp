@@ -1287,6 +1287,8 @@ void AVStreamWrapper::update()
     avg_frame_rate = src->avg_frame_rate;
     nb_side_data = src->nb_side_data;
     event_flags = src->event_flags;
+    index_entries = nullptr;
+    nb_index_entries = 0;
   }
   else if (libVer.avformat == 57)
   {
@@ -1304,6 +1306,8 @@ void AVStreamWrapper::update()
     avg_frame_rate = src->avg_frame_rate;
     nb_side_data = src->nb_side_data;
     event_flags = src->event_flags;
+    index_entries = src->index_entries;
+    nb_index_entries = src->nb_index_entries;
     codecpar = AVCodecParametersWrapper(src->codecpar, libVer);
   }
   else 
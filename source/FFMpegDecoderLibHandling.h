@@ -341,8 +341,8 @@ private:
 class AVStreamWrapper
 {
 public:
-  AVStreamWrapper() { str = nullptr; }
-  AVStreamWrapper(AVStream *src_str, FFmpegLibraryVersion v) { str = src_str; libVer = v; update(); }
+  AVStreamWrapper() { str = nullptr; index_entries = nullptr; nb_index_entries = 0; }
+  AVStreamWrapper(AVStream *src_str, FFmpegLibraryVersion v) { str = src_str; libVer = v; index_entries = nullptr; nb_index_entries = 0; update(); }
   explicit operator bool() const { return str != nullptr; };
 
   AVMediaType getCodecType();
@@ -354,6 +354,10 @@ public:
   int get_frame_height();
   AVColorSpace get_colorspace();
   int get_index() { update(); return index; }
+  int64_t get_nb_frames() { update(); return nb_frames; }
+  // The index entries are only accessible from avformat major version 57 and up (nullptr/0 otherwise)
+  AVIndexEntry *get_index_entries() { update(); return index_entries; }
+  int get_nb_index_entries()        { update(); return nb_index_entries; }
 
   AVCodecParametersWrapper get_codecpar() { update(); return codecpar; }
 
@@ -374,6 +378,8 @@ private:
   AVRational avg_frame_rate;
   int nb_side_data;
   int event_flags;
+  AVIndexEntry *index_entries;
+  int nb_index_entries;
     
   // The AVCodecParameters are present from avformat major version 57 and up.
   AVCodecParametersWrapper codecpar;
@@ -32,13 +32,19 @@
 
 #include "FFmpegDecoder.h"
 
+#include <climits>
 #include <cstring>
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QProgressDialog>
 #include <QSettings>
+#include <QtConcurrent>
 #include "mainwindow.h"
+#include "startupTrace.h"
 #include "typedef.h"
 
 using namespace FFmpeg;
@@ -64,6 +70,7 @@ FFmpegDecoder::FFmpegDecoder()
   frameRate = -1;
   colorConversionType = BT709_LimitedRange;
   canShowNALUnits = false;
+  cancelBackgroundIndex.store(0);
 
   // Initialize the file watcher and install it (if enabled)
   fileChanged = false;
@@ -79,6 +86,13 @@ FFmpegDecoder::FFmpegDecoder()
 
 FFmpegDecoder::~FFmpegDecoder()
 {
+  if (backgroundIndexFuture.isRunning())
+  {
+    // The background scan is still running. Cancel it and wait until it is done.
+    cancelBackgroundIndex.store(1);
+    backgroundIndexFuture.waitForFinished();
+  }
+
   // Free all the allocated data structures
   if (pkt)
     pkt.free_packet();
@@ -155,6 +169,13 @@ bool FFmpegDecoder::openFile(QString fileName, FFmpegDecoder *otherDec)
     if (ff.av_dict_set(opts, "flags2", "+export_mvs", 0))
       return setOpeningError(QStringLiteral("Could not request motion vector retrieval.").arg(ret));
 
+    // Decode using frame and slice threading. The number of threads can be set in the settings (0 is auto).
+    QSettings settings;
+    const int nrThreads = settings.value("Decoders/FFMpeg.threads", 0).toInt();
+    const QByteArray threads = (nrThreads > 0) ? QByteArray::number(nrThreads) : QByteArray("auto");
+    if (ff.av_dict_set(opts, "threads", threads.constData(), 0) < 0 || ff.av_dict_set(opts, "thread_type", "frame+slice", 0) < 0)
+      DEBUG_FFMPEG("FFmpegDecoder::openFile Could not set the number of decoding threads. Decoding single threaded.");
+
     // Open codec
     ret = ff.avcodec_open2(decCtx, videoCodec, opts);
     if (ret < 0)
@@ -165,14 +186,19 @@ bool FFmpegDecoder::openFile(QString fileName, FFmpegDecoder *otherDec)
       return setOpeningError(QStringLiteral("Could not allocate frame (av_frame_alloc)."));
 
     if (otherDec)
-    {
       // Copy the key picture list and nrFrames from the other decoder
-      keyFrameList = otherDec->keyFrameList;
-      nrFrames = otherDec->nrFrames;
-    }
-    else
-      if (!scanBitstream())
+      copyIndexFrom(*otherDec);
+    else if (!readIndexFromContainer())
+    {
+      if (estimateNumberFrames())
+      {
+        // Start with the estimate and scan the bitstream in the background
+        cancelBackgroundIndex.store(0);
+        backgroundIndexFuture = QtConcurrent::run(this, &FFmpegDecoder::backgroundIndexWorker, video_stream.get_index());
+      }
+      else if (!scanBitstream())
         return setOpeningError(QStringLiteral("Error scanning bitstream for key pictures."));
+    }
 
     // Initialize an empty packet
     pkt.allocate_paket(ff);
@@ -376,10 +402,18 @@ yuvPixelFormat FFmpegDecoder::getYUVPixelFormat()
   return yuvPixelFormat();
 }
 
+// Searching for the FFmpeg libraries can be slow (e.g. if the working directory is on a network drive) and every
+// decoder does this when it opens a file. The directory where the libraries were found last time (per search path
+// from the settings) is tried first.
+static QMutex foundLibraryPathsMutex;
+static QHash<QString, QString> foundLibraryPaths;
+
 void FFmpegDecoder::loadFFmpegLibraries()
 {
   // Try to load the ffmpeg libraries from the current working directory and several other directories.
   // Unfortunately relative paths like "./" do not work: (at least on windows)
+  QElapsedTimer loadingTimer;
+  loadingTimer.start();
 
   // First try the specific FFMpeg libraries (if set)
   QSettings settings;
@@ -389,41 +423,46 @@ void FFmpegDecoder::loadFFmpegLibraries()
   QString avUtilLib = settings.value("FFMpeg.avutil", "").toString();
   QString swResampleLib = settings.value("FFMpeg.swresample", "").toString();
   if (ff.loadFFMpegLibrarySpecific(avFormatLib, avCodecLib, avUtilLib, swResampleLib))
+  {
     // Success
+    startupTrace::instance().addDuration("Loading the FFmpeg libraries", loadingTimer.elapsed());
     return;
+  }
 
-  // Next, try the directory that is saved in the settings (if it exists).
+  QStringList libPaths;
   QString decoderSearchPath = settings.value("SearchPath", "").toString();
-  if (!decoderSearchPath.isEmpty() && ff.loadFFmpegLibraryInPath(decoderSearchPath))
-    // Success
-    return;
-
-  // Next, try the current working directory
-  if (ff.loadFFmpegLibraryInPath(QDir::currentPath() + "/"))
-    // Success
-    return;
-
-  // Try the subdirectory "ffmpeg"
-  if (ff.loadFFmpegLibraryInPath(QDir::currentPath() + "/ffmpeg/"))
-    // Success
-    return;
-
-  // Try the path of the YUView.exe
-  if (ff.loadFFmpegLibraryInPath(QCoreApplication::applicationDirPath() + "/"))
-    // Success
-    return;
-
-  // Try the path of the YUView.exe -> sub directory "ffmpeg"
-  if (ff.loadFFmpegLibraryInPath(QCoreApplication::applicationDirPath() + "/ffmpeg/"))
-    return;
+  foundLibraryPathsMutex.lock();
+  if (foundLibraryPaths.contains(decoderSearchPath))
+    libPaths << foundLibraryPaths.value(decoderSearchPath);
+  foundLibraryPathsMutex.unlock();
 
+  // Next, try the directory that is saved in the settings (if it exists).
+  if (!decoderSearchPath.isEmpty())
+    libPaths << decoderSearchPath;
+  // Next, try the current working directory and the subdirectory "ffmpeg"
+  libPaths << QDir::currentPath() + "/" << QDir::currentPath() + "/ffmpeg/";
+  // Try the path of the YUView.exe and the sub directory "ffmpeg"
+  libPaths << QCoreApplication::applicationDirPath() + "/" << QCoreApplication::applicationDirPath() + "/ffmpeg/";
   // Last try: Do not use any path.
   // Just try to call QLibrary::load so that the system folder will be searched.
-  if (ff.loadFFmpegLibraryInPath(""))
-    return;
+  libPaths << "";
+
+  for (auto &libPath : libPaths)
+  {
+    if (ff.loadFFmpegLibraryInPath(libPath))
+    {
+      // Success
+      foundLibraryPathsMutex.lock();
+      foundLibraryPaths.insert(decoderSearchPath, libPath);
+      foundLibraryPathsMutex.unlock();
+      startupTrace::instance().addDuration("Loading the FFmpeg libraries", loadingTimer.elapsed());
+      return;
+    }
+  }
 
   // Loading the libraries failed
   decodingError = ffmpeg_errorLoadingLibrary;
+  startupTrace::instance().addDuration("Loading the FFmpeg libraries (failed)", loadingTimer.elapsed());
 }
 
 bool FFmpegDecoder::scanBitstream()
@@ -451,62 +490,95 @@ bool FFmpegDecoder::scanBitstream()
   AVRational timeBase = video_stream.get_time_base();
 
   qint64 maxPTS = duration * timeBase.den / timeBase.num / 1000;
-  // Updating the dialog (setValue) is quite slow. Only do this if the percent value changes.
-  int curPercentValue = 0;
   QProgressDialog progress("Parsing (indexing) bitstream...", "Cancel", 0, 100, mainWindow);
   progress.setMinimumDuration(1000);  // Show after 1s
   progress.setAutoClose(false);
   progress.setAutoReset(false);
   progress.setWindowModality(Qt::WindowModal);
 
+  QList<pictureIdx> keyFrames;
+  int frames;
+  const bool success = scanPackets(fmt_ctx, video_stream.get_index(), keyFrames, frames, &progress, maxPTS);
+  progress.close();
+  if (!success)
+    return false;
+
+  {
+    QMutexLocker lock(&indexMutex);
+    keyFrameList = keyFrames;
+    nrFrames = frames;
+  }
+
+  // Seek back to the beginning of the stream.
+  ret = ff.seek_frame(fmt_ctx, video_stream.get_index(), 0);
+  if (ret != 0)
+    // Seeking failed.
+    return false;
+
+  return true;
+}
+
+bool FFmpegDecoder::scanPackets(AVFormatContextWrapper &ctx, int streamIdx, QList<pictureIdx> &keyFrames, int &frames, QProgressDialog *progress, qint64 maxPTS)
+{
+  keyFrames.clear();
+  frames = -1;
+
+  // Updating the dialog (setValue) is quite slow. Only do this if the percent value changes.
+  int curPercentValue = 0;
+
   // Initialize an empty packet (data and size set to 0).
   AVPacketWrapper p(ff);
 
   qint64 lastKeyFramePTS = 0;
-  const int stream_idx = video_stream.get_index();
+  int ret;
   do
   {
     // Get one packet
-    ret = fmt_ctx.read_frame(ff, p);
+    ret = ctx.read_frame(ff, p);
 
-    if (ret == 0 && p.get_stream_index() == stream_idx)
+    if (ret == 0 && p.get_stream_index() == streamIdx)
     {
       int64_t pts = p.get_pts();
 
       // Next video frame found
       if (p.get_flags() & AV_PKT_FLAG_KEY)
       {
-        if (nrFrames == -1)
-          nrFrames = 0;
-        keyFrameList.append(pictureIdx(nrFrames, pts));
+        if (frames == -1)
+          frames = 0;
+        keyFrames.append(pictureIdx(frames, pts));
         lastKeyFramePTS = pts;
       }
       if (pts < lastKeyFramePTS)
       {
         // What now? Can this happen? If this happens, the frame count/PTS combination of the last key frame
         // is wrong.
-        keyFrameList.clear();
-        nrFrames = -1;
+        keyFrames.clear();
+        frames = -1;
         // Free the packet (this will automatically unref the packet as weel)
         p.unref_packet(ff);
         return false;
       }
-      nrFrames++;
+      frames++;
 
-      // Update the progress dialog
-      if (progress.wasCanceled())
+      // Was the scan canceled?
+      if ((progress && progress->wasCanceled()) || cancelBackgroundIndex.load())
       {
-        keyFrameList.clear();
-        nrFrames = -1;
+        keyFrames.clear();
+        frames = -1;
         // Free the packet (this will automatically unref the packet as weel)
         p.unref_packet(ff);
         return false;
       }
-      int newPercentValue = pts * 100 / maxPTS;
-      if (newPercentValue != curPercentValue)
+
+      // Update the progress dialog
+      if (progress && maxPTS > 0)
       {
-        progress.setValue(newPercentValue);
-        curPercentValue = newPercentValue;
+        int newPercentValue = pts * 100 / maxPTS;
+        if (newPercentValue != curPercentValue)
+        {
+          progress->setValue(newPercentValue);
+          curPercentValue = newPercentValue;
+        }
       }
     }
 
@@ -514,17 +586,92 @@ bool FFmpegDecoder::scanBitstream()
     p.unref_packet(ff);
   } while (ret == 0);
 
-  progress.close();
+  return true;
+}
 
-  // Seek back to the beginning of the stream.
-  ret = ff.seek_frame(fmt_ctx, video_stream.get_index(), 0);
-  if (ret != 0)
-    // Seeking failed.
+bool FFmpegDecoder::readIndexFromContainer()
+{
+  // Some containers (like mp4) have an index entry for every frame. Others (like mkv) only list the key frames.
+  // We need all frames to know the frame number of each key frame.
+  AVIndexEntry *entries = video_stream.get_index_entries();
+  const int nrEntries = video_stream.get_nb_index_entries();
+  if (entries == nullptr || nrEntries <= 0 || video_stream.get_nb_frames() != nrEntries)
+    return false;
+
+  QList<pictureIdx> keyFrames;
+  for (int i = 0; i < nrEntries; i++)
+    if (entries[i].flags & AVINDEX_KEYFRAME)
+      keyFrames.append(pictureIdx(i, entries[i].timestamp));
+
+  // Decoding must be able to start with the first frame
+  if (keyFrames.isEmpty() || keyFrames.first().frame != 0)
+    return false;
+
+  DEBUG_FFMPEG("FFmpegDecoder::readIndexFromContainer %d frames, %d key frames", nrEntries, keyFrames.count());
+  QMutexLocker lock(&indexMutex);
+  keyFrameList = keyFrames;
+  nrFrames = nrEntries;
+  return true;
+}
+
+bool FFmpegDecoder::estimateNumberFrames()
+{
+  // Prefer the number of frames from the stream. If it is not set, use the duration and the frame rate.
+  int64_t frames = video_stream.get_nb_frames();
+  if (frames <= 0)
+  {
+    AVRational avgFrameRate = video_stream.get_avg_frame_rate();
+    int64_t duration = fmt_ctx.get_duration();
+    if (avgFrameRate.num <= 0 || avgFrameRate.den <= 0 || duration <= 0)
+      return false;
+    frames = duration * avgFrameRate.num / avgFrameRate.den / AV_TIME_BASE;
+  }
+  if (frames <= 0 || frames > INT_MAX)
     return false;
 
+  DEBUG_FFMPEG("FFmpegDecoder::estimateNumberFrames %lld frames", frames);
+  QMutexLocker lock(&indexMutex);
+  keyFrameList.clear();
+  keyFrameList.append(pictureIdx(0, 0));
+  nrFrames = int(frames);
   return true;
 }
 
+void FFmpegDecoder::backgroundIndexWorker(int streamIdx)
+{
+  // Use a separate format context so that the decoding in the foreground is not disturbed.
+  AVFormatContextWrapper ctx;
+  if (ff.open_input(ctx, fullFilePath) < 0)
+  {
+    ctx.avformat_close_input(ff);
+    return;
+  }
+
+  QList<pictureIdx> keyFrames;
+  int frames;
+  const bool success = scanPackets(ctx, streamIdx, keyFrames, frames, nullptr, 0);
+  ctx.avformat_close_input(ff);
+  if (!success || keyFrames.isEmpty())
+    // Canceled or the scan failed. Keep the estimate.
+    return;
+
+  {
+    QMutexLocker lock(&indexMutex);
+    keyFrameList = keyFrames;
+    nrFrames = frames;
+  }
+  DEBUG_FFMPEG("FFmpegDecoder::backgroundIndexWorker %d frames, %d key frames", frames, keyFrames.count());
+  emit signalIndexUpdated();
+}
+
+void FFmpegDecoder::copyIndexFrom(FFmpegDecoder &otherDec)
+{
+  QMutexLocker otherLock(&otherDec.indexMutex);
+  QMutexLocker lock(&indexMutex);
+  keyFrameList = otherDec.keyFrameList;
+  nrFrames = otherDec.nrFrames;
+}
+
 QList<infoItem> FFmpegDecoder::getFileInfoList() const
 {
   QList<infoItem> infoList;
@@ -580,7 +727,16 @@ QByteArray FFmpegDecoder::loadYUVFrameData(int frameIdx)
     return currentOutputBuffer;
   }
 
+  // When stepping backwards, the frame may have been decoded recently (when we seeked back the last time)
+  if (frameIdx < currentOutputBufferFrameIndex && recentFrames.contains(frameIdx))
+  {
+    DEBUG_FFMPEG("FFmpegDecoder::loadYUVFrameData Frame %d from the recently decoded frames", frameIdx);
+    return recentFrames.get(frameIdx);
+  }
+
   // We have to decode the requested frame.
+  // If we seek backwards, keep all frames that are decoded on the way to the requested frame
+  const bool seekingBackwards = (currentOutputBufferFrameIndex != -1 && (int)frameIdx < currentOutputBufferFrameIndex);
   if ((int)frameIdx < currentOutputBufferFrameIndex || currentOutputBufferFrameIndex == -1)
   {
     // The requested frame lies before the current one. We will have to rewind and start decoding from there.
@@ -611,13 +767,17 @@ QByteArray FFmpegDecoder::loadYUVFrameData(int frameIdx)
     currentOutputBufferFrameIndex++;
 
     // We have decoded one frame. Get the pixel format.
-    if (currentOutputBufferFrameIndex == frameIdx)
+    if (currentOutputBufferFrameIndex == frameIdx || seekingBackwards)
     {
-      // This is the frame that we want to decode
-
-      // Put image data into buffer
+      // Put image data into buffer (and keep it for the next backward steps)
       copyFrameToOutputBuffer();
+      if (seekingBackwards)
+        recentFrames.add(currentOutputBufferFrameIndex, currentOutputBuffer);
+    }
 
+    if (currentOutputBufferFrameIndex == frameIdx)
+    {
+      // This is the frame that we want to decode
       // Get the motion vectors from the image as well...
       // TODO: Only perform this if the statistics are shown. 
       copyFrameMotionInformation();
@@ -734,6 +894,7 @@ bool FFmpegDecoder::reloadItemSource()
 
 FFmpegDecoder::pictureIdx FFmpegDecoder::getClosestSeekableFrameNumberBefore(int frameIdx)
 {
+  QMutexLocker lock(&indexMutex);
   pictureIdx ret = keyFrameList.first();
   for (auto f : keyFrameList)
   {
@@ -782,6 +943,8 @@ statisticsData FFmpegDecoder::getStatisticsData(int frameIdx, int typeIdx)
       // This can be done like this:
       currentOutputBufferFrameIndex ++;
 
+    // Don't serve the frame from the recently decoded frames. It must be decoded to get the statistics.
+    recentFrames.remove(frameIdx);
     loadYUVFrameData(frameIdx);
   }
 
@@ -33,13 +33,19 @@
 #ifndef FFMPEGDECODER_H
 #define FFMPEGDECODER_H
 
+#include "decodedFrameRing.h"
 #include "fileInfoWidget.h"
 #include "statisticsExtensions.h"
 #include "videoHandlerYUV.h"
 #include "FFMpegDecoderLibHandling.h"
 #include "fileSourceAVCAnnexBFile.h"
+#include <QAtomicInt>
 #include <QLibrary>
 #include <QFileSystemWatcher>
+#include <QFuture>
+#include <QMutex>
+
+class QProgressDialog;
 
 using namespace YUV_Internals;
 
@@ -56,7 +62,12 @@ public:
   // Return false if an error occured (opening the decoder or parsing the bitstream)
   // If a second decoder is provided, the bistream will not be scanned again (scanBitstream), but
   // the values will be copied from the given decoder.
+  // If the container provides an index of all frames (e.g. mp4), the key frames are taken from there. Otherwise,
+  // the number of frames is estimated and the bitstream is scanned in the background. signalIndexUpdated is
+  // emitted when the scan is done.
   bool openFile(QString fileName, FFmpegDecoder *otherDec=nullptr);
+  // Copy the key frame list and the number of frames from the given decoder
+  void copyIndexFrom(FFmpegDecoder &otherDec);
 
   // Get the pixel format and frame size. This is valid after openFile was called.
   yuvPixelFormat getYUVPixelFormat();
@@ -66,7 +77,7 @@ public:
   QList<infoItem> getFileInfoList() const;
 
   // How many frames are in the file?
-  int getNumberPOCs() const { return nrFrames; }
+  int getNumberPOCs() const { QMutexLocker lock(&indexMutex); return nrFrames; }
   double getFrameRate() const { return frameRate; }
   ColorConversion getColorConversionType() const { return colorConversionType; }
 
@@ -81,6 +92,8 @@ public:
 
   // Load the raw YUV data for the given frame
   QByteArray loadYUVFrameData(int frameIdx);
+  // The memory that the frames kept for backward steps use (in bytes). This can be called from any thread.
+  qint64 getRecentFramesBytes() const { return recentFrames.getNrBytes(); }
 
   // Was the file changed by some other application?
   bool isFileChanged() { bool b = fileChanged; fileChanged = false; return b; }
@@ -97,6 +110,12 @@ public:
 
   // Annex B files
   bool canShowNALInfo() const { return canShowNALUnits; }
+  // The sizes and slice types of all pictures (only for Annex B files)
+  const QVector<fileSourceAnnexBFile::pictureStats> &getPictureStats() const { return annexBFile.getPictureStats(); }
+
+signals:
+  // The bitstream was scanned in the background. The key frame list and the number of frames were updated.
+  void signalIndexUpdated();
 
 private slots:
   void fileSystemWatcherFileChanged(const QString &path) { Q_UNUSED(path); fileChanged = true; }
@@ -164,8 +183,23 @@ private:
   // These are filled after opening a file (after scanBitstream was called)
   int nrFrames;                               //< How many frames are in the sequence?
   QList<pictureIdx> keyFrameList;  //< A list of pairs (frameNr, PTS) that we can seek to.
+  mutable QMutex indexMutex;       //< Locked when accessing nrFrames/keyFrameList (they may be updated in the background)
   pictureIdx getClosestSeekableFrameNumberBefore(int frameIdx);
 
+  // Get the key frames from the index of the container. This only works if the index contains all frames.
+  bool readIndexFromContainer();
+  // Estimate the number of frames from the stream/container info. Only the first frame is known to be a key frame.
+  bool estimateNumberFrames();
+  // Read all packets of the video stream from the given context and collect the key frames. The scan can be canceled
+  // using the progress dialog (if given) or cancelBackgroundIndex.
+  bool scanPackets(AVFormatContextWrapper &ctx, int streamIdx, QList<pictureIdx> &keyFrames, int &frames, QProgressDialog *progress, qint64 maxPTS);
+
+  // Scan the bitstream in the background (using a separate format context)
+  void backgroundIndexWorker(int streamIdx);
+  QFuture<void> backgroundIndexFuture;
+  // Set from the main thread, polled by the background worker
+  QAtomicInt cancelBackgroundIndex;
+
   // Seek the stream to the given pts value, flush the decoder and load the first packet so
   // that we are ready to start decoding from this pts.
   bool seekToPTS(qint64 pts);
@@ -176,6 +210,8 @@ private:
 
   // The buffer and the index that was requested in the last call to getOneFrame
   int currentOutputBufferFrameIndex;
+  // The frames that were decoded when seeking backwards. Used to serve further backward steps.
+  decodedFrameRing recentFrames;
 #if SSE_CONVERSION
   byteArrayAligned currentOutputBuffer;
   void copyImgToByteArray(const de265_image *src, byteArrayAligned &dst);
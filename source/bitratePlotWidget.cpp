@@ -0,0 +1,179 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "bitratePlotWidget.h"
+
+#include <QDialog>
+#include <QHelpEvent>
+#include <QLabel>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollArea>
+#include <QToolTip>
+#include <QVBoxLayout>
+
+// The width of one bar in pixels
+#define BITRATE_PLOT_BAR_WIDTH 3
+// The height of the plot and the number of horizontal grid lines
+#define BITRATE_PLOT_HEIGHT 400
+#define BITRATE_PLOT_GRID_LINES 4
+
+bitratePlotWidget::bitratePlotWidget(QWidget *parent) : QWidget(parent)
+{
+  maxBytes = 0;
+  setMouseTracking(true);
+  setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void bitratePlotWidget::setPictureStats(const QVector<fileSourceAnnexBFile::pictureStats> &stats)
+{
+  pictureStats = stats;
+  maxBytes = 0;
+  for (const fileSourceAnnexBFile::pictureStats &p : pictureStats)
+    maxBytes = qMax(maxBytes, p.nrBytes);
+
+  setFixedSize(sizeHint());
+  update();
+}
+
+QString bitratePlotWidget::getSummary(double frameRate) const
+{
+  if (pictureStats.isEmpty())
+    return "No pictures";
+
+  quint64 totalBytes = 0;
+  int nrPictures[fileSourceAnnexBFile::pictureSlice_Other + 1] = {0};
+  for (const fileSourceAnnexBFile::pictureStats &p : pictureStats)
+  {
+    totalBytes += p.nrBytes;
+    nrPictures[p.sliceType]++;
+  }
+
+  const double averageBytes = double(totalBytes) / pictureStats.count();
+  QString summary = QString("%1 pictures (I %2, P %3, B %4). Average %5 bytes per picture, maximum %6 bytes.")
+    .arg(pictureStats.count())
+    .arg(nrPictures[fileSourceAnnexBFile::pictureSlice_I])
+    .arg(nrPictures[fileSourceAnnexBFile::pictureSlice_P])
+    .arg(nrPictures[fileSourceAnnexBFile::pictureSlice_B])
+    .arg(averageBytes, 0, 'f', 0)
+    .arg(maxBytes);
+  if (frameRate > 0)
+    summary += QString(" Bitrate %1 kbit/s at %2 fps.").arg(averageBytes * 8 * frameRate / 1000, 0, 'f', 1).arg(frameRate);
+  return summary;
+}
+
+void bitratePlotWidget::showDialog(const QVector<fileSourceAnnexBFile::pictureStats> &stats, double frameRate)
+{
+  QDialog newDialog;
+  newDialog.setWindowTitle("Picture sizes in coding order");
+  bitratePlotWidget *plot = new bitratePlotWidget();
+  plot->setPictureStats(stats);
+  QScrollArea *scrollArea = new QScrollArea();
+  scrollArea->setWidget(plot);
+  QVBoxLayout *verticalLayout = new QVBoxLayout(&newDialog);
+  verticalLayout->addWidget(new QLabel(plot->getSummary(frameRate) + "\nI pictures are red, P pictures green and B pictures blue."));
+  verticalLayout->addWidget(scrollArea);
+  newDialog.resize(QSize(1000, BITRATE_PLOT_HEIGHT + 100));
+  newDialog.exec();
+}
+
+QSize bitratePlotWidget::sizeHint() const
+{
+  return QSize(qMax(pictureStats.count() * BITRATE_PLOT_BAR_WIDTH, 100), BITRATE_PLOT_HEIGHT);
+}
+
+void bitratePlotWidget::paintEvent(QPaintEvent *event)
+{
+  QPainter painter(this);
+  const QRect drawRect = event->rect();
+  painter.fillRect(drawRect, Qt::white);
+
+  if (pictureStats.isEmpty() || maxBytes == 0)
+    return;
+
+  // Only draw the bars that are visible
+  const int h = height();
+  const int firstPic = qMax(drawRect.left() / BITRATE_PLOT_BAR_WIDTH, 0);
+  const int lastPic = qMin(drawRect.right() / BITRATE_PLOT_BAR_WIDTH, pictureStats.count() - 1);
+  const QColor sliceTypeColors[] = {Qt::red, Qt::darkGreen, Qt::blue, Qt::gray};
+  for (int i = firstPic; i <= lastPic; i++)
+  {
+    const fileSourceAnnexBFile::pictureStats &p = pictureStats[i];
+    const int barHeight = int(qint64(p.nrBytes) * (h - 1) / maxBytes);
+    painter.fillRect(i * BITRATE_PLOT_BAR_WIDTH, h - barHeight, BITRATE_PLOT_BAR_WIDTH, barHeight, sliceTypeColors[p.sliceType]);
+  }
+
+  // Draw the horizontal grid lines. The labels are drawn at the left of the visible area so that they
+  // stay visible when scrolling.
+  painter.setPen(Qt::lightGray);
+  for (int l = 1; l <= BITRATE_PLOT_GRID_LINES; l++)
+  {
+    const int y = h - 1 - (h - 1) * l / BITRATE_PLOT_GRID_LINES;
+    painter.drawLine(drawRect.left(), y, drawRect.right(), y);
+  }
+  painter.setPen(Qt::black);
+  for (int l = 1; l <= BITRATE_PLOT_GRID_LINES; l++)
+  {
+    const int y = h - 1 - (h - 1) * l / BITRATE_PLOT_GRID_LINES;
+    painter.drawText(drawRect.left() + 2, y + painter.fontMetrics().ascent() + 1, QString("%1 bytes").arg(qint64(maxBytes) * l / BITRATE_PLOT_GRID_LINES));
+  }
+}
+
+bool bitratePlotWidget::event(QEvent *event)
+{
+  if (event->type() == QEvent::ToolTip)
+  {
+    QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+    const int idx = pictureAt(helpEvent->pos().x());
+    if (idx >= 0)
+    {
+      const fileSourceAnnexBFile::pictureStats &p = pictureStats[idx];
+      const QStringList sliceTypeNames = QStringList() << "I" << "P" << "B" << "Other";
+      QToolTip::showText(helpEvent->globalPos(), QString("Picture %1 (POC %2)\nSize: %3 bytes\nSlice type: %4\nTemporal ID: %5\nslice_qp_delta: %6")
+        .arg(idx).arg(p.poc).arg(p.nrBytes).arg(sliceTypeNames.value(p.sliceType)).arg(p.temporalID).arg(p.sliceQPDelta));
+    }
+    else
+    {
+      QToolTip::hideText();
+      event->ignore();
+    }
+    return true;
+  }
+  return QWidget::event(event);
+}
+
+int bitratePlotWidget::pictureAt(int x) const
+{
+  const int idx = x / BITRATE_PLOT_BAR_WIDTH;
+  return (x >= 0 && idx < pictureStats.count()) ? idx : -1;
+}
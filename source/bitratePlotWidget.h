@@ -0,0 +1,74 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BITRATEPLOTWIDGET_H
+#define BITRATEPLOTWIDGET_H
+
+#include <QWidget>
+#include "fileSourceAnnexBFile.h"
+
+/* This widget plots the size of every picture of a bitstream (in coding order) as a bar chart.
+ * The bars are colored by the slice type of the picture. Put it into a QScrollArea for long sequences.
+ * A tooltip shows the details of the picture under the mouse.
+*/
+class bitratePlotWidget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  bitratePlotWidget(QWidget *parent = 0);
+
+  // Set the pictures to plot
+  void setPictureStats(const QVector<fileSourceAnnexBFile::pictureStats> &stats);
+
+  // Get a summary text (number of pictures, average size and bitrate if the frame rate is known)
+  QString getSummary(double frameRate) const;
+
+  virtual QSize sizeHint() const Q_DECL_OVERRIDE;
+
+  // Show a modal dialog with the summary and the plot of the given pictures
+  static void showDialog(const QVector<fileSourceAnnexBFile::pictureStats> &stats, double frameRate);
+
+protected:
+  virtual void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+  virtual bool event(QEvent *event) Q_DECL_OVERRIDE;
+
+private:
+  // Get the index of the picture at the given x position (-1 if there is none)
+  int pictureAt(int x) const;
+
+  QVector<fileSourceAnnexBFile::pictureStats> pictureStats;
+  quint32 maxBytes;
+};
+
+#endif // BITRATEPLOTWIDGET_H
@@ -0,0 +1,71 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "decodedFrameRing.h"
+
+#include <QtGlobal>
+
+decodedFrameRing::decodedFrameRing(qint64 maxNrBytes)
+{
+  nrBytes.store(0);
+  maxBytes = maxNrBytes;
+}
+
+void decodedFrameRing::add(int frameIdx, const QByteArray &data)
+{
+  if (data.isEmpty())
+    return;
+
+  remove(frameIdx);
+  frames.insert(frameIdx, data);
+  nrBytes.fetchAndAddOrdered(data.size());
+
+  // Drop frames until we are within the limit. Always drop the frame from the end that is farther away
+  // from the frame that was just added. The frame that was just added is kept in any case.
+  while (nrBytes.load() > maxBytes && frames.size() > 1)
+  {
+    auto it = (qAbs(frames.firstKey() - frameIdx) >= qAbs(frames.lastKey() - frameIdx)) ? frames.begin() : --frames.end();
+    nrBytes.fetchAndAddOrdered(-it.value().size());
+    frames.erase(it);
+  }
+}
+
+void decodedFrameRing::remove(int frameIdx)
+{
+  auto it = frames.find(frameIdx);
+  if (it != frames.end())
+  {
+    nrBytes.fetchAndAddOrdered(-it.value().size());
+    frames.erase(it);
+  }
+}
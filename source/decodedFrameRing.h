@@ -0,0 +1,71 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DECODEDFRAMERING_H
+#define DECODEDFRAMERING_H
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QMap>
+
+// The default maximum amount of memory that one ring may use (in bytes)
+#define DECODED_FRAME_RING_MAX_BYTES (qint64(256) * 1024 * 1024)
+
+/* A bounded set of recently decoded raw frames of a decoder.
+ * A decoder can only seek to random access points. So stepping backwards one frame at a time would require
+ * decoding the GOP up to the requested frame again for every step (quadratic decoding work). If a decoder has
+ * to seek backwards, it puts all frames that it decodes on the way to the requested frame in here. The following
+ * backward steps (or short backward jumps) can then be served without decoding anything.
+ * The memory that is used is limited. If the limit is exceeded, the frames farthest away from the last
+ * inserted frame are dropped first.
+ */
+class decodedFrameRing
+{
+public:
+  decodedFrameRing(qint64 maxNrBytes = DECODED_FRAME_RING_MAX_BYTES);
+
+  bool contains(int frameIdx) const { return frames.contains(frameIdx); }
+  QByteArray get(int frameIdx) const { return frames.value(frameIdx); }
+  void add(int frameIdx, const QByteArray &data);
+  void remove(int frameIdx);
+  void clear() { frames.clear(); nrBytes.store(0); }
+  // The memory that the frames use (in bytes). This can be read from any thread.
+  qint64 getNrBytes() const { return nrBytes.load(); }
+
+private:
+  QMap<int, QByteArray> frames;
+  QAtomicInteger<qint64> nrBytes;
+  qint64 maxBytes;
+};
+
+#endif // DECODEDFRAMERING_H
@@ -33,7 +33,11 @@
 #include "decoderBase.h"
 
 #include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QSettings>
+#include "startupTrace.h"
 
 // Debug the decoder ( 0:off 1:interactive deocder only 2:caching decoder only 3:both)
 #define DECODERBASE_DEBUG_OUTPUT 0
@@ -60,6 +64,7 @@ decoderBase::decoderBase(bool cachingDecoder) :
   statsCacheCurPOC = -1;
   isCachingDecoder = cachingDecoder;
   decodeSignal = 0;
+  captureAllSignals = false;
 
   nrBitsC0 = -1;
   pixelFormat = YUV_NUM_SUBSAMPLINGS;
@@ -68,6 +73,7 @@ decoderBase::decoderBase(bool cachingDecoder) :
   // When using the zoom box the getOneFrame function is called frequently so we
   // keep this buffer to not decode the same frame over and over again.
   currentOutputBufferFrameIndex = -1;
+  seekingBackwards = false;
 }
 
 void decoderBase::setDecodeSignal(int signalID)
@@ -81,6 +87,11 @@ void decoderBase::setDecodeSignal(int signalID)
   {
     // A different signal was selected
     decodeSignal = signalID;
+    recentFrames.clear();
+
+    if (captureAllSignals && signalID >= 0 && signalID < capturedSignals.size() && capturedSignals[signalID].contains(currentOutputBufferFrameIndex))
+      // The new signal was captured for the current frame. The decoder can just continue from here.
+      return;
 
     // We will have to decode the current frame again to get the internals/statistics
     // This can be done like this:
@@ -89,18 +100,74 @@ void decoderBase::setDecodeSignal(int signalID)
   }
 }
 
+void decoderBase::setCaptureAllSignals(bool capture)
+{
+  if (capture == captureAllSignals || (capture && !canCaptureAllSignals()))
+    return;
+
+  DEBUG_HEVCDECODERBASE("decoderBase::setCaptureAllSignals %d", capture);
+
+  captureAllSignals = capture;
+  if (capture)
+    capturedSignals = QVector<decodedFrameRing>(wrapperGetSignalNames().count(), decodedFrameRing(DECODER_CAPTURED_SIGNAL_MAX_BYTES));
+  else
+    capturedSignals.clear();
+
+  // The decoder has to be set up again to output all signals. Decode the current frame again.
+  currentOutputBufferFrameIndex = -1;
+  recentFrames.clear();
+}
+
+bool decoderBase::getRecentFrame(int frameIdx, QByteArray &frame)
+{
+  // When stepping backwards, the frame may have been decoded recently (when we seeked back the last time)
+  if (frameIdx < currentOutputBufferFrameIndex && recentFrames.contains(frameIdx))
+  {
+    DEBUG_HEVCDECODERBASE("decoderBase::getRecentFrame Frame %d from the recently decoded frames", frameIdx);
+    frame = recentFrames.get(frameIdx);
+    return true;
+  }
+
+  // The frame has to be decoded. If we seek backwards, keep all frames that are decoded on the way to it.
+  seekingBackwards = (currentOutputBufferFrameIndex != -1 && frameIdx < currentOutputBufferFrameIndex);
+  return false;
+}
+
+void decoderBase::keepDecodedFrame(const QByteArray &frame)
+{
+  if (seekingBackwards)
+    recentFrames.add(currentOutputBufferFrameIndex, frame);
+}
+
+qint64 decoderBase::getCapturedSignalsBytes() const
+{
+  qint64 nrBytes = 0;
+  for (const decodedFrameRing &ring : capturedSignals)
+    nrBytes += ring.getNrBytes();
+  return nrBytes;
+}
+
 void decoderBase::setError(const QString &reason)
 {
   decoderError = true;
   errorString = reason;
 }
 
+// Searching for a decoder library can be slow (e.g. if the working directory is on a network drive) and every
+// decoder does this when it is created. The library that was found last time (per library names and search path)
+// is tried first.
+static QMutex foundLibrariesMutex;
+static QHash<QString, QString> foundLibraries;
+
 void decoderBase::loadDecoderLibrary(QString specificLibrary)
 {
   // Try to load the libde265 library from the current working directory
   // Unfortunately relative paths like this do not work: (at least on windows)
   // library.setFileName(".\\libde265");
 
+  QElapsedTimer loadingTimer;
+  loadingTimer.start();
+
   bool libLoaded = false;
 
   // Try the specific library first
@@ -122,6 +189,17 @@ void decoderBase::loadDecoderLibrary(QString specificLibrary)
     searchPath.append("%1");
     settings.endGroup();
 
+    const QString foundLibrariesKey = libNames.join(";") + ";" + searchPath;
+    foundLibrariesMutex.lock();
+    const QString foundLibrary = foundLibraries.value(foundLibrariesKey);
+    foundLibrariesMutex.unlock();
+    if (!foundLibrary.isEmpty())
+    {
+      library.setFileName(foundLibrary);
+      libraryPath = foundLibrary;
+      libLoaded = library.load();
+    }
+
     QStringList const libPaths = QStringList()
       << searchPath
       << QDir::currentPath() + "/%1"
@@ -132,6 +210,8 @@ void decoderBase::loadDecoderLibrary(QString specificLibrary)
 
     for (auto &libName : libNames)
     {
+      if (libLoaded)
+        break;
       for (auto &libPath : libPaths)
       {
         library.setFileName(libPath.arg(libName));
@@ -140,11 +220,17 @@ void decoderBase::loadDecoderLibrary(QString specificLibrary)
         if (libLoaded)
           break;
       }
-      if (libLoaded)
-        break;
+    }
+
+    if (libLoaded)
+    {
+      foundLibrariesMutex.lock();
+      foundLibraries.insert(foundLibrariesKey, libraryPath);
+      foundLibrariesMutex.unlock();
     }
   }
 
+  startupTrace::instance().addDuration("Loading the decoder library " + (libLoaded ? libraryPath : getLibraryNames().join(", ")), loadingTimer.elapsed());
   if (!libLoaded)
   {
     libraryPath.clear();
@@ -34,6 +34,8 @@
 #define DECODERBASE_H
 
 #include <QLibrary>
+#include <QVector>
+#include "decodedFrameRing.h"
 #include "fileSourceAnnexBFile.h"
 #include "statisticHandler.h"
 #include "statisticsExtensions.h"
@@ -41,6 +43,9 @@
 
 using namespace YUV_Internals;
 
+// The maximum amount of memory that the captured frames of one signal may use (in bytes)
+#define DECODER_CAPTURED_SIGNAL_MAX_BYTES (qint64(16) * 1024 * 1024)
+
 /* This class is the abstract base class for all non FFMpeg decoders that read from a raw source file.
 */
 class decoderBase
@@ -65,6 +70,15 @@ public:
 
   // Which signal should we read from the decoder? Reconstruction(0, default), Prediction(1) or Residual(2)
   void setDecodeSignal(int signalID);
+  // Can the decoder retrieve all signals from a decoded picture at once?
+  virtual bool canCaptureAllSignals() const { return false; }
+  // If enabled, the decoder retrieves all signals from every picture that it outputs and keeps them (for a limited
+  // number of frames). Switching the decode signal does then not require decoding the frames again.
+  void setCaptureAllSignals(bool capture);
+  // The memory that the captured signals use (in bytes). Must be called from the thread that sets setCaptureAllSignals.
+  qint64 getCapturedSignalsBytes() const;
+  // The memory that the frames kept for backward steps use (in bytes). This can be called from any thread.
+  qint64 getRecentFramesBytes() const { return recentFrames.getNrBytes(); }
 
   // Load the raw YUV data for the given frame
   virtual QByteArray loadYUVFrameData(int frameIdx) = 0;
@@ -130,6 +144,10 @@ protected:
   // Reconstruction(0, default), Prediction(1) or Residual(2)
   int decodeSignal;
 
+  // Are all signals retrieved from every output picture? If so, they are kept in capturedSignals[signalID].
+  bool captureAllSignals;
+  QVector<decodedFrameRing> capturedSignals;
+
   // Statistics caching
   QHash<int, statisticsData> curPOCStats;  // cache of the statistics for the current POC [statsTypeID]
   int statsCacheCurPOC;                    // the POC of the statistics that are in the curPOCStats
@@ -137,6 +155,19 @@ protected:
   // The buffer and the index that was requested in the last call to getOneFrame
   int currentOutputBufferFrameIndex;
 
+  // The frames that were decoded when seeking backwards. Used to serve further backward steps.
+  // A decoder can only seek to random access points. If it has to seek backwards, all frames that are decoded on the
+  // way to the requested frame are kept. Call getRecentFrame before decoding the requested frame. It returns true if
+  // the frame was decoded recently. For every decoded frame, check needsDecodedFrame and call keepDecodedFrame.
+  bool getRecentFrame(int frameIdx, QByteArray &frame);
+  // Must the frame that was just decoded (currentOutputBufferFrameIndex) be copied? This is the case if it is the
+  // requested frame or if it is kept for the next backward steps.
+  bool needsDecodedFrame(int frameIdx) const { return currentOutputBufferFrameIndex == frameIdx || seekingBackwards; }
+  // Keep the frame that was just decoded (currentOutputBufferFrameIndex) if we are seeking backwards
+  void keepDecodedFrame(const QByteArray &frame);
+  decodedFrameRing recentFrames;
+  bool seekingBackwards;
+
   // This holds the file path to the loaded library
   QString libraryPath;
 
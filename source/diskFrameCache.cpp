@@ -0,0 +1,303 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "diskFrameCache.h"
+
+#include <cstring>
+#include <QDir>
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+// Activate this if you want to know when frames are written to/read from the disk cache
+#define DISKFRAMECACHE_DEBUG_OUTPUT 0
+#if DISKFRAMECACHE_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_DISKCACHE qDebug
+#else
+#define DEBUG_DISKCACHE(fmt,...) ((void)0)
+#endif
+
+// The maximum number of frames that are queued for writing. The queued frames are kept in memory (outside of the
+// budget of the memory cache) so this should be small.
+#define DISKFRAMECACHE_MAX_PENDING_FRAMES 8
+
+QMutex diskFrameCache::settingsMutex;
+bool diskFrameCache::enabled = false;
+QString diskFrameCache::path;
+qint64 diskFrameCache::maxSize = 0;
+qint64 diskFrameCache::usedSize = 0;
+
+diskFrameCache::diskFrameCache()
+{
+  imageFormat = QImage::Format_Invalid;
+  slotSize = 0;
+  nrSlots = 0;
+  writerRunning = false;
+  writingFrame = -1;
+  writingSlot = -1;
+  writingFrameRemoved = false;
+}
+
+diskFrameCache::~diskFrameCache()
+{
+  // Drop all queued frames and wait for the background writer. The temporary file is removed when it is deleted.
+  clear();
+  writerFuture.waitForFinished();
+}
+
+void diskFrameCache::setSettings(bool enable, const QString &scratchPath, qint64 maxBytes)
+{
+  QMutexLocker lock(&settingsMutex);
+  enabled = enable;
+  path = scratchPath.isEmpty() ? QDir::tempPath() : scratchPath;
+  maxSize = maxBytes;
+}
+
+bool diskFrameCache::isEnabled()
+{
+  QMutexLocker lock(&settingsMutex);
+  return enabled && maxSize > 0;
+}
+
+bool diskFrameCache::contains(int frameIdx) const
+{
+  QMutexLocker lock(&accessMutex);
+  return frameSlots.contains(frameIdx) || pendingFrames.contains(frameIdx) || writingFrame == frameIdx;
+}
+
+void diskFrameCache::add(int frameIdx, const QImage &image)
+{
+  if (image.isNull() || !isEnabled())
+    return;
+
+  QMutexLocker lock(&accessMutex);
+  if (!pendingFrames.contains(frameIdx))
+    pendingOrder.enqueue(frameIdx);
+  pendingFrames.insert(frameIdx, image);
+  while (pendingOrder.count() > DISKFRAMECACHE_MAX_PENDING_FRAMES)
+  {
+    const int droppedFrame = pendingOrder.dequeue();
+    DEBUG_DISKCACHE("diskFrameCache::add queue full - dropping frame %d", droppedFrame);
+    pendingFrames.remove(droppedFrame);
+  }
+
+  if (!writerRunning)
+  {
+    writerRunning = true;
+    writerFuture = QtConcurrent::run(this, &diskFrameCache::writePendingFrames);
+  }
+}
+
+void diskFrameCache::writePendingFrames()
+{
+  QMutexLocker lock(&accessMutex);
+  while (!pendingOrder.isEmpty())
+  {
+    const int frameIdx = pendingOrder.dequeue();
+    const QImage image = pendingFrames.take(frameIdx);
+    uchar *data = reserveSlotLocked(frameIdx, image);
+    if (data == nullptr)
+      continue;
+
+    // Copy the frame without holding the mutex so that reading frames does not wait for the disk
+    const qint64 nrBytes = slotSize;
+    writingFrame = frameIdx;
+    writingImage = image;
+    writingFrameRemoved = false;
+    lock.unlock();
+    std::memcpy(data, image.constBits(), nrBytes);
+    lock.relock();
+
+    scratchFile->unmap(data);
+    if (writingFrameRemoved)
+      freeSlots.append(writingSlot);
+    else
+    {
+      DEBUG_DISKCACHE("diskFrameCache::writePendingFrames frame %d to slot %d", frameIdx, writingSlot);
+      frameSlots.insert(frameIdx, writingSlot);
+      frameOrder.enqueue(frameIdx);
+    }
+    writingFrame = -1;
+    writingSlot = -1;
+    writingImage = QImage();
+    writingDone.wakeAll();
+  }
+  writerRunning = false;
+}
+
+uchar *diskFrameCache::reserveSlotLocked(int frameIdx, const QImage &image)
+{
+  if (image.size() != imageSize || image.format() != imageFormat || image.byteCount() != slotSize)
+  {
+    // The frame size or format changed. All frames in the file are useless.
+    clearLocked();
+    imageSize = image.size();
+    imageFormat = image.format();
+    slotSize = image.byteCount();
+  }
+
+  if (frameSlots.contains(frameIdx))
+    // The frame was put into the disk cache before and was read from it again. It is unchanged.
+    return nullptr;
+
+  if (!openScratchFile())
+    return nullptr;
+  const int slot = getFreeSlot();
+  if (slot < 0)
+    return nullptr;
+
+  const qint64 offset = slot * slotSize;
+  if (scratchFile->size() < offset + slotSize && !scratchFile->resize(offset + slotSize))
+  {
+    freeSlots.append(slot);
+    return nullptr;
+  }
+  uchar *data = scratchFile->map(offset, slotSize);
+  if (data == nullptr)
+  {
+    freeSlots.append(slot);
+    return nullptr;
+  }
+  writingSlot = slot;
+  return data;
+}
+
+QImage diskFrameCache::get(int frameIdx)
+{
+  QMutexLocker lock(&accessMutex);
+  auto pendingIt = pendingFrames.find(frameIdx);
+  if (pendingIt != pendingFrames.end())
+    // The frame was not written yet
+    return pendingIt.value();
+  if (writingFrame == frameIdx)
+    return writingImage;
+
+  auto it = frameSlots.find(frameIdx);
+  if (it == frameSlots.end() || !scratchFile)
+    return QImage();
+
+  QImage image(imageSize, imageFormat);
+  if (image.byteCount() != slotSize)
+    return QImage();
+  uchar *data = scratchFile->map(it.value() * slotSize, slotSize);
+  if (data == nullptr)
+    return QImage();
+  std::memcpy(image.bits(), data, slotSize);
+  scratchFile->unmap(data);
+
+  DEBUG_DISKCACHE("diskFrameCache::get frame %d from slot %d", frameIdx, it.value());
+  return image;
+}
+
+void diskFrameCache::remove(int frameIdx)
+{
+  QMutexLocker lock(&accessMutex);
+  if (pendingFrames.remove(frameIdx) > 0)
+    pendingOrder.removeOne(frameIdx);
+  if (writingFrame == frameIdx)
+    // The slot is freed when the copy is done
+    writingFrameRemoved = true;
+  auto it = frameSlots.find(frameIdx);
+  if (it == frameSlots.end())
+    return;
+  freeSlots.append(it.value());
+  frameSlots.erase(it);
+  frameOrder.removeOne(frameIdx);
+}
+
+void diskFrameCache::clear()
+{
+  QMutexLocker lock(&accessMutex);
+  pendingFrames.clear();
+  pendingOrder.clear();
+  clearLocked();
+}
+
+void diskFrameCache::clearLocked()
+{
+  // The file must not be removed while the background task copies a frame into it
+  while (writingFrame >= 0)
+    writingDone.wait(&accessMutex);
+
+  frameSlots.clear();
+  frameOrder.clear();
+  freeSlots.clear();
+  if (nrSlots > 0)
+  {
+    QMutexLocker settingsLock(&settingsMutex);
+    usedSize -= nrSlots * slotSize;
+  }
+  nrSlots = 0;
+  scratchFile.reset();
+}
+
+bool diskFrameCache::openScratchFile()
+{
+  if (scratchFile)
+    return true;
+
+  QString scratchPath;
+  {
+    QMutexLocker settingsLock(&settingsMutex);
+    scratchPath = path;
+  }
+  scratchFile.reset(new QTemporaryFile(QDir(scratchPath).filePath("YUView_frameCache_XXXXXX.tmp")));
+  if (!scratchFile->open())
+  {
+    DEBUG_DISKCACHE("diskFrameCache::openScratchFile Error opening a scratch file in %s", scratchPath.toLatin1().data());
+    scratchFile.reset();
+    return false;
+  }
+  return true;
+}
+
+int diskFrameCache::getFreeSlot()
+{
+  if (!freeSlots.isEmpty())
+    return freeSlots.takeLast();
+
+  {
+    // Can the file grow by another slot?
+    QMutexLocker settingsLock(&settingsMutex);
+    if (usedSize + slotSize <= maxSize)
+    {
+      usedSize += slotSize;
+      return nrSlots++;
+    }
+  }
+
+  // Overwrite the oldest frame
+  if (frameOrder.isEmpty())
+    return -1;
+  return frameSlots.take(frameOrder.dequeue());
+}
@@ -0,0 +1,121 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DISKFRAMECACHE_H
+#define DISKFRAMECACHE_H
+
+#include <QFuture>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+#include <QWaitCondition>
+
+/* The second tier of the frame cache of a videoHandler. Frames that are removed from the (memory) cache are written
+ * to a scratch file on disk. If such a frame is needed again, it is read back from the file instead of being loaded
+ * again. For coded video this is a disk read instead of decoding the GOP up to the frame.
+ * The scratch file is split into slots of the size of one frame and accessed through memory mappings. The size of all
+ * scratch files together is limited. If the limit is reached, the oldest frame of the cache is overwritten.
+ * Frames are written by a background task, so that evicting a frame from the memory cache does not wait for the disk.
+ * The disk cache is configured globally (enabled, scratch directory and size). All functions are thread save.
+ */
+class diskFrameCache
+{
+public:
+  diskFrameCache();
+  ~diskFrameCache();
+
+  // Set the global settings. If the disk cache is disabled, no new frames are added.
+  static void setSettings(bool enabled, const QString &scratchPath, qint64 maxBytes);
+  static bool isEnabled();
+
+  bool contains(int frameIdx) const;
+  // Queue the frame for writing to the scratch file (if it is not in there yet). The frame is written in the
+  // background. Until then, it can be read back from the queue. If too many frames are queued (the disk can not keep
+  // up), the oldest queued frames are dropped.
+  void add(int frameIdx, const QImage &image);
+  // Read the frame from the scratch file. Returns a null image if the frame is not in the disk cache.
+  QImage get(int frameIdx);
+  void remove(int frameIdx);
+  void clear();
+
+private:
+  // The background task that writes all queued frames to the scratch file
+  void writePendingFrames();
+
+  // The mutex must be locked for these
+  // Reserve a slot for the frame and map it. Returns nullptr if the frame can not (or does not have to) be written.
+  uchar *reserveSlotLocked(int frameIdx, const QImage &image);
+  void clearLocked();
+  bool openScratchFile();
+  int getFreeSlot();
+
+  mutable QMutex accessMutex;
+  QScopedPointer<QTemporaryFile> scratchFile;
+
+  // All frames in the file must have the same size and format. If this changes, the disk cache is cleared.
+  QSize imageSize;
+  QImage::Format imageFormat;
+  qint64 slotSize;
+  int nrSlots;
+
+  QMap<int, int> frameSlots;  // The slot that each frame is saved in
+  QQueue<int> frameOrder;     // The frames in the order in which they were written
+  QList<int> freeSlots;
+
+  // The frames that were added but are not written to the scratch file yet (and the order in which they were added)
+  QMap<int, QImage> pendingFrames;
+  QQueue<int> pendingOrder;
+  bool writerRunning;
+  QFuture<void> writerFuture;
+
+  // The frame that the background task copies into its slot right now. The copy is done without holding the mutex.
+  // Until it is done, the frame is read from writingImage and clearLocked waits for writingDone.
+  int writingFrame;
+  int writingSlot;
+  bool writingFrameRemoved;
+  QImage writingImage;
+  QWaitCondition writingDone;
+
+  // The global settings and the size of all scratch files (protected by settingsMutex)
+  static QMutex settingsMutex;
+  static bool enabled;
+  static QString path;
+  static qint64 maxSize;
+  static qint64 usedSize;
+};
+
+#endif // DISKFRAMECACHE_H
@@ -36,16 +36,17 @@
 #include <QDir>
 #include <QRegExp>
 #include <QSettings>
+#include <QThread>
 #include "typedef.h"
 
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
  
 #define FILESOURCE_DEBUG_SIMULATESLOWLOADING 0
-#if FILESOURCE_DEBUG_SIMULATESLOWLOADING && !NDEBUG
-#include <QThread>
-#endif
 
 fileSource::fileSource()
 {
@@ -74,8 +75,11 @@ bool fileSource::openFile(const QString &filePath)
   // Save the full file path
   fullFilePath = filePath;
 
-  // Install a watcher for the file (if file watching is active)
-  updateFileWatchSetting();
+  // Install a watcher for the file (if file watching is active). The watcher can only be used
+  // from the thread that owns it. If the file is opened in a background thread, the owner has
+  // to call updateFileWatchSetting() once the file is open.
+  if (QThread::currentThread() == thread())
+    updateFileWatchSetting();
 
   fileChanged = false;
 
@@ -325,4 +329,18 @@ void fileSource::clearFileCache()
   srcFile.setFileName(fullFilePath);
   srcFile.open(QIODevice::ReadOnly);
 #endif
-}
\ No newline at end of file
+}
+
+void fileSource::adviseWillNeed(qint64 startPos, qint64 nrBytes)
+{
+  if (!isFileOpened || nrBytes <= 0)
+    return;
+
+#ifdef Q_OS_LINUX
+  // The kernel starts reading the range asynchronously. Failing is not an error, the data is just not prefetched.
+  posix_fadvise(srcFile.handle(), startPos, nrBytes, POSIX_FADV_WILLNEED);
+#else
+  Q_UNUSED(startPos);
+  Q_UNUSED(nrBytes);
+#endif
+}
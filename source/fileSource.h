@@ -99,6 +99,10 @@ public:
   // Clear the cache of the file in the system. Currently only windows supported.
   void clearFileCache();
 
+  // Tell the system that the given range of the file will be read soon. The system can then start reading
+  // it in the background. This returns immediately. Currently only linux supported.
+  void adviseWillNeed(qint64 startPos, qint64 nrBytes);
+
 private slots:
   void fileSystemWatcherFileChanged(const QString &path) { Q_UNUSED(path); fileChanged = true; }
 
@@ -72,22 +72,19 @@ void fileSourceAVCAnnexBFile::parseAndAddNALUnit(int nalID)
   nalHeaderBytes.append(getCurByte());
   gotoNextByte();
 
-  // Create a new TreeItem root for the NAL unit. We don't set data (a name) for this item
-  // yet. We want to parse the item and then set a good description.
+  // The syntax elements are not saved while scanning. If the NAL unit is expanded in the NAL unit
+  // view, it is parsed again (parseNALUnitDetails).
   QString specificDescription;
-  TreeItem *nalRoot = nullptr;
-  if (!nalUnitModel.rootItem.isNull())
-    nalRoot = new TreeItem(nalUnitModel.rootItem.data());
 
   // Create a nal_unit and read the header
   nal_unit_avc nal_avc(curFilePos, nalID);
-  nal_avc.parse_nal_unit_header(nalHeaderBytes, nalRoot);
+  nal_avc.parse_nal_unit_header(nalHeaderBytes, nullptr);
 
   if (nal_avc.nal_unit_type == SPS)
   {
     // A sequence parameter set
     auto new_sps = QSharedPointer<sps>(new sps(nal_avc));
-    new_sps->parse_sps(getRemainingNALBytes(), nalRoot);
+    new_sps->parse_sps(getRemainingNALBytes(), nullptr);
       
     // Add sps (replace old one if existed)
     active_SPS_list.insert(new_sps->seq_parameter_set_id, new_sps);
@@ -105,7 +102,7 @@ void fileSourceAVCAnnexBFile::parseAndAddNALUnit(int nalID)
   {
     // A picture parameter set
     auto new_pps = QSharedPointer<pps>(new pps(nal_avc));
-    new_pps->parse_pps(getRemainingNALBytes(), nalRoot, active_SPS_list);
+    new_pps->parse_pps(getRemainingNALBytes(), nullptr, active_SPS_list);
       
     // Add pps (replace old one if existed)
     active_PPS_list.insert(new_pps->pic_parameter_set_id, new_pps);
@@ -120,7 +117,7 @@ void fileSourceAVCAnnexBFile::parseAndAddNALUnit(int nalID)
   {
     // Create a new slice unit
     auto new_slice = QSharedPointer<slice_header>(new slice_header(nal_avc));
-    new_slice->parse_slice_header(getRemainingNALBytes(), active_SPS_list, active_PPS_list, last_picture_first_slice, nalRoot);
+    new_slice->parse_slice_header(getRemainingNALBytes(), active_SPS_list, active_PPS_list, last_picture_first_slice, nullptr);
 
     if (!new_slice->bottom_field_flag && 
        (last_picture_first_slice.isNull() || new_slice->TopFieldOrderCnt != last_picture_first_slice->TopFieldOrderCnt) &&
@@ -130,6 +127,16 @@ void fileSourceAVCAnnexBFile::parseAndAddNALUnit(int nalID)
     // Add the POC of the slice
     specificDescription = QString(" POC %1").arg(new_slice->globalPOC);
 
+    // Add the slice to the picture summary. AVC has no temporal ID in the NAL header.
+    pictureSliceType sliceType = pictureSlice_Other;
+    if (new_slice->slice_type == slice_header::SLICE_I || new_slice->slice_type == slice_header::SLICE_SI)
+      sliceType = pictureSlice_I;
+    else if (new_slice->slice_type == slice_header::SLICE_P || new_slice->slice_type == slice_header::SLICE_SP)
+      sliceType = pictureSlice_P;
+    else if (new_slice->slice_type == slice_header::SLICE_B)
+      sliceType = pictureSlice_B;
+    addSliceToPictureStats(new_slice->first_mb_in_slice == 0, new_slice->globalPOC, sliceType, 0, new_slice->slice_qp_delta);
+
     // Get the poc and add it to the POC list
     if (new_slice->globalPOC >= 0)
       addPOCToList(new_slice->globalPOC);
@@ -143,36 +150,69 @@ void fileSourceAVCAnnexBFile::parseAndAddNALUnit(int nalID)
   }
   else if (nal_avc.nal_unit_type == SEI)
   {
-    // Create a new SEI
-    auto new_sei = QSharedPointer<sei>(new sei(nal_avc));
-    QByteArray sei_data = getRemainingNALBytes();
-    int nrBytes = new_sei->parse_sei_message(sei_data, nalRoot);
-    sei_data.remove(0, nrBytes);
+    // Parse the SEI
+    specificDescription = parseSEI(nal_avc, getRemainingNALBytes(), nullptr);
+  }
 
-    specificDescription = QString(" payloadType %1").arg(new_sei->payloadType);
-    if (!new_sei->payloadTypeName.isEmpty())
-      specificDescription += " - " + new_sei->payloadTypeName;
+  if (!nalUnitModel.rootItem.isNull())
+    // Add the NAL unit to the model with a useful name
+    nalUnitModel.addNALUnit(curFilePos, QString("NAL %1: %2").arg(nal_avc.nal_idx).arg(nal_unit_type_toString.value(nal_avc.nal_unit_type)) + specificDescription);
+}
 
-    if (new_sei->payloadType == 0)
-    {
-      auto new_buffering_period_sei = QSharedPointer<buffering_period_sei>(new buffering_period_sei(new_sei));
-      new_buffering_period_sei->parse_buffering_period_sei(sei_data, active_SPS_list, nalRoot);
-    }
-    else if (new_sei->payloadType == 1)
-    {
-      auto new_pic_timing_sei = QSharedPointer<pic_timing_sei>(new pic_timing_sei(new_sei));
-      new_pic_timing_sei->parse_pic_timing_sei(sei_data, active_SPS_list, CpbDpbDelaysPresentFlag, nalRoot);
-    }
-    else if (new_sei->payloadType == 5)
-    {
-      auto new_user_data_sei = QSharedPointer<user_data_sei>(new user_data_sei(new_sei));
-      new_user_data_sei->parse_user_data_sei(sei_data, nalRoot);
-    }
+QString fileSourceAVCAnnexBFile::parseSEI(const nal_unit_avc &nal_avc, QByteArray sei_data, TreeItem *nalRoot)
+{
+  // Create a new SEI
+  auto new_sei = QSharedPointer<sei>(new sei(nal_avc));
+  int nrBytes = new_sei->parse_sei_message(sei_data, nalRoot);
+  sei_data.remove(0, nrBytes);
+
+  QString specificDescription = QString(" payloadType %1").arg(new_sei->payloadType);
+  if (!new_sei->payloadTypeName.isEmpty())
+    specificDescription += " - " + new_sei->payloadTypeName;
+
+  if (new_sei->payloadType == 0)
+  {
+    auto new_buffering_period_sei = QSharedPointer<buffering_period_sei>(new buffering_period_sei(new_sei));
+    new_buffering_period_sei->parse_buffering_period_sei(sei_data, active_SPS_list, nalRoot);
+  }
+  else if (new_sei->payloadType == 1)
+  {
+    auto new_pic_timing_sei = QSharedPointer<pic_timing_sei>(new pic_timing_sei(new_sei));
+    new_pic_timing_sei->parse_pic_timing_sei(sei_data, active_SPS_list, CpbDpbDelaysPresentFlag, nalRoot);
+  }
+  else if (new_sei->payloadType == 5)
+  {
+    auto new_user_data_sei = QSharedPointer<user_data_sei>(new user_data_sei(new_sei));
+    new_user_data_sei->parse_user_data_sei(sei_data, nalRoot);
   }
 
-  if (nalRoot)
-    // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_avc.nal_idx).arg(nal_unit_type_toString.value(nal_avc.nal_unit_type)) + specificDescription);
+  return specificDescription;
+}
+
+void fileSourceAVCAnnexBFile::parseNALUnitDetails(const QByteArray &nalData, TreeItem *root)
+{
+  // Parse the NAL header (one byte)
+  nal_unit_avc nal_avc(0, -1);
+  nal_avc.parse_nal_unit_header(nalData.left(1), root);
+  const QByteArray payload = nalData.mid(1);
+
+  if (nal_avc.nal_unit_type == SPS)
+  {
+    sps new_sps(nal_avc);
+    new_sps.parse_sps(payload, root);
+  }
+  else if (nal_avc.nal_unit_type == PPS)
+  {
+    pps new_pps(nal_avc);
+    new_pps.parse_pps(payload, root, active_SPS_list);
+  }
+  else if (nal_avc.isSlice())
+  {
+    slice_header new_slice(nal_avc);
+    new_slice.parse_slice_header(payload, active_SPS_list, active_PPS_list, last_picture_first_slice, root);
+  }
+  else if (nal_avc.nal_unit_type == SEI)
+    parseSEI(nal_avc, payload, root);
 }
 
 const QStringList fileSourceAVCAnnexBFile::nal_unit_type_toString = QStringList()
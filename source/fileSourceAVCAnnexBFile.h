@@ -488,6 +488,10 @@ protected:
   static void read_scaling_list(sub_byte_reader &reader, int *scalingList, int sizeOfScalingList, bool *useDefaultScalingMatrixFlag, TreeItem *itemTree);
 
   void parseAndAddNALUnit(int nalID) Q_DECL_OVERRIDE;
+  void parseNALUnitDetails(const QByteArray &nalData, TreeItem *root) Q_DECL_OVERRIDE;
+
+  // Parse the SEI NAL and return a short description of it
+  QString parseSEI(const nal_unit_avc &nal_avc, QByteArray sei_data, TreeItem *nalRoot);
 
   // When we start to parse the bitstream we will remember the first RAP POC
   // so that we can disregard any possible RASL pictures.
@@ -31,6 +31,8 @@
 */
 
 #include "fileSourceAnnexBFile.h"
+
+#include <algorithm>
 #include "mainwindow.h"
 
 #define ANNEXBFILE_DEBUG_OUTPUT 0
@@ -41,6 +43,9 @@
 #define DEBUG_ANNEXB(fmt,...) ((void)0)
 #endif
 
+// The number of parsed NAL unit trees that the NALUnitModel keeps
+#define NAL_MODEL_PARSED_UNITS 32
+
 #define READFLAG(into) {into=(reader.readBits(1)!=0); if (itemTree) new TreeItem(#into,into,QString("u(1)"),(into!=0)?"1":"0",itemTree);}
 #define READBITS(into,numBits) {QString code; into=reader.readBits(numBits, &code); if (itemTree) new TreeItem(#into,into,QString("u(v) -> u(%1)").arg(numBits),code, itemTree);}
 
@@ -226,12 +231,13 @@ bool fileSourceAnnexBFile::sub_byte_reader::p_gotoNextByte()
   return true;
 }
 
-fileSourceAnnexBFile::fileSourceAnnexBFile()
+fileSourceAnnexBFile::fileSourceAnnexBFile() : nalUnitModel(this)
 {
   fileBuffer.resize(BUFFER_SIZE);
   posInBuffer = 0;
   bufferStartPosInFile = 0;
   numZeroBytes = 0;
+  curNALIsSlice = false;
   
   // Set the start code to look for (0x00 0x00 0x01)
   startCode.append((char)0);
@@ -269,9 +275,11 @@ bool fileSourceAnnexBFile::openFile(const QString &fileName, bool saveAllUnits,
   nalUnitListCopied = (otherFile != nullptr);
   if (otherFile)
   {
-    // Copy the nalUnitList and POC_List from the other file
+    // Copy the nalUnitList, POC_List, the random access points and the picture summary from the other file
     nalUnitList = otherFile->nalUnitList;
     POC_List = otherFile->POC_List;
+    randomAccessPointList = otherFile->randomAccessPointList;
+    pictureStatsList = otherFile->pictureStatsList;
     return true;
   }
   else
@@ -439,19 +447,107 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit()
   return QByteArray();
 }
 
+QByteArray fileSourceAnnexBFile::readNALUnitFromFile(quint64 filePos)
+{
+  // Read block by block until the next start code is found. The reading position of the
+  // file is restored so that the buffer of the scanner stays valid.
+  const qint64 oldPos = pos();
+  QByteArray nalData;
+  QByteArray block;
+  quint64 readPos = filePos;
+  int nalStart = -1;  // The position of the NAL header in nalData (after the start code)
+  while (true)
+  {
+    const qint64 nrBytes = readBytes(block, readPos, BUFFER_SIZE);
+    if (nrBytes <= 0)
+      break;
+    const int searchFrom = qMax(nalData.size() - 2, 0);
+    nalData.append(block.constData(), int(nrBytes));
+    readPos += nrBytes;
+    if (nalStart < 0)
+    {
+      // The file position may point to a 3 byte (00 00 01) or 4 byte (00 00 00 01) start code. Skip it.
+      const int idx = nalData.indexOf(startCode, searchFrom);
+      if (idx < 0)
+        continue;
+      nalStart = idx + 3;
+    }
+    const int idx = nalData.indexOf(startCode, qMax(searchFrom, nalStart));
+    if (idx >= 0)
+    {
+      nalData.truncate(idx);
+      break;
+    }
+  }
+  seek(oldPos);
+  if (nalStart < 0)
+    return QByteArray();
+  nalData.remove(0, nalStart);
+
+  // Remove the zeroes that belong to the next start code
+  while (nalData.endsWith(char(0)))
+    nalData.chop(1);
+  return nalData;
+}
+
 bool fileSourceAnnexBFile::addPOCToList(int poc)
 {
   if (poc < 0)
     return false;
 
-  if (POC_List.contains(poc))
+  if (POC_Set.contains(poc))
     // Two pictures with the same POC are not allowed
     return false;
   
+  POC_Set.insert(poc);
   POC_List.append(poc);
   return true;
 }
 
+int fileSourceAnnexBFile::getFrameIdxForPOC(int poc) const
+{
+  auto it = std::lower_bound(POC_List.constBegin(), POC_List.constEnd(), poc);
+  if (it == POC_List.constEnd() || *it != poc)
+    return -1;
+  return int(it - POC_List.constBegin());
+}
+
+void fileSourceAnnexBFile::addSliceToPictureStats(bool firstSliceInPicture, int poc, pictureSliceType sliceType, int temporalID, int sliceQPDelta)
+{
+  curNALIsSlice = true;
+  if (!firstSliceInPicture && !pictureStatsList.isEmpty())
+    // The size of the slice is added to the current picture
+    return;
+
+  pictureStats stats;
+  stats.poc = poc;
+  stats.nrBytes = 0;
+  stats.sliceType = sliceType;
+  stats.temporalID = temporalID;
+  stats.sliceQPDelta = sliceQPDelta;
+  pictureStatsList.append(stats);
+}
+
+void fileSourceAnnexBFile::buildRandomAccessPointList()
+{
+  randomAccessPointList.clear();
+  for (int i = 0; i < nalUnitList.count(); i++)
+  {
+    const nal_unit *nal = nalUnitList[i].data();
+    if (!nal->isParameterSet() && nal->getPOC() >= 0)
+    {
+      randomAccessPoint rap;
+      rap.poc = nal->getPOC();
+      rap.nalListIdx = i;
+      rap.filePos = nal->filePos;
+      randomAccessPointList.append(rap);
+    }
+  }
+  // The random access points should already be in POC order
+  std::stable_sort(randomAccessPointList.begin(), randomAccessPointList.end());
+  randomAccessPointList.squeeze();
+}
+
 bool fileSourceAnnexBFile::scanFileForNalUnits(bool saveAllUnits)
 {
   DEBUG_ANNEXB("fileSourceAnnexBFile::scanFileForNalUnits %s", saveAllUnits ? "saveAllUnits" : "");
@@ -484,8 +580,19 @@ bool fileSourceAnnexBFile::scanFileForNalUnits(bool saveAllUnits)
     // Create a new root for the nal unit tree of the QAbstractItemModel
     nalUnitModel.rootItem.reset(new TreeItem(QStringList() << "Name" << "Value" << "Coding" << "Code" << "Meaning", nullptr));
 
+  // The size of a NAL unit is known when the start code of the next NAL unit is found.
+  // The size of slice NAL units is added to the current picture.
+  quint64 lastNALStartPos = 0;
+  curNALIsSlice = false;
+
   while (seekToNextNALUnit()) 
   {
+    const quint64 nalStartPos = tell() - 3;
+    if (curNALIsSlice && !pictureStatsList.isEmpty())
+      pictureStatsList.last().nrBytes += quint32(nalStartPos - lastNALStartPos);
+    curNALIsSlice = false;
+    lastNALStartPos = nalStartPos;
+
     try
     {
       // Seek successfull. The file is now pointing to the first byte after the start code.
@@ -519,8 +626,17 @@ bool fileSourceAnnexBFile::scanFileForNalUnits(bool saveAllUnits)
   // We are done.
   progress.close();
 
-  // Sort the POC list
+  // Add the size of the last NAL unit
+  if (curNALIsSlice && !pictureStatsList.isEmpty())
+    pictureStatsList.last().nrBytes += quint32(getFileSize() - lastNALStartPos);
+  curNALIsSlice = false;
+  pictureStatsList.squeeze();
+
+  // Sort the POC list. The hash was only needed for the duplicate check while scanning.
   std::sort(POC_List.begin(), POC_List.end());
+  POC_List.squeeze();
+  POC_Set.clear();
+  buildRandomAccessPointList();
     
   return true;
 }
@@ -535,20 +651,15 @@ int fileSourceAnnexBFile::getClosestSeekableFrameNumber(int frameIdx) const
   // We schould always be able to seek to the beginning of the file
   int bestSeekPOC = POC_List[0];
 
-  for (auto nal : nalUnitList)
-  {
-    if (!nal->isParameterSet() && nal->getPOC() >= 0) 
-    {
-      if (nal->getPOC() <= iPOC)
-        // We could seek here
-        bestSeekPOC = nal->getPOC();
-      else
-        break;
-    }
-  }
+  // Find the last random access point with a POC smaller or equal to the POC of the frame
+  randomAccessPoint search;
+  search.poc = iPOC;
+  auto it = std::upper_bound(randomAccessPointList.constBegin(), randomAccessPointList.constEnd(), search);
+  if (it != randomAccessPointList.constBegin())
+    bestSeekPOC = (it - 1)->poc;
 
   // Get the frame index for the given POC
-  return POC_List.indexOf(bestSeekPOC);
+  return getFrameIdxForPOC(bestSeekPOC);
 }
 
 QList<QByteArray> fileSourceAnnexBFile::seekToFrameNumber(int iFrameNr)
@@ -556,36 +667,33 @@ QList<QByteArray> fileSourceAnnexBFile::seekToFrameNumber(int iFrameNr)
   // Get the POC for the frame number
   int iPOC = POC_List[iFrameNr];
 
+  // Find the random access point with the POC
+  randomAccessPoint search;
+  search.poc = iPOC;
+  auto it = std::lower_bound(randomAccessPointList.constBegin(), randomAccessPointList.constEnd(), search);
+  if (it == randomAccessPointList.constEnd() || it->poc != iPOC)
+    return QList<QByteArray>();
+
   // A list of all parameter sets up to the random access point with the given frame number.
   QList<QByteArray> paramSets;
-  
-  for (auto nal : nalUnitList)
-  {
-    if (nal->isParameterSet())
-    {
+  for (int i = 0; i < it->nalListIdx; i++)
+    if (nalUnitList[i]->isParameterSet())
       // Append the raw parameter set to the return array
-      paramSets.append(nal->getRawNALData());
-    }
-    else if (nal->getPOC() >= 0)
-    {
-      if (nal->getPOC() == iPOC) 
-      {
-        // Seek here
-        seekToFilePos(nal->filePos);
+      paramSets.append(nalUnitList[i]->getRawNALData());
 
-        // Return the parameter sets that we encountered so far.
-        return paramSets;
-      }
-    }
-  }
-
-  return QList<QByteArray>();
+  // Seek here and return the parameter sets that we encountered so far.
+  seekToFilePos(it->filePos);
+  return paramSets;
 }
 
 void fileSourceAnnexBFile::clearData()
 {
+  nalUnitModel.clear();
   nalUnitList.clear();
   POC_List.clear();
+  POC_Set.clear();
+  randomAccessPointList.clear();
+  pictureStatsList.clear();
 
   // Reset all internal values
   fileBuffer.clear();
@@ -604,10 +712,9 @@ QVariant fileSourceAnnexBFile::NALUnitModel::headerData(int section, Qt::Orienta
   return QVariant();
 }
 
+// The top level items (the NAL units) have no internal pointer. All items below point to their TreeItem.
 QVariant fileSourceAnnexBFile::NALUnitModel::data(const QModelIndex &index, int role) const
 {
-  //qDebug() << "ileSourceHEVCAnnexBFile::data " << index;
-
   if (!index.isValid())
     return QVariant();
 
@@ -615,23 +722,25 @@ QVariant fileSourceAnnexBFile::NALUnitModel::data(const QModelIndex &index, int
     return QVariant();
 
   TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+  if (item == nullptr)
+    return (index.column() == 0) ? QVariant(nalUnits.value(index.row()).name) : QVariant();
 
   return QVariant(item->itemData.value(index.column()));
 }
 
 QModelIndex fileSourceAnnexBFile::NALUnitModel::index(int row, int column, const QModelIndex &parent) const
 {
-  //qDebug() << "ileSourceHEVCAnnexBFile::index " << row << column << parent;
-
   if (!hasIndex(row, column, parent))
     return QModelIndex();
 
-  TreeItem *parentItem;
-
   if (!parent.isValid())
-    parentItem = rootItem.data();
-  else
-    parentItem = static_cast<TreeItem*>(parent.internalPointer());
+    // A NAL unit
+    return createIndex(row, column, nullptr);
+
+  TreeItem *parentItem = static_cast<TreeItem*>(parent.internalPointer());
+  if (parentItem == nullptr)
+    // The parent is a NAL unit. Get the root of the parsed tree.
+    parentItem = parsedUnits.value(parent.row(), nullptr);
 
   if (parentItem == nullptr)
     return QModelIndex();
@@ -645,38 +754,125 @@ QModelIndex fileSourceAnnexBFile::NALUnitModel::index(int row, int column, const
 
 QModelIndex fileSourceAnnexBFile::NALUnitModel::parent(const QModelIndex &index) const
 {
-  //qDebug() << "ileSourceHEVCAnnexBFile::parent " << index;
-
   if (!index.isValid())
     return QModelIndex();
 
   TreeItem *childItem = static_cast<TreeItem*>(index.internalPointer());
-  TreeItem *parentItem = childItem->parentItem;
-
-  if (parentItem == rootItem.data())
+  if (childItem == nullptr)
+    // A NAL unit
     return QModelIndex();
 
-  // Get the row of the item in the list of children of the parent item
-  int row = 0;
-  if (parentItem)
-    row = parentItem->parentItem->childItems.indexOf(const_cast<TreeItem*>(parentItem));
+  TreeItem *parentItem = childItem->parentItem;
+  if (parentItem->parentItem == nullptr)
+    // The parent is the root of a parsed tree. This is the NAL unit item.
+    return createIndex(parsedUnits.key(parentItem, -1), 0, nullptr);
 
+  // Get the row of the item in the list of children of the parent item
+  int row = parentItem->parentItem->childItems.indexOf(parentItem);
   return createIndex(row, 0, parentItem);
-
 }
 
 int fileSourceAnnexBFile::NALUnitModel::rowCount(const QModelIndex &parent) const
 {
-  //qDebug() << "ileSourceHEVCAnnexBFile::rowCount " << parent;
-
-  TreeItem *parentItem;
   if (parent.column() > 0)
     return 0;
 
   if (!parent.isValid())
-    parentItem = rootItem.data();
-  else
-    parentItem = static_cast<TreeItem*>(parent.internalPointer());
+    return nalUnits.count();
+
+  TreeItem *parentItem = static_cast<TreeItem*>(parent.internalPointer());
+  if (parentItem == nullptr)
+  {
+    parentItem = parsedUnits.value(parent.row(), nullptr);
+    if (parentItem != nullptr)
+      markParsedUnitUsed(parent.row());
+  }
 
   return (parentItem == nullptr) ? 0 : parentItem->childItems.count();
-}
\ No newline at end of file
+}
+
+bool fileSourceAnnexBFile::NALUnitModel::hasChildren(const QModelIndex &parent) const
+{
+  // Every NAL unit has children. They are parsed when the unit is expanded.
+  if (parent.isValid() && parent.column() == 0 && parent.internalPointer() == nullptr)
+    return true;
+  return QAbstractItemModel::hasChildren(parent);
+}
+
+bool fileSourceAnnexBFile::NALUnitModel::canFetchMore(const QModelIndex &parent) const
+{
+  return parent.isValid() && parent.internalPointer() == nullptr && !parsedUnits.contains(parent.row());
+}
+
+void fileSourceAnnexBFile::NALUnitModel::fetchMore(const QModelIndex &parent)
+{
+  const int row = parent.row();
+  if (parent.isValid() && parent.internalPointer() == nullptr && parsedUnits.contains(row))
+  {
+    // The unit is already parsed. It is now the most recently used one.
+    markParsedUnitUsed(row);
+    return;
+  }
+  if (!canFetchMore(parent))
+    return;
+
+  // Read the NAL unit from the file again and parse it
+  TreeItem *unitRoot = new TreeItem(nullptr);
+  try
+  {
+    source->parseNALUnitDetails(source->readNALUnitFromFile(nalUnits[row].filePos), unitRoot);
+  }
+  catch (...)
+  {
+    // Keep what could be parsed so far
+    new TreeItem("Error parsing the NAL unit", unitRoot);
+  }
+
+  const int nrChildren = unitRoot->childItems.count();
+  if (nrChildren > 0)
+    beginInsertRows(parent, 0, nrChildren - 1);
+  parsedUnits.insert(row, unitRoot);
+  parsedUnitsOrder.append(row);
+  if (nrChildren > 0)
+    endInsertRows();
+
+  // Drop the trees of the units that were expanded the longest time ago
+  while (parsedUnitsOrder.count() > NAL_MODEL_PARSED_UNITS)
+  {
+    const int oldRow = parsedUnitsOrder.takeFirst();
+    TreeItem *oldRoot = parsedUnits.value(oldRow);
+    const int nrOldChildren = oldRoot->childItems.count();
+    if (nrOldChildren > 0)
+      beginRemoveRows(createIndex(oldRow, 0, nullptr), 0, nrOldChildren - 1);
+    parsedUnits.remove(oldRow);
+    if (nrOldChildren > 0)
+      endRemoveRows();
+    delete oldRoot;
+  }
+}
+
+void fileSourceAnnexBFile::NALUnitModel::markParsedUnitUsed(int row) const
+{
+  if (!parsedUnitsOrder.isEmpty() && parsedUnitsOrder.last() == row)
+    return;
+  parsedUnitsOrder.removeOne(row);
+  parsedUnitsOrder.append(row);
+}
+
+void fileSourceAnnexBFile::NALUnitModel::addNALUnit(quint64 filePos, const QString &name)
+{
+  nalUnitEntry entry;
+  entry.filePos = filePos;
+  entry.name = name;
+  nalUnits.append(entry);
+}
+
+void fileSourceAnnexBFile::NALUnitModel::clear()
+{
+  beginResetModel();
+  nalUnits.clear();
+  qDeleteAll(parsedUnits);
+  parsedUnits.clear();
+  parsedUnitsOrder.clear();
+  endResetModel();
+}
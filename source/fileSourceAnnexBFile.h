@@ -34,6 +34,9 @@
 #define FILESOURCEANNEXBFILE_H
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QSet>
+#include <QVector>
 #include "fileSource.h"
 #include "videoHandlerYUV.h"
 
@@ -101,6 +104,19 @@ public:
   // Get a pointer to the nal unit model
   QAbstractItemModel *getNALUnitModel() { return &nalUnitModel; }
 
+  // A short summary of every coded picture. This is collected while scanning the file.
+  enum pictureSliceType { pictureSlice_I, pictureSlice_P, pictureSlice_B, pictureSlice_Other };
+  struct pictureStats
+  {
+    int poc;
+    quint32 nrBytes;    //< The size of all slice NAL units of the picture (including start codes)
+    qint8 sliceType;    //< The slice type of the first slice (pictureSliceType)
+    qint8 temporalID;
+    qint8 sliceQPDelta; //< The slice_qp_delta of the first slice
+  };
+  // Get the summary of all pictures in coding order
+  const QVector<pictureStats> &getPictureStats() const { return pictureStatsList; }
+
 protected:
   // ----- Some nested classes that are only used in the scope of this file handler class
 
@@ -127,10 +143,15 @@ protected:
     TreeItem *parentItem;
   };
 
+  /* The model only saves the position and a name of every NAL unit. The syntax elements of a NAL unit are
+   * parsed (parseNALUnitDetails) when the unit is expanded in the view for the first time. Only the trees of the
+   * most recently expanded units are kept.
+  */
   class NALUnitModel : public QAbstractItemModel
   {
   public:
-    NALUnitModel() {}
+    NALUnitModel(fileSourceAnnexBFile *source) : source(source) {}
+    ~NALUnitModel() { qDeleteAll(parsedUnits); }
 
     // The functions that must be overridden from the QAbstractItemModel
     virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
@@ -140,8 +161,35 @@ protected:
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
     virtual int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE { Q_UNUSED(parent); return 5; }
 
-    // The root of the tree
+    // The NAL units are parsed on demand when they are expanded
+    virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual bool canFetchMore(const QModelIndex &parent) const Q_DECL_OVERRIDE;
+    virtual void fetchMore(const QModelIndex &parent) Q_DECL_OVERRIDE;
+
+    // Add a NAL unit at the given file position (the first byte of the start code) with the given name.
+    void addNALUnit(quint64 filePos, const QString &name);
+    // Remove all NAL units
+    void clear();
+
+    // The root of the tree. This only holds the header. Saving of NAL units is active if this is set.
     QScopedPointer<TreeItem> rootItem;
+
+  private:
+    struct nalUnitEntry
+    {
+      quint64 filePos;
+      QString name;
+    };
+    QVector<nalUnitEntry> nalUnits;
+
+    // The parsed trees of the most recently used units (the row in nalUnits is the key). The order is from the
+    // least to the most recently used unit.
+    QHash<int, TreeItem*> parsedUnits;
+    mutable QList<int> parsedUnitsOrder;
+    // Move the given parsed unit to the back of parsedUnitsOrder
+    void markParsedUnitUsed(int row) const;
+
+    fileSourceAnnexBFile *source;
   };
   NALUnitModel nalUnitModel;
 
@@ -212,11 +260,15 @@ protected:
   quint64      bufferStartPosInFile; ///< The byte position in the file of the start of the currently loaded buffer
   int          numZeroBytes;         ///< The number of zero bytes that occured. (This will be updated by gotoNextByte() and seekToNextNALUnit()
 
-  // A list of all POCs in the sequence (in coding order). POC's don't have to be consecutive, so the only
+  // A list of all POCs in the sequence (sorted after scanning). POC's don't have to be consecutive, so the only
   // way to know how many pictures are in a sequences is to keep a list of all POCs.
-  QList<int> POC_List;
+  QVector<int> POC_List;
+  // While scanning, all POCs are also kept in a hash so that duplicates are found in constant time.
+  QSet<int> POC_Set;
   // Returns false if the POC was already present int the list
   bool addPOCToList(int poc);
+  // Get the frame index of the given POC (binary search in the sorted POC_List). -1 if not found.
+  int getFrameIdxForPOC(int poc) const;
 
   // The start code pattern
   QByteArray startCode;
@@ -227,6 +279,25 @@ protected:
   QList<QSharedPointer<nal_unit>> nalUnitList;
   bool nalUnitListCopied;       //< If this list was copied (another file was porovided when opening the file) we don't own the pointers in this list.
 
+  // The per picture summary (in coding order)
+  QVector<pictureStats> pictureStatsList;
+  // Add a slice to the summary. This should be called by parseAndAddNALUnit for every slice. If firstSliceInPicture is set,
+  // a new picture is started. The NAL unit size is added by scanFileForNalUnits.
+  void addSliceToPictureStats(bool firstSliceInPicture, int poc, pictureSliceType sliceType, int temporalID, int sliceQPDelta);
+  bool curNALIsSlice;
+
+  // A compact list of all random access points sorted by POC. This is filled from the nalUnitList after scanning
+  // so that we can find the closest random access point for a frame using a binary search.
+  struct randomAccessPoint
+  {
+    int poc;
+    int nalListIdx;   //< The index of the RAP NAL in the nalUnitList
+    quint64 filePos;  //< The file position of the RAP NAL
+    bool operator<(const randomAccessPoint &other) const { return poc < other.poc; }
+  };
+  QVector<randomAccessPoint> randomAccessPointList;
+  void buildRandomAccessPointList();
+
   // Scan the file NAL by NAL. Keep track of all possible random access points and parameter sets in
   // nalUnitList. Also collect a list of all POCs in coding order in POC_List.
   // If saving is activated, all NAL data is saved to be used by the QAbstractItemModel.
@@ -234,8 +305,16 @@ protected:
 
   // The bitstream is at the start of a nal unit. This function should be overloaded and parse the NAL unit header
   // and whatever the NAL unit may contain. Finally it should add the unit to the nalUnitList (if it is a parameter set or an RA point).
+  // If saving of all units is active, the unit should be added to the nalUnitModel.
   virtual void parseAndAddNALUnit(int nalID) = 0;
 
+  // Parse the given NAL unit (NAL header and payload without the start code) and add all syntax elements to the
+  // given tree. This must not change the state of the parser. The parameter sets known after scanning are used.
+  virtual void parseNALUnitDetails(const QByteArray &nalData, TreeItem *root) = 0;
+
+  // Read the NAL unit that starts at the given file position (the first byte of the start code). The start code is not returned.
+  QByteArray readNALUnitFromFile(quint64 filePos);
+
   // Clear all knowledge about the bitstream.
   void clearData();
 
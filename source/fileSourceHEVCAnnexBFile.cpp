@@ -363,15 +363,7 @@ void fileSourceHEVCAnnexBFile::pred_weight_table::parse_pred_weight_table(sub_by
   }
 }
 
-int fileSourceHEVCAnnexBFile::st_ref_pic_set::NumNegativePics[65];
-int fileSourceHEVCAnnexBFile::st_ref_pic_set::NumPositivePics[65];
-int fileSourceHEVCAnnexBFile::st_ref_pic_set::DeltaPocS0[65][16];
-int fileSourceHEVCAnnexBFile::st_ref_pic_set::DeltaPocS1[65][16];
-bool fileSourceHEVCAnnexBFile::st_ref_pic_set::UsedByCurrPicS0[65][16];
-bool fileSourceHEVCAnnexBFile::st_ref_pic_set::UsedByCurrPicS1[65][16];
-int fileSourceHEVCAnnexBFile::st_ref_pic_set::NumDeltaPocs[65];
-
-void fileSourceHEVCAnnexBFile::st_ref_pic_set::parse_st_ref_pic_set(sub_byte_reader &reader, int stRpsIdx, sps *actSPS, TreeItem *root)
+void fileSourceHEVCAnnexBFile::st_ref_pic_set::parse_st_ref_pic_set(sub_byte_reader &reader, int stRpsIdx, sps *actSPS, parsing_state *state, TreeItem *root)
 {
   // Create a new TreeItem root for the item
   // The macros will use this variable to add all the parsed variables
@@ -397,7 +389,7 @@ void fileSourceHEVCAnnexBFile::st_ref_pic_set::parse_st_ref_pic_set(sub_byte_rea
     LOGVAL(RefRpsIdx);
     LOGVAL(deltaRps);
 
-    for(int j=0; j<=NumDeltaPocs[RefRpsIdx]; j++)
+    for(int j=0; j<=state->NumDeltaPocs[RefRpsIdx]; j++)
     {
       READFLAG_A(used_by_curr_pic_flag, j);
       use_delta_flag.append(true); // Infer to 1
@@ -407,64 +399,64 @@ void fileSourceHEVCAnnexBFile::st_ref_pic_set::parse_st_ref_pic_set(sub_byte_rea
 
     // Derive NumNegativePics Rec. ITU-T H.265 v3 (04/2015) (7-59)
     int i = 0;
-    for(int j=NumPositivePics[RefRpsIdx] - 1; j >= 0; j--)
+    for(int j=state->NumPositivePics[RefRpsIdx] - 1; j >= 0; j--)
     {
-      int dPoc = DeltaPocS1[RefRpsIdx][j] + deltaRps;
-      if(dPoc < 0 && use_delta_flag[NumNegativePics[RefRpsIdx] + j]) 
+      int dPoc = state->DeltaPocS1[RefRpsIdx][j] + deltaRps;
+      if(dPoc < 0 && use_delta_flag[state->NumNegativePics[RefRpsIdx] + j]) 
       { 
-        DeltaPocS0[stRpsIdx][i] = dPoc;
+        state->DeltaPocS0[stRpsIdx][i] = dPoc;
         LOGSTRVAL(QString("DeltaPocS0[%1][%2]").arg(stRpsIdx).arg(i), dPoc);
-        UsedByCurrPicS0[stRpsIdx][i++] = used_by_curr_pic_flag[NumNegativePics[RefRpsIdx] + j];
+        state->UsedByCurrPicS0[stRpsIdx][i++] = used_by_curr_pic_flag[state->NumNegativePics[RefRpsIdx] + j];
       }
     }
-    if(deltaRps < 0 && use_delta_flag[NumDeltaPocs[RefRpsIdx]])
+    if(deltaRps < 0 && use_delta_flag[state->NumDeltaPocs[RefRpsIdx]])
     { 
-      DeltaPocS0[stRpsIdx][i] = deltaRps;
+      state->DeltaPocS0[stRpsIdx][i] = deltaRps;
       LOGSTRVAL(QString("DeltaPocS0[%1][%2]").arg(stRpsIdx).arg(i), deltaRps);
-      UsedByCurrPicS0[stRpsIdx][i++] = used_by_curr_pic_flag[NumDeltaPocs[RefRpsIdx]];
+      state->UsedByCurrPicS0[stRpsIdx][i++] = used_by_curr_pic_flag[state->NumDeltaPocs[RefRpsIdx]];
     }
-    for(int j=0; j<NumNegativePics[RefRpsIdx]; j++)
+    for(int j=0; j<state->NumNegativePics[RefRpsIdx]; j++)
     { 
-      int dPoc = DeltaPocS0[RefRpsIdx][j] + deltaRps;
+      int dPoc = state->DeltaPocS0[RefRpsIdx][j] + deltaRps;
       if(dPoc < 0 && use_delta_flag[j])
       { 
-        DeltaPocS0[stRpsIdx][i] = dPoc;
+        state->DeltaPocS0[stRpsIdx][i] = dPoc;
         LOGSTRVAL(QString("DeltaPocS0[%1][%2]").arg(stRpsIdx).arg(i), dPoc);
-        UsedByCurrPicS0[stRpsIdx][i++] = used_by_curr_pic_flag[j];
+        state->UsedByCurrPicS0[stRpsIdx][i++] = used_by_curr_pic_flag[j];
       } 
     } 
-    NumNegativePics[stRpsIdx] = i;
+    state->NumNegativePics[stRpsIdx] = i;
     LOGSTRVAL(QString("NumNegativePics[%1]").arg(stRpsIdx), i);
 
     // Derive NumPositivePics Rec. ITU-T H.265 v3 (04/2015) (7-60)
     i = 0;
-    for(int j=NumNegativePics[RefRpsIdx] - 1; j>=0; j--)
+    for(int j=state->NumNegativePics[RefRpsIdx] - 1; j>=0; j--)
     { 
-      int dPoc = DeltaPocS0[RefRpsIdx][j] + deltaRps;
+      int dPoc = state->DeltaPocS0[RefRpsIdx][j] + deltaRps;
       if(dPoc > 0 && use_delta_flag[j])
       { 
-        DeltaPocS1[stRpsIdx][i] = dPoc;
+        state->DeltaPocS1[stRpsIdx][i] = dPoc;
         LOGSTRVAL(QString("DeltaPocS1[%1][%2]").arg(stRpsIdx).arg(i), dPoc);
-        UsedByCurrPicS1[stRpsIdx][i++] = used_by_curr_pic_flag[j];
+        state->UsedByCurrPicS1[stRpsIdx][i++] = used_by_curr_pic_flag[j];
       }
     }
-    if(deltaRps > 0 && use_delta_flag[NumDeltaPocs[RefRpsIdx]])
+    if(deltaRps > 0 && use_delta_flag[state->NumDeltaPocs[RefRpsIdx]])
     {
-      DeltaPocS1[stRpsIdx][i] = deltaRps;
+      state->DeltaPocS1[stRpsIdx][i] = deltaRps;
       LOGSTRVAL(QString("DeltaPocS1[%1][%2]").arg(stRpsIdx).arg(i), deltaRps);
-      UsedByCurrPicS1[stRpsIdx][i++] = used_by_curr_pic_flag[NumDeltaPocs[RefRpsIdx]];
+      state->UsedByCurrPicS1[stRpsIdx][i++] = used_by_curr_pic_flag[state->NumDeltaPocs[RefRpsIdx]];
     }
-    for(int j=0; j<NumPositivePics[RefRpsIdx]; j++)
+    for(int j=0; j<state->NumPositivePics[RefRpsIdx]; j++)
     { 
-      int dPoc = DeltaPocS1[RefRpsIdx][j] + deltaRps;
-      if(dPoc > 0 && use_delta_flag[NumNegativePics[RefRpsIdx] + j])
+      int dPoc = state->DeltaPocS1[RefRpsIdx][j] + deltaRps;
+      if(dPoc > 0 && use_delta_flag[state->NumNegativePics[RefRpsIdx] + j])
       { 
-        DeltaPocS1[stRpsIdx][i] = dPoc;
+        state->DeltaPocS1[stRpsIdx][i] = dPoc;
         LOGSTRVAL(QString("DeltaPocS1[%1][%2]").arg(stRpsIdx).arg(i), dPoc);
-        UsedByCurrPicS1[stRpsIdx][i++] = used_by_curr_pic_flag[NumNegativePics[RefRpsIdx] + j] ;
+        state->UsedByCurrPicS1[stRpsIdx][i++] = used_by_curr_pic_flag[state->NumNegativePics[RefRpsIdx] + j] ;
       }
     }
-    NumPositivePics[stRpsIdx] = i;
+    state->NumPositivePics[stRpsIdx] = i;
     LOGSTRVAL(QString("NumPositivePics[%1]").arg(stRpsIdx), i);
   }
   else
@@ -477,12 +469,12 @@ void fileSourceHEVCAnnexBFile::st_ref_pic_set::parse_st_ref_pic_set(sub_byte_rea
       READFLAG_A(used_by_curr_pic_s0_flag, i);
       
       if (i==0)
-        DeltaPocS0[stRpsIdx][i] = -(delta_poc_s0_minus1.last() + 1); // (7-65)
+        state->DeltaPocS0[stRpsIdx][i] = -(delta_poc_s0_minus1.last() + 1); // (7-65)
       else
-        DeltaPocS0[stRpsIdx][i] = DeltaPocS0[stRpsIdx][i-1] - (delta_poc_s0_minus1.last() + 1); // (7-67)
-      LOGSTRVAL(QString("DeltaPocS0[%1][%2]").arg(stRpsIdx).arg(i), DeltaPocS0[stRpsIdx][i]);
-      UsedByCurrPicS0[stRpsIdx][i] = used_by_curr_pic_s0_flag[i];
-      LOGSTRVAL(QString("UsedByCurrPicS0[%1][%2]").arg(stRpsIdx).arg(i), UsedByCurrPicS0[stRpsIdx][i]);
+        state->DeltaPocS0[stRpsIdx][i] = state->DeltaPocS0[stRpsIdx][i-1] - (delta_poc_s0_minus1.last() + 1); // (7-67)
+      LOGSTRVAL(QString("DeltaPocS0[%1][%2]").arg(stRpsIdx).arg(i), state->DeltaPocS0[stRpsIdx][i]);
+      state->UsedByCurrPicS0[stRpsIdx][i] = used_by_curr_pic_s0_flag[i];
+      LOGSTRVAL(QString("UsedByCurrPicS0[%1][%2]").arg(stRpsIdx).arg(i), state->UsedByCurrPicS0[stRpsIdx][i]);
     }
     for(int i = 0; i < num_positive_pics; i++)
     {
@@ -490,32 +482,32 @@ void fileSourceHEVCAnnexBFile::st_ref_pic_set::parse_st_ref_pic_set(sub_byte_rea
       READFLAG_A(used_by_curr_pic_s1_flag, i);
 
       if (i==0)
-        DeltaPocS1[stRpsIdx][i] = delta_poc_s1_minus1.last() + 1; // (7-66)
+        state->DeltaPocS1[stRpsIdx][i] = delta_poc_s1_minus1.last() + 1; // (7-66)
       else
-        DeltaPocS1[stRpsIdx][i] = DeltaPocS1[stRpsIdx][i-1] + (delta_poc_s1_minus1.last() + 1); // (7-68)
-      LOGSTRVAL(QString("DeltaPocS1[%1][%2]").arg(stRpsIdx).arg(i), DeltaPocS1[stRpsIdx][i]);
-      UsedByCurrPicS1[stRpsIdx][i] = used_by_curr_pic_s1_flag[i];
-      LOGSTRVAL(QString("UsedByCurrPicS1[%1][%2]").arg(stRpsIdx).arg(i), UsedByCurrPicS1[stRpsIdx][i]);
+        state->DeltaPocS1[stRpsIdx][i] = state->DeltaPocS1[stRpsIdx][i-1] + (delta_poc_s1_minus1.last() + 1); // (7-68)
+      LOGSTRVAL(QString("DeltaPocS1[%1][%2]").arg(stRpsIdx).arg(i), state->DeltaPocS1[stRpsIdx][i]);
+      state->UsedByCurrPicS1[stRpsIdx][i] = used_by_curr_pic_s1_flag[i];
+      LOGSTRVAL(QString("UsedByCurrPicS1[%1][%2]").arg(stRpsIdx).arg(i), state->UsedByCurrPicS1[stRpsIdx][i]);
     }
 
-    NumNegativePics[stRpsIdx] = num_negative_pics;
-    NumPositivePics[stRpsIdx] = num_positive_pics;
+    state->NumNegativePics[stRpsIdx] = num_negative_pics;
+    state->NumPositivePics[stRpsIdx] = num_positive_pics;
     LOGSTRVAL(QString("NumNegativePics[%1]").arg(stRpsIdx), num_negative_pics);
     LOGSTRVAL(QString("NumPositivePics[%1]").arg(stRpsIdx), num_positive_pics);
   }
 
-  NumDeltaPocs[stRpsIdx] = NumNegativePics[stRpsIdx] + NumPositivePics[stRpsIdx]; // (7-69)
+  state->NumDeltaPocs[stRpsIdx] = state->NumNegativePics[stRpsIdx] + state->NumPositivePics[stRpsIdx]; // (7-69)
 }
 
 // (7-55)
-int fileSourceHEVCAnnexBFile::st_ref_pic_set::NumPicTotalCurr(int CurrRpsIdx, slice *actSlice)
+int fileSourceHEVCAnnexBFile::st_ref_pic_set::NumPicTotalCurr(int CurrRpsIdx, slice *actSlice, parsing_state *state)
 {
   int NumPicTotalCurr = 0;
-  for(int i = 0; i < NumNegativePics[CurrRpsIdx]; i++)
-    if(UsedByCurrPicS0[CurrRpsIdx][i])
+  for(int i = 0; i < state->NumNegativePics[CurrRpsIdx]; i++)
+    if(state->UsedByCurrPicS0[CurrRpsIdx][i])
       NumPicTotalCurr++ ;
-  for(int i = 0; i < NumPositivePics[CurrRpsIdx]; i++)  
-    if(UsedByCurrPicS1[CurrRpsIdx][i]) 
+  for(int i = 0; i < state->NumPositivePics[CurrRpsIdx]; i++)  
+    if(state->UsedByCurrPicS1[CurrRpsIdx][i]) 
       NumPicTotalCurr++;
   for(int i = 0; i < actSlice->num_long_term_sps + actSlice->num_long_term_pics; i++) 
     if(actSlice->UsedByCurrPicLt[i])
@@ -748,7 +740,7 @@ fileSourceHEVCAnnexBFile::sps::sps(const nal_unit_hevc &nal) : nal_unit_hevc(nal
   sps_extension_5bits = 0;
 }
 
-void fileSourceHEVCAnnexBFile::sps::parse_sps(const QByteArray &parameterSetData, TreeItem *root)
+void fileSourceHEVCAnnexBFile::sps::parse_sps(const QByteArray &parameterSetData, parsing_state *state, TreeItem *root)
 {
   nalPayload = parameterSetData;
   
@@ -836,7 +828,7 @@ void fileSourceHEVCAnnexBFile::sps::parse_sps(const QByteArray &parameterSetData
   for(int i=0; i<num_short_term_ref_pic_sets; i++)
   {
     sps_st_ref_pic_sets.append(st_ref_pic_set());
-    sps_st_ref_pic_sets.last().parse_st_ref_pic_set(reader, i, this, itemTree);
+    sps_st_ref_pic_sets.last().parse_st_ref_pic_set(reader, i, this, state, itemTree);
   }
 
   READFLAG(long_term_ref_pics_present_flag);
@@ -1055,11 +1047,6 @@ void fileSourceHEVCAnnexBFile::ref_pic_lists_modification::parse_ref_pic_lists_m
   }
 }
 
-// Initialize static member. Only true for the first slice instance
-bool fileSourceHEVCAnnexBFile::slice::bFirstAUInDecodingOrder = true;
-int fileSourceHEVCAnnexBFile::slice::prevTid0Pic_slice_pic_order_cnt_lsb = 0;
-int fileSourceHEVCAnnexBFile::slice::prevTid0Pic_PicOrderCntMsb = 0;
-
 fileSourceHEVCAnnexBFile::slice::slice(const nal_unit_hevc &nal) : nal_unit_hevc(nal)
 {
   PicOrderCntVal = -1;
@@ -1084,7 +1071,7 @@ fileSourceHEVCAnnexBFile::slice::slice(const nal_unit_hevc &nal) : nal_unit_hevc
 }
 
 // T-REC-H.265-201410 - 7.3.6.1 slice_segment_header()
-void fileSourceHEVCAnnexBFile::slice::parse_slice(const QByteArray &sliceHeaderData, const sps_map &p_active_SPS_list, const pps_map &p_active_PPS_list, QSharedPointer<slice> firstSliceInSegment, TreeItem *root)
+void fileSourceHEVCAnnexBFile::slice::parse_slice(const QByteArray &sliceHeaderData, const sps_map &p_active_SPS_list, const pps_map &p_active_PPS_list, QSharedPointer<slice> firstSliceInSegment, parsing_state *state, TreeItem *root)
 {
   sub_byte_reader reader(sliceHeaderData);
 
@@ -1141,7 +1128,7 @@ void fileSourceHEVCAnnexBFile::slice::parse_slice(const QByteArray &sliceHeaderD
       //This has to be re-thought ...
 
       if(!short_term_ref_pic_set_sps_flag)
-        st_rps.parse_st_ref_pic_set(reader, actSPS->num_short_term_ref_pic_sets, actSPS.data(), itemTree);
+        st_rps.parse_st_ref_pic_set(reader, actSPS->num_short_term_ref_pic_sets, actSPS.data(), state, itemTree);
       else if(actSPS->num_short_term_ref_pic_sets > 1)
       {
         int nrBits = ceil(log2(actSPS->num_short_term_ref_pic_sets));
@@ -1210,7 +1197,7 @@ void fileSourceHEVCAnnexBFile::slice::parse_slice(const QByteArray &sliceHeaderD
       }
 
       int CurrRpsIdx = (short_term_ref_pic_set_sps_flag) ? short_term_ref_pic_set_idx : actSPS->num_short_term_ref_pic_sets;
-      int NumPicTotalCurr = st_rps.NumPicTotalCurr(CurrRpsIdx, this);
+      int NumPicTotalCurr = st_rps.NumPicTotalCurr(CurrRpsIdx, this, state);
       if(actPPS->lists_modification_present_flag && NumPicTotalCurr > 1)
         slice_rpl_mod.parse_ref_pic_lists_modification(reader, this, NumPicTotalCurr, itemTree);
 
@@ -1297,10 +1284,10 @@ void fileSourceHEVCAnnexBFile::slice::parse_slice(const QByteArray &sliceHeaderD
   NoRaslOutputFlag = false;
   if (nal_type == IDR_W_RADL || nal_type == BLA_W_LP)
     NoRaslOutputFlag = true;
-  else if (bFirstAUInDecodingOrder) 
+  else if (state->bFirstAUInDecodingOrder) 
   {
     NoRaslOutputFlag = true;
-    bFirstAUInDecodingOrder = false;
+    state->bFirstAUInDecodingOrder = false;
   }
 
   // T-REC-H.265-201410 - 8.3.1 Decoding process for picture order count
@@ -1312,8 +1299,8 @@ void fileSourceHEVCAnnexBFile::slice::parse_slice(const QByteArray &sliceHeaderD
   {
     // the variables prevPicOrderCntLsb and prevPicOrderCntMsb are derived as follows:
      
-    prevPicOrderCntLsb = prevTid0Pic_slice_pic_order_cnt_lsb;
-    prevPicOrderCntMsb = prevTid0Pic_PicOrderCntMsb;
+    prevPicOrderCntLsb = state->prevTid0Pic_slice_pic_order_cnt_lsb;
+    prevPicOrderCntMsb = state->prevTid0Pic_PicOrderCntMsb;
   }
   LOGVAL(prevPicOrderCntLsb);
   LOGVAL(prevPicOrderCntMsb);
@@ -1346,8 +1333,8 @@ void fileSourceHEVCAnnexBFile::slice::parse_slice(const QByteArray &sliceHeaderD
     // equal to 0 and that is not a RASL picture, a RADL picture or an SLNR picture.
 
     // Set these for the next slice
-    prevTid0Pic_slice_pic_order_cnt_lsb = slice_pic_order_cnt_lsb;
-    prevTid0Pic_PicOrderCntMsb = PicOrderCntMsb;
+    state->prevTid0Pic_slice_pic_order_cnt_lsb = slice_pic_order_cnt_lsb;
+    state->prevTid0Pic_PicOrderCntMsb = PicOrderCntMsb;
   }
 }
 
@@ -1370,16 +1357,13 @@ void fileSourceHEVCAnnexBFile::parseAndAddNALUnit(int nalID)
   nalHeaderBytes.append(getCurByte());
   gotoNextByte();
 
-  // Create a new TreeItem root for the NAL unit. We don't set data (a name) for this item
-  // yet. We want to parse the item and then set a good description.
+  // The syntax elements are not saved while scanning. If the NAL unit is expanded in the NAL unit
+  // view, it is parsed again (parseNALUnitDetails).
   QString specificDescription;
-  TreeItem *nalRoot = nullptr;
-  if (!nalUnitModel.rootItem.isNull())
-    nalRoot = new TreeItem(nalUnitModel.rootItem.data());
 
   // Create a nal_unit and read the header
   nal_unit_hevc nal_hevc(curFilePos, nalID);
-  nal_hevc.parse_nal_unit_header(nalHeaderBytes, nalRoot);
+  nal_hevc.parse_nal_unit_header(nalHeaderBytes, nullptr);
 
   if (nal_hevc.isSlice())
   {
@@ -1405,7 +1389,7 @@ void fileSourceHEVCAnnexBFile::parseAndAddNALUnit(int nalID)
   {
     // A video parameter set
     auto new_vps = QSharedPointer<vps>(new vps(nal_hevc));
-    new_vps->parse_vps(getRemainingNALBytes(), nalRoot);
+    new_vps->parse_vps(getRemainingNALBytes(), nullptr);
 
     // Put parameter sets into the NAL unit list
     nalUnitList.append(new_vps);
@@ -1420,7 +1404,7 @@ void fileSourceHEVCAnnexBFile::parseAndAddNALUnit(int nalID)
   {
     // A sequence parameter set
     auto new_sps = QSharedPointer<sps>(new sps(nal_hevc));
-    new_sps->parse_sps(getRemainingNALBytes(), nalRoot);
+    new_sps->parse_sps(getRemainingNALBytes(), &parseState, nullptr);
       
     // Add sps (replace old one if existed)
     active_SPS_list.insert(new_sps->sps_seq_parameter_set_id, new_sps);
@@ -1435,7 +1419,7 @@ void fileSourceHEVCAnnexBFile::parseAndAddNALUnit(int nalID)
   {
     // A picture parameter set
     auto new_pps = QSharedPointer<pps>(new pps(nal_hevc));
-    new_pps->parse_pps(getRemainingNALBytes(), nalRoot);
+    new_pps->parse_pps(getRemainingNALBytes(), nullptr);
       
     // Add pps (replace old one if existed)
     active_PPS_list.insert(new_pps->pps_pic_parameter_set_id, new_pps);
@@ -1450,7 +1434,7 @@ void fileSourceHEVCAnnexBFile::parseAndAddNALUnit(int nalID)
   {
     // Create a new slice unit
     auto new_slice = QSharedPointer<slice>(new slice(nal_hevc));
-    new_slice->parse_slice(getRemainingNALBytes(), active_SPS_list, active_PPS_list, lastFirstSliceSegmentInPic, nalRoot);
+    new_slice->parse_slice(getRemainingNALBytes(), active_SPS_list, active_PPS_list, lastFirstSliceSegmentInPic, &parseState, nullptr);
 
     // Add the POC of the slice
     if (new_slice->isIRAP() && new_slice->NoRaslOutputFlag && maxPOCCount > 0)
@@ -1467,6 +1451,16 @@ void fileSourceHEVCAnnexBFile::parseAndAddNALUnit(int nalID)
     if (new_slice->first_slice_segment_in_pic_flag)
       lastFirstSliceSegmentInPic = new_slice;
 
+    // Add the slice to the picture summary (slice_type 0-B 1-P 2-I)
+    pictureSliceType sliceType = pictureSlice_Other;
+    if (new_slice->slice_type == 0)
+      sliceType = pictureSlice_B;
+    else if (new_slice->slice_type == 1)
+      sliceType = pictureSlice_P;
+    else if (new_slice->slice_type == 2)
+      sliceType = pictureSlice_I;
+    addSliceToPictureStats(new_slice->first_slice_segment_in_pic_flag, POC, sliceType, nal_hevc.nuh_temporal_id_plus1 - 1, new_slice->slice_qp_delta);
+
     // 
     bool isRandomAccessSkip = false;
     if (firstPOCRandomAccess == INT_MAX)
@@ -1508,63 +1502,111 @@ void fileSourceHEVCAnnexBFile::parseAndAddNALUnit(int nalID)
   else if (nal_hevc.nal_type == PREFIX_SEI_NUT || nal_hevc.nal_type == SUFFIX_SEI_NUT)
   {
     // An SEI NAL. Each SEI NAL may contain multiple sei_payloads
-    auto new_sei = QSharedPointer<sei>(new sei(nal_hevc));
-    QByteArray sei_data = getRemainingNALBytes();
+    int sei_count = parseSEIMessages(nal_hevc, getRemainingNALBytes(), true, nullptr);
+    specificDescription = QString(" Number Messages: %1").arg(sei_count);
+  }
 
-    int sei_count = 0;
-    while(!sei_data.isEmpty())
-    {
-      TreeItem *const message_tree = nalRoot ? new TreeItem("", nalRoot) : nullptr;
+  if (!nalUnitModel.rootItem.isNull())
+    // Add the NAL unit to the model with a useful name
+    nalUnitModel.addNALUnit(curFilePos, QString("NAL %1: %2").arg(nal_hevc.nal_idx).arg(nal_unit_type_toString.value(nal_hevc.nal_type)) + specificDescription);
+}
 
-      int nrBytes = new_sei->parse_sei_message(sei_data, message_tree);
-      sei_data.remove(0, nrBytes);
-      
-      if (message_tree)
-        message_tree->itemData[0] = QString("sei_message %1 - %2").arg(sei_count).arg(new_sei->payloadTypeName);
+int fileSourceHEVCAnnexBFile::parseSEIMessages(const nal_unit_hevc &nal_hevc, QByteArray sei_data, bool reparseLater, TreeItem *nalRoot)
+{
+  auto new_sei = QSharedPointer<sei>(new sei(nal_hevc));
 
-      QByteArray sub_sei_data = sei_data.mid(0, new_sei->payloadSize);
+  int sei_count = 0;
+  while(!sei_data.isEmpty())
+  {
+    TreeItem *const message_tree = nalRoot ? new TreeItem("", nalRoot) : nullptr;
 
-      if (new_sei->payloadType == 1)
-      {
-        auto new_pic_timing_sei = QSharedPointer<pic_timing_sei>(new pic_timing_sei(new_sei));
-        if (new_pic_timing_sei->parse_pic_timing_sei(sub_sei_data, active_VPS_list, active_SPS_list, message_tree) == SEI_PARSING_WAIT_FOR_PARAMETER_SETS)
-          reparse_sei.append(new_pic_timing_sei);
-      }
-      else if (new_sei->payloadType == 5)
-      {
-        auto new_user_data_sei = QSharedPointer<user_data_sei>(new user_data_sei(new_sei));
-        new_user_data_sei->parse_user_data_sei(sub_sei_data, message_tree);
-      }
-      else if (new_sei->payloadType == 129)
-      {
-        auto new_active_parameter_sets_sei = QSharedPointer<active_parameter_sets_sei>(new active_parameter_sets_sei(new_sei));
-        if (new_active_parameter_sets_sei->parse_active_parameter_sets_sei(sub_sei_data, active_VPS_list, message_tree) == SEI_PARSING_WAIT_FOR_PARAMETER_SETS)
-          // We have to parse this sei again when we have the VPS
-          reparse_sei.append(new_active_parameter_sets_sei);
-      }
-      else if (new_sei->payloadType == 147)
-      {
-        auto new_alternative_transfer_characteristics_sei = QSharedPointer<alternative_transfer_characteristics_sei>(new alternative_transfer_characteristics_sei(new_sei));
-        new_alternative_transfer_characteristics_sei->parse_alternative_transfer_characteristics_sei(sub_sei_data, message_tree);
-      }
-      
-      // Remove the sei payload bytes from the data
-      sei_data.remove(0, new_sei->payloadSize);
-      if (sei_data.length() == 1)
-      {
-        // This should be the rspb trailing bits (10000000)
-        sei_data.remove(0, 1);
-      }
+    int nrBytes = new_sei->parse_sei_message(sei_data, message_tree);
+    sei_data.remove(0, nrBytes);
+    
+    if (message_tree)
+      message_tree->itemData[0] = QString("sei_message %1 - %2").arg(sei_count).arg(new_sei->payloadTypeName);
 
-      sei_count++;
+    QByteArray sub_sei_data = sei_data.mid(0, new_sei->payloadSize);
+
+    if (new_sei->payloadType == 1)
+    {
+      auto new_pic_timing_sei = QSharedPointer<pic_timing_sei>(new pic_timing_sei(new_sei));
+      if (new_pic_timing_sei->parse_pic_timing_sei(sub_sei_data, active_VPS_list, active_SPS_list, message_tree) == SEI_PARSING_WAIT_FOR_PARAMETER_SETS && reparseLater)
+        reparse_sei.append(new_pic_timing_sei);
+    }
+    else if (new_sei->payloadType == 5)
+    {
+      auto new_user_data_sei = QSharedPointer<user_data_sei>(new user_data_sei(new_sei));
+      new_user_data_sei->parse_user_data_sei(sub_sei_data, message_tree);
+    }
+    else if (new_sei->payloadType == 129)
+    {
+      auto new_active_parameter_sets_sei = QSharedPointer<active_parameter_sets_sei>(new active_parameter_sets_sei(new_sei));
+      if (new_active_parameter_sets_sei->parse_active_parameter_sets_sei(sub_sei_data, active_VPS_list, message_tree) == SEI_PARSING_WAIT_FOR_PARAMETER_SETS && reparseLater)
+        // We have to parse this sei again when we have the VPS
+        reparse_sei.append(new_active_parameter_sets_sei);
+    }
+    else if (new_sei->payloadType == 147)
+    {
+      auto new_alternative_transfer_characteristics_sei = QSharedPointer<alternative_transfer_characteristics_sei>(new alternative_transfer_characteristics_sei(new_sei));
+      new_alternative_transfer_characteristics_sei->parse_alternative_transfer_characteristics_sei(sub_sei_data, message_tree);
+    }
+    
+    // Remove the sei payload bytes from the data
+    sei_data.remove(0, new_sei->payloadSize);
+    if (sei_data.length() == 1)
+    {
+      // This should be the rspb trailing bits (10000000)
+      sei_data.remove(0, 1);
     }
 
-    specificDescription = QString(" Number Messages: %1").arg(sei_count);
+    sei_count++;
   }
 
-  if (nalRoot)
-    // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_hevc.nal_idx).arg(nal_unit_type_toString.value(nal_hevc.nal_type)) + specificDescription);
+  return sei_count;
+}
+
+void fileSourceHEVCAnnexBFile::parseNALUnitDetails(const QByteArray &nalData, TreeItem *root)
+{
+  // Parse the NAL header (two bytes)
+  nal_unit_hevc nal_hevc(0, -1);
+  nal_hevc.parse_nal_unit_header(nalData.left(2), root);
+  const QByteArray payload = nalData.mid(2);
+
+  // Parsing an SPS or a slice updates the parsing state of the scan (the short term reference picture sets and the
+  // POC state). Restore it afterwards.
+  const parsing_state savedParseState = parseState;
+  try
+  {
+    if (nal_hevc.nal_type == VPS_NUT)
+    {
+      vps new_vps(nal_hevc);
+      new_vps.parse_vps(payload, root);
+    }
+    else if (nal_hevc.nal_type == SPS_NUT)
+    {
+      sps new_sps(nal_hevc);
+      new_sps.parse_sps(payload, &parseState, root);
+    }
+    else if (nal_hevc.nal_type == PPS_NUT)
+    {
+      pps new_pps(nal_hevc);
+      new_pps.parse_pps(payload, root);
+    }
+    else if (nal_hevc.isSlice())
+    {
+      slice new_slice(nal_hevc);
+      new_slice.parse_slice(payload, active_SPS_list, active_PPS_list, lastFirstSliceSegmentInPic, &parseState, root);
+    }
+    else if (nal_hevc.nal_type == PREFIX_SEI_NUT || nal_hevc.nal_type == SUFFIX_SEI_NUT)
+      parseSEIMessages(nal_hevc, payload, false, root);
+  }
+  catch (...)
+  {
+    parseState = savedParseState;
+    throw;
+  }
+  parseState = savedParseState;
 }
 
 QList<QByteArray> fileSourceHEVCAnnexBFile::seekToFrameNumber(int iFrameNr)
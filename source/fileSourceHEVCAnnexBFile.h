@@ -33,6 +33,7 @@
 #ifndef FILESOURCEAVCANNEXBFILE_H
 #define FILESOURCEAVCANNEXBFILE_H
 
+#include <cstring>
 #include <QAbstractItemModel>
 #include <QMap>
 #include "fileSourceAnnexBFile.h"
@@ -214,6 +215,27 @@ protected:
     int scaling_list_dc_coef_minus8[2][6];
   };
 
+  // Values that are derived while the bitstream is parsed in decoding order. They are kept per file (and not in
+  // static variables) so that several files can be parsed at the same time.
+  struct parsing_state
+  {
+    parsing_state() { memset(this, 0, sizeof(*this)); bFirstAUInDecodingOrder = true; }
+
+    // Calculated values of the short term reference picture sets. They are used for reference picture set prediction.
+    int NumNegativePics[65];
+    int NumPositivePics[65];
+    int DeltaPocS0[65][16];
+    int DeltaPocS1[65][16];
+    bool UsedByCurrPicS0[65][16];
+    bool UsedByCurrPicS1[65][16];
+    int NumDeltaPocs[65];
+
+    // For keeping track of the decoding order (the POC of the slices)
+    bool bFirstAUInDecodingOrder;
+    int prevTid0Pic_slice_pic_order_cnt_lsb;
+    int prevTid0Pic_PicOrderCntMsb;
+  };
+
   // 7.3.6.3 Weighted prediction parameters syntax
   struct sps;
   struct slice;
@@ -241,8 +263,8 @@ protected:
   // 7.3.7 Short-term reference picture set syntax
   struct st_ref_pic_set
   {
-    void parse_st_ref_pic_set(sub_byte_reader &reader, int stRpsIdx, sps *actSPS, TreeItem *root);
-    int NumPicTotalCurr(int CurrRpsIdx, slice *actSlice);
+    void parse_st_ref_pic_set(sub_byte_reader &reader, int stRpsIdx, sps *actSPS, parsing_state *state, TreeItem *root);
+    int NumPicTotalCurr(int CurrRpsIdx, slice *actSlice, parsing_state *state);
 
     bool inter_ref_pic_set_prediction_flag;
     int delta_idx_minus1;
@@ -257,15 +279,6 @@ protected:
     QList<bool> used_by_curr_pic_s0_flag;
     QList<int> delta_poc_s1_minus1;
     QList<bool> used_by_curr_pic_s1_flag;
-
-    // Calculated values. These are static. They are used for reference picture set prediction.
-    static int NumNegativePics[65];
-    static int NumPositivePics[65];
-    static int DeltaPocS0[65][16];
-    static int DeltaPocS1[65][16];
-    static bool UsedByCurrPicS0[65][16];
-    static bool UsedByCurrPicS1[65][16];
-    static int NumDeltaPocs[65];
   };
 
   struct vui_parameters
@@ -375,7 +388,7 @@ protected:
   struct sps : nal_unit_hevc
   {
     sps(const nal_unit_hevc &nal);
-    void parse_sps(const QByteArray &parameterSetData, TreeItem *root);
+    void parse_sps(const QByteArray &parameterSetData, parsing_state *state, TreeItem *root);
 
     int sps_video_parameter_set_id;
     int sps_max_sub_layers_minus1;
@@ -528,7 +541,7 @@ protected:
   struct slice : nal_unit_hevc
   {
     slice(const nal_unit_hevc &nal);
-    void parse_slice(const QByteArray &sliceHeaderData, const sps_map &p_active_SPS_list, const pps_map &p_active_PPS_list, QSharedPointer<slice> firstSliceInSegment, TreeItem *root);
+    void parse_slice(const QByteArray &sliceHeaderData, const sps_map &p_active_SPS_list, const pps_map &p_active_PPS_list, QSharedPointer<slice> firstSliceInSegment, parsing_state *state, TreeItem *root);
     virtual int getPOC() const override { return PicOrderCntVal; }
     
     bool first_slice_segment_in_pic_flag;
@@ -591,11 +604,6 @@ protected:
 
     int globalPOC;
 
-    // Static variables for keeping track of the decoding order
-    static bool bFirstAUInDecodingOrder;
-    static int prevTid0Pic_slice_pic_order_cnt_lsb;
-    static int prevTid0Pic_PicOrderCntMsb;
-
   private:
     // We will keep a pointer to the active SPS and PPS
     QSharedPointer<pps> actPPS;
@@ -701,6 +709,11 @@ protected:
   static QStringList get_matrix_coefficients_meaning();
 
   void parseAndAddNALUnit(int nalID) Q_DECL_OVERRIDE;
+  void parseNALUnitDetails(const QByteArray &nalData, TreeItem *root) Q_DECL_OVERRIDE;
+
+  // Parse all SEI messages of the SEI NAL. Return the number of messages. If reparseLater is set, messages which need
+  // parameter sets that were not received yet are added to reparse_sei.
+  int parseSEIMessages(const nal_unit_hevc &nal_hevc, QByteArray sei_data, bool reparseLater, TreeItem *nalRoot);
 
   // When we start to parse the bitstream we will remember the first RAP POC
   // so that we can disregard any possible RASL pictures.
@@ -716,6 +729,8 @@ protected:
   QSharedPointer<slice> lastFirstSliceSegmentInPic;
   // A list of seis that need to be parsed after the parameter sets were recieved.
   QList<QSharedPointer<sei>> reparse_sei;
+  // The state of parsing the bitstream in decoding order
+  parsing_state parseState;
 };
 
 #endif //FILESOURCEAVCANNEXBFILE_H
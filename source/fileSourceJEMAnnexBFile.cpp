@@ -52,13 +52,9 @@ void fileSourceJEMAnnexBFile::parseAndAddNALUnit(int nalID)
   nalHeaderBytes.append(getCurByte());
   gotoNextByte();
 
-  // Create a new TreeItem root for the NAL unit.
-  TreeItem *nalRoot = nullptr;
-  if (!nalUnitModel.rootItem.isNull())
-    nalRoot = new TreeItem(nalUnitModel.rootItem.data());
-
+  // The NAL header is parsed again if the NAL unit is expanded in the NAL unit view (parseNALUnitDetails).
   auto nal_jem = QSharedPointer<nal_unit_jem>(new nal_unit_jem(curFilePos, nalID));
-  nal_jem->parse_nal_unit_header(nalHeaderBytes, nalRoot);
+  nal_jem->parse_nal_unit_header(nalHeaderBytes, nullptr);
 
   // Get the NAL as raw bytes and emit the signal to get some information on the NAL.
   nal_jem->nalPayload = getRemainingNALBytes();
@@ -83,9 +79,16 @@ void fileSourceJEMAnnexBFile::parseAndAddNALUnit(int nalID)
     nalUnitList.append(nal_jem);
   }
 
-  if (nalRoot)
-    // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1").arg(nal_jem->nal_idx));
+  if (!nalUnitModel.rootItem.isNull())
+    // Add the NAL unit to the model
+    nalUnitModel.addNALUnit(curFilePos, QString("NAL %1").arg(nal_jem->nal_idx));
+}
+
+void fileSourceJEMAnnexBFile::parseNALUnitDetails(const QByteArray &nalData, TreeItem *root)
+{
+  // We only know the NAL header
+  nal_unit_jem nal_jem(0, -1);
+  nal_jem.parse_nal_unit_header(nalData.left(2), root);
 }
 
 void fileSourceJEMAnnexBFile::nal_unit_jem::parse_nal_unit_header(const QByteArray &parameterSetData, TreeItem *root)
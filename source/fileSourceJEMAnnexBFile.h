@@ -101,6 +101,7 @@ protected:
   };
 
   void parseAndAddNALUnit(int nalID) Q_DECL_OVERRIDE;
+  void parseNALUnitDetails(const QByteArray &nalData, TreeItem *root) Q_DECL_OVERRIDE;
   
   int nalInfoPoc;
   bool nalInfoIsRAP;
@@ -281,8 +281,14 @@ QImage frameHandler::calculateDifference(frameHandler *item2, const int frameIdx
   Q_UNUSED(frameIdxItem0);
   Q_UNUSED(frameIdxItem1);
 
-  int width  = qMin(frameSize.width(), item2->frameSize.width());
-  int height = qMin(frameSize.height(), item2->frameSize.height());
+  const QSize diffSize(qMin(frameSize.width(), item2->frameSize.width()), qMin(frameSize.height(), item2->frameSize.height()));
+  return calculateDifferenceRGB(currentImage, item2->currentImage, diffSize, differenceInfoList, amplificationFactor, markDifference);
+}
+
+QImage frameHandler::calculateDifferenceRGB(const QImage &image0, const QImage &image1, const QSize &diffSize, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference)
+{
+  const int width = diffSize.width();
+  const int height = diffSize.height();
 
   QImage diffImg(width, height, platformImageFormat());
 
@@ -293,8 +299,8 @@ QImage frameHandler::calculateDifference(frameHandler *item2, const int frameIdx
   {
     for (int x = 0; x < width; x++)
     {
-      QRgb pixel1 = getPixelVal(x, y);
-      QRgb pixel2 = item2->getPixelVal(x, y);
+      QRgb pixel1 = image0.pixel(x, y);
+      QRgb pixel2 = image1.pixel(x, y);
 
       int dR = int(qRed(pixel1)) - int(qRed(pixel2));
       int dG = int(qGreen(pixel1)) - int(qGreen(pixel2));
@@ -116,6 +116,10 @@ protected:
   // When slotVideoControlChanged is called, update the controls and return the new selected size
   QSize getNewSizeFromControls();
 
+  // Calculate the RGB difference of the top left diffSize part of the two images. This does not use any
+  // members so it can also be called for images that are not the current image (e.g. while caching).
+  static QImage calculateDifferenceRGB(const QImage &image0, const QImage &image1, const QSize &diffSize, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference);
+
 private:
 
   // A list of all frame size presets. Only used privately in this class. Defined in the .cpp file.
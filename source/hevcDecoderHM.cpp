@@ -223,6 +223,11 @@ QByteArray hevcDecoderHM::loadYUVFrameData(int frameIdx)
     return currentOutputBuffer;
   }
 
+  // When stepping backwards, the frame may have been decoded recently (when we seeked back the last time)
+  QByteArray recentFrame;
+  if (getRecentFrame(frameIdx, recentFrame))
+    return recentFrame;
+
   DEBUG_DECHM("hevcDecoderHM::loadYUVFrameData Start request %d", frameIdx);
 
   // We have to decode the requested frame.
@@ -353,13 +358,16 @@ QByteArray hevcDecoderHM::loadYUVFrameData(int frameIdx)
         if (picSize != frameSize)
           DEBUG_DECHM("hevcDecoderHM::loadYUVFrameData recieved frame has different size. Set: %dx%d Pic: %dx%d", frameSize.width(), frameSize.height(), picSize.width(), picSize.height());
         
-        if (currentOutputBufferFrameIndex == frameIdx)
+        if (needsDecodedFrame(frameIdx))
         {
-          // This is the frame that we want to decode
-
-          // Put image data into buffer
+          // Put image data into buffer (and keep it for the next backward steps)
           copyImgToByteArray(pic, currentOutputBuffer);
+          keepDecodedFrame(currentOutputBuffer);
+        }
 
+        if (currentOutputBufferFrameIndex == frameIdx)
+        {
+          // This is the frame that we want to decode
           if (retrieveStatistics)
           {
             // Get the statistics from the image and put them into the statistics cache
@@ -564,6 +572,8 @@ statisticsData hevcDecoderHM::getStatisticsData(int frameIdx, int typeIdx)
       // This can be done like this:
       currentOutputBufferFrameIndex++;
 
+    // Don't serve the frame from the recently decoded frames. It must be decoded to get the statistics.
+    recentFrames.remove(frameIdx);
     loadYUVFrameData(frameIdx);
   }
 
@@ -580,6 +590,7 @@ bool hevcDecoderHM::reloadItemSource()
   decError = LIBHMDEC_OK;
   statsCacheCurPOC = -1;
   currentOutputBufferFrameIndex = -1;
+  recentFrames.clear();
 
   // Re-open the input file. This will reload the bitstream as if it was completely unknown.
   QString fileName = annexBFile->absoluteFilePath();
@@ -211,8 +211,14 @@ void hevcDecoderLibde265::allocateNewDecoder()
   de265_set_parameter_bool(decoder, DE265_DECODER_PARAM_DISABLE_DEBLOCKING, false);
   de265_set_parameter_bool(decoder, DE265_DECODER_PARAM_DISABLE_SAO, false);
 
-  // Set retrieval of the right component
-  if (nrSignalsSupported > 0)
+  // Set retrieval of the right component (or of all components)
+  if (captureAllSignals)
+  {
+    de265_internals_set_parameter_bool(decoder, DE265_INTERNALS_DECODER_PARAM_SAVE_PREDICTION, true);
+    de265_internals_set_parameter_bool(decoder, DE265_INTERNALS_DECODER_PARAM_SAVE_RESIDUAL, true);
+    de265_internals_set_parameter_bool(decoder, DE265_INTERNALS_DECODER_PARAM_SAVE_TR_COEFF, true);
+  }
+  else if (nrSignalsSupported > 0)
   {
     if (decodeSignal == 1)
       de265_internals_set_parameter_bool(decoder, DE265_INTERNALS_DECODER_PARAM_SAVE_PREDICTION, true);
@@ -239,6 +245,13 @@ void hevcDecoderLibde265::allocateNewDecoder()
 
 QByteArray hevcDecoderLibde265::loadYUVFrameData(int frameIdx)
 {
+  // If all signals are captured, the frame may have been decoded before (possibly while another signal was selected)
+  if (captureAllSignals && decodeSignal < capturedSignals.size() && capturedSignals[decodeSignal].contains(frameIdx))
+  {
+    DEBUG_LIBDE265("hevcDecoderLibde265::loadYUVFrameData Frame %d from the captured signals", frameIdx);
+    return capturedSignals[decodeSignal].get(frameIdx);
+  }
+
   // At first check if the request is for the frame that has been requested in the
   // last call to this function.
   if (frameIdx == currentOutputBufferFrameIndex)
@@ -247,6 +260,11 @@ QByteArray hevcDecoderLibde265::loadYUVFrameData(int frameIdx)
     return currentOutputBuffer;
   }
 
+  // When stepping backwards, the frame may have been decoded recently (when we seeked back the last time)
+  QByteArray recentFrame;
+  if (getRecentFrame(frameIdx, recentFrame))
+    return recentFrame;
+
   DEBUG_LIBDE265("hevcDecoderLibde265::loadYUVFrameData Start request %d", frameIdx);
 
   // We have to decode the requested frame.
@@ -377,13 +395,18 @@ QByteArray hevcDecoderLibde265::loadYUVFrameData(int frameIdx)
         if (picSize != frameSize)
           DEBUG_LIBDE265("hevcNextGenDecoderJEM::loadYUVFrameData recieved frame has different size. Set: %dx%d Pic: %dx%d", frameSize.width(), frameSize.height(), picSize.width(), picSize.height());
 
+        if (needsDecodedFrame(frameIdx))
+        {
+          // Put image data into buffer (and keep it for the next backward steps)
+          copyImgToByteArray(img, currentOutputBuffer, decodeSignal);
+          keepDecodedFrame(currentOutputBuffer);
+          if (captureAllSignals)
+            captureSignals(img);
+        }
+
         if (currentOutputBufferFrameIndex == frameIdx)
         {
           // This is the frame that we want to decode
-            
-          // Put image data into buffer
-          copyImgToByteArray(img, currentOutputBuffer);
-
           if (retrieveStatistics)
           {
             // Get the statistics from the image and put them into the statistics cache
@@ -425,10 +448,31 @@ QByteArray hevcDecoderLibde265::loadYUVFrameData(int frameIdx)
   return QByteArray();
 }
 
+void hevcDecoderLibde265::captureSignals(const de265_image *img)
+{
+  // The selected signal is already in the currentOutputBuffer. Copy the others from the image.
+  for (int signalID = 0; signalID < capturedSignals.size(); signalID++)
+  {
+    if (signalID == decodeSignal)
+    {
+      capturedSignals[signalID].add(currentOutputBufferFrameIndex, currentOutputBuffer);
+      continue;
+    }
+
+#if SSE_CONVERSION
+    byteArrayAligned signalBuffer;
+#else
+    QByteArray signalBuffer;
+#endif
+    copyImgToByteArray(img, signalBuffer, signalID);
+    capturedSignals[signalID].add(currentOutputBufferFrameIndex, signalBuffer);
+  }
+}
+
 #if SSE_CONVERSION
-void hevcDecoderLibde265::copyImgToByteArray(const de265_image *src, byteArrayAligned &dst)
+void hevcDecoderLibde265::copyImgToByteArray(const de265_image *src, byteArrayAligned &dst, int signalID)
 #else
-void hevcDecoderLibde265::copyImgToByteArray(const de265_image *src, QByteArray &dst)
+void hevcDecoderLibde265::copyImgToByteArray(const de265_image *src, QByteArray &dst, int signalID)
 #endif
 {
   // How many image planes are there?
@@ -458,13 +502,13 @@ void hevcDecoderLibde265::copyImgToByteArray(const de265_image *src, QByteArray
   for (int c = 0; c < nrPlanes; c++)
   {
     const uint8_t* img_c = nullptr;
-    if (decodeSignal == 0 || nrSignalsSupported == 1)
+    if (signalID == 0 || nrSignalsSupported == 1)
       img_c = de265_get_image_plane(src, c, &stride);
-    else if (decodeSignal == 1)
+    else if (signalID == 1)
       img_c = de265_internals_get_image_plane(src, DE265_INTERNALS_DECODER_PARAM_SAVE_PREDICTION, c, &stride);
-    else if (decodeSignal == 2)
+    else if (signalID == 2)
       img_c = de265_internals_get_image_plane(src, DE265_INTERNALS_DECODER_PARAM_SAVE_RESIDUAL, c, &stride);
-    else if (decodeSignal == 3)
+    else if (signalID == 3)
       img_c = de265_internals_get_image_plane(src, DE265_INTERNALS_DECODER_PARAM_SAVE_TR_COEFF, c, &stride);
     
     if (img_c == nullptr)
@@ -791,6 +835,11 @@ statisticsData hevcDecoderLibde265::getStatisticsData(int frameIdx, int typeIdx)
       // This can be done like this:
       currentOutputBufferFrameIndex++;
 
+    // Don't serve the frame from the recently decoded frames or the captured signals. It must be decoded to get the
+    // statistics.
+    recentFrames.remove(frameIdx);
+    for (auto &signalFrames : capturedSignals)
+      signalFrames.remove(frameIdx);
     loadYUVFrameData(frameIdx);
   }
 
@@ -807,6 +856,9 @@ bool hevcDecoderLibde265::reloadItemSource()
   decError = DE265_OK;
   statsCacheCurPOC = -1;
   currentOutputBufferFrameIndex = -1;
+  recentFrames.clear();
+  for (auto &signalFrames : capturedSignals)
+    signalFrames.clear();
 
   // Re-open the input file. This will reload the bitstream as if it was completely unknown.
   QString fileName = annexBFile->absoluteFilePath();
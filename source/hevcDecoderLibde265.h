@@ -113,6 +113,8 @@ public:
 
   QString getDecoderName() const Q_DECL_OVERRIDE { return "libDe265"; }
   QStringList wrapperGetSignalNames() const Q_DECL_OVERRIDE { return QStringList() << "Reconstruction" << "Prediction" << "Residual" << "Transform Coefficients"; }
+  // All signals can be retrieved at once if the library supports the prediction/residual internals
+  bool canCaptureAllSignals() const Q_DECL_OVERRIDE { return nrSignalsSupported > 1; }
 
   // Check if the given library file is an existing libde265 decoder that we can use.
   static bool checkLibraryFile(QString libFilePath, QString &error);
@@ -150,11 +152,13 @@ private:
 
 #if SSE_CONVERSION
   byteArrayAligned currentOutputBuffer;
-  void copyImgToByteArray(const de265_image *src, byteArrayAligned &dst);
+  void copyImgToByteArray(const de265_image *src, byteArrayAligned &dst, int signalID);
 #else
   QByteArray currentOutputBuffer;
-  void copyImgToByteArray(const de265_image *src, QByteArray &dst);   // Copy the raw data from the de265_image source *src to the byte array
+  void copyImgToByteArray(const de265_image *src, QByteArray &dst, int signalID);   // Copy the given signal from the de265_image source *src to the byte array
 #endif
+  // Put all signals of the current output picture into capturedSignals
+  void captureSignals(const de265_image *img);
 };
 
 #endif // HEVCDECODERLIBDE265_H
@@ -277,6 +277,11 @@ QByteArray hevcNextGenDecoderJEM::loadYUVFrameData(int frameIdx)
     return currentOutputBuffer;
   }
 
+  // When stepping backwards, the frame may have been decoded recently (when we seeked back the last time)
+  QByteArray recentFrame;
+  if (getRecentFrame(frameIdx, recentFrame))
+    return recentFrame;
+
   DEBUG_DECJEM("hevcNextGenDecoderJEM::loadYUVFrameData Start request %d", frameIdx);
 
   // We have to decode the requested frame.
@@ -398,13 +403,16 @@ QByteArray hevcNextGenDecoderJEM::loadYUVFrameData(int frameIdx)
         if (picSize != frameSize)
           DEBUG_DECJEM("hevcNextGenDecoderJEM::loadYUVFrameData recieved frame has different size. Set: %dx%d Pic: %dx%d", frameSize.width(), frameSize.height(), picSize.width(), picSize.height());
         
-        if (currentOutputBufferFrameIndex == frameIdx)
+        if (needsDecodedFrame(frameIdx))
         {
-          // This is the frame that we want to decode
-
-          // Put image data into buffer
+          // Put image data into buffer (and keep it for the next backward steps)
           copyImgToByteArray(pic, currentOutputBuffer);
+          keepDecodedFrame(currentOutputBuffer);
+        }
 
+        if (currentOutputBufferFrameIndex == frameIdx)
+        {
+          // This is the frame that we want to decode
           if (retrieveStatistics)
           {
             // Get the statistics from the image and put them into the statistics cache
@@ -594,6 +602,8 @@ statisticsData hevcNextGenDecoderJEM::getStatisticsData(int frameIdx, int typeId
       // This can be done like this:
       currentOutputBufferFrameIndex++;
 
+    // Don't serve the frame from the recently decoded frames. It must be decoded to get the statistics.
+    recentFrames.remove(frameIdx);
     loadYUVFrameData(frameIdx);
   }
 
@@ -610,6 +620,7 @@ bool hevcNextGenDecoderJEM::reloadItemSource()
   decError = LIBJEMDEC_OK;
   statsCacheCurPOC = -1;
   currentOutputBufferFrameIndex = -1;
+  recentFrames.clear();
 
   // Re-open the input file. This will reload the bitstream as if it was completely unknown.
   QString fileName = annexBFile->absoluteFilePath();
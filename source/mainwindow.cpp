@@ -42,6 +42,7 @@
 #include <QShortcut>
 #include "playlistItems.h"
 #include "settingsDialog.h"
+#include "startupTrace.h"
 
 MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindow(parent)
 {
@@ -55,16 +56,18 @@ MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindo
     settings.setValue("OverlayGrid/Color", QColor(0, 0, 0));
 
   ui.setupUi(this);
+  startupTrace::instance().addPhase("Main window: Setup the user interface");
 
   // Create the update handler
   updater.reset(new updateHandler(this, useAlternativeSources));
+  startupTrace::instance().addPhase("Main window: Create the update handler");
 
   setFocusPolicy(Qt::StrongFocus);
 
   statusBar()->hide();
 
   saveWindowsStateOnExit = true;
-  for (int i = 0; i < 6; i++)
+  for (int i = 0; i < 7; i++)
     panelsVisible[i] = false;
 
   // Initialize the separate window
@@ -99,14 +102,20 @@ MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindo
   connect(ui.playlistTreeWidget, &PlaylistTreeWidget::itemAboutToBeDeleted, ui.propertiesWidget, &PropertiesWidget::itemAboutToBeDeleted);
   connect(ui.playlistTreeWidget, &PlaylistTreeWidget::openFileDialog, this, &MainWindow::showFileOpenDialog);
   connect(ui.playlistTreeWidget, &PlaylistTreeWidget::selectedItemDoubleBufferLoad, ui.playbackController, &PlaybackController::currentSelectedItemsDoubleBufferLoad);
+  connect(ui.playlistTreeWidget, &PlaylistTreeWidget::selectionRangeChanged, ui.scopesWidget, &videoScopesWidget::currentSelectedItemsChanged);
+  connect(ui.playlistTreeWidget, &PlaylistTreeWidget::selectedItemChanged, ui.scopesWidget, &videoScopesWidget::selectedItemChanged);
+  connect(ui.playlistTreeWidget, &PlaylistTreeWidget::itemAboutToBeDeleted, ui.scopesWidget, &videoScopesWidget::itemAboutToBeDeleted);
+  connect(ui.playbackController, &PlaybackController::signalCurrentFrameChanged, ui.scopesWidget, &videoScopesWidget::currentFrameChanged);
 
   ui.displaySplitView->setAttribute(Qt::WA_AcceptTouchEvents);
 
   // Create the videoCache object
   cache.reset(new videoCache(ui.playlistTreeWidget, ui.playbackController, ui.displaySplitView, this));
   cache->setupControls(ui.cachingDebugDock);
+  startupTrace::instance().addPhase("Main window: Create the video cache");
 
   createMenusAndActions();
+  startupTrace::instance().addPhase("Main window: Create the menus");
 
   ui.playbackController->setSplitViews(ui.displaySplitView, &separateViewWindow.splitView);
   ui.playbackController->setPlaylist(ui.playlistTreeWidget);
@@ -114,6 +123,7 @@ MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindo
   ui.displaySplitView->setPlaylistTreeWidget(ui.playlistTreeWidget);
   ui.displaySplitView->setVideoCache(cache.data());
   separateViewWindow.splitView.setPlaybackController(ui.playbackController);
+  ui.scopesWidget->setPlaybackController(ui.playbackController);
   separateViewWindow.splitView.setPlaylistTreeWidget(ui.playlistTreeWidget);
 
   if (!settings.contains("mainWindow/geometry"))
@@ -128,6 +138,7 @@ MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindo
     separateViewWindow.restoreGeometry(settings.value("separateViewWindow/geometry").toByteArray());
     separateViewWindow.restoreState(settings.value("separateViewWindow/windowState").toByteArray());
   }
+  startupTrace::instance().addPhase("Main window: Restore the window layout");
 
   connect(ui.openButton, &QPushButton::clicked, this, &MainWindow::showFileOpenDialog);
 
@@ -141,6 +152,7 @@ MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindo
   ui.playlistTreeWidget->setViewStateHandler(&stateHandler);
 
   updateSettings();
+  startupTrace::instance().addPhase("Main window: Load the settings");
 }
 
 void MainWindow::createMenusAndActions()
@@ -210,6 +222,7 @@ void MainWindow::createMenusAndActions()
   viewMenu->addAction("Hide/Show &Properties", ui.propertiesDock->toggleViewAction(), SLOT(trigger()), Qt::CTRL + Qt::Key_P);
   viewMenu->addAction("Hide/Show &Info", ui.fileInfoDock->toggleViewAction(), SLOT(trigger()), Qt::CTRL + Qt::Key_I);
   viewMenu->addAction("Hide/Show Caching Info", ui.cachingDebugDock->toggleViewAction(), SLOT(trigger()));
+  viewMenu->addAction("Hide/Show Scopes", ui.scopesDock->toggleViewAction(), SLOT(trigger()));
   viewMenu->addSeparator();
   viewMenu->addAction("Hide/Show Playback &Controls", ui.playbackControllerDock->toggleViewAction(), SLOT(trigger()));
   viewMenu->addSeparator();
@@ -452,6 +465,8 @@ void MainWindow::toggleFullscreen()
       ui.fileInfoDock->show();
     if (panelsVisible[5])
       ui.cachingDebugDock->show();
+    if (panelsVisible[6])
+      ui.scopesDock->show();
 
     // show the menu bar
     if (!is_Q_OS_MAC)
@@ -473,6 +488,7 @@ void MainWindow::toggleFullscreen()
     panelsVisible[3] = ui.playbackControllerDock->isVisible();
     panelsVisible[4] = ui.fileInfoDock->isVisible();
     panelsVisible[5] = ui.cachingDebugDock->isVisible();
+    panelsVisible[6] = ui.scopesDock->isVisible();
 
     // Hide panels
     ui.propertiesDock->hide();
@@ -483,6 +499,7 @@ void MainWindow::toggleFullscreen()
       ui.playbackControllerDock->hide();
     ui.fileInfoDock->hide();
     ui.cachingDebugDock->hide();
+    ui.scopesDock->hide();
 
     // hide menu bar
     if (!is_Q_OS_MAC)
@@ -703,6 +720,7 @@ void MainWindow::resetWindowLayout()
   ui.playbackControllerDock->setFloating(false);
   ui.fileInfoDock->setFloating(false);
   ui.cachingDebugDock->setFloating(false);
+  ui.scopesDock->setFloating(false);
 
   // show the menu bar
   if (!is_Q_OS_MAC)
@@ -711,6 +729,8 @@ void MainWindow::resetWindowLayout()
   // Reset main window state (the size and position of the dock widgets). The code obtain this raw value is above.
   QByteArray mainWindowState = QByteArray::fromHex("000000ff00000000fd00000003000000000000011600000348fc0200000003fb000000240070006c00610079006c0069007300740044006f0063006b005700690064006700650074010000001500000212000000c000fffffffb0000001800660069006c00650049006e0066006f0044006f0063006b010000022b000000840000005b00fffffffb0000002000630061006300680069006e0067004400650062007500670044006f0063006b01000002b3000000aa000000aa00ffffff00000001000000b900000348fc0200000002fb0000001c00700072006f00700065007200740069006500730044006f0063006b0100000015000002670000002d00fffffffb000000220064006900730070006c006100790044006f0063006b0057006900640067006500740100000280000000dd000000dd0007ffff000000030000048f00000032fc0100000001fb0000002c0070006c00610079006200610063006b0043006f006e00740072006f006c006c006500720044006f0063006b01000000000000048f000001460007ffff000002b80000034800000004000000040000000800000008fc00000000");
   restoreState(mainWindowState);
+  // The scopes are not part of the default layout
+  ui.scopesDock->hide();
 
   // Set the size/position of the main window
   setGeometry(0, 0, 1100, 750);
@@ -124,7 +124,7 @@ private:
   void showAboutHelp(bool about);
 
   // Which panels are visible when going to full-screen mode?
-  bool panelsVisible[6];
+  bool panelsVisible[7];
 
   // Get the values from the settings and set them in this main windows and all the dock widgets
   void updateSettings();
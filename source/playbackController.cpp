@@ -33,8 +33,11 @@
 #include "playbackController.h"
 
 #include <QSettings>
+#include <algorithm>
+#include <cmath>
 #include "playlistItem.h"
 #include "typedef.h"
+#include "videoHandler.h"
 
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
 #define PLAYBACKCONTROLLER_DEBUG 0
@@ -65,8 +68,13 @@ PlaybackController::PlaybackController()
   timerInterval = -1;
   timerFPSCounter = 0;
   timerLastFPSTime = QTime::currentTime();
+  playbackClockFrames = 0;
   playbackMode = PlaybackStopped;
   playbackWasStalled = false;
+  dropLateFrames = false;
+  droppedFrames = 0;
+  droppedFramesLastFPS = 0;
+  lateFrames = 0;
   waitingForItem[0] = false;
   waitingForItem[1] = false;
 
@@ -116,6 +124,7 @@ void PlaybackController::on_playPauseButton_clicked()
     playPauseButton->setIcon(iconPlay);
     fpsLabel->setText("0");
     fpsLabel->setStyleSheet("");
+    fpsLabel->setToolTip("");
     splitViewPrimary->freezeView(false);
 
     splitViewPrimary->update(false, false);
@@ -170,6 +179,10 @@ void PlaybackController::itemCachingFinished(playlistItem *item)
 
 void PlaybackController::startPlayback()
 {
+  droppedFrames = 0;
+  droppedFramesLastFPS = 0;
+  lateFrames = 0;
+
   // Start the timer, update the icon and (possibly) freeze the primary view.
   startOrUpdateTimer();
 
@@ -190,17 +203,21 @@ void PlaybackController::startOrUpdateTimer()
     timerStaticItemCountDown = -1;
     timerInterval = 1000.0 / frameRate;
     DEBUG_PLAYBACK("PlaybackController::startOrUpdateTimer framerate %f", frameRate);
+
+    // The currently shown frame is presented now. Schedule the next one using the presentation clock.
+    anchorPlaybackClock();
+    scheduleNextFrame();
   }
   else
   {
     // The item (or both items) are not indexed by frame.
-    // Use the duration of item 0
-    timerInterval = int(1000 / 10);
+    // Use the duration of item 0 and update the slider every 100ms.
+    timerInterval = 1000.0 / 10;
     timerStaticItemCountDown = currentItem[0]->getDuration() * 10;
-    DEBUG_PLAYBACK("PlaybackController::startOrUpdateTimer duration %d", timerInterval);
+    DEBUG_PLAYBACK("PlaybackController::startOrUpdateTimer duration %f", timerInterval);
+    timer.start(int(timerInterval), Qt::PreciseTimer, this);
   }
-  
-  timer.start(timerInterval, Qt::PreciseTimer, this);
+
   playbackMode = PlaybackRunning;
   timerLastFPSTime = QTime::currentTime();
   timerFPSCounter = 0;
@@ -373,6 +390,11 @@ void PlaybackController::updateSettings()
   bool wait = settings.value("PlaybackPauseCaching", false).toBool();
   waitForCachingOfItem = caching && wait;
 
+  // How many frames are loaded ahead while playing back and do we drop frames if loading can not keep up?
+  videoHandler::setDoubleBufferQueueDepth(settings.value("PlaybackQueueDepth", 4).toInt());
+  dropLateFrames = settings.value("PlaybackDropFrames", false).toBool();
+  settings.endGroup();
+
   // Load the icons for the buttons
   iconPlay = convertIcon(":img_play.png");
   iconStop = convertIcon(":img_stop.png");
@@ -428,6 +450,7 @@ void PlaybackController::enableControls(bool enable)
     const QSignalBlocker blocker(frameSlider);
     fpsLabel->setText("0");
     fpsLabel->setStyleSheet("");
+    fpsLabel->setToolTip("");
     playbackWasStalled = false;
   }
 
@@ -511,11 +534,11 @@ void PlaybackController::timerEvent(QTimerEvent *event)
   else
   {
     // Do we have to wait for one of the (possibly two) items to load until we can display it/them?
-    waitingForItem[0] = currentItem[0]->isLoading() || currentItem[0]->isLoadingDoubleBuffer();
-    waitingForItem[1] = splitViewPrimary->isSplitting() && currentItem[1] && (currentItem[1]->isLoading() || currentItem[1]->isLoadingDoubleBuffer());
+    waitingForItem[0] = !isNextFrameReady(0, nextFrameIdx);
+    waitingForItem[1] = !isNextFrameReady(1, nextFrameIdx);
     if (waitingForItem[0] || waitingForItem[1])
     {
-      // The double buffer of the current item or the second item is still loading. Playback is not fast enough.
+      // The next frame of the current item or the second item is still loading. Playback is not fast enough.
       // We must wait until the next frame was loaded (in both items) successfully until we can display it.
       // We must pause the timer until this happens.
       timer.stop();
@@ -525,9 +548,42 @@ void PlaybackController::timerEvent(QTimerEvent *event)
       return;
     }
 
+    if (dropLateFrames && playbackClock.isValid())
+    {
+      // How many frames are due according to the presentation clock? If we are more than one frame behind,
+      // skip ahead to the frame that is due (or the last frame before it that is already loaded).
+      const int framesDue = int(playbackClock.elapsed() / timerInterval);
+      const int framesBehind = framesDue - (playbackClockFrames + 1);
+      if (framesBehind > 0)
+      {
+        int dueFrameIdx = std::min(nextFrameIdx + framesBehind, frameSlider->maximum());
+        const bool checkItem1 = currentItem[1] && splitViewPrimary->isSplitting();
+        while (dueFrameIdx > nextFrameIdx && (currentItem[0]->needsLoading(dueFrameIdx, false) == LoadingNeeded ||
+               (checkItem1 && currentItem[1]->needsLoading(dueFrameIdx, false) == LoadingNeeded)))
+          dueFrameIdx--;
+        if (dueFrameIdx > nextFrameIdx)
+        {
+          DEBUG_PLAYBACK("PlaybackController::timerEvent dropping frames %d-%d", nextFrameIdx, dueFrameIdx - 1);
+          droppedFrames += dueFrameIdx - nextFrameIdx;
+          playbackClockFrames += dueFrameIdx - nextFrameIdx;
+          nextFrameIdx = dueFrameIdx;
+        }
+      }
+    }
+
     // Go to the next frame and update the splitView
     DEBUG_PLAYBACK("PlaybackController::timerEvent next frame %d", nextFrameIdx);
     setCurrentFrame(nextFrameIdx);
+    playbackClockFrames++;
+
+    if (!dropLateFrames && playbackClock.isValid() && playbackClock.elapsed() - playbackClockFrames * timerInterval > timerInterval)
+    {
+      // The frame was presented more than one frame interval late. We don't drop frames so re-anchor the clock.
+      // Otherwise we would try to catch up by presenting the following frames in a burst.
+      DEBUG_PLAYBACK("PlaybackController::timerEvent frame %d late", nextFrameIdx);
+      lateFrames++;
+      anchorPlaybackClock();
+    }
 
     // Update the FPS counter every 50 frames
     timerFPSCounter++;
@@ -542,9 +598,13 @@ void PlaybackController::timerEvent(QTimerEvent *event)
         fpsLabel->setText(QString::number(framesPerSec, 'f', 1));
       if (playbackWasStalled)
         fpsLabel->setStyleSheet("QLabel { background-color: yellow }");
+      else if (droppedFrames != droppedFramesLastFPS)
+        fpsLabel->setStyleSheet("QLabel { background-color: orange }");
       else
         fpsLabel->setStyleSheet("");
+      fpsLabel->setToolTip(QString("Dropped frames: %1\nLate frames: %2").arg(droppedFrames).arg(lateFrames));
       playbackWasStalled = false;
+      droppedFramesLastFPS = droppedFrames;
 
       timerLastFPSTime = QTime::currentTime();
       timerFPSCounter = 0;
@@ -558,28 +618,60 @@ void PlaybackController::timerEvent(QTimerEvent *event)
       if (frameRate < 0.01)
         frameRate = 0.01;
 
-      int newtimerInterval = 1000.0 / frameRate;
+      double newtimerInterval = 1000.0 / frameRate;
       if (timerInterval != newtimerInterval)
+      {
         startOrUpdateTimer();
+        return;
+      }
     }
+
+    // Wait until the next frame is due
+    scheduleNextFrame();
   }
 }
 
+bool PlaybackController::isNextFrameReady(int itemIdx, int frameIdx) const
+{
+  playlistItem *item = currentItem[itemIdx];
+  if (!item || (itemIdx == 1 && !splitViewPrimary->isSplitting()))
+    return true;
+  // The frame is only not ready if the item is actually busy loading. If nothing is loading, the frame will
+  // be loaded on demand when it is drawn.
+  if (!item->isLoading() && !item->isLoadingDoubleBuffer())
+    return true;
+  return item->needsLoading(frameIdx, false) != LoadingNeeded;
+}
+
+void PlaybackController::anchorPlaybackClock(bool nextFrameDueNow)
+{
+  playbackClock.start();
+  playbackClockFrames = nextFrameDueNow ? -1 : 0;
+}
+
+void PlaybackController::scheduleNextFrame()
+{
+  const double nextFrameDue = (playbackClockFrames + 1) * timerInterval;
+  const int msecsToNextFrame = std::max(0, int(std::lround(nextFrameDue - playbackClock.elapsed())));
+  timer.start(msecsToNextFrame, Qt::PreciseTimer, this);
+}
+
 void PlaybackController::currentSelectedItemsDoubleBufferLoad(int itemID)
 {
   assert(itemID == 0 || itemID == 1);
   if (playbackMode == PlaybackStalled)
   {
-    waitingForItem[itemID] = false;
+    // The item loaded a frame into its playback queue. Is the frame that we are waiting for ready now?
+    const int nextFrameIdx = getNextFrameIndex();
+    waitingForItem[itemID] = nextFrameIdx != -1 && !isNextFrameReady(itemID, nextFrameIdx);
     if (!waitingForItem[0] && !waitingForItem[1])
     {
       // Playback was stalled because we were waiting for the double buffer to load.
-      // We can go on now.
-      DEBUG_PLAYBACK("PlaybackController::currentSelectedItemsDoubleBufferLoad - timer interval %d", timerInterval);
-      timer.start(timerInterval, Qt::PreciseTimer, this);
-      timerEvent(nullptr);
-      // Playback is not stalled anymore
+      // We can go on now. The next frame is shown right away and the clock is re-anchored to it.
+      DEBUG_PLAYBACK("PlaybackController::currentSelectedItemsDoubleBufferLoad - timer interval %f", timerInterval);
       playbackMode = PlaybackRunning;
+      anchorPlaybackClock(true);
+      timerEvent(nullptr);
     }
   }
 }
@@ -604,6 +696,8 @@ void PlaybackController::setCurrentFrame(int frame, bool updateView)
   frameSpinBox->setValue(frame);
   frameSlider->setValue(frame);
 
+  emit signalCurrentFrameChanged(frame);
+
   if (updateView)
   {
     // Also update the view to display the new frame
@@ -34,6 +34,7 @@
 #define PLAYBACKCONTROLLER_H
 
 #include <QBasicTimer>
+#include <QElapsedTimer>
 #include <QPointer>
 #include <QTime>
 #include <QWidget>
@@ -108,6 +109,9 @@ signals:
   // The playback is now going to start
   void signalPlaybackStarting();
 
+  // The current frame was changed (by playback or by the user, e.g. while dragging the frame slider)
+  void signalCurrentFrameChanged(int frame);
+
 public slots:
   // The video cache calls this if caching of the item is finished
   void itemCachingFinished(playlistItem *item);
@@ -169,12 +173,32 @@ private:
   // Was playback stalled recently? This is used to indicate stalling in the fps label.
   bool playbackWasStalled;
 
+  // Is the next frame of the item with the given index (0 or 1) ready to be shown? A frame is not ready if it
+  // is not in the playback queue/cache yet and the item is currently loading it.
+  bool isNextFrameReady(int itemIdx, int frameIdx) const;
+
+  // If decoding can not keep up, do we drop late frames (jump ahead to the frame that is due) or do we just slow down?
+  bool dropLateFrames;
+  int  droppedFrames;          // The number of frames that were skipped since playback started
+  int  droppedFramesLastFPS;   // The value of droppedFrames at the last update of the fps label
+  int  lateFrames;             // The number of frames that were shown late (more than one frame interval) since playback started
+
   // Before starting playback of an item, do we wait until caching is complete?
   bool waitForCachingOfItem;
 
-  // The timer for playback
+  // The timer for playback. For indexed items, frames are not paced by a fixed timer interval but by a monotonic
+  // presentation clock: Frame n (counted since the clock was anchored) is due at n*timerInterval milliseconds.
+  // After each frame, the timer is rescheduled to fire at the due time of the next frame so that rounding
+  // errors and the time spent in the event loop do not accumulate.
   QBasicTimer timer;
-  int    timerInterval;        // The current timer interval in milli seconds. If it changes, update the running timer.
+  double timerInterval;        // The current frame interval in milli seconds. If it changes, the clock is re-anchored.
+  QElapsedTimer playbackClock; // The presentation clock
+  int    playbackClockFrames;  // The number of frames presented since the clock was anchored
+  // Restart the presentation clock. If nextFrameDueNow is set, the next frame is due immediately. Otherwise the
+  // currently shown frame is considered to be presented now and the next frame is due after one interval.
+  void anchorPlaybackClock(bool nextFrameDueNow=false);
+  // Start the timer so that it fires when the next frame is due according to the presentation clock
+  void scheduleNextFrame();
   int    timerFPSCounter;      // Every time the timer is toggled count this up. If it reaches 50, calculate FPS.
   QTime  timerLastFPSTime;     // The last time we updated the FPS counter. Used to calculate new FPS.
   int    timerStaticItemCountDown; // Also for static items we run the timer to update the slider.
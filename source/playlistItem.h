@@ -159,11 +159,11 @@ public:
   virtual bool isLoading() const { return false; }
   virtual bool isLoadingDoubleBuffer() const { return false; }
 
-  // If the needsLoading function returns LoadingNeededDoubleBuffer, this should activate the double buffer so that in the next draw
-  // operation it is drawn. This is done because loading of a new double buffer is triggered right after the call to this function.
+  // If the needsLoading function returns LoadingNeededDoubleBuffer, this should activate the given frame from the double buffer
+  // (the playback queue) so that in the next draw operation it is drawn. This is done because loading of a new double buffer is triggered right after the call to this function.
   // If the buffer is not activated first, it could be overwritten by the background loading process if the draw even is scheduled 
   // too late.
-  virtual void activateDoubleBuffer() {}
+  virtual void activateDoubleBuffer(int frameIdx) { Q_UNUSED(frameIdx); }
 
   // ----- Caching -----
 
@@ -185,6 +185,11 @@ public:
   virtual int getNumberCachedFrames() const { return 0; }
   // How many bytes will caching one frame use (in bytes)?
   virtual unsigned int getCachingFrameSize() const { return 0; }
+  // The memory (in bytes) that the item uses for cached data besides the cached frames (e.g. the frames of other
+  // cache layers or frames that are kept by a decoder). This counts against the cache budget.
+  virtual qint64 getAdditionalCacheSize() const { return 0; }
+  // Free as much of the additional cache as possible (e.g. the frames of other cache layers).
+  virtual void removeAdditionalCache() {}
   // Remove the frame with the given index from the cache.
   virtual void removeFrameFromCache(int idx) { Q_UNUSED(idx); }
   virtual void removeAllFramesFromCache() {};
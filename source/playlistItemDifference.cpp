@@ -32,6 +32,7 @@
 
 #include "playlistItemDifference.h"
 
+#include <algorithm>
 #include <QPainter>
 
 // Activate this if you want to know when which difference is loaded
@@ -56,6 +57,7 @@ playlistItemDifference::playlistItemDifference()
   frameLimitsMax = false;
   isDifferenceLoading = false;
   isDifferenceLoadingToDoubleBuffer = false;
+  cachingEnabled = true;
 
   // The text that is shown when no difference can be drawn
   infoText = DIFFERENCE_INFO_TEXT;
@@ -109,6 +111,7 @@ void playlistItemDifference::drawItem(QPainter *painter, int frameIdx, double zo
 
     // Update the frame range
     startEndFrame = getStartEndFrameLimits();
+    updateInputFrameOffsets();
 
     if (childCount() > 2)
       infoText = "More than two items are not supported.\n" DIFFERENCE_INFO_TEXT;
@@ -232,16 +235,19 @@ void playlistItemDifference::loadFrame(int frameIdx, bool playing, bool loadRawD
   
   if (playing && (state == LoadingNeeded || state == LoadingNeededDoubleBuffer))
   {
-    // Load the next frame into the double buffer
-    int nextFrameIdx = frameIdxInternal + 1;
-    if (nextFrameIdx <= startEndFrame.second)
+    // Fill the double buffer queue with the differences of the next frames
+    const int lastFrameIdx = std::min(frameIdxInternal + videoHandler::getDoubleBufferQueueDepth(), startEndFrame.second);
+    for (int nextFrameIdx = frameIdxInternal + 1; nextFrameIdx <= lastFrameIdx; nextFrameIdx++)
     {
+      if (difference.isFrameAvailable(nextFrameIdx))
+        continue;
+
       DEBUG_DIFF("playlistItemDifference::loadFrame loading difference into double buffer %d %s", nextFrameIdx, playing ? "(playing)" : "");
       isDifferenceLoadingToDoubleBuffer = true;
       // Since every playlist item can have it's own relative indexing, we need two frame indices
       int idx0 = getChildPlaylistItem(0)->getFrameIdxInternal(nextFrameIdx);
       int idx1 = getChildPlaylistItem(1)->getFrameIdxInternal(nextFrameIdx);
-      difference.loadFrameDifference(frameIdxInternal, idx0, idx1, true);
+      difference.loadFrameDifference(nextFrameIdx, idx0, idx1, true);
       isDifferenceLoadingToDoubleBuffer = false;
       if (emitSignals)
         emit signalItemDoubleBufferLoaded();
@@ -251,8 +257,57 @@ void playlistItemDifference::loadFrame(int frameIdx, bool playing, bool loadRawD
 
 void playlistItemDifference::childChanged(bool redraw, recacheIndicator recache)
 {
-  // One of the child items changed and needs to redraw. This means that the difference is out of date
-  // and has to be recalculated.
-  difference.invalidateAllBuffers();
+  if (recache != RECACHE_NONE)
+  {
+    // The frames or the frame range of a child changed. All calculated differences are out of date
+    // and have to be recalculated/recached.
+    difference.invalidateDifference();
+    updateInputFrameOffsets();
+    recache = RECACHE_CLEAR;
+  }
+  else if (redraw)
+    // Only the current difference has to be recalculated
+    difference.invalidateCurrentDifference();
+
   playlistItemContainer::childChanged(redraw, recache);
+}
+
+void playlistItemDifference::reloadItemSource()
+{
+  playlistItemContainer::reloadItemSource();
+
+  // The children cleared their buffers. All differences have to be recalculated.
+  difference.invalidateDifference();
+  emit signalItemChanged(true, RECACHE_CLEAR);
+}
+
+void playlistItemDifference::updateInputFrameOffsets()
+{
+  if (childCount() != 2)
+    return;
+
+  // The frame index of the difference is mapped to the children using their internal frame index
+  difference.setInputFrameOffsets(getChildPlaylistItem(0)->getFrameIdxInternal(0), getChildPlaylistItem(1)->getFrameIdxInternal(0));
+}
+
+int playlistItemDifference::cachingThreadLimit()
+{
+  // Calculating a difference loads a frame from both children. Use the strictest limit of the children.
+  int limit = -1;
+  for (int i = 0; i < childCount(); i++)
+  {
+    int childLimit = getChildPlaylistItem(i)->cachingThreadLimit();
+    if (childLimit != -1 && (limit == -1 || childLimit < limit))
+      limit = childLimit;
+  }
+  return limit;
+}
+
+QList<int> playlistItemDifference::getCachedFrames() const
+{
+  // Convert indices from internal to external indices
+  QList<int> retList;
+  for (int i : difference.getCachedFrames())
+    retList.append(getFrameIdxExternal(i));
+  return retList;
 }
\ No newline at end of file
@@ -71,6 +71,21 @@ public:
   // Return the frame handler pointer that draws the difference
   virtual frameHandler *getFrameHandler() Q_DECL_OVERRIDE { return &difference; }
 
+  // Overload from playlistItem. Reload the children and recalculate all differences.
+  virtual void reloadItemSource() Q_DECL_OVERRIDE;
+
+  // ----- Caching -----
+  // The difference frames are calculated by the caching threads and cached in the difference handler. The inputs are
+  // not changed by this. Their cached frames (or raw data) are used.
+  virtual bool isCachable() const Q_DECL_OVERRIDE { return playlistItem::isCachable() && childCount() == 2 && difference.inputsValid(); }
+  virtual int cachingThreadLimit() Q_DECL_OVERRIDE;
+  virtual void cacheFrame(int frameIdx, bool testMode) Q_DECL_OVERRIDE { if (isCachable()) difference.cacheFrame(getFrameIdxInternal(frameIdx), testMode); }
+  virtual QList<int> getCachedFrames() const Q_DECL_OVERRIDE;
+  virtual int getNumberCachedFrames() const Q_DECL_OVERRIDE { return difference.getNumberCachedFrames(); }
+  virtual unsigned int getCachingFrameSize() const Q_DECL_OVERRIDE { return difference.getCachingFrameSize(); }
+  virtual void removeFrameFromCache(int frameIdx) Q_DECL_OVERRIDE { difference.removeFrameFromCache(getFrameIdxInternal(frameIdx)); }
+  virtual void removeAllFramesFromCache() Q_DECL_OVERRIDE { difference.removeAllFrameFromCache(); }
+
 protected slots:
   virtual void childChanged(bool redraw, recacheIndicator recache) Q_DECL_OVERRIDE;
 
@@ -80,6 +95,9 @@ private:
   // and set propertiesWidget to point to it.
   virtual void createPropertiesWidget() Q_DECL_OVERRIDE;
 
+  // Set the frame offsets of the two children in the difference handler (used when calculating differences for caching)
+  void updateInputFrameOffsets();
+
   videoHandlerDifference difference;
   bool isDifferenceLoading;
   bool isDifferenceLoadingToDoubleBuffer;
@@ -36,8 +36,11 @@
 #include <QDir>
 #include <QUrl>
 #include <QPainter>
+#include <QtConcurrent>
 
+#include "bitratePlotWidget.h"
 #include "fileSource.h"
+#include "sharedFrameStore.h"
 
 #define FFMPEG_DEBUG_OUTPUT 0
 #if FFMPEG_DEBUG_OUTPUT && !NDEBUG
@@ -54,31 +57,70 @@ playlistItemFFmpegFile::playlistItemFFmpegFile(const QString &ffmpegFilePath)
   setIcon(0, convertIcon(":img_videoHEVC.png"));
   setFlags(flags() | Qt::ItemIsDropEnabled);
 
-  // So far, there was no error
-  decoderReady = true;
+  // The decoders are ready once the file was opened
+  decoderReady = false;
 
   // Set the video pointer correctly
   video.reset(new videoHandlerYUV());
+  // Decoding a frame again is much slower than reading it back from disk
+  video->setDiskCacheEnabled(true);
 
   // Connect the basic signals from the video
   playlistItemWithVideo::connectVideo();
 
-  // Open the file
-  if (!loadingDecoder.openFile(ffmpegFilePath))
+  // The loading decoder may finish indexing the file in the background
+  connect(&loadingDecoder, &FFmpegDecoder::signalIndexUpdated, this, &playlistItemFFmpegFile::loadingDecoderIndexUpdated);
+
+  // Open the file in the background. The item is shown as being opened until this is done.
+  fileOpening = true;
+  indexUpdatePending = false;
+  connect(&openFileWatcher, &QFutureWatcher<bool>::finished, this, &playlistItemFFmpegFile::finishOpeningFile);
+  openFileWatcher.setFuture(QtConcurrent::run(this, &playlistItemFFmpegFile::openDecoders, ffmpegFilePath));
+}
+
+bool playlistItemFFmpegFile::openDecoders(const QString &filePath)
+{
+  // This is run in a background thread. Only the decoders are used here.
+  if (!loadingDecoder.openFile(filePath))
   {
     // Opening the input file failed.
     DEBUG_FFMPEG("Opening the input file with the loading decoder failed.");
-    decoderReady = false;
-    return;
+    return false;
   }
 
-  if (!cachingDecoder.openFile(ffmpegFilePath, &loadingDecoder))
+  if (!cachingDecoder.openFile(filePath, &loadingDecoder))
   {
     // Opening the input file failed.
     DEBUG_FFMPEG("Opening the input file with the caching decoder failed.");
-    decoderReady = false;
+    return false;
+  }
+  return true;
+}
+
+void playlistItemFFmpegFile::waitForFileOpened()
+{
+  if (!fileOpening)
+    return;
+  openFileWatcher.waitForFinished();
+  finishOpeningFile();
+}
+
+void playlistItemFFmpegFile::finishOpeningFile()
+{
+  if (!fileOpening)
+    // Already done (waitForFileOpened was called before the finished signal arrived)
+    return;
+  fileOpening = false;
+
+  if (!openFileWatcher.result())
+  {
+    emit signalItemChanged(true, RECACHE_NONE);
     return;
   }
+  decoderReady = true;
+
+  // The file was opened in the background. Install the file watcher here in the GUI thread.
+  loadingDecoder.updateFileWatchSetting();
 
   // Fill the list of statistics that we can provide
   fillStatisticList();
@@ -86,8 +128,8 @@ playlistItemFFmpegFile::playlistItemFFmpegFile(const QString &ffmpegFilePath)
   // Get the yuvVideo handler
   videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(video.data());
 
-  // Set the frame number limits and frame rate
-  startEndFrame = getStartEndFrameLimits();
+  // Set the frame number limits and frame rate. A range that was loaded from a playlist is kept.
+  setStartEndFrame((startEndFrame == indexRange(-1, -1)) ? getStartEndFrameLimits() : startEndFrame, false);
   frameRate = loadingDecoder.getFrameRate();
   yuvVideo->setFrameSize(loadingDecoder.getFrameSize());
   statSource.statFrameSize = loadingDecoder.getFrameSize();
@@ -100,16 +142,55 @@ playlistItemFFmpegFile::playlistItemFFmpegFile(const QString &ffmpegFilePath)
   // The FFMpeg file can be cached.
   cachingEnabled = true;
 
+  // Other items may decode the same file. They can share the decoded frames.
+  sharedSourcePath = sharedFrameStore::getSourcePath(plItemNameOrFileName);
+  sharedFrameStore::instance().addSourceReference(sharedSourcePath);
+
   connect(yuvVideo, &videoHandlerYUV::signalRequestRawData, this, &playlistItemFFmpegFile::loadYUVData, Qt::DirectConnection);
   connect(yuvVideo, &videoHandlerYUV::signalUpdateFrameLimits, this, &playlistItemFFmpegFile::slotUpdateFrameLimits);
   connect(&statSource, &statisticHandler::updateItem, this, &playlistItemFFmpegFile::updateStatSource);
   connect(&statSource, &statisticHandler::requestStatisticsLoading, this, &playlistItemFFmpegFile::loadStatisticToCache, Qt::DirectConnection);
+
+  if (indexUpdatePending)
+    loadingDecoderIndexUpdated();
+
+  // The item can be drawn and cached now
+  emit signalItemChanged(true, RECACHE_CLEAR);
+}
+
+playlistItemFFmpegFile::~playlistItemFFmpegFile()
+{
+  // The decoders must not be deleted while they are opened in the background
+  openFileWatcher.waitForFinished();
+
+  if (!sharedSourcePath.isEmpty())
+    sharedFrameStore::instance().removeSourceReference(sharedSourcePath);
+}
+
+void playlistItemFFmpegFile::loadingDecoderIndexUpdated()
+{
+  if (fileOpening)
+  {
+    // The caching decoder may still be opened in the background. Update it once this is done.
+    indexUpdatePending = true;
+    return;
+  }
+  indexUpdatePending = false;
+
+  // The real number of frames and the key frames are known now. Update the caching decoder and the frame limits.
+  cachingDecoder.copyIndexFrom(loadingDecoder);
+  slotUpdateFrameLimits();
 }
 
 void playlistItemFFmpegFile::drawItem(QPainter *painter, int frameIdx, double zoomFactor, bool drawRawData)
 {
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
-  if (loadingDecoder.errorLoadingLibraries())
+  if (fileOpening)
+  {
+    infoText = "Opening the file...";
+    playlistItem::drawItem(painter, -1, zoomFactor, drawRawData);
+  }
+  else if (loadingDecoder.errorLoadingLibraries())
   {
     infoText = QString("There was an error loading the FFmpeg libraries:\n'") + loadingDecoder.decoderErrorString() + "'\n\n";
     if (is_Q_OS_WIN)
@@ -194,6 +275,14 @@ infoData playlistItemFFmpegFile::getInfo() const
 {
   infoData info("FFMpeg File Info");
 
+  if (fileOpening)
+  {
+    // The decoders are still busy in the background
+    info.items.append(infoItem("File", plItemNameOrFileName));
+    info.items.append(infoItem("Opening", "Opening the file...", "The file is opened in the background. The item can be used once this is done."));
+    return info;
+  }
+
   // At first append the file information part (path, date created, file size...)
   info.items.append(loadingDecoder.getFileInfoList());
 
@@ -209,6 +298,8 @@ infoData playlistItemFFmpegFile::getInfo() const
     info.items.append(loadingDecoder.getDecoderInfo());
     if (loadingDecoder.canShowNALInfo())
       info.items.append(infoItem("NAL units", "Show NAL units", "Show a detailed list of all NAL units.", true));
+    if (!loadingDecoder.getPictureStats().isEmpty())
+      info.items.append(infoItem("Bitrate", "Show bitrate plot", "Plot the size and slice type of every picture.", true));
   }
 
   return info;
@@ -216,7 +307,12 @@ infoData playlistItemFFmpegFile::getInfo() const
 
 void playlistItemFFmpegFile::infoListButtonPressed(int buttonID)
 {
-  Q_UNUSED(buttonID);
+  if (getInfo().items.value(buttonID).name == "Bitrate")
+  {
+    // The picture sizes were collected when the file was scanned
+    bitratePlotWidget::showDialog(loadingDecoder.getPictureStats(), frameRate);
+    return;
+  }
 
   fileSourceAVCAnnexBFile file;
   
@@ -255,13 +351,17 @@ void playlistItemFFmpegFile::loadYUVData(int frameIdxInternal, bool caching)
     return;
   }
 
-  // Just get the frame from the correct decoder
+  // If another item decodes the same file, the frame may already be decoded. Otherwise, just get the frame
+  // from the correct decoder.
   QByteArray decByteArray;
-
-  if (caching)
-    decByteArray = cachingDecoder.loadYUVFrameData(frameIdxInternal);
-  else
-    decByteArray = loadingDecoder.loadYUVFrameData(frameIdxInternal);
+  if (!sharedFrameStore::instance().getFrame(sharedSourcePath, "FFmpeg", frameIdxInternal, decByteArray))
+  {
+    if (caching)
+      decByteArray = cachingDecoder.loadYUVFrameData(frameIdxInternal);
+    else
+      decByteArray = loadingDecoder.loadYUVFrameData(frameIdxInternal);
+    sharedFrameStore::instance().addFrame(sharedSourcePath, "FFmpeg", frameIdxInternal, decByteArray);
+  }
 
   if (!decByteArray.isEmpty())
   {
@@ -324,7 +424,10 @@ void playlistItemFFmpegFile::reloadItemSource()
   // TODO: The caching decoder must also be reloaded
   //       All items in the cache are also now invalid
 
+  waitForFileOpened();
   loadingDecoder.reloadItemSource();
+  if (!sharedSourcePath.isEmpty())
+    sharedFrameStore::instance().removeSource(sharedSourcePath);
 
   // Set the frame number limits
   startEndFrame = getStartEndFrameLimits();
@@ -348,6 +451,14 @@ void playlistItemFFmpegFile::cacheFrame(int frameIdx, bool testMode)
   cachingMutex.unlock();
 }
 
+qint64 playlistItemFFmpegFile::getAdditionalCacheSize() const
+{
+  const qint64 cacheLayersSize = playlistItemWithVideo::getAdditionalCacheSize();
+  if (fileOpening)
+    return cacheLayersSize;
+  return cacheLayersSize + loadingDecoder.getRecentFramesBytes() + cachingDecoder.getRecentFramesBytes();
+}
+
 void playlistItemFFmpegFile::loadFrame(int frameIdx, bool playing, bool loadRawdata, bool emitSignals)
 {
   auto stateYUV = video->needsLoading(frameIdx, loadRawdata);
@@ -375,20 +486,9 @@ void playlistItemFFmpegFile::loadFrame(int frameIdx, bool playing, bool loadRawd
       emit signalItemChanged(true, RECACHE_NONE);
   }
 
+  // Fill the playback queue with the next frames
   if (playing && (stateYUV == LoadingNeeded || stateYUV == LoadingNeededDoubleBuffer))
-  {
-    // Load the next frame into the double buffer
-    int nextFrameIdx = frameIdx + 1;
-    if (nextFrameIdx <= startEndFrame.second)
-    {
-      DEBUG_FFMPEG("playlistItemFFmpegFile::loadFrame loading frame into double buffer %d %s", nextFrameIdx, playing ? "(playing)" : "");
-      isFrameLoadingDoubleBuffer = true;
-      video->loadFrame(nextFrameIdx, true);
-      isFrameLoadingDoubleBuffer = false;
-      if (emitSignals)
-        emit signalItemDoubleBufferLoaded();
-    }
-  }
+    loadFramesToDoubleBuffer(frameIdx, emitSignals);
 }
 
 itemLoadingState playlistItemFFmpegFile::needsLoading(int frameIdx, bool loadRawValues)
@@ -33,6 +33,7 @@
 #ifndef PLAYLISTITEMFFMPEGFILE_H
 #define PLAYLISTITEMFFMPEGFILE_H
 
+#include <QFutureWatcher>
 #include "FFmpegDecoder.h"
 #include "playlistItemWithVideo.h"
 #include "statisticHandler.h"
@@ -51,6 +52,7 @@ public:
    * addPropertiesWidget to add the custom properties panel.
   */
   playlistItemFFmpegFile(const QString &fileName);
+  virtual ~playlistItemFFmpegFile();
 
   // Draw the FFmpeg item using the given painter and zoom factor.
   virtual void drawItem(QPainter *painter, int frameIdx, double zoomFactor, bool drawRawData) Q_DECL_OVERRIDE;
@@ -76,13 +78,15 @@ public:
   virtual ValuePairListSets getPixelValues(const QPoint &pixelPos, int frameIdx) Q_DECL_OVERRIDE;
 
   // ----- Detection of source/file change events -----
-  virtual bool isSourceChanged()        Q_DECL_OVERRIDE { return loadingDecoder.isFileChanged(); }
+  virtual bool isSourceChanged()        Q_DECL_OVERRIDE { return !fileOpening && loadingDecoder.isFileChanged(); }
   virtual void reloadItemSource()       Q_DECL_OVERRIDE;
-  virtual void updateSettings()         Q_DECL_OVERRIDE { loadingDecoder.updateFileWatchSetting(); statSource.updateSettings(); }
+  virtual void updateSettings()         Q_DECL_OVERRIDE { if (!fileOpening) loadingDecoder.updateFileWatchSetting(); statSource.updateSettings(); }
 
   // Cache the frame with the given index.
   // For FFMpeg items, a mutex must be locked when caching a frame (only one frame can be cached at a time).
   void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE;
+  // The frames that the decoders keep for backward steps count against the cache budget
+  virtual qint64 getAdditionalCacheSize() const Q_DECL_OVERRIDE;
 
   // Load the frame in the video item. Emit signalItemChanged(true,false) when done.
   virtual void loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals=true) Q_DECL_OVERRIDE;
@@ -100,7 +104,8 @@ protected:
 
 private:
   // Override from playlistItemIndexed. The FFMpeg decoder can tell us how many POSs there are.
-  virtual indexRange getStartEndFrameLimits() const Q_DECL_OVERRIDE { return indexRange(0, loadingDecoder.getNumberPOCs() - 1); }
+  // While the file is opened in the background, the number of frames is not known yet.
+  virtual indexRange getStartEndFrameLimits() const Q_DECL_OVERRIDE { return fileOpening ? indexRange(-1, -1) : indexRange(0, loadingDecoder.getNumberPOCs() - 1); }
 
   // We allocate two decoder: One for loading images in the foreground and one for caching in the background.
   // This is better if random access and linear decoding (caching) is performed at the same time.
@@ -119,8 +124,25 @@ private:
 
   bool decoderReady;
 
+  // Opening the decoders can take a while (e.g. a raw h264 file is parsed completely). This is done in a background thread
+  // so that many files (e.g. from a playlist) can be opened concurrently. While fileOpening is set, the decoders must not be used.
+  bool openDecoders(const QString &filePath);
+  // Wait for the background thread (if it is still running) and finish opening the file
+  void waitForFileOpened();
+  bool fileOpening;
+  // Did the loading decoder finish its index while the file was still being opened?
+  bool indexUpdatePending;
+  QFutureWatcher<bool> openFileWatcher;
+
+  // The path that identifies the file in the sharedFrameStore (empty if the file can not be decoded)
+  QString sharedSourcePath;
+
 private slots:
+  // Called when the decoders were opened in the background. Set the frame limits and load the first frame.
+  void finishOpeningFile();
   void updateStatSource(bool bRedraw) { emit signalItemChanged(bRedraw, RECACHE_NONE); }
+  // The loading decoder finished scanning the bitstream in the background
+  void loadingDecoderIndexUpdated();
 };
 
 #endif // PLAYLISTITEMFFMPEGFILE_H
@@ -45,7 +45,6 @@ playlistItemImageFileSequence::playlistItemImageFileSequence(const QString &rawF
   setFlags(flags() | Qt::ItemIsDropEnabled);
 
   loadPlaylistFrameMissing = false;
-  isFrameLoading = false;
 
   // Create the video handler
   video.reset(new videoHandler());
@@ -53,8 +52,9 @@ playlistItemImageFileSequence::playlistItemImageFileSequence(const QString &rawF
   // Connect the basic signals from the video
   playlistItemWithVideo::connectVideo();
 
-  // Connect the video signalRequestFrame to this::loadFrame
-  connect(video.data(), &videoHandler::signalRequestFrame, this, &playlistItemImageFileSequence::slotFrameRequest);
+  // Every frame is a separate file. Let the video handler load frames in parallel (also from the caching threads).
+  video->setParallelFrameLoading(true);
+  connect(video.data(), &videoHandler::signalRequestFrameToImage, this, &playlistItemImageFileSequence::slotLoadFrameToImage, Qt::DirectConnection);
   
   if (!rawFilePath.isEmpty())
   {
@@ -259,10 +259,8 @@ void playlistItemImageFileSequence::getSupportedFileExtensions(QStringList &allE
   filters.append(filter);
 }
 
-void playlistItemImageFileSequence::slotFrameRequest(int frameIdxInternal, bool caching)
+void playlistItemImageFileSequence::slotLoadFrameToImage(int frameIdxInternal, QImage &image)
 {
-  Q_UNUSED(caching);
-
   // Does the index/file exist?
   if (frameIdxInternal < 0 || frameIdxInternal >= imageFiles.count())
     return;
@@ -270,9 +268,13 @@ void playlistItemImageFileSequence::slotFrameRequest(int frameIdxInternal, bool
   if (!fileInfo.exists() || !fileInfo.isFile())
     return;
   
-  // Load the given frame
-  video->requestedFrame = QImage(imageFiles[frameIdxInternal]);
-  video->requestedFrame_idx = frameIdxInternal;
+  // Load the given frame. Convert it to the platform format here (in the loading thread) so that
+  // drawing it later does not require a conversion in the main thread.
+  QImageReader reader(imageFiles[frameIdxInternal]);
+  QImage frame = reader.read();
+  if (frame.isNull())
+    return;
+  image = (frame.format() == platformImageFormat()) ? frame : frame.convertToFormat(platformImageFormat());
 }
 
 void playlistItemImageFileSequence::setInternals(const QString &filePath)
@@ -281,11 +283,16 @@ void playlistItemImageFileSequence::setInternals(const QString &filePath)
   if (startEndFrame == indexRange(-1,-1))
     startEndFrame = getStartEndFrameLimits();
 
-  // Open frame 0 and set the size of it
-  QImage frame0 = QImage(imageFiles[0]);
-  video->setFrameSize(frame0.size());
+  // Get the size of frame 0. Only the header of the file has to be read for this.
+  QImageReader reader(imageFiles[0]);
+  QSize frameSize = reader.size();
+  if (!frameSize.isValid())
+    // The image format does not support reading the size from the header
+    frameSize = reader.read().size();
+  video->setFrameSize(frameSize);
 
-  cachingEnabled = false;  
+  // The frames are loaded in parallel and can be cached
+  cachingEnabled = true;
 
   // Set the internal name
   QFileInfo fi(filePath);
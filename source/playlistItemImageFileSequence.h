@@ -74,13 +74,11 @@ public:
   virtual void reloadItemSource()       Q_DECL_OVERRIDE;
   virtual void updateSettings()         Q_DECL_OVERRIDE;
 
-  // Is an image currently being loaded?
-  virtual bool isLoading() const Q_DECL_OVERRIDE { return isFrameLoading; }
-
 private slots:
-  // Load the given frame from file. This slot is called by the videoHandler if the frame that is
-  // requested to be drawn has not been loaded yet.
-  virtual void slotFrameRequest(int frameIdxInternal, bool caching);
+  // Load the given frame from file into the given image. This slot is called by the videoHandler if the frame
+  // that is requested to be drawn or cached has not been loaded yet. Every frame is a separate file, so this
+  // is thread-safe and is called by all caching threads in parallel.
+  void slotLoadFrameToImage(int frameIdxInternal, QImage &image);
 
   // The image file that we loaded was changed.
   void fileSystemWatcherFileChanged(const QString &path) { Q_UNUSED(path); fileChanged = true; }
@@ -115,9 +113,6 @@ private:
   // Watch the loaded file for modifications
   QFileSystemWatcher fileWatcher;
   bool fileChanged;
-
-  // Is a frame currently being loaded?
-  bool isFrameLoading;
 };
 
 #endif // PLAYLISTITEMIMAGEFILESEQUENCE_H
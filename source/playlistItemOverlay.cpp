@@ -34,6 +34,7 @@
 
 #include <limits>
 #include <QPainter>
+#include "playlistItemWithVideo.h"
 
 #define PLAYLISTITEMOVERLAY_DEBUG 0
 #if PLAYLISTITEMOVERLAY_DEBUG && !NDEBUG
@@ -57,6 +58,10 @@ playlistItemOverlay::playlistItemOverlay() :
   manualAlignment = QPoint(0,0);
   vSpacer = nullptr;
   startEndFrame = indexRange(-1,-1);
+
+  // If all children are videos, the composite images can be cached
+  cachingEnabled = true;
+  compositeCacheGeneration = 0;
 }
 
 /* For an overlay item, the info list is just a list of the names of the
@@ -117,6 +122,14 @@ ValuePairListSets playlistItemOverlay::getPixelValues(const QPoint &pixelPos, in
 
 itemLoadingState playlistItemOverlay::needsLoading(int frameIdx, bool loadRawdata)
 {
+  // If the composite is cached, it is drawn directly. Only the raw values have to be loaded from the children.
+  if (!loadRawdata)
+  {
+    QMutexLocker lock(&compositeCacheMutex);
+    if (compositeCache.contains(frameIdx))
+      return LoadingNotNeeded;
+  }
+
   // The overlay needs to load if one of the child items needs to load
   for (int i = 0; i < childCount(); i++)
   {
@@ -152,9 +165,29 @@ void playlistItemOverlay::drawItem(QPainter *painter, int frameIdx, double zoomF
     return;
   }
 
-  // Update the layout if the number of items changedupdateLayout
+  // Update the layout if the children changed
   updateLayout();
 
+  if (!drawRawData || zoomFactor < SPLITVIEW_DRAW_VALUES_ZOOMFACTOR)
+  {
+    // If the composite of this frame is cached, draw it. The composite image is centered like the bounding rect.
+    QImage composite;
+    compositeCacheMutex.lock();
+    if (compositeCache.contains(frameIdx))
+      composite = compositeCache[frameIdx];
+    compositeCacheMutex.unlock();
+
+    if (!composite.isNull())
+    {
+      DEBUG_OVERLAY("playlistItemOverlay::drawItem frame %d from cache", frameIdx);
+      QRect compositeRect;
+      compositeRect.setSize(boundingRect.size() * zoomFactor);
+      compositeRect.moveCenter(QPoint(0,0));
+      painter->drawImage(compositeRect, composite);
+      return;
+    }
+  }
+
   // Translate to the center of this overlay item
   painter->translate(centerRoundTL(boundingRect) * zoomFactor * -1);
 
@@ -187,25 +220,23 @@ void playlistItemOverlay::updateLayout(bool checkNumber)
 {
   if (childCount() == 0)
   {
+    QMutexLocker lock(&compositeCacheMutex);
     childItems.clear();
+    childItemPointers.clear();
     boundingRect = QRect();
     return;
   }
 
-  if (checkNumber && childCount() == childItems.count())
+  const QList<playlistItem*> newChildItemPointers = getChildItemPointers();
+  if (checkNumber && newChildItemPointers == childItemPointers)
     return;
 
   DEBUG_OVERLAY("playlistItemOverlay::updateLayout%s", checkNumber ? " checkNumber" : "");
 
-  if (childItems.count() != childCount())
-  {
-    // Resize the childItems list
-    childItems.clear();
-    for (int i = 0; i < childCount(); i++)
-    {
-      childItems.append(QRect());
-    }
-  }
+  // The new layout is calculated first and then set. The caching threads read the layout.
+  QList<QRect> newChildItems;
+  for (int i = 0; i < childCount(); i++)
+    newChildItems.append(QRect());
 
   // Update the layout in all children which are also playlistItemOverlays
   for (int i = 0; i < childCount(); i++)
@@ -217,13 +248,14 @@ void playlistItemOverlay::updateLayout(bool checkNumber)
   }
 
   playlistItem *firstItem = getChildPlaylistItem(0);
-  boundingRect.setSize(firstItem->getSize());
-  boundingRect.moveCenter(QPoint(0,0));
+  QRect newBoundingRect;
+  newBoundingRect.setSize(firstItem->getSize());
+  newBoundingRect.moveCenter(QPoint(0,0));
 
   QRect firstItemRect;
   firstItemRect.setSize(firstItem->getSize());
   firstItemRect.moveCenter(QPoint(0,0));
-  childItems[0] = firstItemRect;
+  newChildItems[0] = firstItemRect;
   DEBUG_OVERLAY("playlistItemOverlay::updateLayout item 0 size (%d,%d) firstItemRect (%d,%d)", firstItem->getSize().width(), firstItem->getSize().height(), firstItemRect.left(), firstItemRect.top());
 
   // Align the rest of the items
@@ -266,14 +298,146 @@ void playlistItemOverlay::updateLayout(bool checkNumber)
       targetRect.translate(manualAlignment);
 
       // Set item bounding rectangle
-      childItems[i] = targetRect;
+      newChildItems[i] = targetRect;
 
       DEBUG_OVERLAY("playlistItemOverlay::updateLayout item %d size (%d,%d) alignmentMode %d targetRect (%d,%d)", i, childSize.width(), childSize.height(), alignmentMode, targetRect.left(), targetRect.top());
 
       // Expand the bounding rectangle
-      boundingRect = boundingRect.united(targetRect);
+      newBoundingRect = newBoundingRect.united(targetRect);
     }
   }
+
+  QMutexLocker lock(&compositeCacheMutex);
+  if (newBoundingRect != boundingRect || newChildItems != childItems || newChildItemPointers != childItemPointers)
+  {
+    // The layout changed. All cached composites are invalid.
+    DEBUG_OVERLAY("playlistItemOverlay::updateLayout layout changed - clearing composite cache");
+    compositeCache.clear();
+    compositeCacheGeneration++;
+  }
+  boundingRect = newBoundingRect;
+  childItems = newChildItems;
+  childItemPointers = newChildItemPointers;
+}
+
+QList<playlistItem*> playlistItemOverlay::getChildItemPointers() const
+{
+  QList<playlistItem*> items;
+  for (int i = 0; i < childCount(); i++)
+    items.append(getChildPlaylistItem(i));
+  return items;
+}
+
+bool playlistItemOverlay::canRenderComposite() const
+{
+  if (childCount() == 0)
+    return false;
+  for (int i = 0; i < childCount(); i++)
+    if (dynamic_cast<playlistItemWithVideo*>(getChildPlaylistItem(i)) == nullptr)
+      // Only videos can be rendered into the composite (e.g. statistics are drawn depending on the zoom factor)
+      return false;
+  return true;
+}
+
+bool playlistItemOverlay::isCachable() const
+{
+  return playlistItem::isCachable() && canRenderComposite();
+}
+
+int playlistItemOverlay::cachingThreadLimit()
+{
+  // Rendering a composite loads a frame from every child. Use the strictest limit of the children.
+  int limit = -1;
+  for (int i = 0; i < childCount(); i++)
+  {
+    int childLimit = getChildPlaylistItem(i)->cachingThreadLimit();
+    if (childLimit != -1 && (limit == -1 || childLimit < limit))
+      limit = childLimit;
+  }
+  return limit;
+}
+
+QImage playlistItemOverlay::renderComposite(int frameIdx, const QRect &rect, const QList<QRect> &itemRects)
+{
+  QImage composite(rect.size(), QImage::Format_ARGB32_Premultiplied);
+  composite.fill(Qt::transparent);
+
+  QPainter painter(&composite);
+  for (int i = 0; i < childCount() && i < itemRects.count(); i++)
+  {
+    playlistItemWithVideo *childVideo = dynamic_cast<playlistItemWithVideo*>(getChildPlaylistItem(i));
+    if (childVideo == nullptr)
+      return QImage();
+
+    QImage childImage = childVideo->getFrameImage(frameIdx);
+    if (!childImage.isNull())
+      painter.drawImage(itemRects[i].topLeft() - rect.topLeft(), childImage);
+  }
+  return composite;
+}
+
+void playlistItemOverlay::cacheFrame(int frameIdx, bool testMode)
+{
+  if (!isCachable())
+    return;
+
+  // Get the layout and check if the frame is already cached
+  QMutexLocker lock(&compositeCacheMutex);
+  if (compositeCache.contains(frameIdx) && !testMode)
+    return;
+  const QRect rect = boundingRect;
+  const QList<QRect> itemRects = childItems;
+  const int generation = compositeCacheGeneration;
+  lock.unlock();
+
+  if (rect.isEmpty() || itemRects.count() != childCount())
+    // The layout was not updated yet
+    return;
+
+  DEBUG_OVERLAY("playlistItemOverlay::cacheFrame rendering frame %d", frameIdx);
+  QImage composite = renderComposite(frameIdx, rect, itemRects);
+
+  lock.relock();
+  // Only add the composite if nothing changed while rendering
+  if (!composite.isNull() && !testMode && generation == compositeCacheGeneration)
+    compositeCache.insert(frameIdx, composite);
+}
+
+QList<int> playlistItemOverlay::getCachedFrames() const
+{
+  QMutexLocker lock(&compositeCacheMutex);
+  return compositeCache.keys();
+}
+
+int playlistItemOverlay::getNumberCachedFrames() const
+{
+  QMutexLocker lock(&compositeCacheMutex);
+  return compositeCache.count();
+}
+
+unsigned int playlistItemOverlay::getCachingFrameSize() const
+{
+  // The composite is always 32 bit ARGB
+  QMutexLocker lock(&compositeCacheMutex);
+  return boundingRect.width() * boundingRect.height() * 4;
+}
+
+void playlistItemOverlay::removeFrameFromCache(int frameIdx)
+{
+  QMutexLocker lock(&compositeCacheMutex);
+  compositeCache.remove(frameIdx);
+}
+
+void playlistItemOverlay::removeAllFramesFromCache()
+{
+  invalidateCompositeCache();
+}
+
+void playlistItemOverlay::invalidateCompositeCache()
+{
+  QMutexLocker lock(&compositeCacheMutex);
+  compositeCache.clear();
+  compositeCacheGeneration++;
 }
 
 void playlistItemOverlay::createPropertiesWidget()
@@ -360,19 +524,45 @@ void playlistItemOverlay::controlChanged(int idx)
   // No new item was added but update the layout of the items
   updateLayout(false);
 
-  emit signalItemChanged(true, RECACHE_NONE);
+  // The cached composites are invalid now
+  emit signalItemChanged(true, RECACHE_CLEAR);
+}
+
+bool playlistItemOverlay::updateChildFrameMapping()
+{
+  QList<childFrameMapping> mappings;
+  for (playlistItem *item : getAllChildPlaylistItems())
+    mappings.append({item, item->getFrameIdxInternal(0), item->getSampling()});
+  if (mappings == childFrameMappings)
+    return false;
+  childFrameMappings = mappings;
+  return true;
 }
 
 void playlistItemOverlay::childChanged(bool redraw, recacheIndicator recache)
 {
-  if (redraw)
-    updateLayout(false);
+  // If the child has to be recached (or the frames of the child that are shown changed), the composites are also
+  // invalid. Always check the frame mapping so that it is up to date.
+  const bool mappingChanged = updateChildFrameMapping();
+  if (recache != RECACHE_NONE || mappingChanged)
+    invalidateCompositeCache();
+
+  // Children may also have been added, removed or reordered (updateChildList)
+  updateLayout(!redraw);
 
   playlistItemContainer::childChanged(redraw, recache);
 }
 
 void playlistItemOverlay::loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals)
 {
+  if (!loadRawData)
+  {
+    // Nothing has to be loaded if the composite is cached
+    QMutexLocker lock(&compositeCacheMutex);
+    if (compositeCache.contains(frameIdx))
+      return;
+  }
+
   // Does one of the items need loading?
   bool itemLoadedDoubleBuffer = false;
   bool itemLoaded = false;
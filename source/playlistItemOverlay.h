@@ -33,6 +33,8 @@
 #ifndef PLAYLISTITEMOVERLAY_H
 #define PLAYLISTITEMOVERLAY_H
 
+#include <QMap>
+#include <QMutex>
 #include "playlistItemContainer.h"
 #include "typedef.h"
 #include "ui_playlistItemOverlay.h"
@@ -70,6 +72,18 @@ public:
 
   virtual ValuePairListSets getPixelValues(const QPoint &pixelPos, int frameIdx) Q_DECL_OVERRIDE;
 
+  // ----- Caching -----
+  // If all child items are videos, the overlay renders a composite image of all children (at their position in the
+  // layout) per frame. These images can be cached so that drawing a cached frame is only one image draw.
+  virtual bool isCachable() const Q_DECL_OVERRIDE;
+  virtual int cachingThreadLimit() Q_DECL_OVERRIDE;
+  virtual void cacheFrame(int frameIdx, bool testMode) Q_DECL_OVERRIDE;
+  virtual QList<int> getCachedFrames() const Q_DECL_OVERRIDE;
+  virtual int getNumberCachedFrames() const Q_DECL_OVERRIDE;
+  virtual unsigned int getCachingFrameSize() const Q_DECL_OVERRIDE;
+  virtual void removeFrameFromCache(int frameIdx) Q_DECL_OVERRIDE;
+  virtual void removeAllFramesFromCache() Q_DECL_OVERRIDE;
+
 protected slots:
   void controlChanged(int idx);
   void childChanged(bool redraw, recacheIndicator recache) Q_DECL_OVERRIDE;
@@ -85,16 +99,41 @@ private:
   int alignmentMode;
   QPoint manualAlignment;
 
-  // The layout of the child items
+  // The layout of the child items and the children that it was calculated for
   QRect boundingRect;
   QList<QRect> childItems;
+  QList<playlistItem*> childItemPointers;
 
   // Update the child item layout and this item's bounding QRect. If checkNumber is true the values
-  // will be updated only if the number of items in childItems and childCount() disagree (if new items
-  // were added to the overlay)
+  // will be updated only if the children changed (items were added, removed or reordered)
   void updateLayout(bool checkNumber=true);
+  QList<playlistItem*> getChildItemPointers() const;
 
   QSpacerItem *vSpacer;
+
+  // --- Composite cache ---
+  // Can a composite image be rendered? This is possible if all children are videos.
+  bool canRenderComposite() const;
+  // Draw the given frame of all children into one image. This is called from the caching threads.
+  QImage renderComposite(int frameIdx, const QRect &rect, const QList<QRect> &itemRects);
+  // Clear the cache. Composites that are currently rendered are not added to the cache.
+  void invalidateCompositeCache();
+  // Which frames of the children are shown in the composites (the start frame and sampling of all children)?
+  // Returns true if this changed since the last call.
+  bool updateChildFrameMapping();
+  struct childFrameMapping
+  {
+    playlistItem *item;
+    int startFrame;
+    int sampling;
+    bool operator==(const childFrameMapping &other) const { return item == other.item && startFrame == other.startFrame && sampling == other.sampling; }
+  };
+  QList<childFrameMapping> childFrameMappings;
+  QMap<int, QImage> compositeCache;
+  // Incremented whenever the cache is invalidated
+  int compositeCacheGeneration;
+  // Protects the cache and the layout (boundingRect and childItems) when it is read from the caching threads
+  mutable QMutex compositeCacheMutex;
 };
 
 #endif // PLAYLISTITEMOVERLAY_H
@@ -32,13 +32,18 @@
 
 #include "playlistItemRawCodedVideo.h"
 
+#include <QElapsedTimer>
 #include <QInputDialog>
 #include <QPainter>
 #include <QtConcurrent>
 #include <QUrl>
+#include <algorithm>
+#include <cmath>
+#include "bitratePlotWidget.h"
 #include "hevcDecoderHM.h"
 #include "hevcDecoderLibde265.h"
 #include "hevcNextGenDecoderJEM.h"
+#include "sharedFrameStore.h"
 
 #define HEVC_DEBUG_OUTPUT 0
 #if HEVC_DEBUG_OUTPUT && !NDEBUG
@@ -48,6 +53,10 @@
 #define DEBUG_HEVC(fmt,...) ((void)0)
 #endif
 
+// The limits for the number of frames that the decode ahead worker may decode ahead of the last requested frame
+#define DECODE_AHEAD_MIN_DEPTH 2
+#define DECODE_AHEAD_MAX_DEPTH 16
+
 // Initialize the static names list of the decoder engines
 QStringList playlistItemRawCodedVideo::decoderEngineNames = QStringList() << "libDe265" << "HM" << "JEM";
 
@@ -61,6 +70,8 @@ playlistItemRawCodedVideo::playlistItemRawCodedVideo(const QString &hevcFilePath
   // Set the video pointer correctly
   video.reset(new videoHandlerYUV());
   videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(video.data());
+  // Decoding a frame again is much slower than reading it back from disk
+  video->setDiskCacheEnabled(true);
 
   // Connect the basic signals from the video
   playlistItemWithVideo::connectVideo();
@@ -69,8 +80,17 @@ playlistItemRawCodedVideo::playlistItemRawCodedVideo(const QString &hevcFilePath
   isFrameLoading = false;
   isFrameLoadingDoubleBuffer = false;
 
-  // An HEVC file can be cached if nothing goes wrong
-  cachingEnabled = true;
+  // The decode ahead pipeline is only started during playback
+  decodeAheadEnabled = false;
+  decodeAheadRunning = false;
+  decodeAheadAbort = false;
+  decodeAheadNextFrame = -1;
+  decodeAheadConsumedFrame = -1;
+  decodeAheadDepth = DECODE_AHEAD_MIN_DEPTH;
+  decodeAheadPeakTime = 0;
+
+  // An HEVC file can be cached once it was opened (if nothing goes wrong)
+  cachingEnabled = false;
 
   // Set which signal to show
   displaySignal = displayComponent;
@@ -102,49 +122,107 @@ playlistItemRawCodedVideo::playlistItemRawCodedVideo(const QString &hevcFilePath
     displaySignal = 0;
   yuvVideo->showPixelValuesAsDiff = (displaySignal == 2 || displaySignal == 3);
 
-  // Open the input file.
-  if (!loadingDecoder->openFile(hevcFilePath))
+  // Open the input file in the background. The item is shown as being opened until this is done.
+  fileState = opening;
+  cachingDecoderOpened = false;
+  connect(&openFileWatcher, &QFutureWatcher<bool>::finished, this, &playlistItemRawCodedVideo::finishOpeningFile);
+  openFileWatcher.setFuture(QtConcurrent::run(this, &playlistItemRawCodedVideo::openDecoders, hevcFilePath));
+}
+
+bool playlistItemRawCodedVideo::openDecoders(const QString &filePath)
+{
+  // This is run in a background thread. Only the decoders are used here.
+  if (!loadingDecoder->openFile(filePath))
+    return false;
+
+  // Opening the caching decoder reuses the parsed bitstream of the loading decoder
+  cachingDecoderOpened = (cachingDecoder && cachingDecoder->openFile(filePath, loadingDecoder.data()));
+  return true;
+}
+
+void playlistItemRawCodedVideo::waitForFileOpened()
+{
+  if (fileState != opening)
+    return;
+  openFileWatcher.waitForFinished();
+  finishOpeningFile();
+}
+
+void playlistItemRawCodedVideo::finishOpeningFile()
+{
+  if (fileState != opening)
+    // Already done (waitForFileOpened was called before the finished signal arrived)
+    return;
+
+  if (!openFileWatcher.result())
   {
     // Something went wrong. Let's find out what.
+    fileState = error;
     if (loadingDecoder->errorInDecoder())
       fileState = onlyParsing;
     if (loadingDecoder->errorParsingBitstream())
       fileState = error;
+    if (fileState == onlyParsing)
+      // The file was opened in the background. Install the file watcher here in the GUI thread.
+      loadingDecoder->updateFileWatchSetting();
 
     // In any case, decoding of images is not possible.
-    cachingEnabled = false;
+    emit signalItemChanged(true, RECACHE_NONE);
     return;
   }
 
   // The bitstream looks valid and the decoder is operational.
   fileState = noError;
 
-  if (cachingDecoder && !cachingDecoder->openFile(hevcFilePath, loadingDecoder.data()))
-  {
-    // Loading the normal decoder worked, but loading another decoder for caching failed.
-    // That is strange.
-    cachingEnabled = false;
-  }
+  // The file was opened in the background. Install the file watcher here in the GUI thread.
+  loadingDecoder->updateFileWatchSetting();
+
+  // Other items may decode the same bitstream. They can share the decoded frames.
+  sharedSourcePath = sharedFrameStore::getSourcePath(plItemNameOrFileName);
+  sharedFrameStore::instance().addSourceReference(sharedSourcePath);
+
+  // If loading the normal decoder worked, but loading another decoder for caching failed, caching is not possible.
+  // That is strange.
+  cachingEnabled = cachingDecoderOpened;
 
   // Fill the list of statistics that we can provide
   fillStatisticList();
 
-  // Set the frame number limits
-  startEndFrame = getStartEndFrameLimits();
+  // Set the frame number limits. A range that was loaded from a playlist is kept.
+  setStartEndFrame((startEndFrame == indexRange(-1, -1)) ? getStartEndFrameLimits() : startEndFrame, false);
 
   if (startEndFrame.second == -1)
+  {
     // No frames to decode
+    emit signalItemChanged(true, RECACHE_NONE);
     return;
+  }
 
   // Load frame 0. This will decode the first frame in the sequence and set the
   // correct frame size/YUV format.
   loadYUVData(0, false);
 
   // If the yuvVideHandler requests raw YUV data, we provide it from the file
+  videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(video.data());
   connect(yuvVideo, &videoHandlerYUV::signalRequestRawData, this, &playlistItemRawCodedVideo::loadYUVData, Qt::DirectConnection);
   connect(yuvVideo, &videoHandlerYUV::signalUpdateFrameLimits, this, &playlistItemRawCodedVideo::slotUpdateFrameLimits);
   connect(&statSource, &statisticHandler::updateItem, this, &playlistItemRawCodedVideo::updateStatSource);
   connect(&statSource, &statisticHandler::requestStatisticsLoading, this, &playlistItemRawCodedVideo::loadStatisticToCache, Qt::DirectConnection);
+
+  // The item can be drawn and cached now
+  emit signalItemChanged(true, RECACHE_CLEAR);
+}
+
+playlistItemRawCodedVideo::~playlistItemRawCodedVideo()
+{
+  // The decoders must not be deleted while they are opened in the background
+  openFileWatcher.waitForFinished();
+
+  // The worker must not access the decoder anymore
+  stopDecodeAhead();
+
+  if (!sharedSourcePath.isEmpty())
+    sharedFrameStore::instance().removeSourceReference(sharedSourcePath);
 }
 
 void playlistItemRawCodedVideo::savePlaylist(QDomElement &root, const QDir &playlistDir) const
@@ -201,6 +279,17 @@ infoData playlistItemRawCodedVideo::getInfo() const
 {
   infoData info("HEVC File Info");
 
+  if (fileState == opening)
+  {
+    // The decoders are still busy in the background
+    info.items.append(infoItem("File", plItemNameOrFileName));
+    info.items.append(infoItem("Opening", "Parsing the bitstream...", "The bitstream is parsed in the background. The item can be used once this is done."));
+    return info;
+  }
+
+  // The decode ahead worker may be using the loading decoder right now
+  QMutexLocker decoderLock(&loadingDecoderMutex);
+
   // At first append the file information part (path, date created, file size...)
   info.items.append(loadingDecoder->getFileInfoList());
 
@@ -210,6 +299,8 @@ infoData playlistItemRawCodedVideo::getInfo() const
   {
     info.items.append(infoItem("Num POCs", QString::number(loadingDecoder->getNumberPOCs()), "The number of pictures in the stream."));
     info.items.append(infoItem("NAL units", "Show NAL units", "Show a detailed list of all NAL units.", true));
+    if (!loadingDecoder->getFileSource()->getPictureStats().isEmpty())
+      info.items.append(infoItem("Bitrate", "Show bitrate plot", "Plot the size and slice type of every picture.", true));
   }
   else if (fileState == noError)
   {
@@ -221,6 +312,8 @@ infoData playlistItemRawCodedVideo::getInfo() const
     info.items.append(infoItem("Internals", loadingDecoder->wrapperInternalsSupported() ? "Yes" : "No", "Is the decoder able to provide internals (statistics)?"));
     info.items.append(infoItem("Stat Parsing", loadingDecoder->statisticsEnabled() ? "Yes" : "No", "Are the statistics of the sequence currently extracted from the stream?"));
     info.items.append(infoItem("NAL units", "Show NAL units", "Show a detailed list of all NAL units.", true));
+    if (!loadingDecoder->getFileSource()->getPictureStats().isEmpty())
+      info.items.append(infoItem("Bitrate", "Show bitrate plot", "Plot the size and slice type of every picture.", true));
   }
 
   return info;
@@ -228,7 +321,12 @@ infoData playlistItemRawCodedVideo::getInfo() const
 
 void playlistItemRawCodedVideo::infoListButtonPressed(int buttonID)
 {
-  Q_UNUSED(buttonID);
+  if (getInfo().items.value(buttonID).name == "Bitrate")
+  {
+    // The picture sizes were collected when the file was scanned
+    bitratePlotWidget::showDialog(loadingDecoder->getFileSource()->getPictureStats(), frameRate);
+    return;
+  }
 
   QScopedPointer<fileSourceAnnexBFile> file;
   if (decoderEngineType == decoderLibde265 || decoderEngineType == decoderHM)
@@ -267,7 +365,12 @@ void playlistItemRawCodedVideo::drawItem(QPainter *painter, int frameIdx, double
 {
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
 
-  if (fileState == noError && frameIdxInternal >= 0 && frameIdxInternal < loadingDecoder->getNumberPOCs())
+  if (fileState == opening)
+  {
+    infoText = "Opening the bitstream...";
+    playlistItem::drawItem(painter, -1, zoomFactor, drawRawData);
+  }
+  else if (fileState == noError && frameIdxInternal >= 0 && frameIdxInternal < loadingDecoder->getNumberPOCs())
   {
     video->drawFrame(painter, frameIdxInternal, zoomFactor, drawRawData);
     statSource.paintStatistics(painter, frameIdxInternal, zoomFactor);
@@ -306,12 +409,35 @@ void playlistItemRawCodedVideo::loadYUVData(int frameIdxInternal, bool caching)
     return;
   }
 
-  // Just get the frame from the correct decoder
+  // If another item decodes the same bitstream (with the same decoder and signal), the frame may already be decoded.
+  // Otherwise, just get the frame from the correct decoder.
+  const QString storeFormat = QString("%1:%2").arg(loadingDecoder->getDecoderName()).arg(displaySignal);
   QByteArray decByteArray;
-  if (caching)
-    decByteArray = cachingDecoder->loadYUVFrameData(frameIdxInternal);
+  if (sharedFrameStore::instance().getFrame(sharedSourcePath, storeFormat, frameIdxInternal, decByteArray))
+    DEBUG_HEVC("playlistItemRawCodedVideo::loadYUVData %d taken from the shared frame store", frameIdxInternal);
   else
-    decByteArray = loadingDecoder->loadYUVFrameData(frameIdxInternal);
+  {
+    if (caching)
+    {
+      QMutexLocker decoderLock(&cachingDecoderMutex);
+      decByteArray = cachingDecoder->loadYUVFrameData(frameIdxInternal);
+    }
+    else if (!takeDecodeAheadFrame(frameIdxInternal, decByteArray))
+    {
+      // The decode ahead pipeline can not provide the frame (it is not running or we seeked). Decode it right now.
+      stopDecodeAhead();
+      {
+        QMutexLocker decoderLock(&loadingDecoderMutex);
+        decByteArray = loadingDecoder->loadYUVFrameData(frameIdxInternal);
+      }
+
+      // While playing back, let the decoder continue with the next frames in the background while
+      // this frame is converted. If statistics are retrieved, the decoder must stay at the current frame.
+      if (decodeAheadEnabled && !decByteArray.isEmpty() && !loadingDecoder->statisticsEnabled())
+        startDecodeAhead(frameIdxInternal + 1);
+    }
+    sharedFrameStore::instance().addFrame(sharedSourcePath, storeFormat, frameIdxInternal, decByteArray);
+  }
 
   if (!decByteArray.isEmpty())
   {
@@ -320,6 +446,113 @@ void playlistItemRawCodedVideo::loadYUVData(int frameIdxInternal, bool caching)
   }
 }
 
+void playlistItemRawCodedVideo::startDecodeAhead(int frameIdxInternal)
+{
+  QMutexLocker lock(&decodeAheadMutex);
+  if (decodeAheadRunning || frameIdxInternal > startEndFrame.second)
+    return;
+
+  DEBUG_HEVC("playlistItemRawCodedVideo::startDecodeAhead at frame %d", frameIdxInternal);
+  decodeAheadRunning = true;
+  decodeAheadAbort = false;
+  decodeAheadNextFrame = frameIdxInternal;
+  decodeAheadConsumedFrame = frameIdxInternal - 1;
+  decodeAheadQueue.clear();
+  decodeAheadFuture = QtConcurrent::run(this, &playlistItemRawCodedVideo::decodeAheadWorker);
+}
+
+void playlistItemRawCodedVideo::stopDecodeAhead()
+{
+  decodeAheadMutex.lock();
+  if (decodeAheadRunning)
+  {
+    DEBUG_HEVC("playlistItemRawCodedVideo::stopDecodeAhead");
+    decodeAheadAbort = true;
+    decodeAheadCondition.wakeAll();
+  }
+  decodeAheadMutex.unlock();
+
+  // Wait for the worker to finish (it may be decoding one frame right now)
+  decodeAheadFuture.waitForFinished();
+
+  QMutexLocker lock(&decodeAheadMutex);
+  decodeAheadQueue.clear();
+  decodeAheadAbort = false;
+}
+
+bool playlistItemRawCodedVideo::takeDecodeAheadFrame(int frameIdxInternal, QByteArray &data)
+{
+  QMutexLocker lock(&decodeAheadMutex);
+
+  if (!decodeAheadQueue.contains(frameIdxInternal))
+  {
+    // Is the worker going to decode the frame soon? If not, the frame must be decoded directly.
+    if (!decodeAheadRunning || frameIdxInternal < decodeAheadNextFrame || frameIdxInternal > decodeAheadNextFrame + decodeAheadDepth)
+      return false;
+
+    // Allow the worker to decode up to the requested frame and wait for it
+    DEBUG_HEVC("playlistItemRawCodedVideo::takeDecodeAheadFrame waiting for frame %d", frameIdxInternal);
+    decodeAheadConsumedFrame = std::max(decodeAheadConsumedFrame, frameIdxInternal - decodeAheadDepth);
+    decodeAheadCondition.wakeAll();
+    while (decodeAheadRunning && !decodeAheadQueue.contains(frameIdxInternal))
+      decodeAheadCondition.wait(&decodeAheadMutex);
+    if (!decodeAheadQueue.contains(frameIdxInternal))
+      return false;
+  }
+
+  data = decodeAheadQueue.take(frameIdxInternal);
+
+  // Frames before the requested one will not be requested anymore. Make room for the worker to continue.
+  while (!decodeAheadQueue.isEmpty() && decodeAheadQueue.firstKey() < frameIdxInternal)
+    decodeAheadQueue.erase(decodeAheadQueue.begin());
+  decodeAheadConsumedFrame = std::max(decodeAheadConsumedFrame, frameIdxInternal);
+  decodeAheadCondition.wakeAll();
+  return true;
+}
+
+void playlistItemRawCodedVideo::decodeAheadWorker()
+{
+  QMutexLocker lock(&decodeAheadMutex);
+  while (true)
+  {
+    // Wait until we are allowed to decode the next frame
+    while (!decodeAheadAbort && decodeAheadNextFrame <= startEndFrame.second && decodeAheadNextFrame > decodeAheadConsumedFrame + decodeAheadDepth)
+      decodeAheadCondition.wait(&decodeAheadMutex);
+    if (decodeAheadAbort || decodeAheadNextFrame > startEndFrame.second)
+      break;
+
+    // Decode the frame without holding the queue lock
+    const int frameIdx = decodeAheadNextFrame;
+    lock.unlock();
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+    QByteArray decByteArray;
+    {
+      QMutexLocker decoderLock(&loadingDecoderMutex);
+      decByteArray = loadingDecoder->loadYUVFrameData(frameIdx);
+    }
+    const double decodeTime = decodeTimer.nsecsElapsed() / 1000000.0;
+    lock.relock();
+
+    if (decodeAheadAbort || decByteArray.isEmpty())
+      break;
+
+    decodeAheadQueue.insert(frameIdx, decByteArray);
+    decodeAheadNextFrame = frameIdx + 1;
+
+    // Adapt how far we decode ahead. We must be able to bridge the slowest recently decoded frame.
+    decodeAheadPeakTime = std::max(decodeTime, decodeAheadPeakTime * 0.95);
+    const double frameInterval = 1000.0 / std::max(getFrameRate(), 0.01);
+    decodeAheadDepth = clip(int(std::ceil(decodeAheadPeakTime / frameInterval)) + 1, DECODE_AHEAD_MIN_DEPTH, DECODE_AHEAD_MAX_DEPTH);
+    DEBUG_HEVC("playlistItemRawCodedVideo::decodeAheadWorker decoded %d in %fms - depth %d", frameIdx, decodeTime, decodeAheadDepth);
+
+    decodeAheadCondition.wakeAll();
+  }
+
+  decodeAheadRunning = false;
+  decodeAheadCondition.wakeAll();
+}
+
 void playlistItemRawCodedVideo::createPropertiesWidget()
 {
   // Absolutely always only call this once
@@ -373,6 +606,9 @@ void playlistItemRawCodedVideo::loadStatisticToCache(int frameIdx, int typeIdx)
   if (!loadingDecoder->wrapperInternalsSupported())
     return;
 
+  // The statistics are retrieved from the loading decoder. It must not run ahead.
+  stopDecodeAhead();
+  QMutexLocker decoderLock(&loadingDecoderMutex);
   statSource.statsCache[typeIdx] = loadingDecoder->getStatisticsData(frameIdxInternal, typeIdx);
 }
 
@@ -401,7 +637,11 @@ void playlistItemRawCodedVideo::reloadItemSource()
   // TODO: The caching decoder must also be reloaded
   //       All items in the cache are also now invalid
 
+  waitForFileOpened();
+  stopDecodeAhead();
   loadingDecoder->reloadItemSource();
+  if (!sharedSourcePath.isEmpty())
+    sharedFrameStore::instance().removeSource(sharedSourcePath);
 
   // Set the frame number limits
   startEndFrame = getStartEndFrameLimits();
@@ -425,6 +665,16 @@ void playlistItemRawCodedVideo::cacheFrame(int frameIdx, bool testMode)
   cachingMutex.unlock();
 }
 
+qint64 playlistItemRawCodedVideo::getAdditionalCacheSize() const
+{
+  const qint64 cacheLayersSize = playlistItemWithVideo::getAdditionalCacheSize();
+  if (fileState == opening)
+    return cacheLayersSize;
+  const qint64 capturedSignalsSize = loadingDecoder->getCapturedSignalsBytes() + cachingDecoder->getCapturedSignalsBytes();
+  const qint64 recentFramesSize = loadingDecoder->getRecentFramesBytes() + cachingDecoder->getRecentFramesBytes();
+  return cacheLayersSize + capturedSignalsSize + recentFramesSize;
+}
+
 void playlistItemRawCodedVideo::loadFrame(int frameIdx, bool playing, bool loadRawdata, bool emitSignals)
 {
   // The current thread must never be the main thread but one of the interactive threads.
@@ -434,6 +684,11 @@ void playlistItemRawCodedVideo::loadFrame(int frameIdx, bool playing, bool loadR
   auto stateYUV = video->needsLoading(frameIdxInternal, loadRawdata);
   auto stateStat = statSource.needsLoading(frameIdxInternal);
 
+  // Only decode ahead while playing back
+  decodeAheadEnabled = playing;
+  if (!playing)
+    stopDecodeAhead();
+
   if (stateYUV == LoadingNeeded || stateStat == LoadingNeeded)
   {
     isFrameLoading = true;
@@ -454,20 +709,9 @@ void playlistItemRawCodedVideo::loadFrame(int frameIdx, bool playing, bool loadR
       emit signalItemChanged(true, RECACHE_NONE);
   }
 
+  // Fill the playback queue with the next frames
   if (playing && (stateYUV == LoadingNeeded || stateYUV == LoadingNeededDoubleBuffer))
-  {
-    // Load the next frame into the double buffer
-    int nextFrameIdx = frameIdxInternal + 1;
-    if (nextFrameIdx <= startEndFrame.second)
-    {
-      DEBUG_HEVC("playlistItemRawFile::loadFrame loading frame into double buffer %d %s", nextFrameIdx, playing ? "(playing)" : "");
-      isFrameLoadingDoubleBuffer = true;
-      video->loadFrame(nextFrameIdx, true);
-      isFrameLoadingDoubleBuffer = false;
-      if (emitSignals)
-        emit signalItemDoubleBufferLoaded();
-    }
-  }
+    loadFramesToDoubleBuffer(frameIdxInternal, emitSignals);
 }
 
 playlistItemRawCodedVideo::decoderEngine playlistItemRawCodedVideo::askForDecoderEngine(QWidget *parent)
@@ -489,13 +733,29 @@ void playlistItemRawCodedVideo::displaySignalComboBoxChanged(int idx)
   if (displaySignal != idx)
   {
     displaySignal = idx;
-    loadingDecoder->setDecodeSignal(idx);
-    cachingDecoder->setDecodeSignal(idx);
+    waitForFileOpened();
+    stopDecodeAhead();
+    {
+      // The decoders may be in use by the interactive loading thread, a caching thread or the video scopes
+      QMutexLocker cachingLock(&cachingMutex);
+      QMutexLocker decoderLock(&loadingDecoderMutex);
+      QMutexLocker cachingDecoderLock(&cachingDecoderMutex);
+
+      // The user compares the signals. From now on, retrieve all signals at once so that switching back and forth
+      // does not require decoding the frames again.
+      loadingDecoder->setCaptureAllSignals(true);
+      cachingDecoder->setCaptureAllSignals(true);
+      loadingDecoder->setDecodeSignal(idx);
+      cachingDecoder->setDecodeSignal(idx);
+
+      // No frame of the old signal must end up in the cache layer of the new signal
+      video->setCacheLayer(idx);
+    }
 
-    // A different display signal was chosen. Invalidate the cache and signal that we will need a redraw.
+    // A different display signal was chosen. Every signal has its own layer in the cache, so that the cached frames
+    // of the other signals are kept. Redraw and cache the frames of the new signal that are not cached yet.
     videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(video.data());
     yuvVideo->showPixelValuesAsDiff = (idx == 2 || idx == 3);
-    yuvVideo->invalidateAllBuffers();
-    emit signalItemChanged(true, RECACHE_CLEAR);
+    emit signalItemChanged(true, RECACHE_UPDATE);
   }
 }
@@ -33,6 +33,11 @@
 #ifndef PLAYLISTITEMHEVCFILE_H
 #define PLAYLISTITEMHEVCFILE_H
 
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
 #include "decoderBase.h"
 #include "playlistItemWithVideo.h"
 #include "statisticHandler.h"
@@ -65,6 +70,7 @@ public:
    * 'displayComponent' initializes the component to display (reconstruction/prediction/residual/trCoeff).
   */
   playlistItemRawCodedVideo(const QString &fileName, int displayComponent=0, decoderEngine e=decoderLibde265);
+  virtual ~playlistItemRawCodedVideo();
 
   // Save the HEVC file element to the given XML structure.
   virtual void savePlaylist(QDomElement &root, const QDir &playlistDir) const Q_DECL_OVERRIDE;
@@ -90,21 +96,20 @@ public:
   static void getSupportedFileExtensions(QStringList &allExtensions, QStringList &filters);
 
   // ----- Detection of source/file change events -----
-  virtual bool isSourceChanged()        Q_DECL_OVERRIDE { return loadingDecoder->isFileChanged(); }
+  virtual bool isSourceChanged()        Q_DECL_OVERRIDE { return fileState != opening && loadingDecoder->isFileChanged(); }
   virtual void reloadItemSource()       Q_DECL_OVERRIDE;
-  virtual void updateSettings()         Q_DECL_OVERRIDE { loadingDecoder->updateFileWatchSetting(); statSource.updateSettings(); }
+  virtual void updateSettings()         Q_DECL_OVERRIDE { if (fileState != opening) loadingDecoder->updateFileWatchSetting(); statSource.updateSettings(); }
 
   // Do we need to load the given frame first?
   virtual itemLoadingState needsLoading(int frameIdx, bool loadRawData) Q_DECL_OVERRIDE;
   // Load the frame in the video item. Emit signalItemChanged(true,false) when done.
   virtual void loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals=true) Q_DECL_OVERRIDE;
-  // Is an image currently being loaded?
-  virtual bool isLoading() const Q_DECL_OVERRIDE { return isFrameLoading; }
-  virtual bool isLoadingDoubleBuffer() const Q_DECL_OVERRIDE { return isFrameLoadingDoubleBuffer; }
-
   // Cache the frame with the given index.
   // For HEVC items, a mutex must be locked when caching a frame (only one frame can be cached at a time).
   void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE;
+  // The signals that the decoders keep (if all signals are captured) and the frames that they keep for backward
+  // steps count against the cache budget
+  virtual qint64 getAdditionalCacheSize() const Q_DECL_OVERRIDE;
 
   // We only have one caching decoder so it is better if only one thread caches frames from this item.
   // This way, the frames will always be cached in the right order and no unnecessary decoding is performed.
@@ -123,12 +128,14 @@ public slots:
 
 protected:
   // Override from playlistItemIndexed. The annexBFile handler can tell us how many POSs there are.
-  virtual indexRange getStartEndFrameLimits() const Q_DECL_OVERRIDE { return indexRange(0, loadingDecoder->getNumberPOCs() - 1); }
+  // While the file is opened in the background, the number of POCs is not known yet.
+  virtual indexRange getStartEndFrameLimits() const Q_DECL_OVERRIDE { return (fileState == opening) ? indexRange(-1, -1) : indexRange(0, loadingDecoder->getNumberPOCs() - 1); }
 
   virtual void createPropertiesWidget() Q_DECL_OVERRIDE;
 
   typedef enum
   {
+    opening,     // The bitstream is still being parsed in the background.
     noError,     // There was no error. Parsing the bitstream worked and frames can be decoded.
     onlyParsing, // Loading of the decoder failed. We can only parse the bitstream.
     error        // The bitstream looks invalid. Error.
@@ -143,9 +150,46 @@ protected:
   // Which type of decoder do we use?
   decoderEngine decoderEngineType;
 
-  // Is the loadFrame function currently loading?
-  bool isFrameLoading;
-  bool isFrameLoadingDoubleBuffer;
+  // ----- Opening the file in the background -----
+  // Opening the decoders parses the whole bitstream which can take a while for large files. This is done in a background
+  // thread so that many files (e.g. from a playlist) can be opened concurrently. Until finishOpeningFile was called, the
+  // fileState is opening and the decoders must not be used.
+  bool openDecoders(const QString &filePath);
+  // Wait for the background thread (if it is still running) and finish opening the file
+  void waitForFileOpened();
+  QFutureWatcher<bool> openFileWatcher;
+  bool cachingDecoderOpened;
+
+  // The loading decoder is used by the interactive loading threads and by the decode ahead worker.
+  // Only one of them may use it at a time.
+  mutable QMutex loadingDecoderMutex;
+  // The caching decoder is used by the caching threads and by other threads that load frames for caching
+  // (e.g. the video scopes). These do not hold the cachingMutex.
+  QMutex cachingDecoderMutex;
+
+  // ----- Decode ahead pipeline -----
+  // While playing back, the loading decoder runs ahead of the requested frames in a background thread and
+  // puts the decoded raw frames into a queue. So decoding of frame N+1 overlaps with the conversion of frame N
+  // in the interactive loading thread. How far the worker runs ahead adapts to the measured decoding time
+  // so that the spike of decoding an intra frame does not stall the playback.
+  void startDecodeAhead(int frameIdxInternal);
+  void stopDecodeAhead();
+  // Take the given frame from the decode ahead queue. If the worker is about to decode the frame, wait for it.
+  // Return false if the frame can not be provided by the pipeline (it is not running or the frame is out of reach).
+  bool takeDecodeAheadFrame(int frameIdxInternal, QByteArray &data);
+  // The function that is run in the background thread
+  void decodeAheadWorker();
+  bool decodeAheadEnabled;              // Set by loadFrame while playback is running
+  bool decodeAheadRunning;              // Is the worker running?
+  bool decodeAheadAbort;                // Set to stop the worker
+  int  decodeAheadNextFrame;            // The next frame that the worker will decode
+  int  decodeAheadConsumedFrame;        // The last frame that was taken from the queue
+  int  decodeAheadDepth;                // The worker may decode up to this many frames ahead of decodeAheadConsumedFrame
+  double decodeAheadPeakTime;           // The (slowly decaying) peak decoding time per frame in ms
+  QMap<int, QByteArray> decodeAheadQueue;
+  QMutex decodeAheadMutex;              // Protects all decodeAhead* values
+  QWaitCondition decodeAheadCondition;  // Signaled when a frame was decoded/taken or the worker is stopped
+  QFuture<void> decodeAheadFuture;
 
   // Only cache one frame at a time. Caching should also always be done in display order of the frames.
   // TODO: Could we somehow make shure that caching is always performed in display order?
@@ -160,11 +204,16 @@ protected:
   // Which of the signals is being displayed? Reconstruction(0), Prediction(1) or Residual(2)
   int displaySignal;
 
+  // The path that identifies the bitstream in the sharedFrameStore (empty if the bitstream can not be decoded)
+  QString sharedSourcePath;
+
   SafeUi<Ui::playlistItemHEVCFile_Widget> ui;
 
   static QStringList decoderEngineNames;
 
 private slots:
+  // Called when the decoders were opened in the background. Set the frame limits and load the first frame.
+  void finishOpeningFile();
   void updateStatSource(bool bRedraw) { emit signalItemChanged(bRedraw, RECACHE_NONE); }
   void displaySignalComboBoxChanged(int idx);
 };
@@ -32,11 +32,14 @@
 
 #include "playlistItemRawFile.h"
 
+#include <algorithm>
 #include <QFileInfo>
 #include <QPainter>
+#include <QRegExp>
 #include <QtConcurrent>
 #include <QUrl>
 #include <QVBoxLayout>
+#include "sharedFrameStore.h"
 
 using namespace YUV_Internals;
 
@@ -48,6 +51,19 @@ using namespace YUV_Internals;
 #define DEBUG_RAWFILE(fmt,...) ((void)0)
 #endif
 
+// The maximum number of frames and bytes that are read ahead while playing back
+#define RAWFILE_READ_AHEAD_MAX_FRAMES 8
+#define RAWFILE_READ_AHEAD_MAX_BYTES  (128*1024*1024)
+
+// The number of bytes that are read from the start of a file with unknown format to guess the format
+#define RAWFILE_CORRELATION_READ_SIZE (48*1024*1024)
+
+// Y4M frame indexing. The maximum length of a frame header ("FRAME" and the frame parameters), the number of frames
+// that are checked if all frame headers have the same length and the size of the buffer when searching all frame headers.
+#define Y4M_MAX_FRAME_HEADER_LENGTH 256
+#define Y4M_VERIFY_SAMPLES          16
+#define Y4M_SCAN_BUFFER_SIZE        (4*1024*1024)
+
 playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize &frameSize, const QString &sourcePixelFormat, const QString &fmt)
   : playlistItemWithVideo(rawFilePath, playlistItem_Indexed)
 {
@@ -56,6 +72,11 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
   // If there is also a image@2x.png in the qrc, Qt will use this for high DPI
   isY4MFile = false;
 
+  readAheadStartFrame = -1;
+  readAheadRunning = false;
+  cancelReadAhead = false;
+  readAheadPlaying = false;
+
   // Set the properties of the playlistItem
   setIcon(0, convertIcon(":img_video.png"));
   setFlags(flags() | Qt::ItemIsDropEnabled);
@@ -100,9 +121,11 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
 
     if (!video->isFormatValid())
     {
-      // Load 24883200 bytes from the input and try to get the format from the correlation.
+      // Load the start of the file and try to get the format from the correlation. The data must hold two frames of
+      // the biggest tested formats (e.g. 2160p 4:2:2 10 bit).
       QByteArray rawData;
-      dataSource.readBytes(rawData, 0, 24883200);
+      qint64 nrBytes = dataSource.readBytes(rawData, 0, RAWFILE_CORRELATION_READ_SIZE);
+      rawData.resize(std::max(nrBytes, qint64(0)));
       video->setFormatFromCorrelation(rawData, dataSource.getFileSize());
     }
   }
@@ -120,7 +143,7 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
     startEndFrame = getStartEndFrameLimits();
 
   // If the videHandler requests raw data, we provide it from the file
-  connect(video.data(), SIGNAL(signalRequestRawData(int, bool)), this, SLOT(loadRawData(int)), Qt::DirectConnection);
+  connect(video.data(), SIGNAL(signalRequestRawData(int, bool)), this, SLOT(loadRawData(int, bool)), Qt::DirectConnection);
   connect(video.data(), &videoHandler::signalUpdateFrameLimits, this,  &playlistItemRawFile::slotUpdateFrameLimits);
 
   // Connect the basic signals from the video
@@ -128,6 +151,19 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
 
   // A raw file can be cached.
   cachingEnabled = true;
+
+  // Other items may read from the same file. They can share the frames that were read.
+  sharedSourcePath = sharedFrameStore::getSourcePath(rawFilePath);
+  sharedFrameStore::instance().addSourceReference(sharedSourcePath);
+}
+
+playlistItemRawFile::~playlistItemRawFile()
+{
+  // Stop the read ahead thread (if running)
+  clearReadAheadBuffers();
+
+  if (!sharedSourcePath.isEmpty())
+    sharedFrameStore::instance().removeSourceReference(sharedSourcePath);
 }
 
 qint64 playlistItemRawFile::getNumberFrames() const
@@ -256,28 +292,38 @@ bool playlistItemRawFile::parseY4MFile()
     }
     else if (parameterIndicator == 'C')
     {
-      // Get 3 bytes and check them
-      QByteArray formatName;
-      formatName.append(rawData.at(offset++));
-      formatName.append(rawData.at(offset++));
-      formatName.append(rawData.at(offset++));
-
-      // The YUV format. By default, YUV420 is setup.
-      // TDOO: What is the difference between these two formats?
-      // 'C420' = 4:2:0 with coincident chroma planes
-      // 'C420jpeg' = 4:2 : 0 with biaxially - displaced chroma planes
-      // 'C420paldv' = 4 : 2 : 0 with vertically - displaced chroma planes
-      if (formatName == "422")
+      // The color space (up to the next space or 0x0A). By default, YUV420 is setup.
+      // The chroma siting variants ('420jpeg', '420paldv', '420mpeg2') only differ in the chroma position.
+      // High bit depths are indicated by 'p' and the bit depth ('420p10', '444p16') or 'mono16'.
+      QByteArray colorSpace;
+      while (offset < rawData.count() && rawData.at(offset) != ' ' && rawData.at(offset) != 10)
+        colorSpace.append(rawData.at(offset++));
+
+      if (colorSpace.startsWith("422"))
         format.subsampling = YUV_422;
-      else if (formatName == "444")
+      else if (colorSpace.startsWith("444"))
         format.subsampling = YUV_444;
-
-      if (rawData.at(offset) == 'p' && rawData.at(offset+1) == '1' && rawData.at(offset+2) == '0')
+      else if (colorSpace.startsWith("411"))
+        format.subsampling = YUV_411;
+      else if (colorSpace.startsWith("mono"))
+        format.subsampling = YUV_400;
+      else if (!colorSpace.startsWith("420"))
+        return setError(QString("Error parsing the Y4M header: Unsupported color space '%1'.").arg(QString(colorSpace)));
+
+      if (colorSpace == "444alpha")
+        format.planeOrder = Order_YUVA;
+
+      // High bit depth samples are stored in two bytes (little endian)
+      QRegExp bitDepthRegExp("^(\\d{3}p|mono)(\\d+)$");
+      if (bitDepthRegExp.indexIn(QString(colorSpace)) != -1)
       {
-        format.bitsPerSample = 10;
-        format.planar = true;
-        offset += 3;
+        int bitDepth = bitDepthRegExp.cap(2).toInt();
+        if (bitDepth < 8 || bitDepth > 16)
+          return setError(QString("Error parsing the Y4M header: Unsupported bit depth %1.").arg(bitDepth));
+        format.bitsPerSample = bitDepth;
+        format.bigEndian = false;
       }
+      format.planar = true;
     }
 
     // If not already there, seek to the next space (a 0x0A ends the header).
@@ -304,53 +350,98 @@ bool playlistItemRawFile::parseY4MFile()
   // paramters for the frame. The 'FRAME' indicator is terminated by a 0x0A. The list of parameters is 
   // also terminated by 0x0A.
 
-  // The offset in bytes to the next frame
-  int stride = width * height * 3 / 2;
-  if (format.subsampling == YUV_422)
-    stride = width * height * 2;
-  else if (format.subsampling == YUV_444)
-    stride = width * height * 3;
-  if (format.bitsPerSample > 8)
-    stride *= 2;
-  
-  while (true)
+  // The number of bytes of the raw YUV data of each frame
+  const qint64 frameSize = format.bytesPerFrame(QSize(width, height));
+  if (frameSize <= 0)
+    return setError("Error parsing the Y4M header: Invalid frame size.");
+
+  y4mFrameIndices.clear();
+  const qint64 fileSize = dataSource.getFileSize();
+  if (!indexY4MFramesConstantHeader(offset, frameSize, fileSize))
   {
-    // Seek the file to 'offset' and read a few bytes
-    if (dataSource.readBytes(rawData, offset, 20) < 20)
-      return setError("Error parsing the Y4M header: The file ended unexpectedly.");
+    // The frame headers differ. Search all of them.
+    y4mFrameIndices.clear();
+    if (!indexY4MFramesScan(offset, frameSize, fileSize))
+      return false;
+  }
 
-    QByteArray frameIndicator = rawData.mid(0, 5);
-    if (frameIndicator != "FRAME")
-      return setError("Error parsing the Y4M header: Could not locate the next 'FRAME' indicator.");
+  // Success. Set the format and return true;
+  video->setFrameSize(QSize(width, height));
+  getYUVVideo()->setYUVPixelFormat(format);
+  return true;
+}
 
-    // We will now ignore all frame parameters by searching for the next 0x0A byte. I don't know what
-    // we could do with these parameters. 
-    offset += 5;
-    int internalOffset = 5;
-    while (rawData.at(internalOffset) != 10 && internalOffset < 20)
+bool playlistItemRawFile::indexY4MFramesConstantHeader(qint64 offset, qint64 frameSize, qint64 fileSize)
+{
+  // Read the header of the first frame. It is terminated by a 0x0A.
+  QByteArray header;
+  const qint64 nrBytes = dataSource.readBytes(header, offset, Y4M_MAX_FRAME_HEADER_LENGTH);
+  if (nrBytes < 6 || !header.startsWith("FRAME"))
+    return false;
+  const int headerLength = header.left(nrBytes).indexOf(char(10)) + 1;
+  if (headerLength <= 0)
+    return false;
+  header.truncate(headerLength);
+
+  // If all headers are identical, the file consists of a whole number of (header + frame) blocks
+  const qint64 frameStride = headerLength + frameSize;
+  const qint64 dataSize = fileSize - offset;
+  if (dataSize % frameStride != 0)
+    return false;
+  const qint64 nrFrames = dataSize / frameStride;
+
+  // Check that the header is identical at a few frames spread over the file (including the last one)
+  QByteArray sample;
+  for (int i = 1; i <= Y4M_VERIFY_SAMPLES; i++)
+  {
+    const qint64 frameIdx = (nrFrames - 1) * i / Y4M_VERIFY_SAMPLES;
+    if (dataSource.readBytes(sample, offset + frameIdx * frameStride, headerLength) < headerLength)
+      return false;
+    if (sample.left(headerLength) != header)
+      return false;
+  }
+
+  y4mFrameIndices.reserve(nrFrames);
+  for (qint64 i = 0; i < nrFrames; i++)
+    y4mFrameIndices.append(offset + i * frameStride + headerLength);
+  return true;
+}
+
+bool playlistItemRawFile::indexY4MFramesScan(qint64 offset, qint64 frameSize, qint64 fileSize)
+{
+  // If the frames are small, several frame headers are in one large read. Otherwise, only the header is read.
+  const qint64 readSize = (frameSize < Y4M_SCAN_BUFFER_SIZE / 4) ? Y4M_SCAN_BUFFER_SIZE : Y4M_MAX_FRAME_HEADER_LENGTH;
+  QByteArray buffer;
+  qint64 bufferStart = 0;
+  qint64 bufferLength = 0;
+
+  while (offset < fileSize)
+  {
+    if (offset + Y4M_MAX_FRAME_HEADER_LENGTH > bufferStart + bufferLength)
     {
-      offset++;
-      internalOffset++;
+      // The header is not (completely) in the buffer. Read the next block.
+      bufferStart = offset;
+      bufferLength = dataSource.readBytes(buffer, offset, readSize);
     }
 
-    // Go to the first byte of the YUV frame
-    offset++;
-    internalOffset++;
+    const char *header = buffer.constData() + (offset - bufferStart);
+    const qint64 available = bufferStart + bufferLength - offset;
+    if (available < 6)
+      return setError("Error parsing the Y4M header: The file ended unexpectedly.");
+    if (memcmp(header, "FRAME", 5) != 0)
+      return setError("Error parsing the Y4M header: Could not locate the next 'FRAME' indicator.");
 
-    if (internalOffset == 19)
+    // We ignore all frame parameters by searching for the next 0x0A byte.
+    const char *headerEnd = (const char*)memchr(header + 5, 10, std::min(available, qint64(Y4M_MAX_FRAME_HEADER_LENGTH)) - 5);
+    if (headerEnd == nullptr)
       return setError("Error parsing the Y4M header: The file ended unexpectedly.");
 
-    // Add the frame offset value
+    // Add the offset of the first byte of the YUV frame
+    offset += (headerEnd - header) + 1;
     y4mFrameIndices.append(offset);
-
-    offset += stride;
-    if (offset >= dataSource.getFileSize())
-      break;
+    offset += frameSize;
   }
 
-  // Success. Set the format and return true;
-  video->setFrameSize(QSize(width, height));
-  getYUVVideo()->setYUVPixelFormat(format);
   return true;
 }
 
@@ -458,37 +549,186 @@ playlistItemRawFile *playlistItemRawFile::newplaylistItemRawFile(const QDomEleme
   return newFile;
 }
 
-void playlistItemRawFile::loadRawData(int frameIdxInternal)
+qint64 playlistItemRawFile::getFileStartPos(int frameIdxInternal) const
+{
+  if (isY4MFile)
+    return (frameIdxInternal < y4mFrameIndices.count()) ? y4mFrameIndices.at(frameIdxInternal) : -1;
+  return frameIdxInternal * getBytesPerFrame();
+}
+
+void playlistItemRawFile::loadRawData(int frameIdxInternal, bool caching)
 {
   if (!video->isFormatValid())
     return;
 
-  DEBUG_RAWFILE("playlistItemRawFile::loadRawData %d", frameIdx);
+  DEBUG_RAWFILE("playlistItemRawFile::loadRawData %d", frameIdxInternal);
 
   // Load the raw data for the given frameIdx from file and set it in the video
-  qint64 fileStartPos;
-  if (isY4MFile)
-    fileStartPos = y4mFrameIndices.at(frameIdxInternal);
-  else
-    fileStartPos = frameIdxInternal * getBytesPerFrame();
-  qint64 nrBytes = getBytesPerFrame();
+  const qint64 fileStartPos = getFileStartPos(frameIdxInternal);
+  const qint64 nrBytes = getBytesPerFrame();
+  QByteArray &targetBuffer = (rawFormat == YUV) ? getYUVVideo()->rawYUVData : getRGBVideo()->rawRGBData;
 
-  if (rawFormat == YUV)
+  // Take the frame from the read ahead buffers if it was read already. Then check if another item that reads
+  // from the same file already read it. Otherwise read it now.
+  if (!takeReadAheadFrame(frameIdxInternal, fileStartPos, nrBytes, targetBuffer))
   {
-    if (dataSource.readBytes(getYUVVideo()->rawYUVData, fileStartPos, nrBytes) < nrBytes)
-      return; // Error
-    getYUVVideo()->rawYUVData_frameIdx = frameIdxInternal;
+    const QString storeFormat = QString("raw:%1").arg(nrBytes);
+    if (!sharedFrameStore::instance().getFrame(sharedSourcePath, storeFormat, fileStartPos, targetBuffer))
+    {
+      if (dataSource.readBytes(targetBuffer, fileStartPos, nrBytes) < nrBytes)
+        return; // Error
+      sharedFrameStore::instance().addFrame(sharedSourcePath, storeFormat, fileStartPos, targetBuffer);
+    }
   }
+
+  if (rawFormat == YUV)
+    getYUVVideo()->rawYUVData_frameIdx = frameIdxInternal;
   else if (rawFormat == RGB)
-  {
-    if (dataSource.readBytes(getRGBVideo()->rawRGBData, fileStartPos, nrBytes) < nrBytes)
-      return; // Error
     getRGBVideo()->rawRGBData_frameIdx = frameIdxInternal;
-  }
+
+  // The frame was requested for playback. Read the following frames while this one is converted.
+  if (!caching && readAheadPlaying)
+    startReadAhead(frameIdxInternal + 1);
 
   DEBUG_RAWFILE("playlistItemRawFile::loadRawData %d Done", frameIdxInternal);
 }
 
+void playlistItemRawFile::loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals)
+{
+  readAheadPlaying = playing;
+  playlistItemWithVideo::loadFrame(frameIdx, playing, loadRawData, emitSignals);
+  readAheadPlaying = false;
+}
+
+int playlistItemRawFile::getReadAheadDepth() const
+{
+  const qint64 bpf = getBytesPerFrame();
+  if (bpf <= 0)
+    return 0;
+  return int(clip(qint64(RAWFILE_READ_AHEAD_MAX_BYTES) / bpf, qint64(1), qint64(RAWFILE_READ_AHEAD_MAX_FRAMES)));
+}
+
+bool playlistItemRawFile::takeReadAheadFrame(int frameIdxInternal, qint64 fileStartPos, qint64 nrBytes, QByteArray &targetBuffer)
+{
+  QMutexLocker lock(&readAheadMutex);
+  auto it = readAheadBuffers.find(frameIdxInternal);
+  if (it == readAheadBuffers.end())
+    return false;
+
+  // The format might have changed since the frame was read
+  bool valid = (it->filePos == fileStartPos && it->data.size() >= nrBytes);
+  if (valid)
+  {
+    // Swap the buffers. The old buffer of the video handler can be reused for reading ahead.
+    targetBuffer.swap(it->data);
+    DEBUG_RAWFILE("playlistItemRawFile::takeReadAheadFrame %d", frameIdxInternal);
+  }
+  if (it->data.size() > 0)
+    readAheadBufferPool.append(it->data);
+  readAheadBuffers.erase(it);
+  return valid;
+}
+
+void playlistItemRawFile::startReadAhead(int frameIdxInternal)
+{
+  const int depth = getReadAheadDepth();
+  const int lastFrame = std::min(frameIdxInternal + depth - 1, startEndFrame.second);
+  if (depth == 0 || frameIdxInternal > lastFrame)
+    return;
+
+  QMutexLocker lock(&readAheadMutex);
+  if (frameIdxInternal == readAheadStartFrame)
+    // Nothing changed
+    return;
+  readAheadStartFrame = frameIdxInternal;
+
+  // Drop all frames that are not in the new read ahead range
+  for (auto it = readAheadBuffers.begin(); it != readAheadBuffers.end();)
+  {
+    if (it.key() < frameIdxInternal || it.key() > lastFrame)
+    {
+      readAheadBufferPool.append(it->data);
+      it = readAheadBuffers.erase(it);
+    }
+    else
+      ++it;
+  }
+  while (readAheadBufferPool.count() > depth)
+    readAheadBufferPool.removeLast();
+
+  // Let the system start reading the whole range. The thread then reads the frames one by one from the system cache.
+  const qint64 startPos = getFileStartPos(frameIdxInternal);
+  const qint64 endPos = getFileStartPos(lastFrame);
+  if (startPos >= 0 && endPos >= startPos)
+    dataSource.adviseWillNeed(startPos, endPos - startPos + getBytesPerFrame());
+
+  if (!readAheadRunning)
+  {
+    readAheadRunning = true;
+    cancelReadAhead = false;
+    readAheadFuture = QtConcurrent::run(this, &playlistItemRawFile::readAheadWorker);
+  }
+}
+
+void playlistItemRawFile::readAheadWorker()
+{
+  while (true)
+  {
+    // Get the next frame in the read ahead range that was not read yet
+    QMutexLocker lock(&readAheadMutex);
+    const int depth = getReadAheadDepth();
+    const int lastFrame = std::min(readAheadStartFrame + depth - 1, startEndFrame.second);
+    int frameIdx = readAheadStartFrame;
+    while (frameIdx <= lastFrame && readAheadBuffers.contains(frameIdx))
+      frameIdx++;
+    if (cancelReadAhead || frameIdx > lastFrame)
+    {
+      // Everything was read. startReadAhead will restart the thread when the range moves.
+      readAheadRunning = false;
+      return;
+    }
+    QByteArray buffer = readAheadBufferPool.isEmpty() ? QByteArray() : readAheadBufferPool.takeLast();
+    lock.unlock();
+
+    // Read the frame. This is the only part that is done without the lock.
+    const qint64 fileStartPos = getFileStartPos(frameIdx);
+    const qint64 nrBytes = getBytesPerFrame();
+    DEBUG_RAWFILE("playlistItemRawFile::readAheadWorker reading frame %d", frameIdx);
+    const bool readOk = (fileStartPos >= 0 && dataSource.readBytes(buffer, fileStartPos, nrBytes) == nrBytes);
+
+    lock.relock();
+    if (!readOk)
+    {
+      // Reading failed (e.g. the end of the file). Stop here.
+      readAheadRunning = false;
+      return;
+    }
+    if (frameIdx >= readAheadStartFrame)
+    {
+      readAheadBuffer newBuffer;
+      newBuffer.filePos = fileStartPos;
+      newBuffer.data = buffer;
+      readAheadBuffers.insert(frameIdx, newBuffer);
+    }
+    else
+      // The playback already passed this frame
+      readAheadBufferPool.append(buffer);
+  }
+}
+
+void playlistItemRawFile::clearReadAheadBuffers()
+{
+  readAheadMutex.lock();
+  cancelReadAhead = true;
+  readAheadMutex.unlock();
+  readAheadFuture.waitForFinished();
+
+  QMutexLocker lock(&readAheadMutex);
+  readAheadBuffers.clear();
+  readAheadBufferPool.clear();
+  readAheadStartFrame = -1;
+}
+
 ValuePairListSets playlistItemRawFile::getPixelValues(const QPoint &pixelPos, int frameIdx)
 {
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
@@ -523,6 +763,11 @@ qint64 playlistItemRawFile::getBytesPerFrame() const
 
 void playlistItemRawFile::reloadItemSource()
 {
+  // The data that was read ahead (or shared with other items) is outdated
+  clearReadAheadBuffers();
+  if (!sharedSourcePath.isEmpty())
+    sharedFrameStore::instance().removeSource(sharedSourcePath);
+
   // Reopen the file
   dataSource.openFile(plItemNameOrFileName);
   if (!dataSource.isOk())
@@ -34,6 +34,8 @@
 #define PLAYLISTITEMRAWFILE_H
 
 #include <QFuture>
+#include <QMap>
+#include <QMutex>
 #include <QString>
 #include "fileSource.h"
 #include "playlistItemWithVideo.h"
@@ -50,6 +52,7 @@ public:
   // extensions (getSupportedFileExtensions), set the format "fmt" to either "rgb" or "yuv". If you already know the frame size and/or 
   // sourcePixelFormat, you can set them as well.
   playlistItemRawFile(const QString &rawFilePath, const QSize &frameSize=QSize(-1,-1), const QString &sourcePixelFormat=QString(), const QString &fmt=QString());
+  virtual ~playlistItemRawFile();
 
   // Overload from playlistItem. Save the raw file item to playlist.
   virtual void savePlaylist(QDomElement &root, const QDir &playlistDir) const Q_DECL_OVERRIDE;
@@ -78,10 +81,14 @@ public:
   // Cache the given frame
   virtual void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE { if (testMode) dataSource.clearFileCache(); playlistItemWithVideo::cacheFrame(idx, testMode); }
 
+  // Override from playlistItemWithVideo. Remember if we are playing so that the frames are only read ahead while playing.
+  virtual void loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals=true) Q_DECL_OVERRIDE;
+
 public slots:
   // Load the raw data for the given frame index from file. This slot is called by the videoHandler if the frame that is
-  // requested to be drawn has not been loaded yet.
-  virtual void loadRawData(int frameIdxInternal);
+  // requested to be drawn has not been loaded yet. If the frame is loaded for playback (not for caching), the
+  // following frames are read ahead in the background.
+  virtual void loadRawData(int frameIdxInternal, bool caching);
 
 protected:
   // Override from playlistItemIndexed. For a raw file the index range is 0...numFrames-1. 
@@ -107,6 +114,8 @@ private:
   virtual qint64 getNumberFrames() const;
   
   fileSource dataSource;
+  // The path that identifies the file in the sharedFrameStore (empty if the file could not be opened)
+  QString sharedSourcePath;
   
   videoHandlerYUV *getYUVVideo() { return dynamic_cast<videoHandlerYUV*>(video.data()); }
   videoHandlerRGB *getRGBVideo() { return dynamic_cast<videoHandlerRGB*>(video.data()); }
@@ -114,13 +123,50 @@ private:
   const videoHandlerRGB *getRGBVideo() const { return dynamic_cast<const videoHandlerRGB*>(video.data()); }
 
   qint64 getBytesPerFrame() const;
+  // Get the position of the given frame in the file
+  qint64 getFileStartPos(int frameIdxInternal) const;
 
   // A y4m file is a raw YUV file but it adds a header (which has information about the YUV format)
   // and start indicators for every frame. This file will parse the header and save all the byte
   // offsets for each raw YUV frame.
   bool parseY4MFile();
+  // Fill y4mFrameIndices for the frames starting at the given offset. If all frame headers have the same length,
+  // the positions can be calculated (this is checked for a few frames). Otherwise, all frame headers are searched.
+  bool indexY4MFramesConstantHeader(qint64 offset, qint64 frameSize, qint64 fileSize);
+  bool indexY4MFramesScan(qint64 offset, qint64 frameSize, qint64 fileSize);
   bool isY4MFile;
   QList<quint64> y4mFrameIndices;
+
+  // --- Read ahead ---
+  // While playing back, the raw data of the frames after the current frame is read sequentially by a background
+  // thread. The buffers are handed to the videoHandler when it requests the frame (swapped, not copied), so reading
+  // the file and converting the frames (in the caching/loading threads) overlap.
+  struct readAheadBuffer
+  {
+    qint64 filePos;
+    QByteArray data;
+  };
+  QMap<int, readAheadBuffer> readAheadBuffers;
+  // Buffers that are not used anymore. They are reused so that the memory does not have to be allocated for every frame.
+  QList<QByteArray> readAheadBufferPool;
+  // The background thread reads the frames from readAheadStartFrame on
+  int readAheadStartFrame;
+  bool readAheadRunning;
+  bool cancelReadAhead;
+  // Protects all the read ahead variables
+  QMutex readAheadMutex;
+  QFuture<void> readAheadFuture;
+  // Is the frame that is currently loaded (by loadFrame) loaded for playback? Only used by the loading thread.
+  bool readAheadPlaying;
+  // Set the frame from which on the frames are read ahead. Start the background thread if it is not running.
+  void startReadAhead(int frameIdxInternal);
+  void readAheadWorker();
+  // Get the data of the given frame from the read ahead buffers. Return false if the frame was not read ahead.
+  bool takeReadAheadFrame(int frameIdxInternal, qint64 fileStartPos, qint64 nrBytes, QByteArray &targetBuffer);
+  // Stop the background thread and drop all read ahead frames
+  void clearReadAheadBuffers();
+  // How many frames to read ahead (limited by the size of the frames)
+  int getReadAheadDepth() const;
 };
 
 #endif // PLAYLISTITEMRAWFILE_H
@@ -32,6 +32,8 @@
 
 #include "playlistItemWithVideo.h"
 
+#include <algorithm>
+
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
 #define PLAYLISTITEMWITHVIDEO_DEBUG_LOADING 0
 #if PLAYLISTITEMWITHVIDEO_DEBUG_LOADING && !NDEBUG
@@ -69,6 +71,18 @@ void playlistItemWithVideo::drawItem(QPainter *painter, int frameIdx, double zoo
     video->drawFrame(painter, frameIdxInternal, zoomFactor, drawRawValues);
 }
 
+QImage playlistItemWithVideo::getFrameImage(int frameIdx)
+{
+  if (unresolvableError || !video->isFormatValid())
+    return QImage();
+
+  indexRange range = getStartEndFrameLimits();
+  const int frameIdxInternal = getFrameIdxInternal(frameIdx);
+  if (frameIdxInternal < range.first || frameIdxInternal > range.second)
+    return QImage();
+  return video->getFrameImage(frameIdxInternal);
+}
+
 void playlistItemWithVideo::loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals)
 {
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
@@ -86,18 +100,23 @@ void playlistItemWithVideo::loadFrame(int frameIdx, bool playing, bool loadRawDa
   }
   
   if (playing && (state == LoadingNeeded || state == LoadingNeededDoubleBuffer))
+    loadFramesToDoubleBuffer(frameIdxInternal, emitSignals);
+}
+
+void playlistItemWithVideo::loadFramesToDoubleBuffer(int frameIdxInternal, bool emitSignals)
+{
+  const int lastFrameIdx = std::min(frameIdxInternal + videoHandler::getDoubleBufferQueueDepth(), startEndFrame.second);
+  for (int nextFrameIdx = frameIdxInternal + 1; nextFrameIdx <= lastFrameIdx; nextFrameIdx++)
   {
-    // Load the next frame into the double buffer
-    int nextFrameIdx = frameIdxInternal + 1;
-    if (nextFrameIdx <= startEndFrame.second)
-    {
-      DEBUG_PLVIDEO("playlistItemWithVideo::loadFrame loading frame into double buffer %d%s%s", nextFrameIdx, playing ? " playing" : "", loadRawData ? " raw" : "");
-      isFrameLoadingDoubleBuffer = true;
-      video->loadFrame(nextFrameIdx, true);
-      isFrameLoadingDoubleBuffer = false;
-      if (emitSignals)
-        emit signalItemDoubleBufferLoaded();
-    }
+    if (video->isFrameAvailable(nextFrameIdx))
+      continue;
+
+    DEBUG_PLVIDEO("playlistItemWithVideo::loadFramesToDoubleBuffer loading frame into double buffer %d", nextFrameIdx);
+    isFrameLoadingDoubleBuffer = true;
+    video->loadFrame(nextFrameIdx, true);
+    isFrameLoadingDoubleBuffer = false;
+    if (emitSignals)
+      emit signalItemDoubleBufferLoaded();
   }
 }
 
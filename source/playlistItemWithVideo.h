@@ -51,8 +51,8 @@ public:
   // All the functions that we have to overload if we are using a video handler
   virtual QSize getSize() const Q_DECL_OVERRIDE { return (video) ? video->getFrameSize() : QSize(); }
   virtual frameHandler *getFrameHandler() Q_DECL_OVERRIDE { return video.data(); }
-  // Activate the double buffer (set it as current frame)
-  virtual void activateDoubleBuffer() Q_DECL_OVERRIDE { if (video) video->activateDoubleBuffer(); }
+  // Activate the double buffer (take the given frame from the playback queue and set it as current frame)
+  virtual void activateDoubleBuffer(int frameIdx) Q_DECL_OVERRIDE { if (video) video->activateDoubleBuffer(getFrameIdxInternal(frameIdx)); }
 
   // Do we need to load the frame first?
   virtual itemLoadingState needsLoading(int frameIdx, bool loadRawValues) Q_DECL_OVERRIDE;
@@ -65,11 +65,17 @@ public:
   virtual int getNumberCachedFrames() const Q_DECL_OVERRIDE { return video->getNumberCachedFrames(); }
   // How many bytes will caching one frame use (in bytes)?
   virtual unsigned int getCachingFrameSize() const Q_DECL_OVERRIDE { return video->getCachingFrameSize(); }
+  // The frames in the other cache layers of the video
+  virtual qint64 getAdditionalCacheSize() const Q_DECL_OVERRIDE { return video->getOtherCacheLayersSize(); }
+  virtual void removeAdditionalCache() Q_DECL_OVERRIDE { video->removeOtherCacheLayers(); }
   // Remove the given frame from the cache
   virtual void removeFrameFromCache(int idx) Q_DECL_OVERRIDE { video->removeFrameFromCache(getFrameIdxInternal(idx)); }
   virtual void removeAllFramesFromCache() Q_DECL_OVERRIDE { video->removeAllFrameFromCache(); }
   // This item is cachable, if caching is enabled and if the raw format is valid (can be cached).
   virtual bool isCachable() const Q_DECL_OVERRIDE { return playlistItem::isCachable() && video->isFormatValid(); }
+  // Get the image of the given frame without changing what is drawn (e.g. to render it into another image).
+  // This is thread-safe. A null image is returned if the frame is out of range or could not be loaded.
+  QImage getFrameImage(int frameIdx);
 
   // Load the frame in the video item. Emit signalItemChanged(true) when done.
   virtual void loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals=true) Q_DECL_OVERRIDE;
@@ -85,6 +91,11 @@ protected:
   // Connect the basic signals from the video
   void connectVideo();
 
+  // While playing, fill the playback queue of the video handler with the frames following frameIdxInternal
+  // (up to the queue depth). Frames that are already queued or cached are skipped. After each frame,
+  // signalItemDoubleBufferLoaded is emitted so that a stalled playback can resume as soon as possible.
+  void loadFramesToDoubleBuffer(int frameIdxInternal, bool emitSignals);
+
   // Is the loadFrame function currently loading?
   bool isFrameLoading;
   bool isFrameLoadingDoubleBuffer;
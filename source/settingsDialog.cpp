@@ -107,6 +107,7 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
   settings.beginGroup("VideoCache");
   ui.groupBoxCaching->setChecked(settings.value("Enabled", true).toBool());
   ui.sliderThreshold->setValue(settings.value("ThresholdValue", 49).toInt());
+  ui.checkBoxAdaptiveCacheBudget->setChecked(settings.value("AdaptiveBudget", false).toBool());
   ui.checkBoxNrThreads->setChecked(settings.value("SetNrThreads", false).toBool());
   if (ui.checkBoxNrThreads->isChecked())
     ui.spinBoxNrThreads->setValue(settings.value("NrThreads", getOptimalThreadCount()).toInt());
@@ -119,6 +120,12 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
   ui.checkBoxEnablePlaybackCaching->setChecked(playbackCaching);
   ui.spinBoxThreadLimit->setValue(settings.value("PlaybackCachingThreadLimit", 1).toInt());
   ui.spinBoxThreadLimit->setEnabled(playbackCaching);
+  ui.spinBoxPlaybackQueueDepth->setValue(settings.value("PlaybackQueueDepth", 4).toInt());
+  ui.checkBoxPlaybackDropFrames->setChecked(settings.value("PlaybackDropFrames", false).toBool());
+  // Disk cache
+  ui.groupBoxDiskCache->setChecked(settings.value("DiskCacheEnabled", false).toBool());
+  ui.lineEditDiskCachePath->setText(settings.value("DiskCachePath", "").toString());
+  ui.spinBoxDiskCacheSize->setValue(settings.value("DiskCacheSizeGB", 16).toInt());
   settings.endGroup();
 
   // "Decoders" tab
@@ -132,6 +139,7 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
   ui.lineEditAVCodec->setText(settings.value("FFMpeg.avcodec", "").toString());
   ui.lineEditAVUtil->setText(settings.value("FFMpeg.avutil", "").toString());
   ui.lineEditSWResample->setText(settings.value("FFMpeg.swresample", "").toString());
+  ui.spinBoxFFMpegThreads->setValue(settings.value("FFMpeg.threads", 0).toInt());
   settings.endGroup();
 }
 
@@ -196,6 +204,22 @@ void SettingsDialog::on_pushButtonDecoderSelectPath_clicked()
   }
 }
 
+void SettingsDialog::on_pushButtonDiskCacheSelectPath_clicked()
+{
+  // Use the currently selected dir or the temporary dir if this one does not exist.
+  QDir curDir = QDir(ui.lineEditDiskCachePath->text());
+  if (ui.lineEditDiskCachePath->text().isEmpty() || !curDir.exists())
+    curDir = QDir::temp();
+
+  QFileDialog pathDialog(this);
+  pathDialog.setDirectory(curDir);
+  pathDialog.setFileMode(QFileDialog::Directory);
+  pathDialog.setOption(QFileDialog::ShowDirsOnly);
+
+  if (pathDialog.exec())
+    ui.lineEditDiskCachePath->setText(pathDialog.selectedFiles()[0]);
+}
+
 QStringList SettingsDialog::getLibraryPath(QString currentFile, QString caption, bool multipleFiles)
 {
   // Open a file selection dialog
@@ -333,11 +357,17 @@ void SettingsDialog::on_pushButtonSave_clicked()
   settings.setValue("Enabled", ui.groupBoxCaching->isChecked());
   settings.setValue("ThresholdValue", ui.sliderThreshold->value());
   settings.setValue("ThresholdValueMB", getCacheSizeInMB());
+  settings.setValue("AdaptiveBudget", ui.checkBoxAdaptiveCacheBudget->isChecked());
   settings.setValue("SetNrThreads", ui.checkBoxNrThreads->isChecked());
   settings.setValue("NrThreads", ui.spinBoxNrThreads->value());
   settings.setValue("PlaybackPauseCaching", ui.checkBoxPausPlaybackForCaching->isChecked());
   settings.setValue("PlaybackCachingEnabled", ui.checkBoxEnablePlaybackCaching->isChecked());
   settings.setValue("PlaybackCachingThreadLimit", ui.spinBoxThreadLimit->value());
+  settings.setValue("PlaybackQueueDepth", ui.spinBoxPlaybackQueueDepth->value());
+  settings.setValue("PlaybackDropFrames", ui.checkBoxPlaybackDropFrames->isChecked());
+  settings.setValue("DiskCacheEnabled", ui.groupBoxDiskCache->isChecked());
+  settings.setValue("DiskCachePath", ui.lineEditDiskCachePath->text());
+  settings.setValue("DiskCacheSizeGB", ui.spinBoxDiskCacheSize->value());
   settings.endGroup();
 
   // "Decoders" tab
@@ -352,6 +382,7 @@ void SettingsDialog::on_pushButtonSave_clicked()
   settings.setValue("FFMpeg.avcodec", ui.lineEditAVCodec->text());
   settings.setValue("FFMpeg.avutil", ui.lineEditAVUtil->text());
   settings.setValue("FFMpeg.swresample", ui.lineEditSWResample->text());
+  settings.setValue("FFMpeg.threads", ui.spinBoxFFMpegThreads->value());
   settings.endGroup();
   
   accept();
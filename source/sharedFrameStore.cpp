@@ -0,0 +1,170 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "sharedFrameStore.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+
+// The maximum amount of memory that the shared frames may use (in bytes)
+#define SHARED_FRAME_STORE_MAX_BYTES (qint64(512) * 1024 * 1024)
+
+sharedFrameStore &sharedFrameStore::instance()
+{
+  static sharedFrameStore store;
+  return store;
+}
+
+sharedFrameStore::sharedFrameStore()
+{
+  nrBytes = 0;
+  useCounter = 0;
+}
+
+QString sharedFrameStore::getSourcePath(const QString &filePath)
+{
+  QFileInfo fileInfo(filePath);
+  QString path = fileInfo.canonicalFilePath();
+  if (path.isEmpty())
+    path = fileInfo.absoluteFilePath();
+  return path;
+}
+
+void sharedFrameStore::addSourceReference(const QString &filePath)
+{
+  QMutexLocker lock(&accessMutex);
+  sourceReferences[filePath]++;
+}
+
+void sharedFrameStore::removeSourceReference(const QString &filePath)
+{
+  QMutexLocker lock(&accessMutex);
+  auto it = sourceReferences.find(filePath);
+  if (it == sourceReferences.end())
+    return;
+
+  const int references = --it.value();
+  if (references <= 0)
+    sourceReferences.erase(it);
+  if (references <= 1)
+  {
+    // The frames are not shared anymore
+    lock.unlock();
+    removeSource(filePath);
+  }
+}
+
+bool sharedFrameStore::getFrame(const QString &filePath, const QString &format, qint64 frameKey, QByteArray &data)
+{
+  QMutexLocker lock(&accessMutex);
+  auto source = frames.find(filePath);
+  if (source == frames.end())
+    return false;
+  auto it = source->find(frameID(format, frameKey));
+  if (it == source->end())
+    return false;
+
+  useOrder.remove(it->lastUse);
+  it->lastUse = ++useCounter;
+  useOrder.insert(it->lastUse, qMakePair(filePath, it.key()));
+  data = it->data;
+  return true;
+}
+
+void sharedFrameStore::addFrame(const QString &filePath, const QString &format, qint64 frameKey, const QByteArray &data)
+{
+  if (data.isEmpty() || data.size() > SHARED_FRAME_STORE_MAX_BYTES)
+    return;
+
+  QMutexLocker lock(&accessMutex);
+  if (sourceReferences.value(filePath) < 2)
+    // Only one item reads from this file. Nothing to share.
+    return;
+
+  QHash<frameID, storedFrame> &sourceFrames = frames[filePath];
+  auto it = sourceFrames.find(frameID(format, frameKey));
+  if (it != sourceFrames.end())
+  {
+    nrBytes -= it->data.size();
+    useOrder.remove(it->lastUse);
+    sourceFrames.erase(it);
+  }
+
+  storedFrame frame;
+  frame.data = data;
+  frame.lastUse = ++useCounter;
+  sourceFrames.insert(frameID(format, frameKey), frame);
+  useOrder.insert(frame.lastUse, qMakePair(filePath, frameID(format, frameKey)));
+  nrBytes += data.size();
+
+  while (nrBytes > SHARED_FRAME_STORE_MAX_BYTES)
+    removeLeastRecentlyUsedFrame();
+}
+
+void sharedFrameStore::removeSource(const QString &filePath)
+{
+  QMutexLocker lock(&accessMutex);
+  auto source = frames.find(filePath);
+  if (source == frames.end())
+    return;
+
+  for (const storedFrame &frame : source.value())
+  {
+    nrBytes -= frame.data.size();
+    useOrder.remove(frame.lastUse);
+  }
+  frames.erase(source);
+}
+
+void sharedFrameStore::removeLeastRecentlyUsedFrame()
+{
+  // The mutex must be locked
+  if (useOrder.isEmpty())
+  {
+    nrBytes = 0;
+    return;
+  }
+
+  const QPair<QString, frameID> oldest = useOrder.take(useOrder.firstKey());
+  auto source = frames.find(oldest.first);
+  if (source == frames.end())
+    return;
+  auto it = source->find(oldest.second);
+  if (it != source->end())
+  {
+    nrBytes -= it->data.size();
+    source->erase(it);
+  }
+  if (source->isEmpty())
+    frames.erase(source);
+}
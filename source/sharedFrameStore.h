@@ -0,0 +1,95 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SHAREDFRAMESTORE_H
+#define SHAREDFRAMESTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+/* A process wide store of raw (or decoded) frame data that is shared by all playlist items which reference the same
+ * source file. If the same file is opened more than once (e.g. as a plain item and as a child of a difference or with
+ * different display settings), every item would read/decode its own copy of every frame. Items register the file
+ * that they read from. As soon as a file is referenced by more than one item, the frames that one item
+ * reads/decodes are put in here and the other items can take them from here (as implicitly shared QByteArrays).
+ * A frame is identified by the source file, a format string (everything else that determines the data,
+ * e.g. the number of bytes per frame or the decoder and the decoded signal) and a key (the frame index or the file
+ * position). The memory that the store may use is limited. If the limit is exceeded, the least recently used frames
+ * are dropped. All functions are thread save.
+ */
+class sharedFrameStore
+{
+public:
+  static sharedFrameStore &instance();
+
+  // Register/unregister an item that reads from the given file
+  void addSourceReference(const QString &filePath);
+  void removeSourceReference(const QString &filePath);
+
+  // Get the frame from the store. Return false if it is not in the store.
+  bool getFrame(const QString &filePath, const QString &format, qint64 frameKey, QByteArray &data);
+  // Add the frame to the store. Frames are only stored if more than one item references the file.
+  void addFrame(const QString &filePath, const QString &format, qint64 frameKey, const QByteArray &data);
+  // The file changed (it was reloaded). Remove all frames of the file.
+  void removeSource(const QString &filePath);
+
+  // Get the unique path that identifies the given file in the store
+  static QString getSourcePath(const QString &filePath);
+
+private:
+  sharedFrameStore();
+  Q_DISABLE_COPY(sharedFrameStore)
+
+  typedef QPair<QString, qint64> frameID;
+  struct storedFrame
+  {
+    QByteArray data;
+    quint64 lastUse;
+  };
+
+  void removeLeastRecentlyUsedFrame();
+
+  QMutex accessMutex;
+  QHash<QString, int> sourceReferences;
+  QHash<QString, QHash<frameID, storedFrame>> frames;
+  // All stored frames (source file and frame ID) sorted by their last use. The first one is the least recently used.
+  QMap<quint64, QPair<QString, frameID>> useOrder;
+  qint64 nrBytes;
+  quint64 useCounter;
+};
+
+#endif // SHAREDFRAMESTORE_H
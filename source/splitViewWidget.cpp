@@ -1808,7 +1808,7 @@ void splitViewWidget::update(bool newFrame, bool itemRedraw)
         // We can immediately draw the new frame but then we need to update the double buffer
         if (!isSeparateWidget)
         {
-          item[0]->activateDoubleBuffer();
+          item[0]->activateDoubleBuffer(frameIdx);
           cache->loadFrame(item[0], frameIdx, 0);
         }
       }
@@ -1828,7 +1828,7 @@ void splitViewWidget::update(bool newFrame, bool itemRedraw)
         // We can immediately draw the new frame but then we need to update the double buffer
         if (!isSeparateWidget)
         {
-          item[1]->activateDoubleBuffer();
+          item[1]->activateDoubleBuffer(frameIdx);
           cache->loadFrame(item[1], frameIdx, 1);
         }
       }
@@ -0,0 +1,99 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "startupTrace.h"
+
+#include <QDebug>
+
+startupTrace &startupTrace::instance()
+{
+  static startupTrace trace;
+  return trace;
+}
+
+startupTrace::startupTrace()
+{
+  enabled = false;
+  finished = false;
+  lastPhaseEnd = 0;
+  // Start as early as possible (the first call to instance())
+  timer.start();
+}
+
+void startupTrace::enable()
+{
+  QMutexLocker lock(&accessMutex);
+  enabled = true;
+}
+
+void startupTrace::addPhase(const QString &name)
+{
+  if (!enabled)
+    return;
+
+  QMutexLocker lock(&accessMutex);
+  if (finished)
+    // The startup is over. There are no more phases.
+    return;
+  const qint64 now = timer.elapsed();
+  phases.append(QPair<QString, qint64>(name, now - lastPhaseEnd));
+  lastPhaseEnd = now;
+}
+
+void startupTrace::addDuration(const QString &name, qint64 durationMs)
+{
+  if (!enabled)
+    return;
+
+  QMutexLocker lock(&accessMutex);
+  if (finished)
+    qDebug().noquote() << "Startup trace:" << name << "took" << durationMs << "ms";
+  else
+    phases.append(QPair<QString, qint64>(name, durationMs));
+}
+
+void startupTrace::finish()
+{
+  if (!enabled)
+    return;
+
+  QMutexLocker lock(&accessMutex);
+  if (finished)
+    return;
+  finished = true;
+
+  qDebug().noquote() << "Startup trace: Main window shown after" << timer.elapsed() << "ms";
+  for (auto &phase : phases)
+    qDebug().noquote() << "  " << phase.first << ":" << phase.second << "ms";
+  phases.clear();
+}
@@ -0,0 +1,76 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+/* Measure how long the individual phases of the start of YUView take. The trace is enabled with the command line
+ * switch -startupTrace. Every call to addPhase() records the time since the previous call. Once the main window is
+ * visible, finish() prints the list of phases. After that, the time that is spent for initializations that were
+ * deferred until they are needed (e.g. loading the decoder libraries) is printed whenever it is reported using
+ * addDuration(). If the trace is not enabled, all functions return immediately. All functions are thread save.
+ */
+class startupTrace
+{
+public:
+  static startupTrace &instance();
+
+  void enable();
+  bool isEnabled() const { return enabled; }
+
+  // Record a startup phase which ended now (ignored after finish())
+  void addPhase(const QString &name);
+  // Record something that took the given time (e.g. measured using a QElapsedTimer)
+  void addDuration(const QString &name, qint64 durationMs);
+  // Startup is done. Print all phases.
+  void finish();
+
+private:
+  startupTrace();
+  Q_DISABLE_COPY(startupTrace)
+
+  bool enabled;
+  bool finished;
+  QElapsedTimer timer;
+  qint64 lastPhaseEnd;
+  QList<QPair<QString, qint64>> phases;
+  QMutex accessMutex;
+};
+
+#endif // STARTUPTRACE_H
@@ -35,6 +35,7 @@
 #include <cmath>
 #include <QPainter>
 #include <QtMath>
+#include "valueLabelRenderer.h"
 
 // Activate this if you want to know when what is loaded.
 #define STATISTICS_DEBUG_LOADING 0
@@ -161,10 +162,14 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
   // Lock the statsCache mutex so that nothing is changed while we draw the data
   QMutexLocker lock(&statsCacheAccessMutex);
 
+  // The style may have changed since the last draw. Update the color lookup tables before the colors of all blocks are looked up.
+  for (StatisticsType &t : statsTypeList)
+    if (t.render && t.renderValueData)
+      t.colMapper.updateLookupTable();
+
   // Draw all the block types. Also, if the zoom factor is larger than STATISTICS_DRAW_VALUES_ZOOM,
   // also save a list of all the values of the blocks and their position in order to draw the values in the next step.
-  QList<QPoint> drawStatPoints;       // The positions of each value
-  QList<QStringList> drawStatTexts;   // For each point: The values to draw
+  valueLabelRenderer valueLabels;     // The values of the blocks (grouped by position)
   double maxLineWidth = 0.0;          // Also get the maximum width of the lines that is drawn. This will be used as an offset.
   for (int i = statsTypeList.count() - 1; i >= 0; i--)
   {
@@ -218,23 +223,26 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         // Save the position/text in order to draw the values later
         if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM)
         {
-          QString valTxt  = statsTypeList[i].getValueTxt(value);
-          if (!statsTypeList[i].valMap.contains(value) && statsTypeList[i].scaleValueToBlockSize)
-            valTxt = QString("%1").arg(float(value) / (valueItem.size[0] * valueItem.size[1]));
-
-          QString typeTxt = statsTypeList[i].typeName;
-          QString statTxt = moreThanOneBlockStatRendered ? typeTxt + ":" + valTxt : valTxt;
-
-          int i = drawStatPoints.indexOf(displayRect.topLeft());
-          if (i == -1)
+          // All the values at the same position are grouped into one label. The label has the color of the grid.
+          valueLabels.newLine(displayRect.topLeft(), statsTypeList[i].gridPen.color());
+          if (moreThanOneBlockStatRendered)
+          {
+            valueLabels.append(statsTypeList[i].typeName);
+            valueLabels.append(':');
+          }
+          auto valText = statsTypeList[i].valMap.constFind(value);
+          if (valText != statsTypeList[i].valMap.constEnd())
           {
-            // No value for this point yet. Append it and start a new QStringList
-            drawStatPoints.append(displayRect.topLeft());
-            drawStatTexts.append(QStringList(statTxt));
+            valueLabels.append(*valText);
+            valueLabels.append(' ');
+            valueLabels.append('(');
+            valueLabels.append(value);
+            valueLabels.append(')');
           }
+          else if (statsTypeList[i].scaleValueToBlockSize)
+            valueLabels.append(QString("%1").arg(float(value) / (valueItem.size[0] * valueItem.size[1])));
           else
-            // There is already a value for this point. Just append the text.
-            drawStatTexts[i].append(statTxt);
+            valueLabels.append(value);
         }
       }
     }
@@ -243,16 +251,11 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
   // Step three: Draw the values of the block types
   if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM)
   {
-    // For every point, draw only one block of values. So for every point, we check if there are also other
-    // text entries for the same point and then we draw all of them
-    QPoint lineOffset =  QPoint(int(maxLineWidth/2), int(maxLineWidth/2));
-    for (int i = 0; i < drawStatPoints.count(); i++)
-    {
-      QString txt = drawStatTexts[i].join("\n");
-      QRect textRect = painter->boundingRect(QRect(), Qt::AlignLeft, txt);
-      textRect.moveTopLeft(drawStatPoints[i] + QPoint(3,1) + lineOffset);
-      painter->drawText(textRect, Qt::AlignLeft, txt);
-    }
+    // For every point, one block with all the values at this point is drawn. All blocks are drawn in one batch.
+    const QPoint textOffset = QPoint(3,1) + QPoint(int(maxLineWidth/2), int(maxLineWidth/2));
+    painter->translate(textOffset);
+    valueLabels.draw(painter, false);
+    painter->translate(-textOffset);
   }
 
 
@@ -35,6 +35,12 @@
 #include <cmath>
 #include "typedef.h"
 
+// The number of entries of the lookup table for a gradient or a complex color mapping. If the range has less integer
+// values, the number of entries is a multiple of the number of values so that every integer value is mapped exactly.
+#define COLORMAPPER_LOOKUP_SIZE 1024
+// A color map is put into a lookup table if the values span at most this range
+#define COLORMAPPER_LOOKUP_MAP_MAX_RANGE 65536
+
 // All types that are supported by the getColor() function.
 QStringList colorMapper::supportedComplexTypes = QStringList() << "jet" << "heat" << "hsv" << "hot" << "cool" << "spring" << "summer" << "autumn" << "winter" << "gray" << "bone" << "copper" << "pink" << "lines" << "col3_gblr" << "col3_gwr" << "col3_bblr" << "col3_bwr" << "col3_bblg" << "col3_bwg";
 
@@ -395,6 +401,7 @@ colorMapper::colorMapper()
   rangeMax = 0;
   colorMapOther = Qt::black;
   type = none;
+  lookupTableValid = false;
 }
 
 // Setup a color mapper with a gradient
@@ -406,6 +413,7 @@ colorMapper::colorMapper(int min, const QColor &colMin, int max, const QColor &c
   maxColor = colMax;
   colorMapOther = Qt::black;
   type = gradient;
+  lookupTableValid = false;
 }
 
 colorMapper::colorMapper(const QString &rangeName, int min, int max)
@@ -424,16 +432,20 @@ colorMapper::colorMapper(const QString &rangeName, int min, int max)
     type = none;
   }
   colorMapOther = Qt::black;
+  lookupTableValid = false;
 }
 
 QColor colorMapper::getColor(int value)
 {
   if (type == map)
   {
-    if (colorMap.contains(value))
-      return colorMap[value];
-    else
-      return colorMapOther;
+    if (lookupTableValid)
+    {
+      const unsigned int idx = unsigned(value - lookupOffset);
+      return QColor::fromRgba(idx < unsigned(lookupTable.size()) ? lookupTable[idx] : lookupMapping.colorMapOther);
+    }
+    auto it = colorMap.constFind(value);
+    return (it != colorMap.constEnd()) ? it.value() : colorMapOther;
   }
   else
   {
@@ -447,6 +459,17 @@ QColor colorMapper::getColor(float value)
     // Round and use the integer value to get the value from the map
     return getColor(int(value+0.5));
 
+  if (lookupTableValid)
+  {
+    // clamp the value to [min max] and get the nearest entry
+    const float valueClipped = clip(value, float(rangeMin), float(rangeMax));
+    return QColor::fromRgba(lookupTable[int((valueClipped - rangeMin) * lookupScale + 0.5f)]);
+  }
+  return calculateColor(value);
+}
+
+QColor colorMapper::calculateColor(float value) const
+{
   // clamp the value to [min max]
   if (value > rangeMax)
     value = rangeMax;
@@ -687,6 +710,67 @@ QColor colorMapper::getColor(float value)
   return QColor();
 }
 
+bool colorMapper::isLookupTableUpToDate() const
+{
+  if (!lookupTableValid || lookupMapping.type != type)
+    return false;
+  if (type == map)
+    // The comparison of two maps that share their data is fast
+    return lookupMapping.colorMap == colorMap && lookupMapping.colorMapOther == colorMapOther.rgba();
+  if (lookupMapping.rangeMin != rangeMin || lookupMapping.rangeMax != rangeMax)
+    return false;
+  if (type == gradient)
+    return lookupMapping.minColor == minColor.rgba() && lookupMapping.maxColor == maxColor.rgba();
+  return lookupMapping.complexType == complexType;
+}
+
+void colorMapper::updateLookupTable()
+{
+  if (isLookupTableUpToDate())
+    return;
+
+  lookupTableValid = false;
+  lookupTable.clear();
+  if (type == map)
+  {
+    if (colorMap.isEmpty() || qint64(colorMap.lastKey()) - colorMap.firstKey() >= COLORMAPPER_LOOKUP_MAP_MAX_RANGE)
+      // Too sparse for a table. Look up the values in the map.
+      return;
+    lookupOffset = colorMap.firstKey();
+    lookupTable.fill(colorMapOther.rgba(), colorMap.lastKey() - lookupOffset + 1);
+    for (auto it = colorMap.constBegin(); it != colorMap.constEnd(); ++it)
+      lookupTable[it.key() - lookupOffset] = it.value().rgba();
+  }
+  else if (type == gradient || type == complex)
+  {
+    const int span = rangeMax - rangeMin;
+    if (span < 0)
+      return;
+    if (span == 0)
+      lookupScale = 0;
+    else if (span < COLORMAPPER_LOOKUP_SIZE)
+      lookupScale = float((COLORMAPPER_LOOKUP_SIZE - 1) / span);
+    else
+      lookupScale = float(COLORMAPPER_LOOKUP_SIZE - 1) / span;
+    const int nrEntries = int(span * lookupScale + 0.5f) + 1;
+    lookupTable.resize(nrEntries);
+    for (int i = 0; i < nrEntries; i++)
+      lookupTable[i] = calculateColor((span == 0) ? rangeMin : rangeMin + i / lookupScale).rgba();
+  }
+  else
+    return;
+
+  lookupMapping.type = type;
+  lookupMapping.rangeMin = rangeMin;
+  lookupMapping.rangeMax = rangeMax;
+  lookupMapping.minColor = minColor.rgba();
+  lookupMapping.maxColor = maxColor.rgba();
+  lookupMapping.colorMapOther = colorMapOther.rgba();
+  lookupMapping.complexType = complexType;
+  lookupMapping.colorMap = colorMap;
+  lookupTableValid = true;
+}
+
 int colorMapper::getMinVal()
 {
   if (type == gradient || type == complex)
@@ -36,6 +36,7 @@
 #include <QColor>
 #include <QMap>
 #include <QPen>
+#include <QVector>
 
 class QDomElementYUView;
 
@@ -48,6 +49,9 @@ class QDomElementYUView;
  * 3: complex  - We use a specific complex color gradient for values from rangeMin to rangeMax.
  *               They are similar to the ones used in MATLAB. The are set by name. supportedComplexTypes
  *               has a list of all supported types.
+ * getColor() is called for every block that is drawn. So the mapping is compiled into a lookup table by
+ * updateLookupTable(). Call it after changing the mapping (it does nothing if the mapping did not change). As long as
+ * there is no valid lookup table, getColor() calculates the color.
  */
 class colorMapper
 {
@@ -64,6 +68,9 @@ public:
   // ID: 0:colorMapperGradient, 1:colorMapperMap, 2+:ColorMapperComplex
   int getID();
 
+  // (Re)build the lookup table if the mapping changed since it was built.
+  void updateLookupTable();
+
   int rangeMin, rangeMax;
   QColor minColor, maxColor;
   QMap<int,QColor> colorMap;    // Each int is mapped to a specific color
@@ -84,6 +91,29 @@ public:
 
   mappingType type;
   static QStringList supportedComplexTypes;
+
+private:
+  // Calculate the color without the lookup table
+  QColor calculateColor(float value) const;
+
+  // The lookup table. For a map, there is one entry per value starting at lookupOffset. For a gradient or a complex
+  // type, the range is quantized. There are lookupScale entries per value (integer values are mapped exactly).
+  QVector<QRgb> lookupTable;
+  int   lookupOffset;
+  float lookupScale;
+  bool  lookupTableValid;
+
+  // The mapping that the lookup table was built for
+  struct lookupTableMapping
+  {
+    mappingType type;
+    int rangeMin, rangeMax;
+    QRgb minColor, maxColor, colorMapOther;
+    QString complexType;
+    QMap<int,QColor> colorMap;
+  };
+  lookupTableMapping lookupMapping;
+  bool isLookupTableUpToDate() const;
 };
 
 /* This class defines a type of statistic to render. Each statistics type entry defines the name and and ID of a statistic. It also defines
@@ -230,6 +230,7 @@ void StatisticsStyleControl::on_pushButtonEditColorMap_clicked()
     // Convert the currently selected range to a map and let the user edit that
     int lower = std::min(currentItem->colMapper.getMinVal(), currentItem->colMapper.getMaxVal());
     int higher = std::max(currentItem->colMapper.getMinVal(), currentItem->colMapper.getMaxVal());
+    currentItem->colMapper.updateLookupTable();
     for (int i = lower; i <= higher; i++)
       colorMap.insert(i, currentItem->colMapper.getColor(i));
   }
@@ -40,7 +40,9 @@
 #elif defined(Q_OS_WIN32)
 #include <windows.h>
 #endif
+#include <algorithm>
 #include <QColor>
+#include <QFile>
 #include <QIcon>
 #include <QLayout>
 #include <QSettings>
@@ -120,6 +122,117 @@ unsigned int systemMemorySizeInMB()
   return memorySizeInMB;
 }
 
+#ifdef Q_OS_LINUX
+// Read the whole (small) file from /proc or /sys
+static QByteArray readSystemFile(const QString &path)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return QByteArray();
+  return file.readAll();
+}
+
+// Get the value after the given key from a "key value" list (like /proc/meminfo or memory.stat). -1 if not found.
+static qint64 getSystemFileValue(const QByteArray &content, const QByteArray &key)
+{
+  for (const QByteArray &line : content.split('\n'))
+  {
+    QList<QByteArray> entries = line.simplified().split(' ');
+    if (entries.count() >= 2 && entries[0] == key)
+      return entries[1].toLongLong();
+  }
+  return -1;
+}
+
+// Get the memory (in bytes) that is still available in the cgroup of this process. Return -1 if there is no limit.
+static qint64 cgroupAvailableMemory()
+{
+  // Find the cgroup of this process. For cgroup v2 the line is "0::<path>", for v1 "<id>:memory:<path>".
+  QString path, limitFile, usageFile, inactiveKey;
+  for (const QByteArray &line : readSystemFile("/proc/self/cgroup").split('\n'))
+  {
+    QList<QByteArray> entries = line.split(':');
+    if (entries.count() < 3)
+      continue;
+    if (entries[0] == "0" && entries[1].isEmpty())
+    {
+      path = "/sys/fs/cgroup" + QString(entries[2]);
+      limitFile = "memory.max";
+      usageFile = "memory.current";
+      inactiveKey = "inactive_file";
+    }
+    else if (entries[1].split(',').contains("memory"))
+    {
+      path = "/sys/fs/cgroup/memory" + QString(entries[2]);
+      limitFile = "memory.limit_in_bytes";
+      usageFile = "memory.usage_in_bytes";
+      inactiveKey = "total_inactive_file";
+      break;
+    }
+  }
+  if (path.isEmpty())
+    return -1;
+
+  // Inside of a container, the cgroup of the process is mounted as the root
+  if (!QFile::exists(path + "/" + limitFile))
+    path = QFile::exists("/sys/fs/cgroup/" + limitFile) ? "/sys/fs/cgroup" : "/sys/fs/cgroup/memory";
+
+  bool ok;
+  const qint64 limit = readSystemFile(path + "/" + limitFile).trimmed().toLongLong(&ok);
+  // No limit is "max" (v2) or a huge number (v1)
+  if (!ok || limit <= 0 || limit >= (qint64(1) << 60))
+    return -1;
+  qint64 usage = readSystemFile(path + "/" + usageFile).trimmed().toLongLong(&ok);
+  if (!ok)
+    return -1;
+
+  // The usage includes the page cache. Inactive file pages are dropped before the limit is hit.
+  const qint64 inactiveFile = getSystemFileValue(readSystemFile(path + "/memory.stat"), inactiveKey.toLatin1());
+  if (inactiveFile > 0)
+    usage -= std::min(usage, inactiveFile);
+
+  return std::max(limit - usage, qint64(0));
+}
+#endif
+
+qint64 availableMemorySizeInMB()
+{
+  qint64 availableMB = -1;
+#if defined Q_OS_LINUX
+  const qint64 memAvailableKB = getSystemFileValue(readSystemFile("/proc/meminfo"), "MemAvailable:");
+  if (memAvailableKB >= 0)
+    availableMB = memAvailableKB >> 10;
+  const qint64 cgroupAvailable = cgroupAvailableMemory();
+  if (cgroupAvailable >= 0)
+    availableMB = (availableMB < 0) ? (cgroupAvailable >> 20) : std::min(availableMB, cgroupAvailable >> 20);
+#elif defined Q_OS_WIN32
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status))
+    availableMB = status.ullAvailPhys >> 20;
+#endif
+  return availableMB;
+}
+
+double memoryPressure()
+{
+#if defined Q_OS_LINUX
+  // The first line is "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+  QByteArray firstLine = readSystemFile("/proc/pressure/memory").split('\n').first();
+  for (const QByteArray &entry : firstLine.split(' '))
+  {
+    if (entry.startsWith("avg10="))
+    {
+      bool ok;
+      double avg10 = entry.mid(6).toDouble(&ok);
+      if (ok)
+        return avg10;
+    }
+  }
+#endif
+  return -1;
+}
+
 QIcon convertIcon(QString iconPath)
 {
   QSettings settings;
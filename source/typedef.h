@@ -383,6 +383,14 @@ unsigned int getOptimalThreadCount();
 // This function is thread safe and inexpensive to call.
 unsigned int systemMemorySizeInMB();
 
+// Returns the amount of memory (in megabytes) that is currently available for new allocations without swapping.
+// On linux, the memory limit of the cgroup that YUView runs in is also considered. Returns -1 if this is unknown.
+qint64 availableMemorySizeInMB();
+
+// Returns the memory pressure in percent (the share of the last 10 seconds in which tasks were stalled waiting
+// for memory, see /proc/pressure/memory). Only available on linux. Returns -1 if this is unknown.
+double memoryPressure();
+
 // When asking the playlist item if it needs loading, there are some states that the item can return
 enum itemLoadingState
 {
@@ -0,0 +1,237 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "valueLabelRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <QFontMetricsF>
+#include <QImage>
+#include <QMap>
+#include <QPaintDevice>
+#include <QPixmap>
+
+// The empty space around each glyph in the atlas (in pixels). Glyphs may extend slightly beyond their advance.
+#define GLYPH_ATLAS_PADDING 2
+
+namespace
+{
+  // A pixmap that contains all the glyphs of one font in one color that were drawn so far. If a glyph is missing, it
+  // is added and the pixmap is created again.
+  class glyphAtlas
+  {
+  public:
+    struct glyph
+    {
+      int x;          // The position of the glyph cell in the atlas (in device pixels)
+      int cellWidth;  // The width of the glyph cell including the padding (in device pixels)
+      qreal advance;  // The advance of the glyph (in logical pixels)
+    };
+
+    glyphAtlas() : ratio(1), lineHeight(0), ascent(0), atlasWidth(0) {}
+    glyphAtlas(const QFont &font, const QColor &color, qreal ratio) : font(font), color(color), ratio(ratio), atlasWidth(0)
+    {
+      QFontMetricsF metrics(font);
+      lineHeight = metrics.height();
+      ascent = metrics.ascent();
+    }
+
+    // Add the glyphs that are not in the atlas yet. The pixmap is only updated if a glyph was added.
+    void addGlyphs(const QVector<QChar> &chars)
+    {
+      QFontMetricsF metrics(font);
+      bool added = false;
+      for (const QChar &c : chars)
+      {
+        if (glyphs.contains(c))
+          continue;
+        glyph g;
+        g.advance = metrics.width(c);
+        g.cellWidth = int(std::ceil((g.advance + 2 * GLYPH_ATLAS_PADDING) * ratio));
+        g.x = atlasWidth;
+        atlasWidth += g.cellWidth;
+        glyphs.insert(c, g);
+        added = true;
+      }
+      if (!added)
+        return;
+
+      const int rowHeight = int(std::ceil(lineHeight * ratio));
+      QImage img(std::max(atlasWidth, 1), rowHeight, QImage::Format_ARGB32_Premultiplied);
+      img.fill(Qt::transparent);
+      QPainter p(&img);
+      p.setFont(font);
+      p.setPen(color);
+      p.scale(ratio, ratio);
+      for (auto it = glyphs.constBegin(); it != glyphs.constEnd(); ++it)
+        p.drawText(QPointF(it->x / ratio + GLYPH_ATLAS_PADDING, ascent), QString(it.key()));
+      p.end();
+      pixmap = QPixmap::fromImage(img);
+    }
+
+    QFont font;
+    QColor color;
+    qreal ratio;
+    qreal lineHeight;
+    qreal ascent;
+    int atlasWidth;
+    QHash<QChar, glyph> glyphs;
+    QPixmap pixmap;
+  };
+
+  // Get the atlas for the given font, color and device pixel ratio. The atlases are only used from the GUI thread.
+  glyphAtlas &getGlyphAtlas(const QFont &font, const QColor &color, qreal ratio)
+  {
+    static QHash<QString, glyphAtlas> atlases;
+    const QString key = font.key() + QString("@%1#%2").arg(ratio).arg(color.rgba(), 8, 16, QChar('0'));
+    auto it = atlases.find(key);
+    if (it == atlases.end())
+      it = atlases.insert(key, glyphAtlas(font, color, ratio));
+    return *it;
+  }
+}
+
+void valueLabelRenderer::newLine(const QPoint &pos, const QColor &color)
+{
+  const quint64 key = (quint64(quint32(pos.x())) << 32) | quint32(pos.y());
+  auto it = labelIndexByPos.constFind(key);
+  int labelIdx;
+  if (it == labelIndexByPos.constEnd())
+  {
+    labelIdx = labels.count();
+    labels.append({pos, color.rgba(), 0});
+    labelIndexByPos.insert(key, labelIdx);
+  }
+  else
+    labelIdx = *it;
+
+  labels[labelIdx].nrLines++;
+  lines.append({labelIdx, chars.count(), 0});
+}
+
+void valueLabelRenderer::append(const QString &text)
+{
+  for (const QChar &c : text)
+    chars.append(c);
+  lines.last().length += text.length();
+}
+
+void valueLabelRenderer::append(int value)
+{
+  // Format the number directly into the buffer (without creating a QString)
+  char digits[12];
+  int nrDigits = 0;
+  unsigned int v = (value < 0) ? 0u - unsigned(value) : unsigned(value);
+  do
+  {
+    digits[nrDigits++] = char('0' + v % 10);
+    v /= 10;
+  } while (v > 0);
+
+  if (value < 0)
+    append('-');
+  while (nrDigits > 0)
+    append(digits[--nrDigits]);
+}
+
+void valueLabelRenderer::clear()
+{
+  labels.clear();
+  labelIndexByPos.clear();
+  lines.clear();
+  chars.clear();
+}
+
+void valueLabelRenderer::draw(QPainter *painter, bool centered)
+{
+  if (labels.isEmpty())
+    return;
+
+  // Sort the lines by label. The order of the lines within a label is kept.
+  std::stable_sort(lines.begin(), lines.end(), [](const labelLine &l1, const labelLine &l2) { return l1.labelIdx < l2.labelIdx; });
+
+  // Group the labels by color (the index of the first line of each label). Each color is drawn in one batch.
+  QMap<QRgb, QVector<int>> labelsByColor;
+  for (int lineIdx = 0; lineIdx < lines.count(); lineIdx += labels[lines[lineIdx].labelIdx].nrLines)
+    labelsByColor[labels[lines[lineIdx].labelIdx].color].append(lineIdx);
+
+  const qreal ratio = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+  const qreal scale = 1.0 / ratio;
+  QVector<QPainter::PixmapFragment> fragments;
+  fragments.reserve(chars.count());
+  QVector<qreal> lineWidths;
+  for (auto colorIt = labelsByColor.constBegin(); colorIt != labelsByColor.constEnd(); ++colorIt)
+  {
+    glyphAtlas &atlas = getGlyphAtlas(painter->font(), QColor::fromRgba(colorIt.key()), ratio);
+    atlas.addGlyphs(chars);
+    const int rowHeight = int(std::ceil(atlas.lineHeight * ratio));
+
+    fragments.clear();
+    for (int lineIdx : colorIt.value())
+    {
+      const label &l = labels[lines[lineIdx].labelIdx];
+
+      // Get the width of all lines of the label
+      lineWidths.resize(l.nrLines);
+      qreal labelWidth = 0;
+      for (int i = 0; i < l.nrLines; i++)
+      {
+        const labelLine &line = lines[lineIdx + i];
+        lineWidths[i] = 0;
+        for (int c = line.start; c < line.start + line.length; c++)
+          lineWidths[i] += atlas.glyphs[chars[c]].advance;
+        labelWidth = std::max(labelWidth, lineWidths[i]);
+      }
+
+      // Centered labels have centered lines (like drawText with Qt::AlignCenter). Other labels are aligned left.
+      const qreal labelHeight = l.nrLines * atlas.lineHeight;
+      const QPointF topLeft = centered ? QPointF(l.pos) - QPointF(labelWidth / 2, labelHeight / 2) : QPointF(l.pos);
+      for (int i = 0; i < l.nrLines; i++)
+      {
+        const labelLine &line = lines[lineIdx + i];
+        qreal x = topLeft.x() + (centered ? (labelWidth - lineWidths[i]) / 2 : 0);
+        const qreal centerY = topLeft.y() + (i + 0.5) * atlas.lineHeight;
+        for (int c = line.start; c < line.start + line.length; c++)
+        {
+          const glyphAtlas::glyph &g = atlas.glyphs[chars[c]];
+          const QRectF sourceRect(g.x, 0, g.cellWidth, rowHeight);
+          const QPointF center(x - GLYPH_ATLAS_PADDING + g.cellWidth / ratio / 2, centerY);
+          fragments.append(QPainter::PixmapFragment::create(center, sourceRect, scale, scale));
+          x += g.advance;
+        }
+      }
+    }
+
+    painter->drawPixmapFragments(fragments.constData(), fragments.count(), atlas.pixmap);
+  }
+}
@@ -0,0 +1,91 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VALUELABELRENDERER_H
+#define VALUELABELRENDERER_H
+
+#include <QColor>
+#include <QHash>
+#include <QPainter>
+#include <QPoint>
+#include <QString>
+#include <QVector>
+
+/* The valueLabelRenderer draws many small text labels (like the values of pixels or statistics blocks) in one batch.
+ * First, all labels are collected. A label can have multiple lines and all lines that are added at the same position
+ * are grouped into one label (using a hash map). Numbers are formatted directly into one character buffer so that no
+ * QString is created per label. When drawing, all glyphs are copied from a cached glyph atlas (one pixmap per font and
+ * color) with one QPainter::drawPixmapFragments call per color instead of laying out every label with drawText.
+ * Kerning is not applied, which is fine for the short labels this is used for.
+*/
+class valueLabelRenderer
+{
+public:
+  valueLabelRenderer() {}
+
+  // Start a new line of the label at the given position. If there already is a label at this position, the line
+  // is added below the existing lines. The color of the label is set when the label is created.
+  void newLine(const QPoint &pos, const QColor &color=Qt::black);
+  // Append text or a number to the current line
+  void append(const QString &text);
+  void append(char c) { chars.append(QChar(c)); lines.last().length++; }
+  void append(int value);
+
+  // Draw all the labels. If centered is set, each label is centered at its position. Otherwise, the position is the
+  // top left corner of the label. The font of the painter is used.
+  void draw(QPainter *painter, bool centered);
+
+  bool isEmpty() const { return labels.isEmpty(); }
+  void clear();
+
+private:
+  struct label
+  {
+    QPoint pos;
+    QRgb color;
+    int nrLines;
+  };
+  struct labelLine
+  {
+    int labelIdx;
+    int start;
+    int length;
+  };
+
+  QVector<label> labels;
+  QHash<quint64, int> labelIndexByPos;
+  QVector<labelLine> lines;
+  QVector<QChar> chars;
+};
+
+#endif // VALUELABELRENDERER_H
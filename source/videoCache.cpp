@@ -33,14 +33,17 @@
 #include "videoCache.h"
 
 #include <algorithm>
+#include <QAtomicInt>
 #include <QMessageBox>
 #include <QPainter>
 #include <QScrollArea>
 #include <QSettings>
 #include <QStylePainter>
 #include <QThread>
+#include "diskFrameCache.h"
 #include "playbackController.h"
 #include "playlistItem.h"
+#include "typedef.h"
 
 // This debug setting has two values:
 // 1: Basic operation is written to qDebug: If a new item is selected, what is the decision to cache/remove next?
@@ -60,9 +63,40 @@
 #define DEBUG_CACHING_DETAIL(fmt,...) ((void)0)
 #endif
 
-videoCache::cacheJob::cacheJob(playlistItem *item, indexRange range) :
+// The adaptive cache budget. How often the available memory is checked (in ms), how much memory is left to the
+// system and other processes (in % of the system memory but at least the given number of MB), the memory pressure
+// (in %) above which the cache is reduced (by the given share in %) and the minimum budget (in MB).
+// Like the system memory functions, the adaptive budget counts in MB of 1024 * 1024 bytes.
+#define ADAPTIVE_CACHE_UPDATE_INTERVAL_MS   2000
+#define ADAPTIVE_CACHE_RESERVE_PERCENT      10
+#define ADAPTIVE_CACHE_RESERVE_MIN_MB       512
+#define ADAPTIVE_CACHE_PRESSURE_THRESHOLD   10.0
+#define ADAPTIVE_CACHE_PRESSURE_REDUCTION   25
+#define ADAPTIVE_CACHE_MIN_MB               20
+#define ADAPTIVE_CACHE_BYTES_PER_MB         (qint64(1024) * 1024)
+
+// A caching task caches a run of consecutive frames of one item. The run is long enough to hold at least the given
+// number of bytes (so that the dispatch overhead does not matter for small frames) but not more than the given
+// number of frames (so that the caching queue can be updated quickly).
+#define CACHING_TASK_MIN_BYTES   (16 * 1000 * 1000)
+#define CACHING_TASK_MAX_FRAMES  16
+
+// Prefetching while scrubbing. The window of frames ahead of the current frame covers the frames that are reached
+// within the given time at the current scrubbing velocity (within the given limits). The window behind the current
+// frame is the given percentage of it. The velocity is smoothed and reset if there was no frame change for the
+// given time. The cache queue is updated at most once per update delay.
+#define SCRUB_PREFETCH_AHEAD_MIN       8
+#define SCRUB_PREFETCH_AHEAD_MAX       256
+#define SCRUB_PREFETCH_LOOKAHEAD_MS    1000
+#define SCRUB_PREFETCH_BEHIND_PERCENT  25
+#define SCRUB_VELOCITY_SMOOTHING       0.5
+#define SCRUB_TIMEOUT_MS               1000
+#define SCRUB_UPDATE_DELAY_MS          50
+
+videoCache::cacheJob::cacheJob(playlistItem *item, indexRange range, bool backwards) :
   plItem(item),
-  frameRange(range)
+  frameRange(range),
+  backwards(backwards)
 {
 }
 
@@ -103,7 +137,7 @@ void videoCacheStatusWidget::paintEvent(QPaintEvent *event)
 
   // Draw the fill status as text
   //painter.setBrush(palette().windowText());
-  QString pTxt = QString("%1 MB / %2 MB / %3 KB/s").arg(cacheLevelMB).arg(cacheLevelMaxMB).arg(cacheRateInBytesPerMs);
+  QString pTxt = QString("%1 MB / %2 MB%3 / %4 KB/s").arg(cacheLevelMB).arg(cacheLevelMaxMB).arg(adaptiveBudget ? " (adaptive)" : "").arg(cacheRateInBytesPerMs);
   painter.drawText(0, 0, width, height, Qt::AlignCenter, pTxt);
 
   // Only draw the border
@@ -111,17 +145,14 @@ void videoCacheStatusWidget::paintEvent(QPaintEvent *event)
   painter.drawRect(0, 0, width-1, height-1);
 }
 
-void videoCacheStatusWidget::updateStatus(PlaylistTreeWidget *playlist, unsigned int cacheRate)
+void videoCacheStatusWidget::updateStatus(PlaylistTreeWidget *playlist, unsigned int cacheRate, qint64 cacheLevelMax, bool adaptive)
 {
   // Get all items from the playlist
   QList<playlistItem*> allItems = playlist->getAllPlaylistItems();
 
-  // Get if caching is enabled and how much memory we can use for the cache
-  QSettings settings;
-  settings.beginGroup("VideoCache");
-  cacheLevelMaxMB = settings.value("ThresholdValueMB", 49).toUInt();
-  const qint64 cacheLevelMax = cacheLevelMaxMB * 1000 * 1000;
-  settings.endGroup();
+  // How much memory can we use for the cache?
+  cacheLevelMaxMB = cacheLevelMax / 1000000;
+  adaptiveBudget = adaptive;
 
   // Clear the old percent values
   relativeValsEnd.clear();
@@ -134,7 +165,7 @@ void videoCacheStatusWidget::updateStatus(PlaylistTreeWidget *playlist, unsigned
     playlistItem *item = allItems.at(i);
     int nrFrames = item->getNumberCachedFrames();
     qint64 frameSize = item->getCachingFrameSize();
-    qint64 itemCacheSize = nrFrames * frameSize;
+    qint64 itemCacheSize = nrFrames * frameSize + item->getAdditionalCacheSize();
     DEBUG_CACHING_DETAIL("videoCacheStatusWidget::updateStatus Item %d frames %d * size %d = %d", i, nrFrames, frameSize, itemCacheSize);
 
     float endVal = (float)(cacheLevel + itemCacheSize) / cacheLevelMax;
@@ -156,42 +187,27 @@ class loadingWorker : public QObject
 public:
   loadingWorker(QObject *parent) : QObject(parent) { currentCacheItem = nullptr; working = false; id = id_counter++; }
   playlistItem *getCacheItem() { return currentCacheItem; }
-  void setJob(playlistItem *item, int frame, bool test=false) { currentCacheItem = item; currentFrame = frame; testMode = test; }
+  void setJob(playlistItem *item, int frame) { currentCacheItem = item; currentFrame = frame; }
   void setWorking(bool state) { working = state; }
   bool isWorking() { return working; }
   QString getStatus() { return QString("T%1: %2\n").arg(id).arg(working ? QString::number(currentFrame) : QString("-")); }
   // Process the job in the thread that this worker was moved to. This function can be directly
   // called from the main thread. It will still process the call in the separate thread.
-  void processCacheJob() { QMetaObject::invokeMethod(this, "processCacheJobInternal"); }
   void processLoadingJob(bool playing, bool loadRawData) { QMetaObject::invokeMethod(this, "processLoadingJobInternal", Q_ARG(bool, playing), Q_ARG(bool, loadRawData)); }
 signals:
   void loadingFinished();
 private slots:
-  void processCacheJobInternal();
   void processLoadingJobInternal(bool playing, bool loadRawData);
 private:
   playlistItem *currentCacheItem;
   int currentFrame;
   bool working;
-  bool testMode;
   int id;   // A static ID of the thread. Only used in getStatus().
   static int id_counter;
 };
 // Initially this is 0. The threads will number themselves so that there are never two threads with the same id
 int loadingWorker::id_counter = 0;
 
-void loadingWorker::processCacheJobInternal()
-{
-  Q_ASSERT_X(currentCacheItem != nullptr && currentFrame >= 0, "processCacheJobInternal", "Invalid Job");
-
-  // Just cache the frame that was given to us.
-  // This is performed in the thread that this worker is currently placed in.
-  currentCacheItem->cacheFrame(currentFrame, testMode);
-  
-  currentCacheItem = nullptr;
-  emit loadingFinished();
-}
-
 void loadingWorker::processLoadingJobInternal(bool playing, bool loadRawData)
 {
   Q_ASSERT_X(currentCacheItem != nullptr && (!currentCacheItem->isIndexedByFrame() || currentFrame >= 0) && !currentCacheItem->taggedForDeletion(), "processLoadingJobInternal", "Invalid non loadable job");
@@ -213,11 +229,9 @@ public:
     // Create a new worker and move it to this thread
     threadWorker.reset(new loadingWorker(nullptr));
     threadWorker->moveToThread(this);
-    quitting = false;
   }
   void quitWhenDone()
   {
-    quitting = true;
     if (threadWorker->isWorking())
     {
       // We must wait until the worker is done.
@@ -231,12 +245,56 @@ public:
     }
   }
   loadingWorker *worker() { return threadWorker.data(); }
-  bool isQuitting() { return quitting; }
 private:
   QScopedPointer<loadingWorker> threadWorker;
-  bool quitting;  // Are er quitting the job? If yes, do not push new jobs to it.
 };
 
+// A caching task runs on the caching thread pool and caches the given frames of one item. The task is owned by
+// the videoCache and is deleted when it finished. If it is canceled, it stops after the frame that it is currently caching.
+class videoCache::cachingTask : public QObject, public QRunnable
+{
+  Q_OBJECT
+public:
+  cachingTask(playlistItem *cacheItem, const QList<int> &cacheFrames, bool test) : 
+    item(cacheItem), frames(cacheFrames), testMode(test), currentFrame(-1), canceled(0), id(id_counter++)
+  {
+    setAutoDelete(false);
+  }
+  void run() Q_DECL_OVERRIDE
+  {
+    // Caching should run in the background without interrupting normal operation
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+    for (int frame : frames)
+    {
+      if (isCanceled())
+        break;
+      currentFrame.store(frame);
+      item->cacheFrame(frame, testMode);
+    }
+    currentFrame.store(-1);
+    emit finished();
+  }
+  void cancel() { canceled.store(1); }
+  bool isCanceled() const { return canceled.load() != 0; }
+  playlistItem *getItem() const { return item; }
+  QString getStatus() const
+  {
+    const int frame = currentFrame.load();
+    return QString("T%1: %2 (%3 frames)%4\n").arg(id).arg(frame >= 0 ? QString::number(frame) : QString("-")).arg(frames.count()).arg(isCanceled() ? " canceled" : "");
+  }
+signals:
+  void finished();
+private:
+  playlistItem *item;
+  const QList<int> frames;
+  const bool testMode;
+  QAtomicInt currentFrame;
+  QAtomicInt canceled;
+  int id;   // Only used in getStatus()
+  static int id_counter;
+};
+int videoCache::cachingTask::id_counter = 0;
+
 // ------- Video Cache ----------
 
 videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackController *playbackController, splitViewWidget *view, QWidget *parent)
@@ -247,10 +305,21 @@ videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackControlle
   splitView = view;
   parentWidget = parent;
   cacheRateInBytesPerMs = 0;
-  deleteNrThreads = 0;
   watchingItem = nullptr;
-  workerState = workerIdle;
   testMode = false;
+  testPending = false;
+  testCanceled = false;
+  adaptiveCacheBudget = false;
+  cacheLevelMax = 0;
+  cacheLevelMaxSetting = 0;
+  cacheLevelCurrent = 0;
+  connect(&adaptiveBudgetTimer, &QTimer::timeout, this, &videoCache::updateAdaptiveBudget);
+  scrubFrame = -1;
+  scrubDirection = 1;
+  scrubVelocity = 0;
+  scrubWindow = indexRange(-1, -1);
+  scrubUpdateTimer.setSingleShot(true);
+  connect(&scrubUpdateTimer, &QTimer::timeout, this, &videoCache::scrubUpdate);
   
   // Create the interactive threads
   for (int i=0; i<2; i++)
@@ -264,7 +333,7 @@ videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackControlle
     interactiveItemQueued_Idx[i] = -1;
   }
 
-  // Update some values from the QSettings. This will also create the correct number of threads.
+  // Update some values from the QSettings. This will also set the number of caching threads.
   updateSettings();
 
   connect(playlist.data(), &PlaylistTreeWidget::playlistChanged, this, &videoCache::scheduleCachingListUpdate);
@@ -272,6 +341,7 @@ videoCache::videoCache(PlaylistTreeWidget *playlistTreeWidget, PlaybackControlle
   connect(playlist.data(), &PlaylistTreeWidget::signalItemRecache, this, &videoCache::itemNeedsRecache);
   connect(playback.data(), &PlaybackController::waitForItemCaching, this, &videoCache::watchItemForCachingFinished);
   connect(playback.data(), &PlaybackController::signalPlaybackStarting, this, &videoCache::updateCacheQueue);
+  connect(playback.data(), &PlaybackController::signalCurrentFrameChanged, this, &videoCache::currentFrameChanged);
   connect(&statusUpdateTimer, &QTimer::timeout, this, [=]{ updateCacheStatus(); });
   connect(&testProgrssUpdateTimer, &QTimer::timeout, this, [=]{ updateTestProgress(); });
 }
@@ -280,9 +350,8 @@ videoCache::~videoCache()
 {
   DEBUG_CACHING("videoCache::~videoCache Terminate all workers and threads");
 
-  // Tell all threads to quit
-  for (loadingThread *t : cachingThreadList)
-    t->quitWhenDone();
+  // Tell all threads to quit. The caching tasks stop after the current frame.
+  cancelCachingTasks();
   interactiveThread[0]->quitWhenDone();
   interactiveThread[1]->quitWhenDone();
 
@@ -293,37 +362,10 @@ videoCache::~videoCache()
       interactiveThread[i]->terminate();
       interactiveThread[i]->wait();
     }
-  for (loadingThread *t : cachingThreadList)
-    if (!t->wait(3000))
-    {
-      t->terminate();
-      t->wait();
-    }
-
-  // Delete all threads
-  for (loadingThread *t : cachingThreadList)
-    t->deleteLater();
-}
-
-void videoCache::startWorkerThreads(int nrThreads)
-{
-  for (int i = 0; i < nrThreads; i++)
-  {
-    loadingThread *newThread = new loadingThread(this);
-    cachingThreadList.append(newThread);
-
-    // Caching should run in the background without interrupting normal operation. Start with lowest priority.
-    newThread->start(QThread::LowestPriority);
-
-    // Connect the signals/slots to communicate with the cacheWorker.
-    connect(newThread->worker(), &loadingWorker::loadingFinished, this, &videoCache::threadCachingFinished);
+  cachingPool.waitForDone();
 
-    DEBUG_CACHING("videoCache::startWorkerThreads Started thread %p", newThread);
-
-    if (workerState == workerRunning)
-      // Push the next job to the worker. Otherwise it will not start working if caching is currently running.
-      pushNextJobToThread(newThread);
-  }
+  // Delete the tasks. Their finished signals are not processed anymore.
+  qDeleteAll(runningTasks);
 }
 
 void videoCache::updateSettings()
@@ -334,7 +376,23 @@ void videoCache::updateSettings()
   QSettings settings;
   settings.beginGroup("VideoCache");
   cachingEnabled = settings.value("Enabled", true).toBool();
-  cacheLevelMax = (qint64)settings.value("ThresholdValueMB", 49).toUInt() * 1000 * 1000;
+  cacheLevelMaxSetting = (qint64)settings.value("ThresholdValueMB", 49).toUInt() * 1000 * 1000;
+  cacheLevelMax = cacheLevelMaxSetting;
+
+  // Should the budget of the cache follow the available memory?
+  adaptiveCacheBudget = cachingEnabled && settings.value("AdaptiveBudget", false).toBool();
+  if (adaptiveCacheBudget)
+  {
+    updateAdaptiveBudget();
+    adaptiveBudgetTimer.start(ADAPTIVE_CACHE_UPDATE_INTERVAL_MS);
+  }
+  else
+    adaptiveBudgetTimer.stop();
+
+  // The second tier of the cache on disk
+  const bool diskCacheEnabled = cachingEnabled && settings.value("DiskCacheEnabled", false).toBool();
+  const qint64 diskCacheSize = (qint64)settings.value("DiskCacheSizeGB", 16).toUInt() * 1000 * 1000 * 1000;
+  diskFrameCache::setSettings(diskCacheEnabled, settings.value("DiskCachePath", "").toString(), diskCacheSize);
 
   // See if the user changed the number of threads
   int targetNrThreads = getOptimalThreadCount();
@@ -351,41 +409,53 @@ void videoCache::updateSettings()
   else
     nrThreadsPlayback = 0;
 
-  if (targetNrThreads > cachingThreadList.count())
-    // Create new threads
-    startWorkerThreads(targetNrThreads - cachingThreadList.count());
-  else if (targetNrThreads < cachingThreadList.count())
-  {
-    // Remove threads. We can only delete workers (and their threads) that are currently not working.
-    int nrThreadsToRemove = cachingThreadList.count() - targetNrThreads;
+  // This takes effect immediately. If there are less threads now, the running tasks finish their frames first.
+  cachingPool.setMaxThreadCount(std::max(targetNrThreads, 1));
+  if (!cachingEnabled)
+    cancelCachingTasks();
 
-    for (int i = cachingThreadList.count()-1; i >= 0  && nrThreadsToRemove > 0; i--)
-    {
-      if (!cachingThreadList[i]->worker()->isWorking())
-      {
-        // Not working -> delete it now
-        QThread *t = cachingThreadList.takeAt(i);
-        t->exit();
-        t->deleteLater();
+  // Also update the cache status and schedule an update of the caching.
+  updateCacheStatus();
+  scheduleCachingListUpdate();
 
-        DEBUG_CACHING("videoCache::updateSettings Deleting thread %p with worker %p", t, i);
-        nrThreadsToRemove --;
-      }
-    }
+  settings.endGroup();
+}
 
-    if (nrThreadsToRemove > 0)
-    {
-      // We need to remove more threads but the workers in these threads are still running. Do this when the workers finish.
-      DEBUG_CACHING("videoCache::updateSettings Deleting %d threads later", nrThreadsToRemove);
-      deleteNrThreads = nrThreadsToRemove;
-    }
+void videoCache::updateAdaptiveBudget()
+{
+  const qint64 availableMB = availableMemorySizeInMB();
+  if (availableMB < 0)
+  {
+    // We can not tell how much memory is available. Use the fixed threshold.
+    cacheLevelMax = cacheLevelMaxSetting;
+    return;
   }
 
-  // Also update the cache status and schedule an update of the caching.
+  // The cache may grow into the available memory (minus a reserve for the system and other processes).
+  // The memory that the cache uses right now is not available anymore so it is added.
+  const qint64 reserveMB = std::max(qint64(systemMemorySizeInMB()) * ADAPTIVE_CACHE_RESERVE_PERCENT / 100, qint64(ADAPTIVE_CACHE_RESERVE_MIN_MB));
+  qint64 budget = cacheLevelCurrent + (availableMB - reserveMB) * ADAPTIVE_CACHE_BYTES_PER_MB;
+
+  // If tasks are stalled waiting for memory, the system is swapping (or reclaiming). Give memory back.
+  const double pressure = memoryPressure();
+  if (pressure > ADAPTIVE_CACHE_PRESSURE_THRESHOLD)
+    budget = std::min(budget, cacheLevelCurrent * (100 - ADAPTIVE_CACHE_PRESSURE_REDUCTION) / 100);
+
+  const qint64 minBudget = ADAPTIVE_CACHE_MIN_MB * ADAPTIVE_CACHE_BYTES_PER_MB;
+  budget = clip(budget, minBudget, std::max(cacheLevelMaxSetting, minBudget));
+
+  // Only update for changes of more than 5 % so that caching is not restarted for every small fluctuation.
+  // If the cache holds more than the new budget, always update so that frames are removed.
+  const qint64 change = qAbs(budget - cacheLevelMax);
+  if (change == 0 || (change < cacheLevelMax / 20 && budget >= cacheLevelCurrent))
+    return;
+
+  DEBUG_CACHING("videoCache::updateAdaptiveBudget %lld MB available, pressure %f -> budget %lld MB", availableMB, pressure, budget / ADAPTIVE_CACHE_BYTES_PER_MB);
+  cacheLevelMax = budget;
+
+  // Remove frames (or cache more frames) through the normal update of the cache queue
   updateCacheStatus();
   scheduleCachingListUpdate();
-
-  settings.endGroup();
 }
 
 void videoCache::loadFrame(playlistItem * item, int frameIndex, int loadingSlot)
@@ -423,40 +493,8 @@ void videoCache::interactiveLoaderFinished()
   int threadID = (interactiveThread[0]->worker() == worker) ? 0 : 1;
   assert(worker == interactiveThread[0]->worker() || worker == interactiveThread[1]->worker());
 
-  // Check the list of items that are scheduled for deletion. Because a loading thread finished, maybe now we can delete the item(s).
-  bool itemDeleted = false;
-  for (auto it = itemsToDelete.begin(); it != itemsToDelete.end();)
-  {
-    // Is the item still being cached?
-    bool itemCaching = false;
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == *it)
-      {
-        itemCaching = true;
-        break;
-      }
-    // Is the item still being loaded?
-    bool loadingItem = (interactiveThread[0]->worker()->getCacheItem() == *it || interactiveThread[1]->worker()->getCacheItem() == *it);
-
-    if (!itemCaching && !loadingItem)
-    {
-      // Remove the item from the loading queue (if in there)
-      if (interactiveItemQueued[threadID] == (*it))
-      {
-        interactiveItemQueued[threadID] = nullptr;
-        interactiveItemQueued_Idx[threadID] = -1;
-      }
-      // Delete the item and remove it from the itemsToDelete list
-      DEBUG_CACHING("videoCache::interactiveLoaderFinished delete item now %s", (*it)->getName().toLatin1().data());
-      (*it)->deleteLater();
-      it = itemsToDelete.erase(it);
-      itemDeleted = true;
-    }
-    else
-      ++it;
-  }
-  if (itemDeleted)
-    updateCacheStatus();
+  // Because a loading thread finished, maybe now we can delete the items that are scheduled for deletion.
+  deleteItemsWhenIdle();
   
   // The worker finished. Is there another loading request in the queue?
   if (interactiveItemQueued[threadID] && interactiveItemQueued_Idx[threadID] != -1)
@@ -480,29 +518,20 @@ void videoCache::interactiveLoaderFinished()
 
 void videoCache::scheduleCachingListUpdate()
 {
-  // The playlist changed. We have to rethink what to cache next.
-  if (workerState == workerRunning)
-  {
-    // First the worker has to stop. Request a stop and an update of the queue.
-    workerState = workerIntReqRestart;
-    DEBUG_CACHING("videoCache::playlistChanged new state %d (workerIntReqRestart)", workerState);
-    return;
-  }
-  else if (workerState == workerIntReqRestart)
-  {
-    // The worker is still running but we already requested an interrupt and an update of the queue.
-    DEBUG_CACHING("videoCache::playlistChanged new state %d (workerIntReqRestart)", workerState);
+  if (testMode)
+    // The conversion test is running. Normal caching is restarted when it is over.
     return;
-  }
 
-  assert(workerState == workerIdle);
+  // The playlist changed. We have to rethink what to cache next. The running tasks may cache frames that
+  // are not needed anymore. Cancel them. They stop after their current frame.
+  cancelCachingTasks();
   if (cachingEnabled)
   {
-    // Update the cache queue and restart the worker.
+    // Update the cache queue and start new tasks.
     updateCacheQueue();
     startCaching();
   }
-  DEBUG_CACHING("videoCache::playlistChanged new state %d", workerState);
+  DEBUG_CACHING("videoCache::scheduleCachingListUpdate %d tasks running", runningTasks.count());
 }
 
 void videoCache::updateCacheQueue()
@@ -563,6 +592,7 @@ void videoCache::updateCacheQueue()
   // While we are iterating through the list, we will delete all cached frames from the cache that will 
   // never be cached (are outside of the items range of frames to show)
   qint64 cacheLevel = 0;
+  qint64 additionalCacheLevel = 0;  // The memory of the items besides the cached frames (e.g. other cache layers)
   for (playlistItem *item : allItems)
   {
     indexRange range = item->getFrameIdxRange();
@@ -573,7 +603,27 @@ void videoCache::updateCacheQueue()
 
     qint64 cachingFrameSize = item->getCachingFrameSize();
     cacheLevel += item->getNumberCachedFrames() * cachingFrameSize;
+    additionalCacheLevel += item->getAdditionalCacheSize();
   }
+  if (additionalCacheLevel > 0)
+  {
+    // The additional caches are the first thing that is given up if the frames of the selected item do not fit
+    indexRange selectionRange = selection[0]->getFrameIdxRange();
+    const qint64 selectionFrameSize = selection[0]->getCachingFrameSize();
+    const qint64 selectionSpaceNeeded = (selectionRange.second - selectionRange.first + 1 - selection[0]->getNumberCachedFrames()) * selectionFrameSize;
+    if (cacheLevel + additionalCacheLevel + std::max(selectionSpaceNeeded, qint64(0)) > cacheLevelMax)
+    {
+      DEBUG_CACHING("videoCache::updateCacheQueue Removing the additional caches of all items");
+      additionalCacheLevel = 0;
+      for (playlistItem *item : allItems)
+      {
+        item->removeAdditionalCache();
+        // Some of the memory can not be freed (e.g. the frames that a decoder keeps)
+        additionalCacheLevel += item->getAdditionalCacheSize();
+      }
+    }
+  }
+  cacheLevel += additionalCacheLevel;
   if (cacheLevel > cacheLevelMax)
   {
     // The cache is overflowing (maybe the user made the cache smaller).
@@ -619,7 +669,7 @@ void videoCache::updateCacheQueue()
     // Add as much of all items as possible. When the cache is full, mark the remaining frames as "can be
     // deleted"
     int i = itemPos;
-    qint64 newCacheLevel = 0;
+    qint64 newCacheLevel = additionalCacheLevel;
 
     // We start in "adding" mode where items are added. If the cache is full, we switch to "deleting" mode where
     // all frames of all items are removed. This is done for all items in the playlist.
@@ -696,9 +746,13 @@ void videoCache::updateCacheQueue()
         }
       }
 
-      // Adjust the range so that only the number of frames are cached that will fit
+      // Adjust the range so that only the number of frames are cached that will fit. Cache the frames around
+      // the current frame. The cached frames of the item outside of this range can be removed.
       qint64 nrFramesCachable = cacheLevelMax / selection[0]->getCachingFrameSize();
-      range.second = range.first + nrFramesCachable - 1;
+      range = getPrefetchWindow(range, int(nrFramesCachable));
+      for (int f : selection[0]->getCachedFrames())
+        if (f < range.first || f > range.second)
+          cacheDeQueue.enqueue(plItemFrame(selection[0], f));
 
       enqueueCacheJob(selection[0], range);
     }
@@ -870,6 +924,10 @@ void videoCache::updateCacheQueue()
     }
   }
 
+  // Cache the frames around the current frame first
+  if (!play)
+    prioritizePrefetchWindow(selection[0]);
+
 #if CACHING_DEBUG_OUTPUT && !NDEBUG
   if (!cacheQueue.isEmpty())
   {
@@ -878,7 +936,7 @@ void videoCache::updateCacheQueue()
     {
       QString itemStr = j.plItem->getName();
       itemStr.append(" - ");
-      itemStr.append(QString::number(j.frameRange.first) + "-" + QString::number(j.frameRange.second));
+      itemStr.append(QString::number(j.frameRange.first) + "-" + QString::number(j.frameRange.second) + (j.backwards ? " backwards" : ""));
       qDebug() << itemStr;
     }
   }
@@ -917,23 +975,204 @@ void videoCache::enqueueCacheJob(playlistItem* item, indexRange range)
     cacheQueue.append(cacheJob(item, range));
 }
 
-void videoCache::startCaching()
+void videoCache::currentFrameChanged(int frame)
 {
-  DEBUG_CACHING("videoCache::startCaching %s", testMode ? "Test mode" : "");
-  if (cacheQueue.isEmpty() && !testMode)
+  // The cache only follows the position while scrubbing. During playback, the caching is done ahead anyways.
+  if (frame < 0 || playback->playing())
+    return;
+
+  // Update the scrubbing velocity (smoothed) and direction
+  if (scrubFrame >= 0 && scrubTimer.isValid() && scrubTimer.elapsed() < SCRUB_TIMEOUT_MS)
   {
-    // Nothing in the queue to start caching for.
-    workerState = workerIdle;
+    const double velocity = qAbs(frame - scrubFrame) * 1000.0 / std::max(scrubTimer.elapsed(), qint64(1));
+    scrubVelocity = SCRUB_VELOCITY_SMOOTHING * scrubVelocity + (1.0 - SCRUB_VELOCITY_SMOOTHING) * velocity;
   }
   else
+    scrubVelocity = 0;
+  const int direction = (frame >= scrubFrame) ? 1 : -1;
+  const bool directionChanged = (direction != scrubDirection);
+  scrubDirection = direction;
+  scrubFrame = frame;
+  scrubTimer.start();
+
+  // The cache queue only has to be updated if the prioritized window does not cover the frames ahead anymore.
+  // Otherwise the running caching tasks would be canceled for every frame change.
+  const int aheadSize = (scrubWindow.second - scrubWindow.first + 1) * (100 - SCRUB_PREFETCH_BEHIND_PERCENT) / 100;
+  const int aheadLeft = (direction > 0) ? scrubWindow.second - frame : frame - scrubWindow.first;
+  const bool windowValid = scrubWindow.first >= 0 && frame >= scrubWindow.first && frame <= scrubWindow.second;
+  if (!directionChanged && windowValid && aheadLeft > aheadSize / 2)
+    return;
+
+  // Do not update for every step. Wait for the next few frame changes.
+  if (!scrubUpdateTimer.isActive())
+    scrubUpdateTimer.start(SCRUB_UPDATE_DELAY_MS);
+}
+
+void videoCache::scrubUpdate()
+{
+  if (playback->playing())
+    return;
+  DEBUG_CACHING("videoCache::scrubUpdate frame %d direction %d velocity %f", scrubFrame, scrubDirection, scrubVelocity);
+  scheduleCachingListUpdate();
+}
+
+indexRange videoCache::getPrefetchWindow(indexRange range, int nrFrames) const
+{
+  int frame = playback->getCurrentFrame();
+  if (frame < 0)
+    frame = range.first;
+  frame = clip(frame, range.first, range.second);
+
+  // How many frames to cache ahead of (in the direction of scrubbing) and behind the current frame?
+  int ahead, behind;
+  if (nrFrames > 0)
+  {
+    behind = nrFrames * SCRUB_PREFETCH_BEHIND_PERCENT / 100;
+    ahead = nrFrames - behind - 1;
+  }
+  else
+  {
+    // The velocity is only valid while the user is still scrubbing
+    const double velocity = (scrubTimer.isValid() && scrubTimer.elapsed() < SCRUB_TIMEOUT_MS) ? scrubVelocity : 0;
+    ahead = clip(int(velocity * SCRUB_PREFETCH_LOOKAHEAD_MS / 1000), SCRUB_PREFETCH_AHEAD_MIN, SCRUB_PREFETCH_AHEAD_MAX);
+    behind = ahead * SCRUB_PREFETCH_BEHIND_PERCENT / 100;
+  }
+
+  indexRange window = (scrubDirection > 0) ? indexRange(frame - behind, frame + ahead) : indexRange(frame - ahead, frame + behind);
+  if (nrFrames > 0)
+  {
+    // Keep the size of the window by shifting it back into the range
+    if (window.first < range.first)
+      window = indexRange(range.first, window.second + range.first - window.first);
+    if (window.second > range.second)
+      window = indexRange(window.first - (window.second - range.second), range.second);
+  }
+  return indexRange(std::max(window.first, range.first), std::min(window.second, range.second));
+}
+
+void videoCache::prioritizePrefetchWindow(playlistItem *item)
+{
+  scrubWindow = indexRange(-1, -1);
+  if (item == nullptr || !item->isIndexedByFrame() || playback->getCurrentFrame() < 0)
+    return;
+
+  const indexRange window = getPrefetchWindow(item->getFrameIdxRange());
+  const int frame = clip(playback->getCurrentFrame(), window.first, window.second);
+  const QList<int> cachedFrames = item->getCachedFrames();
+
+  // Split the jobs of the item into the parts in the window and the parts outside of it
+  QList<indexRange> rangesInWindow;
+  QList<cacheJob> newQueue;
+  for (const cacheJob &job : cacheQueue)
+  {
+    if (job.plItem != item)
+    {
+      newQueue.append(job);
+      continue;
+    }
+    const indexRange &r = job.frameRange;
+    if (r.first < window.first)
+      newQueue.append(cacheJob(item, indexRange(r.first, std::min(r.second, window.first - 1))));
+    if (r.second > window.second)
+      newQueue.append(cacheJob(item, indexRange(std::max(r.first, window.second + 1), r.second)));
+    if (r.first <= window.second && r.second >= window.first)
+      rangesInWindow.append(indexRange(std::max(r.first, window.first), std::min(r.second, window.second)));
+  }
+  if (rangesInWindow.isEmpty())
+    return;
+
+  // The jobs in the window are cached starting at the current frame. First the frames ahead (in the direction of
+  // scrubbing), then the frames behind. Frames that are cached already are skipped at both ends of the job.
+  QList<cacheJob> windowJobs[2];
+  for (const indexRange &r : rangesInWindow)
   {
-    // Push a task to all the threads and start them.
-    bool jobStarted = false;
-    for (int i = 0; i < cachingThreadList.count(); i++)
-      jobStarted |= pushNextJobToThread(cachingThreadList[i]);
+    const indexRange parts[2] = {indexRange(r.first, std::min(r.second, frame - 1)), indexRange(std::max(r.first, frame), r.second)};
+    for (int i = 0; i < 2; i++)
+    {
+      indexRange part = parts[i];
+      while (part.first <= part.second && cachedFrames.contains(part.first))
+        part.first++;
+      while (part.first <= part.second && cachedFrames.contains(part.second))
+        part.second--;
+      if (part.first > part.second)
+        continue;
+      // The part after the current frame is ahead if scrubbing forward
+      const bool afterFrame = (i == 1);
+      const bool ahead = (afterFrame == (scrubDirection > 0));
+      windowJobs[ahead ? 0 : 1].append(cacheJob(item, part, !afterFrame));
+    }
+  }
+  cacheQueue = QQueue<cacheJob>();
+  for (const cacheJob &j : windowJobs[0] + windowJobs[1] + newQueue)
+    cacheQueue.enqueue(j);
+  scrubWindow = window;
+}
+
+void videoCache::startCaching()
+{
+  DEBUG_CACHING("videoCache::startCaching %s", testMode ? "Test mode" : "");
+
+  // Start tasks until all threads of the pool have work
+  while (getNrActiveTasks() < cachingPool.maxThreadCount() && startNextCachingTask())
+    ;
+
+  // Start/stop the timer that will update the caching status widget and the debug stuff
+  if (!statusUpdateTimer.isActive() && !runningTasks.isEmpty())
+    statusUpdateTimer.start(100);
+}
 
-    workerState = jobStarted ? workerRunning : workerIdle;
+int videoCache::getNrActiveTasks(playlistItem *item) const
+{
+  int nrTasks = 0;
+  for (cachingTask *t : runningTasks)
+    if (!t->isCanceled() && (item == nullptr || t->getItem() == item))
+      nrTasks++;
+  return nrTasks;
+}
+
+bool videoCache::isItemBeingCached(playlistItem *item) const
+{
+  for (cachingTask *t : runningTasks)
+    if (t->getItem() == item)
+      return true;
+  return false;
+}
+
+void videoCache::cancelCachingTasks(playlistItem *item)
+{
+  for (cachingTask *t : runningTasks)
+    if (item == nullptr || t->getItem() == item)
+      t->cancel();
+}
+
+void videoCache::deleteItemsWhenIdle()
+{
+  // Check the list of items that are scheduled for deletion. Delete the ones that are not cached or loaded anymore.
+  bool itemDeleted = false;
+  for (auto it = itemsToDelete.begin(); it != itemsToDelete.end();)
+  {
+    // Is the item still being cached or loaded?
+    bool loadingItem = (interactiveThread[0]->worker()->getCacheItem() == *it || interactiveThread[1]->worker()->getCacheItem() == *it);
+    if (!isItemBeingCached(*it) && !loadingItem)
+    {
+      // Remove the item from the loading queue (if in there)
+      for (int i = 0; i < 2; i++)
+        if (interactiveItemQueued[i] == (*it))
+        {
+          interactiveItemQueued[i] = nullptr;
+          interactiveItemQueued_Idx[i] = -1;
+        }
+      // Delete the item and remove it from the itemsToDelete list
+      DEBUG_CACHING("videoCache::deleteItemsWhenIdle delete item now %s", (*it)->getName().toLatin1().data());
+      (*it)->deleteLater();
+      it = itemsToDelete.erase(it);
+      itemDeleted = true;
+    }
+    else
+      ++it;
   }
+  if (itemDeleted)
+    updateCacheStatus();
 }
 
 void videoCache::watchItemForCachingFinished(playlistItem *item)
@@ -941,9 +1180,9 @@ void videoCache::watchItemForCachingFinished(playlistItem *item)
   watchingItem = item;
   if (watchingItem)
   {
-    // Check if any frame of the item is schedueld for caching.
+    // Check if any frame of the item is schedueld for caching or is being cached.
     // If not, there is nothing to wait for and the wait is over now.
-    bool waitOver = true;
+    bool waitOver = !isItemBeingCached(watchingItem);
     for (auto j : cacheQueue)
       if (j.plItem == watchingItem)
       {
@@ -956,7 +1195,7 @@ void videoCache::watchItemForCachingFinished(playlistItem *item)
       playback->itemCachingFinished(watchingItem);
       watchingItem = nullptr;
     }
-    else if (workerState == workerIdle)
+    else if (runningTasks.isEmpty())
     {
       // If the caching is currently not running, start it. Otherwise we will wait forever.
       DEBUG_CACHING("videoCache::watchItemForCachingFinished waiting for item. Start caching.");
@@ -965,122 +1204,53 @@ void videoCache::watchItemForCachingFinished(playlistItem *item)
   }
 }
 
-// One of the workers is done with it's caching operation. Give it a new task if there is one and we are not
-// breaking the caching process.
-void videoCache::threadCachingFinished()
+// One of the caching tasks is done (or was canceled). Start new tasks if there is more to cache.
+void videoCache::cachingTaskFinished()
 {
-  // Get the thread that caused this call
-  QObject *sender = QObject::sender();
-  loadingWorker *worker = dynamic_cast<loadingWorker*>(sender);
-  Q_ASSERT_X(worker->isWorking(), "videoCache::threadCachingFinished", "The worker that just finished was not working?");
-  worker->setWorking(false);
-  DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished - state %d - worker %p", workerState, worker);
-
-  // Check if all threads have stopped.
-  bool jobsRunning = false;
-  for (loadingThread *t : cachingThreadList)
-  {
-    DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished WorkerList - worker %p - working %d", t, t->worker()->isWorking());
-    if (t->worker()->isWorking())
-      // A job is still running. Wait.
-      jobsRunning = true;
-  }
+  cachingTask *task = dynamic_cast<cachingTask*>(QObject::sender());
+  Q_ASSERT_X(runningTasks.contains(task), "videoCache::cachingTaskFinished", "The task that just finished is unknown");
+  runningTasks.removeOne(task);
+  task->deleteLater();
+  DEBUG_CACHING_DETAIL("videoCache::cachingTaskFinished - task %p - %d tasks running", task, runningTasks.count());
 
   if (testMode)
   {
-    if (workerState == workerIntReqRestart)
+    if (testPending && runningTasks.isEmpty())
     {
-      // The test has not started yet. We are waiting for the normal caching to finish first.
-      if (!jobsRunning)
-      {
-        DEBUG_CACHING("videoCache::threadCachingFinished Start test now");
-        testDuration.start();
-        startCaching();
-      }
+      // The normal caching tasks finished. Start the test now.
+      DEBUG_CACHING("videoCache::cachingTaskFinished Start test now");
+      testPending = false;
+      testDuration.start();
     }
-    else if (testLoopCount < 0 || workerState == workerIntReqStop)
+    if (!testPending)
     {
-      // The test is over or was canceled.
-      // We are not going to start any new threads. Wait for the remaining threads to finish.
-      if (jobsRunning)
-        DEBUG_CACHING("videoCache::threadCachingFinished Test over - Waiting for jobs to finish");
-      else
+      // Start the next test task (if the test is not over or canceled)
+      startCaching();
+      if (runningTasks.isEmpty())
       {
         // Report the results of the test
-        DEBUG_CACHING("videoCache::threadCachingFinished Test over - All jobs finished");
+        DEBUG_CACHING("videoCache::cachingTaskFinished Test over - All jobs finished");
         testFinished();
         // Restart normal caching
-        updateCacheQueue();
-        startCaching();
+        scheduleCachingListUpdate();
       }
     }
-    else if (workerState == workerRunning)
-    {
-      // The caching performance test is running. Just push another test job.
-      DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished Test mode - start next job", t);
-      for (loadingThread *t : cachingThreadList)
-        if (t->worker() == worker)
-          jobsRunning |= pushNextJobToThread(t);
-    }
     return;
   }
 
-  // Check the list of items that are scheduled for deletion. Because a thread finished, maybe now we can delete the item(s).
-  bool itemDeleted = false;
-  for (auto it = itemsToDelete.begin(); it != itemsToDelete.end();)
-  {
-    // Is the item still being cached?
-    bool itemCaching = false;
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == *it)
-      {
-        itemCaching = true;
-        break;
-      }
-    // Is the item still being loaded?
-    bool loadingItem = (interactiveThread[0]->worker()->getCacheItem() == *it || interactiveThread[1]->worker()->getCacheItem() == *it);
-
-    if (!itemCaching && !loadingItem)
-    {
-      // Remove the item from the loading queue (if in there)
-      if (interactiveItemQueued[0] == (*it))
-      {
-        interactiveItemQueued[0] = nullptr;
-        interactiveItemQueued_Idx[0] = -1;
-      }
-      if (interactiveItemQueued[1] == (*it))
-      {
-        interactiveItemQueued[1] = nullptr;
-        interactiveItemQueued_Idx[1] = -1;
-      }
-      // Delete the item and remove it from the itemsToDelete list
-      DEBUG_CACHING("videoCache::threadCachingFinished delete item now %s", (*it)->getName().toLatin1().data());
-      (*it)->deleteLater();
-      it = itemsToDelete.erase(it);
-      itemDeleted = true;
-    }
-    else
-      ++it;
-  }
-  if (itemDeleted)
-    updateCacheStatus();
+  // Because a task finished, maybe now we can delete the items that are scheduled for deletion.
+  deleteItemsWhenIdle();
 
   // Do the same thing for the items which need to clear their cache
+  bool cacheCleared = false;
   for (auto it = itemsToClearCache.begin(); it != itemsToClearCache.end();)
   {
-    bool itemCaching = false;
-    for (loadingThread *t : cachingThreadList)
-    if (t->worker()->getCacheItem() == *it)
-    {
-      itemCaching = true;
-      break;
-    }
-
-    if (!itemCaching)
+    if (!isItemBeingCached(*it))
     {
-      // No job is caching the item anymore. Clear the cache now.
+      // No task is caching the item anymore. Clear the cache now.
       (*it)->removeAllFramesFromCache();
       it = itemsToClearCache.erase(it);
+      cacheCleared = true;
     }
     else
       ++it;
@@ -1089,7 +1259,7 @@ void videoCache::threadCachingFinished()
   if (watchingItem)
   {
     // See if there is more to be done for the item we are waiting for. If not, signal that caching of the item is done.
-    bool waitOver = true;
+    bool waitOver = !isItemBeingCached(watchingItem);
     for (auto j : cacheQueue)
     {
       if (j.plItem == watchingItem)
@@ -1100,84 +1270,56 @@ void videoCache::threadCachingFinished()
     }
     if (waitOver)
     {
-      DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished caching of requested item done");
+      DEBUG_CACHING_DETAIL("videoCache::cachingTaskFinished caching of requested item done");
       playback->itemCachingFinished(watchingItem);
       watchingItem = nullptr;
     }
   }
 
-  // Also check if the worker is in the cachingWorkerList. If not, do not push a new job to it.
-  if (deleteNrThreads > 0)
-  {
-    // We need to delete some threads. So this one has to go.
-    int idx = -1;
-    for (int i=0; i<cachingThreadList.count(); i++)
-      if (cachingThreadList[i]->worker() == worker)
-        idx = i;
-    Q_ASSERT_X(idx >= 0, "deleting thread", "The thread that just finished was not found in the thread list.");
-    loadingThread *t = cachingThreadList.takeAt(idx);
-    t->exit();
-    t->deleteLater();
-
-    DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished Deleting thread %p", t);
-    deleteNrThreads--;
-  }
-  else if (workerState == workerRunning)
-  {
-    // Get the thread of the worker and push the next cache job to it
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker() == worker)
-        jobsRunning |= pushNextJobToThread(t);
-  }
-
-  if (!jobsRunning)
+  if (cacheCleared && cachingEnabled)
   {
-    // All jobs are done
-    DEBUG_CACHING("videoCache::threadCachingFinished - All jobs done");
-    if (workerState == workerIntReqStop || workerState == workerRunning)
-      workerState = workerIdle;
-    else if (workerState == workerIntReqRestart)
-    {
-      updateCacheQueue();
-      startCaching();
-    }
+    // The frames of the items can be cached again
+    updateCacheQueue();
+    startCaching();
   }
+  else if (cachingEnabled)
+    // A thread of the pool is free now
+    startCaching();
 
-  // Start/stop the timer that will update the caching status widget and the debug stuff
-  if (statusUpdateTimer.isActive() && workerState == workerIdle)
+  if (statusUpdateTimer.isActive() && runningTasks.isEmpty())
     // Stop the timer and update one last time
     statusUpdateTimer.stop();
-  else if (!statusUpdateTimer.isActive() && workerState != workerIdle)
-    // The timer is not started yet, but it should be.
-    // Update now and start the timer to trigger future updates.
-    statusUpdateTimer.start(100);
   
   updateCacheStatus();
-
-  DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished - new state %d", workerState);
 }
 
-bool videoCache::pushNextJobToThread(loadingThread *thread)
+bool videoCache::startNextCachingTask()
 {
-  if ((cacheQueue.isEmpty() && !testMode) || thread->isQuitting())
-    // No more jobs in the cache queue or the job does not accept new jobs.
-    return false;
-
   if (testMode)
   {
+    if (testPending || testCanceled || testLoopCount <= 0)
+      return false;
+
     Q_ASSERT_X(testItem, "test mode", "Test item invalid");
     indexRange r = testItem->getFrameIdxRange();
-    int frameNr = clip((1000-testLoopCount) % (r.second - r.first) + r.first, r.first, r.second);
-    if (frameNr < 0)
-      frameNr = 0;
-    thread->worker()->setJob(testItem, frameNr, true);
-    thread->worker()->setWorking(true);
-    thread->worker()->processCacheJob();
-    DEBUG_CACHING_DETAIL("videoCache::pushNextJobToThread - %d of %s", frameNr, testItem->getName().toStdString().c_str());
-    testLoopCount--;
+    const int nrFrames = clip(int(CACHING_TASK_MIN_BYTES / std::max(testItem->getCachingFrameSize(), 1u)), 1, std::min(testLoopCount, CACHING_TASK_MAX_FRAMES));
+    QList<int> frames;
+    for (int i = 0; i < nrFrames; i++)
+    {
+      int frameNr = clip((1000-testLoopCount) % std::max(r.second - r.first, 1) + r.first, r.first, r.second);
+      if (frameNr < 0)
+        frameNr = 0;
+      frames.append(frameNr);
+      testLoopCount--;
+    }
+    startCachingTask(testItem, frames, true);
     return true;
   }
 
+  if (cacheQueue.isEmpty())
+    // No more jobs in the cache queue
+    return false;
+
   // If playback is running and playback is not waiting for a specific item to cache,
   // only start caching of a new job if caching is enabled while playback is running.
   if (playback->playing() && watchingItem == nullptr)
@@ -1187,27 +1329,10 @@ bool videoCache::pushNextJobToThread(loadingThread *thread)
     {
       // Playback is running and the item that is currently being shown is indexed by frame.
       // In this case, obey the restriction on nr threads while playback is running.
-
-      if (nrThreadsPlayback == 0)
+      if (nrThreadsPlayback <= getNrActiveTasks())
       {
-        // No caching while playback is running
-        DEBUG_CACHING_DETAIL("videoCache::pushNextJobToThread no new job started nrThreadsPlayback=0");
-        return false;
-      }
-
-      // Check if there is a limit on the number of threads to use while playback is running.
-      int threadsWorking = 0;
-      for (loadingThread *t : cachingThreadList)
-      {
-        if (t->worker()->isWorking())
-          threadsWorking++;
-      }
-
-      if (nrThreadsPlayback <= threadsWorking)
-      {
-        // The maximum number (or more) of threads are already working.
-        // Do not start another one.
-        DEBUG_CACHING_DETAIL("videoCache::pushNextJobToThread no new job started nrThreadsPlayback=%d threadsWorking=%d", nrThreadsPlayback, threadsWorking);
+        // The maximum number (or more) of threads are already working. Do not start another one.
+        DEBUG_CACHING_DETAIL("videoCache::startNextCachingTask no new task started nrThreadsPlayback=%d", nrThreadsPlayback);
         return false;
       }
     }
@@ -1219,102 +1344,108 @@ bool videoCache::pushNextJobToThread(loadingThread *thread)
   while (j.hasNext())
   {
     cacheJob &job = j.next();
-    if (!job.plItem->isCachable())
+    if (!job.plItem || !job.plItem->isCachable() || job.plItem->taggedForDeletion())
       // Remove the item from the list
       j.remove();
+    else if (itemsToClearCache.contains(job.plItem))
+      // The cache of the item is cleared when the tasks that are still caching it finished
+      continue;
     else 
     {
       // We might be able to cache from this item. Check if there is a thread limit for the item.
+      // Canceled tasks are also counted because they may still be using the item (e.g. its decoder).
       int threadLimit = job.plItem->cachingThreadLimit();
       if (threadLimit != -1)
       {
-        // How many threads are currently caching the given item?
-        int nrThreadsForItem = 0;
-        for (loadingThread *t : cachingThreadList)
-          if (t->worker()->isWorking() && t->worker()->getCacheItem() == job.plItem)
-            nrThreadsForItem++;
-        if (nrThreadsForItem >= threadLimit)
+        int nrTasksForItem = 0;
+        for (cachingTask *t : runningTasks)
+          if (t->getItem() == job.plItem)
+            nrTasksForItem++;
+        if (nrTasksForItem >= threadLimit)
           // Go to the next item. We can not add another thread to this one.
           continue;
       }
 
-      // We can start another thread for this item
+      // We can start another task for this item
       plItem = job.plItem;
       range = job.frameRange;
-
-      // Check if this is the last frame to cache in the item 
-      if (range.first == range.second)
-        j.remove();
-      else
-        // Update the frame range of the head item in the cache queue
-        job.frameRange.first = range.first + 1;
-
       break;
     }
   }
   if (plItem == nullptr)
-    // No item found that we can start another caching thread for.
+    // No item found that we can start another caching task for.
     return false;
 
-  // Get the size of one frame in bytes
-  unsigned int frameSize = plItem->getCachingFrameSize();
+  // Get the size of one frame in bytes and the number of frames to cache in the task. An item that can only be cached
+  // by one thread (e.g. a decoder which has a state) gets the longest run of frames so that it can keep decoding.
+  const unsigned int frameSize = std::max(plItem->getCachingFrameSize(), 1u);
+  int nrFrames = (plItem->cachingThreadLimit() == 1) ? CACHING_TASK_MAX_FRAMES : clip(int(CACHING_TASK_MIN_BYTES / frameSize), 1, CACHING_TASK_MAX_FRAMES);
+  nrFrames = std::min(nrFrames, range.second - range.first + 1);
 
-  // We found an item that we can cache. Cache the first frame of it.
-  int frameToCache = range.first;
-
-  // First check if we need to free up space to cache this frame.
-  while (cacheLevelCurrent + frameSize >= cacheLevelMax && !cacheDeQueue.isEmpty())
+  // First check if we need to free up space to cache these frames.
+  while (cacheLevelCurrent + nrFrames * qint64(frameSize) >= cacheLevelMax && !cacheDeQueue.isEmpty())
   {
     plItemFrame frameToRemove = cacheDeQueue.dequeue();
+    if (!frameToRemove.first)
+      continue;
     unsigned int frameToRemoveSize = frameToRemove.first->getCachingFrameSize();
 
-    DEBUG_CACHING_DETAIL("videoCache::pushNextJobToThread Remove frame %d of %s", frameToRemove.second, frameToRemove.first->getName().toStdString().c_str());
+    DEBUG_CACHING_DETAIL("videoCache::startNextCachingTask Remove frame %d of %s", frameToRemove.second, frameToRemove.first->getName().toStdString().c_str());
     frameToRemove.first->removeFrameFromCache(frameToRemove.second);
     cacheLevelCurrent -= frameToRemoveSize;
   }
 
-  if (cacheDeQueue.isEmpty() && cacheLevelCurrent + frameSize > cacheLevelMax)
+  if (cacheLevelCurrent + nrFrames * qint64(frameSize) > cacheLevelMax)
   {
-    // There is still not enough space but there are no more frames that we can remove.
-    // The updateCacheQueue function should never create a situation where this is possible ...
-    // We are done here.
-    return false;
+    // There is not enough space for all frames but there are no more frames that we can remove.
+    // Only cache the frames that fit. The updateCacheQueue function should never create a situation where not 
+    // even one frame fits ...
+    nrFrames = int((cacheLevelMax - cacheLevelCurrent) / frameSize);
+    if (nrFrames <= 0)
+      return false;
   }
 
-  // Push the job to the thread
-  Q_ASSERT_X(plItem != nullptr && frameToCache >= 0, "push next job to cache", "Invalid job.");
-  thread->worker()->setJob(plItem, frameToCache);
-  thread->worker()->setWorking(true);
-  thread->worker()->processCacheJob();
-  DEBUG_CACHING_DETAIL("videoCache::pushNextJobToThread - %d of %s", frameToCache, plItem->getName().toStdString().c_str());
+  // Take the frames from the head of the job (or from the end if the job is cached backwards)
+  QList<int> frames;
+  const bool backwards = j.value().backwards;
+  for (int i = 0; i < nrFrames; i++)
+    frames.append(backwards ? range.second - i : range.first + i);
+  if (range.first + nrFrames > range.second)
+    j.remove();
+  else if (backwards)
+    j.value().frameRange.second = range.second - nrFrames;
+  else
+    j.value().frameRange.first = range.first + nrFrames;
+
+  Q_ASSERT_X(frames.first() >= 0, "start next caching task", "Invalid job.");
+  startCachingTask(plItem, frames, false);
+  DEBUG_CACHING_DETAIL("videoCache::startNextCachingTask - %d to %d of %s", frames.first(), frames.last(), plItem->getName().toStdString().c_str());
 
   // Update the cache level
-  cacheLevelCurrent += frameSize;
+  cacheLevelCurrent += nrFrames * qint64(frameSize);
 
   return true;
 }
 
+void videoCache::startCachingTask(playlistItem *item, const QList<int> &frames, bool test)
+{
+  cachingTask *task = new cachingTask(item, frames, test);
+  // The task emits the signal from the pool thread. The slot is called in the main thread.
+  connect(task, &cachingTask::finished, this, &videoCache::cachingTaskFinished, Qt::QueuedConnection);
+  runningTasks.append(task);
+  cachingPool.start(task);
+}
+
 void videoCache::itemAboutToBeDeleted(playlistItem* item)
 {
-  // One of the items is about to be deleted. Let's stop the caching. Then the item can be deleted
-  // and then we can re-think our caching strategy.
+  // One of the items is about to be deleted. Cancel all caching of the item. Then the item can be deleted
+  // and then we can re-think our caching strategy (the playlist will signal the change).
 
   // Are we currently loading a frame from this item in one of the interactive loading threads?
   bool loadingItem = (interactiveThread[0]->worker()->getCacheItem() == item || interactiveThread[1]->worker()->getCacheItem() == item);
-  bool cachingItem = false;
-
-  if (workerState != workerIdle)
-  {
-    // Are we currently caching a frame from this item?
-    for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == item)
-        cachingItem = true;
-
-    // An item is about to be deleted. We need to rethink what to cache next.
-    workerState = workerIntReqRestart;
-  }
+  cancelCachingTasks(item);
 
-  if (cachingItem || loadingItem)
+  if (isItemBeingCached(item) || loadingItem)
   {
     // The item can be deleted when all caching/loading threads of the item returned.
     itemsToDelete.append(item);
@@ -1350,34 +1481,21 @@ void videoCache::itemNeedsRecache(playlistItem* item, recacheIndicator clearItem
   else
   {
     // Something about the given playlistitem changed and all items in the cache are invalid.
-    // If a thread is currently caching the given item, we have to stop caching, clear the cache,
-    // rethink what to cache and restart the caching.
-    if (workerState != workerIdle)
+    // If a task is currently caching the given item, we have to cancel it and clear the cache when it finished.
+    cancelCachingTasks(item);
+    if (isItemBeingCached(item))
     {
-      // Are we currently caching a frame from this item?
-      bool cachingItem = false;
-      for (loadingThread *t : cachingThreadList)
-      if (t->worker()->getCacheItem() == item)
-        cachingItem = true;
-
-      if (cachingItem)
-      {
-        // The cache of the item needs to be cleared when all threads working on this item finished.
-        if (!itemsToClearCache.contains(item))
-          itemsToClearCache.append(item);
-      }
-      else
-        // We can clear the cache now
-        item->removeAllFramesFromCache();
-      workerState = workerIntReqRestart;
+      // The cache of the item needs to be cleared when all tasks working on this item finished.
+      // Until then, no new tasks are started for the item.
+      if (!itemsToClearCache.contains(item))
+        itemsToClearCache.append(item);
     }
     else
-    {
-      // The worker thread is idle. We can just clear the item cache now.
+      // We can clear the cache now
       item->removeAllFramesFromCache();
-      // This also implies that we want to rethink what to cache
-      scheduleCachingListUpdate();
-    }
+
+    // This also implies that we want to rethink what to cache
+    scheduleCachingListUpdate();
   }
 
   updateCacheStatus();
@@ -1419,7 +1537,7 @@ void videoCache::updateCacheStatus(bool forceNotVisible)
     return;
 
   DEBUG_CACHING_DETAIL("videoCache::updateCacheStatus");
-  statusWidget->updateStatus(playlist, cacheRateInBytesPerMs);
+  statusWidget->updateStatus(playlist, cacheRateInBytesPerMs, cacheLevelMax, adaptiveCacheBudget);
 
   // Also update the caching info label
   updateCachingInfoLabel(forceNotVisible);
@@ -1433,9 +1551,9 @@ void videoCache::updateCachingInfoLabel(bool forceNotVisible)
   QString labelText = "Interactive:\n";
   labelText.append(interactiveThread[0]->worker()->getStatus());
   labelText.append(interactiveThread[1]->worker()->getStatus());
-  labelText.append("Caching:\n");
-  for (loadingThread *t : cachingThreadList)
-    labelText.append(t->worker()->getStatus());
+  labelText.append(QString("Caching (%1 threads):\n").arg(cachingPool.maxThreadCount()));
+  for (cachingTask *t : runningTasks)
+    labelText.append(t->getStatus());
   cachingInfoLabel->setText(labelText);
 }
 
@@ -1461,17 +1579,20 @@ void videoCache::testConversionSpeed()
 
   testLoopCount = 1000;
   testMode = true;
+  testCanceled = false;
   testProgrssUpdateTimer.start(200);
 
-  if (workerState == workerIdle)
+  // Stop normal caching
+  cancelCachingTasks();
+  if (runningTasks.isEmpty())
   {
     // Start caching (in test mode)
     testDuration.start();
     startCaching();
   }
   else
-    // Request a restart (in test mode)
-    workerState = workerIntReqRestart;
+    // Start the test when the running tasks finished
+    testPending = true;
 }
 
 void videoCache::updateTestProgress()
@@ -1480,8 +1601,11 @@ void videoCache::updateTestProgress()
     return;
 
   // Check if the dialog was canceled
-  if (testProgressDialog->wasCanceled())
-    workerState = workerIntReqStop;
+  if (testProgressDialog->wasCanceled() && !testCanceled)
+  {
+    testCanceled = true;
+    cancelCachingTasks();
+  }
 
   // Update the dialog progress
   testProgressDialog->setValue(1000-testLoopCount);
@@ -1497,7 +1621,7 @@ void videoCache::testFinished()
   delete testProgressDialog;
   testProgressDialog.clear();
 
-  if (workerState == workerIntReqStop)
+  if (testCanceled)
     // The test was canceled
     return;
   
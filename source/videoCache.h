@@ -39,6 +39,7 @@
 #include <QPointer>
 #include <QProgressDialog>
 #include <QQueue>
+#include <QThreadPool>
 #include <QTimer>
 #include <QWidget>
 #include "playlistTreeWidget.h"
@@ -51,16 +52,18 @@ class videoCacheStatusWidget : public QWidget
   Q_OBJECT
 
 public:
-  videoCacheStatusWidget(QWidget *parent) : QWidget(parent), cacheLevelMB(0), cacheRateInBytesPerMs(0), cacheLevelMaxMB(0) {}
+  videoCacheStatusWidget(QWidget *parent) : QWidget(parent), cacheLevelMB(0), cacheRateInBytesPerMs(0), cacheLevelMaxMB(0), adaptiveBudget(false) {}
   // Override the paint event
   virtual void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
-  void updateStatus(PlaylistTreeWidget *playlistWidget, unsigned int cacheRate);
+  // Update the status. cacheLevelMax is the current budget of the cache (which may be adaptive).
+  void updateStatus(PlaylistTreeWidget *playlistWidget, unsigned int cacheRate, qint64 cacheLevelMax, bool adaptive);
 private:
   // The floating point values (0 to 1) of the end positions of the blocks to draw
   QList<float> relativeValsEnd;
   unsigned int cacheLevelMB;
   unsigned int cacheRateInBytesPerMs;
   qint64 cacheLevelMaxMB;
+  bool adaptiveBudget;
 };
 
 class videoCache : public QObject
@@ -95,10 +98,8 @@ private slots:
   // currently running, the update will be performed when the currently running caching jobs are done.
   void scheduleCachingListUpdate();
 
-  // The cacheThread finished. If we requested the interruption, update the cache queue and restart.
-  // If the thread finished by itself, push the next item into it or goto idle state if there is no more things
-  // to cache
-  void threadCachingFinished();
+  // A caching task finished (or was canceled). Start the next task if there are more things to cache.
+  void cachingTaskFinished();
 
   // The interactiveWorker finished loading a frame
   void interactiveLoaderFinished();
@@ -119,19 +120,23 @@ private slots:
   // Analyze the current situation and decide which items are to be cached next (in which order) and
   // which frames can be removed from the cache.
   void updateCacheQueue();
+
+  // The current frame was changed while playback is not running. Update the speed and direction of scrubbing.
+  void currentFrameChanged(int frame);
  
 private:
   // A cache job. Has a pointer to a playlist item and a range of frames to be cached.
   struct cacheJob
   {
-    cacheJob() {}
-    cacheJob(playlistItem *item, indexRange range);
+    cacheJob() : backwards(false) {}
+    cacheJob(playlistItem *item, indexRange range, bool backwards=false);
     QPointer<playlistItem> plItem;
     indexRange frameRange;
+    bool backwards;   // Cache the frames from the end of the range to the start
   };
   typedef QPair<QPointer<playlistItem>, int> plItemFrame;
 
-  // When the cache queue is updated, this function will start the background caching.
+  // When the cache queue is updated, this function will start caching tasks until all threads of the pool are busy.
   void startCaching();
 
   QPointer<PlaylistTreeWidget> playlist;
@@ -149,52 +154,74 @@ private:
   qint64 cacheLevelMax;
   qint64 cacheLevelCurrent;
 
+  // --- Adaptive cache budget ---
+  // If enabled, cacheLevelMax follows the memory that is available (the free system memory, the memory limit of the
+  // cgroup and the memory pressure). It is checked periodically. If the budget shrinks, the cache is reduced by the
+  // normal eviction in updateCacheQueue. The threshold from the settings (cacheLevelMaxSetting) is the upper limit.
+  bool adaptiveCacheBudget;
+  qint64 cacheLevelMaxSetting;
+  QTimer adaptiveBudgetTimer;
+  void updateAdaptiveBudget();
+
   // Enqueue the job in the queue. If all frames within the range are already cached in the item, do nothing.
   void enqueueCacheJob(playlistItem* item, indexRange range);
 
+  // --- Scrubbing ---
+  // If playback is not running, the frames around the current frame are cached first. The window of frames extends
+  // further in the direction in which the user is scrubbing (dragging the frame slider) the faster the scrubbing is.
+  int scrubFrame;
+  int scrubDirection;     // 1 (forward) or -1 (backward)
+  double scrubVelocity;   // In frames per second (absolute value)
+  QElapsedTimer scrubTimer;
+  QTimer scrubUpdateTimer;
+  indexRange scrubWindow; // The window that was prioritized in the last update of the cache queue
+  void scrubUpdate();
+  // Get the frames of the given range to cache first (around the current frame). If nrFrames is set, the window
+  // has this size (the ahead/behind ratio is kept). Otherwise the size depends on the scrubbing velocity.
+  indexRange getPrefetchWindow(indexRange range, int nrFrames=-1) const;
+  // Move the frames of the item in the prefetch window to the front of the cache queue
+  void prioritizePrefetchWindow(playlistItem *item);
+
   unsigned int cacheRateInBytesPerMs;
 
-  // Start the given number of worker threads (if caching is running, also new jobs will be pushed to the workers)
-  void startWorkerThreads(int nrThreads);
-  // If this number is > 0, the indicated number of threads will be deleted when a worker finishes (threadCachingFinished() is called)
-  int deleteNrThreads;
   // How many threads are to be used when playback is running?
   int nrThreadsPlayback;
-
-  // Our tiny internal state machine for the worker
-  enum workerStateEnum
-  {
-    workerIdle,         // The worker is idle. We can update the cacheQuene and go to workerRunning
-    workerRunning,      // The worker is running. If it finishes by itself goto workerIdle. If an interrupt is requested, goto workerInterruptRequested.
-    workerIntReqStop,   // The worker is running but an interrupt was requested. Next goto workerIdle.
-    workerIntReqRestart // The worker is running but an interrupt was requested because the queue needs updating. If the worker finished, we will update the queue and goto workerRunning.
-  };
-  workerStateEnum workerState;
   
   // This list contains the items that are scheduled for deletion. 
-  // All items in this list will be deleted (->deleteLate()) when caching has halted.
+  // All items in this list will be deleted (->deleteLate()) when no task is caching or loading them anymore.
   QList<playlistItem*> itemsToDelete;
+  void deleteItemsWhenIdle();
   // This list contains the items that are scheduled for clearing the cache.
-  // The cache of these items will be cleared when caching has halted.
+  // The cache of these items will be cleared when no task is caching them anymore.
   QList<playlistItem*> itemsToClearCache;
 
   // A simple QObject (to move to threads) that gets a pointer to a playlist item and loads a frame in that item.
   class loadingThread;
 
-  // A list of caching threads that process caching of frames in parallel in the background
-  QList<loadingThread*> cachingThreadList;
+  // --- Caching tasks ---
+  // Caching is performed by tasks on a thread pool. The number of threads can be changed at any time. Each task caches
+  // a run of consecutive frames of one item so that a decoder can keep decoding and the overhead of starting a task
+  // is shared by several frames. A task can be canceled. It will stop after the frame that it is currently caching.
+  class cachingTask;
+  QThreadPool cachingPool;
+  // All tasks that were started and did not finish yet (including canceled ones)
+  QList<cachingTask*> runningTasks;
+  // Get the next frames to cache from the queue and start a task for them.
+  // Return false if no task can be started.
+  bool startNextCachingTask();
+  void startCachingTask(playlistItem *item, const QList<int> &frames, bool test);
+  // Cancel all running tasks (or only the ones that cache the given item)
+  void cancelCachingTasks(playlistItem *item=nullptr);
+  // Get the number of tasks that are not canceled (for the given item or for all items)
+  int getNrActiveTasks(playlistItem *item=nullptr) const;
+  // Is a task (also a canceled one that did not return yet) caching the given item?
+  bool isItemBeingCached(playlistItem *item) const;
 
   // Two threads with a higher priority that performs interactive loading (if the user is the source of the request)
   loadingThread *interactiveThread[2];
   playlistItem  *interactiveItemQueued[2];
   int            interactiveItemQueued_Idx[2];
 
-  // Get the next item and frame to cache from the queue and push it to the given worker.
-  // Return false if there are no more jobs to be pushed.
-  bool pushNextJobToThread(loadingThread *thread);
-  
-  bool updateCacheQueueAndRestartWorker;
-
   // This item is watched. When caching of it is done, we will notify the playback controller.
   playlistItem *watchingItem;
 
@@ -216,6 +243,8 @@ private:
   QPointer<QProgressDialog> testProgressDialog;
   QPointer<playlistItem> testItem;              //< The item to use for the test
   bool testMode;                                //< Set to true when the test is running
+  bool testPending;                             //< The test starts when the running caching tasks finished
+  bool testCanceled;                            //< The test was canceled by the user
   int testLoopCount;                            //< Set before the test starts. Count down to 0. Then the test is over.
   QTimer testProgrssUpdateTimer;                //< Periodically update the progress dialog
   void updateTestProgress();
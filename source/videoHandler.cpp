@@ -32,6 +32,7 @@
 
 #include "videoHandler.h"
 
+#include <QAtomicInt>
 #include <QPainter>
 
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
@@ -42,15 +43,40 @@
 #define DEBUG_VIDEO(fmt,...) ((void)0)
 #endif
 
+// How many frames are loaded ahead of the current frame during playback
+#define DOUBLE_BUFFER_QUEUE_DEPTH_DEFAULT 4
+#define DOUBLE_BUFFER_QUEUE_DEPTH_MAX 64
+
 // --------- videoHandler -------------------------------------
 
+static QAtomicInt doubleBufferQueueDepth(DOUBLE_BUFFER_QUEUE_DEPTH_DEFAULT);
+
 videoHandler::videoHandler()
 {
   // Initialize variables
   currentImageIdx = -1;
   currentImage_frameIndex = -1;
-  doubleBufferImageFrameIdx = -1;
   cacheValid = true;
+  parallelFrameLoading = false;
+  cacheLayer = 0;
+}
+
+void videoHandler::setDoubleBufferQueueDepth(int depth)
+{
+  doubleBufferQueueDepth.store(clip(depth, 1, DOUBLE_BUFFER_QUEUE_DEPTH_MAX));
+}
+
+int videoHandler::getDoubleBufferQueueDepth()
+{
+  return doubleBufferQueueDepth.load();
+}
+
+void videoHandler::setDiskCacheEnabled(bool enable)
+{
+  if (enable && !diskCache)
+    diskCache.reset(new diskFrameCache());
+  else if (!enable)
+    diskCache.reset();
 }
 
 void videoHandler::slotVideoControlChanged()
@@ -86,75 +112,35 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
       return state;
   }
 
-  // Lock the mutex for checking the cache
+  // Lock the mutex for checking the cache and the double buffer queue
   QMutexLocker lock(&imageCacheAccess);
 
-  // The raw values are not needed. 
-  if (frameIdx == currentImageIdx)
+  if (frameIdx != currentImageIdx && !doubleBufferQueue.contains(frameIdx) && !(cacheValid && imageCache.contains(frameIdx)))
   {
-    if (doubleBufferImageFrameIdx == frameIdx + 1)
-    {
-      DEBUG_VIDEO("videoHandler::needsLoading %d is current and %d found in double buffer", frameIdx, frameIdx+1);
-      return LoadingNotNeeded;
-    }
-    else if (cacheValid && imageCache.contains(frameIdx + 1))
-    {
-      DEBUG_VIDEO("videoHandler::needsLoading %d is current and %d found in cache", frameIdx, frameIdx+1);
-      return LoadingNotNeeded;
-    }
-    else
-    {
-      // The next frame is not in the double buffer so that needs to be loaded.
-      DEBUG_VIDEO("videoHandler::needsLoading %d is current but %d not found in double buffer", frameIdx, frameIdx+1);
-      return LoadingNeededDoubleBuffer;
-    }
+    // Frame not in buffer. Return false and request the background loading thread to load the frame.
+    DEBUG_VIDEO("videoHandler::needsLoading %d not found in cache - request load", frameIdx);
+    return LoadingNeeded;
   }
 
-  // Check the double buffer
-  if (doubleBufferImageFrameIdx == frameIdx)
+  // The frame can be drawn. Are the next frames also available (in the double buffer queue or in the cache)?
+  const int queueDepth = getDoubleBufferQueueDepth();
+  for (int i = 1; i <= queueDepth; i++)
   {
-    // The frame in question is in the double buffer...
-    if (cacheValid && imageCache.contains(frameIdx + 1))
-    {
-      // ... and the one after that is in the cache.
-      DEBUG_VIDEO("videoHandler::needsLoading %d found in double buffer. Next frame in cache.", frameIdx);
-      return LoadingNotNeeded;
-    }
-    else
+    if (!doubleBufferQueue.contains(frameIdx + i) && !(cacheValid && imageCache.contains(frameIdx + i)))
     {
-      // .. and the one after that is not in the cache.
-      // Loading of the given frame index is not needed because it is in the double buffer but if you draw it, 
-      // the double buffer needs an update.
-      DEBUG_VIDEO("videoHandler::needsLoading %d found in double buffer", frameIdx);
+      DEBUG_VIDEO("videoHandler::needsLoading %d found but %d not found in double buffer queue", frameIdx, frameIdx+i);
       return LoadingNeededDoubleBuffer;
     }
   }
 
-  // Check the cache
-  if (cacheValid && imageCache.contains(frameIdx))
-  {
-    // What about the next frame? Is it also in the cache or in the double buffer?
-    if (doubleBufferImageFrameIdx == frameIdx + 1)
-    {
-      DEBUG_VIDEO("videoHandler::needsLoading %d in cache and %d found in double buffer", frameIdx, frameIdx+1);
-      return LoadingNotNeeded;
-    }
-    else if (cacheValid && imageCache.contains(frameIdx + 1))
-    {
-      DEBUG_VIDEO("videoHandler::needsLoading %d in cache and %d found in cache", frameIdx, frameIdx+1);
-      return LoadingNotNeeded;
-    }
-    else
-    {
-      // The next frame is not in the double buffer so that needs to be loaded.
-      DEBUG_VIDEO("videoHandler::needsLoading %d found in cache but %d not found in double buffer", frameIdx, frameIdx+1);
-      return LoadingNeededDoubleBuffer;
-    }
-  }
+  DEBUG_VIDEO("videoHandler::needsLoading %d found and the next %d frames are queued", frameIdx, queueDepth);
+  return LoadingNotNeeded;
+}
 
-  // Frame not in buffer. Return false and request the background loading thread to load the frame.
-  DEBUG_VIDEO("videoHandler::needsLoading %d not found in cache - request load", frameIdx);
-  return LoadingNeeded;
+bool videoHandler::isFrameAvailable(int frameIdx) const
+{
+  QMutexLocker lock(&imageCacheAccess);
+  return frameIdx == currentImageIdx || doubleBufferQueue.contains(frameIdx) || (cacheValid && imageCache.contains(frameIdx));
 }
 
 void videoHandler::drawFrame(QPainter *painter, int frameIdx, double zoomFactor, bool drawRawValues)
@@ -164,14 +150,9 @@ void videoHandler::drawFrame(QPainter *painter, int frameIdx, double zoomFactor,
   {
     // The current buffer is out of date. Update it.
 
-    // Check the double buffer
-    if (frameIdx == doubleBufferImageFrameIdx)
-    {
-      currentImage = doubleBufferImage;
-      currentImageIdx = frameIdx;
-      DEBUG_VIDEO("videoHandler::drawFrame %d loaded from double buffer", frameIdx);
-    }
-    else
+    // Check the double buffer queue
+    activateDoubleBuffer(frameIdx);
+    if (frameIdx != currentImageIdx)
     {
       QMutexLocker lock(&imageCacheAccess);
       if (cacheValid && imageCache.contains(frameIdx))
@@ -245,9 +226,10 @@ void videoHandler::cacheFrame(int frameIdx, bool testMode)
     return;
   }
 
-  // Load the frame. While this is happening in the background the frame size must not change.
-  QImage cacheImage;
-  loadFrameForCaching(frameIdx, cacheImage);
+  // Load the frame (from the disk cache if it is in there). While this is happening in the background the frame size must not change.
+  QImage cacheImage = testMode ? QImage() : getFrameFromDiskCache(frameIdx);
+  if (cacheImage.isNull())
+    loadFrameForCaching(frameIdx, cacheImage);
 
   // Put it into the cache
   if (!cacheImage.isNull())
@@ -289,8 +271,15 @@ void videoHandler::removeFrameFromCache(int frameIdx)
 {
   DEBUG_VIDEO("removeFrameFromCache %d", frameIdx);
   QMutexLocker lock(&imageCacheAccess);
-  imageCache.remove(frameIdx);
+  QImage evictedImage = imageCache.take(frameIdx);
+  for (auto &layer : otherCacheLayers)
+    layer.remove(frameIdx);
+  const bool spillToDisk = cacheValid && diskCache && !evictedImage.isNull();
   lock.unlock();
+
+  // Move the frame to the second tier of the cache. It is written to disk in the background.
+  if (spillToDisk)
+    diskCache->add(frameIdx, evictedImage);
 }
 
 void videoHandler::removeAllFrameFromCache()
@@ -298,14 +287,80 @@ void videoHandler::removeAllFrameFromCache()
   DEBUG_VIDEO("removeAllFrameFromCache");
   QMutexLocker lock(&imageCacheAccess);
   imageCache.clear();
+  otherCacheLayers.clear();
+  if (diskCache)
+    diskCache->clear();
   cacheValid = true;
   lock.unlock();
 }
 
+void videoHandler::setCacheLayer(int layer)
+{
+  imageCacheAccess.lock();
+  if (layer == cacheLayer)
+  {
+    imageCacheAccess.unlock();
+    return;
+  }
+  DEBUG_VIDEO("videoHandler::setCacheLayer %d -> %d", cacheLayer, layer);
+  QMap<int, QMap<int, QImage>> layers = otherCacheLayers;
+  if (cacheValid && !imageCache.isEmpty())
+    layers.insert(cacheLayer, imageCache);
+  imageCacheAccess.unlock();
+
+  // The current frame, the double buffer queue, the disk cache (and all buffers of the sub class) show the old layer
+  invalidateAllBuffers();
+
+  QMutexLocker lock(&imageCacheAccess);
+  imageCache = layers.take(layer);
+  otherCacheLayers = layers;
+  cacheLayer = layer;
+}
+
+qint64 videoHandler::getOtherCacheLayersSize() const
+{
+  QMutexLocker lock(&imageCacheAccess);
+  qint64 nrBytes = 0;
+  for (auto &layer : otherCacheLayers)
+    for (const QImage &image : layer)
+      nrBytes += image.byteCount();
+  return nrBytes;
+}
+
+void videoHandler::removeOtherCacheLayers()
+{
+  DEBUG_VIDEO("videoHandler::removeOtherCacheLayers");
+  QMutexLocker lock(&imageCacheAccess);
+  otherCacheLayers.clear();
+}
+
 void videoHandler::loadFrame(int frameIndex, bool loadToDoubleBuffer)
 {
   DEBUG_VIDEO("videoHandler::loadFrame %d %s\n", frameIndex, (loadToDoubleBuffer) ? "toDoubleBuffer" : "");
 
+  if (loadFrameFromDiskCache(frameIndex, loadToDoubleBuffer))
+    return;
+
+  if (parallelFrameLoading)
+  {
+    // Load the frame into a local image. The caching threads may be loading other frames at the same time.
+    QImage image;
+    emit signalRequestFrameToImage(frameIndex, image);
+    if (image.isNull())
+      // Loading failed
+      return;
+
+    if (loadToDoubleBuffer)
+      addFrameToDoubleBuffer(frameIndex, image);
+    else
+    {
+      QMutexLocker imageLock(&currentImageSetMutex);
+      currentImage = image;
+      currentImageIdx = frameIndex;
+    }
+    return;
+  }
+
   if (requestedFrame_idx != frameIndex)
   {
     // Lock the mutex for requesting raw data (we share the requestedFrame buffer with the caching function)
@@ -321,9 +376,8 @@ void videoHandler::loadFrame(int frameIndex, bool loadToDoubleBuffer)
 
   if (loadToDoubleBuffer)
   {
-    // Save the requested frame in the double buffer
-    doubleBufferImage = requestedFrame;
-    doubleBufferImageFrameIdx = frameIndex;
+    // Save the requested frame in the double buffer queue
+    addFrameToDoubleBuffer(frameIndex, requestedFrame);
   }
   else
   {
@@ -338,6 +392,13 @@ void videoHandler::loadFrameForCaching(int frameIndex, QImage &frameToCache)
 {
   DEBUG_VIDEO("videoHandler::loadFrameForCaching %d", frameIndex);
 
+  if (parallelFrameLoading)
+  {
+    // No need to lock. The frame is loaded directly into the given image.
+    emit signalRequestFrameToImage(frameIndex, frameToCache);
+    return;
+  }
+
   QMutexLocker lock(&requestDataMutex);
 
   // Request the image to be loaded
@@ -350,6 +411,57 @@ void videoHandler::loadFrameForCaching(int frameIndex, QImage &frameToCache)
   frameToCache = requestedFrame;
 }
 
+QImage videoHandler::getFrameImage(int frameIdx)
+{
+  {
+    QMutexLocker lock(&imageCacheAccess);
+    if (cacheValid && imageCache.contains(frameIdx))
+      return imageCache[frameIdx];
+    if (doubleBufferQueue.contains(frameIdx))
+      return doubleBufferQueue[frameIdx];
+  }
+  {
+    QMutexLocker imageLock(&currentImageSetMutex);
+    if (currentImageIdx == frameIdx && !currentImage.isNull())
+      return currentImage;
+  }
+
+  QImage image = getFrameFromDiskCache(frameIdx);
+  if (image.isNull())
+    loadFrameForCaching(frameIdx, image);
+  return image;
+}
+
+QImage videoHandler::getFrameFromDiskCache(int frameIndex)
+{
+  if (!diskCache)
+    return QImage();
+  {
+    QMutexLocker lock(&imageCacheAccess);
+    if (!cacheValid)
+      return QImage();
+  }
+  return diskCache->get(frameIndex);
+}
+
+bool videoHandler::loadFrameFromDiskCache(int frameIndex, bool loadToDoubleBuffer)
+{
+  QImage image = getFrameFromDiskCache(frameIndex);
+  if (image.isNull())
+    return false;
+
+  DEBUG_VIDEO("videoHandler::loadFrameFromDiskCache %d", frameIndex);
+  if (loadToDoubleBuffer)
+    addFrameToDoubleBuffer(frameIndex, image);
+  else
+  {
+    QMutexLocker imageLock(&currentImageSetMutex);
+    currentImage = image;
+    currentImageIdx = frameIndex;
+  }
+  return true;
+}
+
 void videoHandler::invalidateAllBuffers()
 {
   // Check if the new resolution changed the number of frames in the sequence
@@ -363,16 +475,55 @@ void videoHandler::invalidateAllBuffers()
   currentImageSetMutex.unlock();
   requestedFrame_idx = -1;
 
+  QMutexLocker lock(&imageCacheAccess);
   imageCache.clear();
+  otherCacheLayers.clear();
+  doubleBufferQueue.clear();
+  if (diskCache)
+    diskCache->clear();
   cacheValid = true;
 }
 
-void videoHandler::activateDoubleBuffer()
+void videoHandler::activateDoubleBuffer(int frameIdx)
+{
+  QMutexLocker lock(&imageCacheAccess);
+  if (doubleBufferQueue.contains(frameIdx))
+  {
+    QMutexLocker imageLock(&currentImageSetMutex);
+    currentImage = doubleBufferQueue.take(frameIdx);
+    currentImageIdx = frameIdx;
+    DEBUG_VIDEO("videoHandler::activateDoubleBuffer %d loaded from double buffer", currentImageIdx);
+  }
+
+  // The frames before the given frame will not be shown during playback anymore
+  while (!doubleBufferQueue.isEmpty() && doubleBufferQueue.firstKey() < frameIdx)
+    doubleBufferQueue.erase(doubleBufferQueue.begin());
+}
+
+void videoHandler::addFrameToDoubleBuffer(int frameIdx, const QImage &image)
 {
-  if (doubleBufferImageFrameIdx != -1)
+  QMutexLocker lock(&imageCacheAccess);
+
+  // Frames are added to the queue in playback order. Drop all frames that are after the new frame (left over from
+  // a previous playback position) or too far before it.
+  const int queueDepth = getDoubleBufferQueueDepth();
+  auto it = doubleBufferQueue.begin();
+  while (it != doubleBufferQueue.end())
   {
-    currentImage = doubleBufferImage;
-    currentImageIdx = doubleBufferImageFrameIdx;
-    DEBUG_VIDEO("videoHandler::drawFrame %d loaded from double buffer", currentImageIdx);
+    if (it.key() < frameIdx - queueDepth || it.key() > frameIdx)
+      it = doubleBufferQueue.erase(it);
+    else
+      ++it;
   }
+
+  doubleBufferQueue.insert(frameIdx, image);
+}
+
+void videoHandler::setCacheInvalid()
+{
+  QMutexLocker lock(&imageCacheAccess);
+  cacheValid = false;
+  doubleBufferQueue.clear();
+  if (diskCache)
+    diskCache->clear();
 }
\ No newline at end of file
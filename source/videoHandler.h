@@ -33,6 +33,7 @@
 #ifndef VIDEOHANDLER_H
 #define VIDEOHANDLER_H
 
+#include "diskFrameCache.h"
 #include "frameHandler.h"
 #include <QBasicTimer>
 #include <QFileInfo>
@@ -98,8 +99,43 @@ public:
 
   int getCurrentImageIndex() { return currentImageIdx; }
 
-  // Set the image in the double buffer as the current image. After this, a new image can be loaded to the double buffer.
-  void activateDoubleBuffer();
+  // If the given frame is in the double buffer queue, set it as the current image. All frames before the given frame are 
+  // removed from the queue so that new frames can be loaded into it.
+  void activateDoubleBuffer(int frameIdx);
+
+  // --- Double buffer queue ---
+  // During playback, the frames following the current frame are loaded into the double buffer queue by the interactive
+  // loading threads (also if caching is disabled). This way, a single slow frame does not stall playback.
+  // The queue depth is a global setting and can be changed from any thread.
+  static void setDoubleBufferQueueDepth(int depth);
+  static int getDoubleBufferQueueDepth();
+  // Is the given frame available for drawing without loading (current frame, in the double buffer queue or in the cache)?
+  bool isFrameAvailable(int frameIdx) const;
+  // Get the image of the given frame without changing the current frame. The image is taken from the cache, the double
+  // buffer queue or the current frame. If it is in none of these, it is loaded like a frame for caching. This is thread-safe.
+  QImage getFrameImage(int frameIdx);
+
+  // --- Parallel loading ---
+  // If the source can load any frame independently and thread-safe (e.g. one image file per frame), it can enable
+  // parallel loading. Frames are then requested using signalRequestFrameToImage (which must be connected using a
+  // Qt::DirectConnection) without locking requestDataMutex, so that all caching threads can load frames at the same time.
+  void setParallelFrameLoading(bool enable) { parallelFrameLoading = enable; }
+
+  // --- Disk cache ---
+  // If loading a frame is expensive (e.g. decoding of coded video), frames that are removed from the cache can be
+  // written to a scratch file on disk (second tier of the cache). Frames are then read back from disk instead of
+  // being loaded again. If the disk cache is disabled in the settings, this has no effect.
+  void setDiskCacheEnabled(bool enable);
+
+  // --- Cache layers ---
+  // A source may provide different signals of the same frames (e.g. the reconstruction and the residual of a decoder).
+  // Every signal has its own layer in the cache. When the layer is changed, the cached frames of the old layer are kept
+  // and the frames of the new layer (if it was shown before) are restored. Only the frames of the current layer are
+  // counted by getNumberCachedFrames and listed by getCachedFrames. The frames of the other layers are counted
+  // separately (getOtherCacheLayersSize) and can only be removed all at once.
+  void setCacheLayer(int layer);
+  qint64 getOtherCacheLayersSize() const;
+  void removeOtherCacheLayers();
   
 signals:
 
@@ -109,6 +145,10 @@ signals:
 
   // The video handler requests a certain frame to be loaded. After this signal is emitted, the frame should be in requestedFrame.
   void signalRequestFrame(int frameIdx, bool caching);
+
+  // If parallel loading is enabled, the given frame should be loaded into the given image. This can be emitted
+  // from several threads at the same time.
+  void signalRequestFrameToImage(int frameIdx, QImage &image);
     
 protected:
 
@@ -139,14 +179,16 @@ protected:
   // Don't let the background loading thread set the image while we are drawing it.
   QMutex currentImageSetMutex;
 
-  // Double buffering
-  QImage doubleBufferImage;
-  int    doubleBufferImageFrameIdx;
+  // Double buffering. A queue of frames that were loaded ahead of the current frame. Access is protected by imageCacheAccess.
+  QMap<int, QImage> doubleBufferQueue;
+  // Add the given frame to the double buffer queue. Frames that are too far from the given frame are dropped.
+  void addFrameToDoubleBuffer(int frameIdx, const QImage &image);
 
-  // Set the cache to be invalid until a call to removefromCache(-1) clears it.
-  void setCacheInvalid() { cacheValid = false; }
+  // Set the cache to be invalid until a call to removefromCache(-1) clears it. This also clears the double buffer queue.
+  void setCacheInvalid();
 
   // --- Caching
+  // Protects the imageCache and the doubleBufferQueue
   QMutex mutable     imageCacheAccess;
   QMap<int, QImage>  imageCache;
   // Is the cache valid? The cache can be ivalid in the following scenario:
@@ -156,6 +198,21 @@ protected:
   // Until then, however, the items that are in the cache (or are being put into the cache by the still running threads) are invalid.
   bool cacheValid;
 
+  // Are frames loaded using signalRequestFrameToImage?
+  bool parallelFrameLoading;
+
+  // The current cache layer and the cached frames of all other layers. Protected by imageCacheAccess.
+  int cacheLayer;
+  QMap<int, QMap<int, QImage>> otherCacheLayers;
+
+  // The second tier of the cache (if enabled). The frames in the disk cache are valid if cacheValid is set.
+  QScopedPointer<diskFrameCache> diskCache;
+  // If the frame is in the disk cache, read it from there and set it as the current frame (or put it into the
+  // double buffer queue). Returns false if the frame is not in the disk cache.
+  bool loadFrameFromDiskCache(int frameIndex, bool loadToDoubleBuffer);
+  // Get the frame from the disk cache. Returns a null image if it is not in there.
+  QImage getFrameFromDiskCache(int frameIndex);
+
 private slots:
   // Override the slotVideoControlChanged slot. For a videoHandler, also the number of frames might have changed.
   void slotVideoControlChanged() Q_DECL_OVERRIDE;
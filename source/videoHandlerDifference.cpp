@@ -49,6 +49,9 @@ videoHandlerDifference::videoHandlerDifference() : videoHandler()
   markDifference = false;
   amplificationFactor = 1;
   codingOrder = CodingOrder_HEVC;
+  inputFrameOffset[0] = 0;
+  inputFrameOffset[1] = 0;
+  currentDifferenceFromInputs = false;
 }
 
 void videoHandlerDifference::drawDifferenceFrame(QPainter *painter, int frameIdx, int frameIdxItem0, int frameIdxItem1, double zoomFactor, bool drawRawValues)
@@ -61,14 +64,9 @@ void videoHandlerDifference::drawDifferenceFrame(QPainter *painter, int frameIdx
   {
     // The current buffer is out of date. Update it.
 
-    // Check the double buffer
-    if (frameIdx == doubleBufferImageFrameIdx)
-    {
-      currentImage = doubleBufferImage;
-      currentImageIdx = frameIdx;
-      DEBUG_VIDEO("videoHandler::drawFrame %d loaded from double buffer", frameIdx);
-    }
-    else
+    // Check the double buffer queue
+    activateDoubleBuffer(frameIdx);
+    if (frameIdx != currentImageIdx)
     {
       QMutexLocker lock(&imageCacheAccess);
       if (cacheValid && imageCache.contains(frameIdx))
@@ -78,6 +76,14 @@ void videoHandlerDifference::drawDifferenceFrame(QPainter *painter, int frameIdx
         DEBUG_VIDEO("videoHandler::drawFrame %d loaded from cache", frameIdx);
       }
     }
+
+    if (frameIdx == currentImageIdx)
+    {
+      // The difference was calculated in the background. Use the info that was calculated with it.
+      QMutexLocker lock(&imageCacheAccess);
+      differenceInfoList = cachedDifferenceInfo.value(frameIdx);
+      currentDifferenceFromInputs = false;
+    }
   }
 
   // Create the video QRect with the size of the sequence and center it.
@@ -99,12 +105,23 @@ void videoHandlerDifference::drawDifferenceFrame(QPainter *painter, int frameIdx
 
 void videoHandlerDifference::loadFrameDifference(int frameIndex, int frameIndex0, int frameIndex1, bool loadToDoubleBuffer)
 {
-  // No double buffering for difference items
-  Q_UNUSED(loadToDoubleBuffer);
-
   // Calculate the difference between the inputVideos
   if (!inputsValid())
     return;
+
+  if (loadToDoubleBuffer)
+  {
+    // Calculate the difference like for caching so that the current frames of the inputs are not changed
+    QList<infoItem> infoList;
+    QImage newFrame = calculateDifferenceForCaching(frameIndex0, frameIndex1, infoList);
+    if (!newFrame.isNull())
+    {
+      addFrameToDoubleBuffer(frameIndex, newFrame);
+      QMutexLocker lock(&imageCacheAccess);
+      cachedDifferenceInfo.insert(frameIndex, infoList);
+    }
+    return;
+  }
   
   differenceInfoList.clear();
 
@@ -125,9 +142,92 @@ void videoHandlerDifference::loadFrameDifference(int frameIndex, int frameIndex0
     currentImageSetMutex.lock();
     currentImage = newFrame;
     currentImageSetMutex.unlock();
+    currentDifferenceFromInputs = true;
   }
 }
 
+void videoHandlerDifference::setInputFrameOffsets(int offset0, int offset1)
+{
+  QMutexLocker lock(&imageCacheAccess);
+  inputFrameOffset[0] = offset0;
+  inputFrameOffset[1] = offset1;
+}
+
+void videoHandlerDifference::loadFrameForCaching(int frameIndex, QImage &frameToCache)
+{
+  DEBUG_VIDEO("videoHandlerDifference::loadFrameForCaching %d", frameIndex);
+
+  if (!inputsValid())
+    return;
+
+  int frameIndex0, frameIndex1;
+  {
+    QMutexLocker lock(&imageCacheAccess);
+    frameIndex0 = frameIndex + inputFrameOffset[0];
+    frameIndex1 = frameIndex + inputFrameOffset[1];
+  }
+
+  QList<infoItem> infoList;
+  frameToCache = calculateDifferenceForCaching(frameIndex0, frameIndex1, infoList);
+  if (!frameToCache.isNull())
+  {
+    QMutexLocker lock(&imageCacheAccess);
+    cachedDifferenceInfo.insert(frameIndex, infoList);
+  }
+}
+
+QImage videoHandlerDifference::calculateDifferenceForCaching(int frameIndex0, int frameIndex1, QList<infoItem> &infoList)
+{
+  // If both inputs are YUV with the same subsampling, calculate the difference from the raw YUV data
+  // (the same as videoHandlerYUV::calculateDifference does for the current frames).
+  videoHandlerYUV *yuvVideo0 = dynamic_cast<videoHandlerYUV*>(inputVideo[0].data());
+  videoHandlerYUV *yuvVideo1 = dynamic_cast<videoHandlerYUV*>(inputVideo[1].data());
+  if (yuvVideo0 && yuvVideo1 && yuvVideo0->getYUVPixelFormat().subsampling == yuvVideo1->getYUVPixelFormat().subsampling)
+    return yuvVideo0->calculateDifferenceForCaching(yuvVideo1, frameIndex0, frameIndex1, infoList, amplificationFactor, markDifference);
+
+  // Compare the RGB images of the inputs. For videos, the images are taken from the cache if possible.
+  QImage image[2];
+  const int frameIndex[2] = {frameIndex0, frameIndex1};
+  for (int i = 0; i < 2; i++)
+  {
+    videoHandler *video = dynamic_cast<videoHandler*>(inputVideo[i].data());
+    image[i] = (video) ? video->getFrameImage(frameIndex[i]) : inputVideo[i]->getCurrentFrameAsImage();
+    if (image[i].isNull())
+      return QImage();
+  }
+
+  const QSize diffSize(std::min(image[0].width(), image[1].width()), std::min(image[0].height(), image[1].height()));
+  return calculateDifferenceRGB(image[0], image[1], diffSize, infoList, amplificationFactor, markDifference);
+}
+
+void videoHandlerDifference::invalidateDifference()
+{
+  currentImageIdx = -1;
+  currentDifferenceFromInputs = false;
+
+  // Set the cache to invalid until it is cleared and recached
+  setCacheInvalid();
+  QMutexLocker lock(&imageCacheAccess);
+  cachedDifferenceInfo.clear();
+}
+
+void videoHandlerDifference::removeFrameFromCache(int frameIdx)
+{
+  videoHandler::removeFrameFromCache(frameIdx);
+
+  QMutexLocker lock(&imageCacheAccess);
+  if (!doubleBufferQueue.contains(frameIdx))
+    cachedDifferenceInfo.remove(frameIdx);
+}
+
+void videoHandlerDifference::removeAllFrameFromCache()
+{
+  videoHandler::removeAllFrameFromCache();
+
+  QMutexLocker lock(&imageCacheAccess);
+  cachedDifferenceInfo.clear();
+}
+
 bool videoHandlerDifference::inputsValid() const
 {
   if (inputVideo[0].isNull() || inputVideo[1].isNull())
@@ -203,9 +303,9 @@ void videoHandlerDifference::slotDifferenceControlChanged()
   {
     markDifference = ui.markDifferenceCheckBox->isChecked();
 
-    // Set the current frame in the buffer to be invalid and emit the signal that something has changed
-    currentImageIdx = -1;
-    emit signalHandlerChanged(true, RECACHE_NONE);
+    // All calculated differences are invalid. Emit that we need a redraw and a recache.
+    invalidateDifference();
+    emit signalHandlerChanged(true, RECACHE_CLEAR);
   }
   else if (sender == ui.codingOrderComboBox)
   {
@@ -218,9 +318,9 @@ void videoHandlerDifference::slotDifferenceControlChanged()
   {
     amplificationFactor = ui.amplificationFactorSpinBox->value();
 
-    // Set the current frame in the buffer to be invalid and emit the signal that something has changed
-    currentImageIdx = -1;
-    emit signalHandlerChanged(true, RECACHE_NONE);
+    // All calculated differences are invalid. Emit that we need a redraw and a recache.
+    invalidateDifference();
+    emit signalHandlerChanged(true, RECACHE_CLEAR);
   }
 }
 
@@ -251,7 +351,7 @@ void videoHandlerDifference::reportFirstDifferencePosition(QList<infoItem> &info
 
 
         videoHandlerYUV* video0 = dynamic_cast<videoHandlerYUV*>(inputVideo[0].data());
-        if(video0 != NULL && video0->getIs_YUV_diff())
+        if(video0 != NULL && video0->getIs_YUV_diff() && currentDifferenceFromInputs)
         {
 
             // find first difference using YUV instead of QImage. The latter does not work for 10bit videos and very small differences, since it only supports 8bit
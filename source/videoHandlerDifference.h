@@ -70,6 +70,20 @@ public:
 
   // Calculate the position of the first difference and add the info to the list
   void reportFirstDifferencePosition(QList<infoItem> &infoList) const;
+
+  // Set the offsets from the frame index of the difference to the frame indices of the two inputs.
+  // These are needed when a difference frame is calculated for caching.
+  void setInputFrameOffsets(int offset0, int offset1);
+
+  // An input or a difference setting changed. All differences (current frame, double buffer and cache) are invalid
+  // until the cache was cleared (removeAllFrameFromCache).
+  void invalidateDifference();
+  // Only the current difference frame is out of date. The double buffer and the cache stay valid.
+  void invalidateCurrentDifference() { currentImageIdx = -1; }
+
+  // Overloaded from videoHandler. Also remove the difference info of the frames.
+  virtual void removeFrameFromCache(int frameIdx) Q_DECL_OVERRIDE;
+  virtual void removeAllFrameFromCache() Q_DECL_OVERRIDE;
     
 private slots:
   void slotDifferenceControlChanged();
@@ -78,6 +92,9 @@ protected:
   bool markDifference;  // Mark differences?
   int  amplificationFactor;
 
+  // Calculate the difference for caching. The current frames/buffers of the inputs are not changed.
+  virtual void loadFrameForCaching(int frameIndex, QImage &frameToCache) Q_DECL_OVERRIDE;
+
 private:
 
   typedef enum
@@ -88,6 +105,19 @@ private:
 
   // The two videos that the difference will be calculated from
   QPointer<frameHandler> inputVideo[2];  
+  int inputFrameOffset[2];  // Protected by imageCacheAccess (read by the caching threads)
+
+  // Calculate the difference of the given input frames without modifying the inputs. If both inputs are YUV
+  // with the same subsampling, the difference is calculated from the raw YUV data. Otherwise the RGB images
+  // of the inputs (cached if possible) are compared. This is thread save.
+  QImage calculateDifferenceForCaching(int frameIndex0, int frameIndex1, QList<infoItem> &infoList);
+
+  // The difference info (MSE ...) of the frames in the double buffer and the cache. If one of these frames is drawn,
+  // the differenceInfoList is set from here. Protected by imageCacheAccess.
+  QMap<int, QList<infoItem>> cachedDifferenceInfo;
+  // Was the current frame calculated from the current frames of the inputs (loadFrameDifference)? Only then
+  // the YUV difference of the first input belongs to the current frame.
+  bool currentDifferenceFromInputs;
 
   // Recursively scan the LCU
   bool hierarchicalPosition(int x, int y, int blockSize, int &firstX, int &firstY, int &partIndex, const QImage &diffImg) const;
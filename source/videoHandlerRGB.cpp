@@ -428,6 +428,11 @@ void videoHandlerRGB::loadFrame(int frameIndex, bool loadToDoubleBuffer)
     // We cannot load a frame if the format is not known
     return;
 
+  // The converted frame may be in the disk cache. If the current image is already up to date, we are only here
+  // to load the raw values.
+  if ((loadToDoubleBuffer || currentImageIdx != frameIndex) && loadFrameFromDiskCache(frameIndex, loadToDoubleBuffer))
+    return;
+
   // Does the data in currentFrameRawRGBData need to be updated?
   if (!loadRawRGBData(frameIndex))
     // Loading failed or it is still being performed in the background
@@ -439,8 +444,7 @@ void videoHandlerRGB::loadFrame(int frameIndex, bool loadToDoubleBuffer)
   {
     QImage newImage;
     convertRGBToImage(currentFrameRawRGBData, newImage);
-    doubleBufferImage = newImage;
-    doubleBufferImageFrameIdx = frameIndex;
+    addFrameToDoubleBuffer(frameIndex, newImage);
   }
   else if (currentImageIdx != frameIndex)
   {
@@ -34,10 +34,16 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
 #include <xmmintrin.h>
 #include <QDir>
 #include <QPainter>
+#include <QThread>
+#include <QtConcurrent>
 #include "fileInfoWidget.h"
+#include "valueLabelRenderer.h"
 
 using namespace YUV_Internals;
 
@@ -141,21 +147,72 @@ bool isDefaultChromaFormat(int chromaOffset, bool offsetX, YUVSubsamplingType su
   return chromaOffset == 0;
 }
 
-// Compute the MSE between the given char sources for numPixels bytes
+// When guessing the format from the correlation of two frames, only every n-th row is compared
+#define YUV_CORRELATION_ROW_STEP 4
+
+// Compute the MSE between the given frames (8 or 16 bit samples). Only every rowStep-th row is used. The inner loop has no
+// branches and uses independent integer sums per row so that the compiler can vectorize it. The maximum sample value
+// of the first frame is returned in maxValue.
 template<typename T>
-double computeMSE(T ptr, T ptr2, int numPixels)
+double computeMSESubsampledRows(const T * restrict frame1, const T * restrict frame2, int width, int height, int rowStep, int &maxValue)
 {
-  if (numPixels <= 0)
-    return 0.0;
+  // For 8 bit samples, the squared differences of a row fit into 32 bit
+  typedef typename std::conditional<sizeof(T) == 1, int, qint64>::type diffType;
+  typedef typename std::conditional<sizeof(T) == 1, quint32, quint64>::type rowSumType;
+
+  quint64 ssd = 0;
+  qint64 numSamples = 0;
+  int maxVal = 0;
+  for (int y = 0; y < height; y += rowStep)
+  {
+    const T *row1 = frame1 + qint64(y) * width;
+    const T *row2 = frame2 + qint64(y) * width;
+    rowSumType rowSum = 0;
+    int rowMax = 0;
+    for (int x = 0; x < width; x++)
+    {
+      const diffType diff = diffType(row1[x]) - diffType(row2[x]);
+      rowSum += rowSumType(diff * diff);
+      rowMax = std::max(rowMax, int(row1[x]));
+    }
+    ssd += rowSum;
+    maxVal = std::max(maxVal, rowMax);
+    numSamples += width;
+  }
 
-  quint64 sad = 0;
-  for(int i=0; i<numPixels; i++)
+  maxValue = maxVal;
+  return (numSamples == 0) ? std::numeric_limits<double>::max() : double(ssd) / numSamples;
+}
+
+// Guess if the chroma of the given 4:2:0 frame (the first frame in rawData) is interleaved (UVUV...). In a planar
+// chroma plane neighboring samples are similar. In an interleaved plane the U and V samples alternate, so the samples
+// two positions apart are much more similar than direct neighbors.
+template<typename T>
+bool isChromaInterleavedInternal(const T *chroma, qint64 numSamples)
+{
+  quint64 diff1 = 0;
+  quint64 diff2 = 0;
+  for (qint64 i = 0; i + 2 < numSamples; i++)
   {
-    int diff = (int)ptr[i] - (int)ptr2[i];
-    sad += diff*diff;
+    diff1 += std::abs(int(chroma[i]) - int(chroma[i+1]));
+    diff2 += std::abs(int(chroma[i]) - int(chroma[i+2]));
   }
+  return diff2 * 2 < diff1;
+}
 
-  return (double)sad / numPixels;
+static bool isChromaInterleaved(const QByteArray &rawYUVData, const yuvPixelFormat &format, const QSize &size)
+{
+  const qint64 lumaSamples = qint64(size.width()) * size.height();
+  const qint64 chromaSamples = lumaSamples / 2;  // U and V
+  if (format.bitsPerSample > 8)
+  {
+    if ((lumaSamples + chromaSamples) * 2 > rawYUVData.size())
+      return false;
+    return isChromaInterleavedInternal((const unsigned short*) rawYUVData.constData() + lumaSamples, chromaSamples);
+  }
+  if (lumaSamples + chromaSamples > rawYUVData.size())
+    return false;
+  return isChromaInterleavedInternal((const unsigned char*) rawYUVData.constData() + lumaSamples, chromaSamples);
 }
 
 namespace YUV_Internals
@@ -1179,12 +1236,9 @@ void videoHandlerYUV::drawPixelValues(QPainter *painter, const int frameIdx, con
 
   // The center point of the pixel (0,0).
   const QPoint centerPointZero = (QPoint(-size.width(), -size.height()) * zoomFactor + QPoint(zoomFactor,zoomFactor)) / 2;
-  // This QRect has the size of one pixel and is moved on top of each pixel to draw the text
-  QRect pixelRect;
-  pixelRect.setSize(QSize(zoomFactor, zoomFactor));
 
-  // We might change the pen doing this so backup the current pen and reset it later
-  QPen backupPen = painter->pen();
+  // The values of all visible pixels are collected and drawn in one batch
+  valueLabelRenderer labels;
 
   // If the Y is below this value, use white text, otherwise black text
   // If there is a second item, a difference will be drawn. A difference of 0 is displayed as gray.
@@ -1209,9 +1263,8 @@ void videoHandlerYUV::drawPixelValues(QPainter *painter, const int frameIdx, con
   {
     for (int y = yMin; y <= yMax; y++)
     {
-      // Calculate the center point of the pixel. (Each pixel is of size (zoomFactor,zoomFactor)) and move the pixelRect to that point.
+      // Calculate the center point of the pixel. (Each pixel is of size (zoomFactor,zoomFactor)).
       QPoint pixCenter = centerPointZero + QPoint(x * zoomFactor, y * zoomFactor);
-      pixelRect.moveCenter(pixCenter);
 
       // Get the YUV values to show
       int Y,U,V;
@@ -1261,47 +1314,34 @@ void videoHandlerYUV::drawPixelValues(QPainter *painter, const int frameIdx, con
         drawWhite = (mathParameters[Luma].invert) ? (Y > whiteLimit) : (Y < whiteLimit);
       }
 
-      // Set the pen
-      painter->setPen(drawWhite ? Qt::white : Qt::black);
-
+      const QColor textColor = drawWhite ? Qt::white : Qt::black;
       if (chromaPresent && (x-chromaOffsetFullX) % subsamplingX == 0 && (y-chromaOffsetFullY) % subsamplingY == 0)
       {
-        QString valText;
+        labels.newLine(pixCenter, textColor);
+        labels.append('Y');
+        labels.append(Y);
         if (chromaOffsetHalfX || chromaOffsetHalfY)
-          // We will only draw the Y value at the center of this pixel
-          valText = QString("Y%1").arg(Y);
-        else
-          // We also draw the U and V value at this position
-          valText = QString("Y%1\nU%2\nV%3").arg(Y).arg(U).arg(V);
-        // Draw
-        painter->drawText(pixelRect, Qt::AlignCenter, valText);
-
-        if (chromaOffsetHalfX || chromaOffsetHalfY)
-        {
-          // Draw the U and V values shifted half a pixel right and/or down
-          valText = QString("U%1\nV%2").arg(U).arg(V);
-
-          // Move the QRect by half a pixel
-          if (chromaOffsetHalfX)
-            pixelRect.translate(zoomFactor/2, 0);
-          if (chromaOffsetHalfY)
-            pixelRect.translate(0, zoomFactor/2);
-
-          // Draw
-          painter->drawText(pixelRect, Qt::AlignCenter, valText);
-        }
+          // Draw the U and V values shifted half a pixel right and/or down. Otherwise they are drawn below the Y value.
+          pixCenter += QPoint(chromaOffsetHalfX ? int(zoomFactor/2) : 0, chromaOffsetHalfY ? int(zoomFactor/2) : 0);
+        labels.newLine(pixCenter, textColor);
+        labels.append('U');
+        labels.append(U);
+        labels.newLine(pixCenter, textColor);
+        labels.append('V');
+        labels.append(V);
       }
       else
       {
         // We only draw the luma value for this pixel
-        QString valText = QString("Y%1").arg(Y);
-        painter->drawText(pixelRect, Qt::AlignCenter, valText);
+        labels.newLine(pixCenter, textColor);
+        labels.append('Y');
+        labels.append(Y);
       }
     }
   }
 
-  // Reset pen
-  painter->setPen(backupPen);
+  // Draw all the values in one batch
+  labels.draw(painter, true);
 }
 
 void videoHandlerYUV::setFormatFromSizeAndName(const QSize size, int bitDepth, qint64 fileSize, const QFileInfo &fileInfo)
@@ -1489,13 +1529,14 @@ void videoHandlerYUV::setFormatFromSizeAndName(const QSize size, int bitDepth, q
   }
 }
 
-/** Try to guess the format of the raw YUV data. A list of candidates is tried (candidateModes) and it is checked if
+/** Try to guess the format of the raw YUV data. A list of candidates is tried and it is checked if
   * the file size matches and if the correlation of the first two frames is below a threshold.
-  * radData must contain at least two frames of the video sequence. Only formats that two frames of could fit into rawData
-  * are tested. E.g. the biggest format that is tested here is 1080p YUV 4:2:2 8 bit which is 4147200 bytes per frame. So
-  * make sure rawData contains 8294400 bytes so that all formats are tested.
+  * radData must contain at least two frames of the video sequence. Candidates for which the luma plane of the second
+  * frame is not at least half in rawData are not tested. E.g. for 2160p YUV 4:2:0 10 bit, rawData should contain
+  * about 40 MB.
   * If a file size is given, we test if the candidates frame size is a multiple of the fileSize. If fileSize is -1, this test
   * is skipped.
+  * The candidates are tested in parallel and only every YUV_CORRELATION_ROW_STEP-th luma row is compared.
   */
 void videoHandlerYUV::setFormatFromCorrelation(const QByteArray &rawYUVData, qint64 fileSize)
 {
@@ -1505,35 +1546,46 @@ void videoHandlerYUV::setFormatFromCorrelation(const QByteArray &rawYUVData, qin
   class testFormatAndSize
   {
   public:
-    testFormatAndSize(const QSize &size, yuvPixelFormat format) : size(size), format(format) { interesting = false; mse = 0; }
+    testFormatAndSize(const QSize &size, yuvPixelFormat format) : size(size), format(format) { interesting = false; mse = 0; maxValue = 0; }
     QSize size;
     yuvPixelFormat format;
     bool interesting;
     double mse;
+    int maxValue;
   };
 
   // The candidates for the size
   const QList<QSize> testSizes = QList<QSize>()
     << QSize(176, 144)
+    << QSize(320, 240)
     << QSize(352, 240)
     << QSize(352, 288)
+    << QSize(416, 240)
     << QSize(480, 480)
     << QSize(480, 576)
+    << QSize(640, 480)
     << QSize(704, 480)
     << QSize(720, 480)
     << QSize(704, 576)
     << QSize(720, 576)
+    << QSize(832, 480)
     << QSize(1024, 768)
     << QSize(1280, 720)
     << QSize(1280, 960)
+    << QSize(1280, 1024)
     << QSize(1920, 1072)
-    << QSize(1920, 1080);
-
-  // Test bit depths 8, 10 and 16
+    << QSize(1920, 1080)
+    << QSize(1920, 1200)
+    << QSize(2048, 1080)
+    << QSize(2560, 1440)
+    << QSize(2560, 1600)
+    << QSize(3840, 2160)
+    << QSize(4096, 2160);
+
+  // Test bit depths 8, 10, 12 and 16
   QList<testFormatAndSize> formatList;
-  for (int b = 0; b < 3; b++)
+  for (int bits : {8, 10, 12, 16})
   {
-    int bits = (b==0) ? 8 : (b==1) ? 10 : 16;
     // Test all subsampling modes
     for (int i = 0; i < YUV_NUM_SUBSAMPLINGS; i++)
     {
@@ -1545,55 +1597,69 @@ void videoHandlerYUV::setFormatFromCorrelation(const QByteArray &rawYUVData, qin
     }
   }
 
-  if (fileSize > 0)
+  // Set all candidates which fit into the data as interesting
+  bool found = false;
+  for (testFormatAndSize &testFormat : formatList)
   {
-    // if any candidate exceeds file size for two frames, discard
-    // if any candidate does not represent a multiple of file size, discard
-    bool found = false;
+    qint64 picSize = testFormat.format.bytesPerFrame(testFormat.size);
+    qint64 lumaSize = testFormat.size.width() * testFormat.size.height() * ((testFormat.format.bitsPerSample > 8) ? 2 : 1);
 
-    for (testFormatAndSize &testFormat : formatList)
-    {
-      qint64 picSize = testFormat.format.bytesPerFrame(testFormat.size);
+    // At least half of the luma plane of the second frame must be in the data
+    if (picSize <= 0 || picSize + lumaSize / 2 > rawYUVData.size())
+      continue;
 
-      if(fileSize >= (picSize*2))       // at least 2 pictures for correlation analysis
-      {
-        if((fileSize % picSize) == 0)   // important: file size must be multiple of the picture size
-        {
-          testFormat.interesting = true;  // test passed
-          found = true;
-        }
-      }
+    if (fileSize > 0)
+    {
+      // if any candidate exceeds file size for two frames, discard
+      // if any candidate does not represent a multiple of file size, discard
+      if (fileSize < (picSize*2))             // at least 2 pictures for correlation analysis
+        continue;
+      if ((fileSize % picSize) != 0)          // important: file size must be multiple of the picture size
+        continue;
     }
 
-    if(!found)
-      // No candidate matches the file size
-      return;
+    testFormat.interesting = true;
+    found = true;
   }
 
-  // calculate max. correlation for first two frames, use max. candidate frame size
-  for (testFormatAndSize &testFormat : formatList)
+  if(!found)
+    // No candidate matches the file size
+    return;
+
+  // Calculate the correlation of the first two frames for all interesting candidates in parallel
+  QtConcurrent::blockingMap(formatList, [&rawYUVData](testFormatAndSize &testFormat)
   {
-    if (testFormat.interesting)
-    {
-      qint64 picSize = testFormat.format.bytesPerFrame(testFormat.size);
-      int lumaSamples = testFormat.size.width() * testFormat.size.height();
+    if (!testFormat.interesting)
+      return;
 
-      // Calculate the MSE for 2 frames
-      if (testFormat.format.bitsPerSample == 8)
-      {
-        unsigned char *ptr = (unsigned char*) rawYUVData.data();
-        testFormat.mse = computeMSE(ptr, ptr + picSize, lumaSamples);
-      }
-      else if (testFormat.format.bitsPerSample > 8 && testFormat.format.bitsPerSample <= 16)
-      {
-        unsigned short *ptr = (unsigned short*) rawYUVData.data();
-        testFormat.mse = computeMSE(ptr, ptr + picSize/2, lumaSamples);
-      }
-      else
-        // Not handled here
-        continue;
+    const qint64 picSize = testFormat.format.bytesPerFrame(testFormat.size);
+    const int width = testFormat.size.width();
+    const int bytesPerSample = (testFormat.format.bitsPerSample > 8) ? 2 : 1;
+
+    // The second frame may not be completely in the data. Only use the rows that are.
+    const int rowsInData = int((rawYUVData.size() - picSize) / (width * bytesPerSample));
+    const int height = std::min(testFormat.size.height(), rowsInData);
+
+    if (bytesPerSample == 1)
+    {
+      const unsigned char *ptr = (const unsigned char*) rawYUVData.constData();
+      testFormat.mse = computeMSESubsampledRows(ptr, ptr + picSize, width, height, YUV_CORRELATION_ROW_STEP, testFormat.maxValue);
     }
-  }
+    else
+    {
+      const unsigned short *ptr = (const unsigned short*) rawYUVData.constData();
+      testFormat.mse = computeMSESubsampledRows(ptr, ptr + picSize / 2, width, height, YUV_CORRELATION_ROW_STEP, testFormat.maxValue);
+
+      // Scale the MSE to 8 bit so that the threshold applies to all bit depths. The same data is interpreted
+      // with different bit depths by the 10, 12 and 16 bit candidates. Only the smallest bit depth that can
+      // hold the maximum sample value is plausible.
+      const int neededBits = (testFormat.maxValue < 1024) ? 10 : (testFormat.maxValue < 4096) ? 12 : 16;
+      if (testFormat.format.bitsPerSample != neededBits)
+        testFormat.interesting = false;
+      const int shift = 2 * (testFormat.format.bitsPerSample - 8);
+      testFormat.mse /= double(1 << shift);
+    }
+  });
 
   // step3: select best candidate
   double leastMSE = std::numeric_limits<double>::max(); // large error...
@@ -1609,9 +1675,30 @@ void videoHandlerYUV::setFormatFromCorrelation(const QByteArray &rawYUVData, qin
     }
   }
 
+  if (bestFormat.bitsPerSample > 8)
+  {
+    // 8 bit data that is interpreted with more than 8 bits per sample has a much smaller scaled MSE. If an 8 bit
+    // candidate with the same frame size in bytes also correlates well, the 8 bit candidate is more plausible.
+    const qint64 bestPicSize = bestFormat.bytesPerFrame(bestSize);
+    double least8BitMSE = 400;
+    for (const testFormatAndSize &testFormat : formatList)
+    {
+      if (testFormat.interesting && testFormat.format.bitsPerSample == 8 && testFormat.mse < least8BitMSE && testFormat.format.bytesPerFrame(testFormat.size) == bestPicSize)
+      {
+        bestFormat = testFormat.format;
+        bestSize = testFormat.size;
+        leastMSE = testFormat.mse;
+        least8BitMSE = testFormat.mse;
+      }
+    }
+  }
+
   if(leastMSE < 400)
   {
     // MSE is below threshold. Choose the candidate.
+    // The luma correlation is the same for planar and interleaved chroma. For 4:2:0, check the chroma data.
+    if (bestFormat.subsampling == YUV_420 && isChromaInterleaved(rawYUVData, bestFormat, bestSize))
+      bestFormat.uvInterleaved = true;
     setSrcPixelFormat(bestFormat, false);
     setFrameSize(bestSize);
   }
@@ -1625,6 +1712,11 @@ void videoHandlerYUV::loadFrame(int frameIndex, bool loadToDoubleBuffer)
     // We cannot load a frame if the format is not known
     return;
 
+  // The converted frame may be in the disk cache. If the current image is already up to date, we are only here
+  // to load the raw values.
+  if ((loadToDoubleBuffer || currentImageIdx != frameIndex) && loadFrameFromDiskCache(frameIndex, loadToDoubleBuffer))
+    return;
+
   // Does the data in currentFrameRawYUVData need to be updated?
   if (!loadRawYUVData(frameIndex))
     // Loading failed or it is still being performed in the background
@@ -1636,8 +1728,7 @@ void videoHandlerYUV::loadFrame(int frameIndex, bool loadToDoubleBuffer)
   {
     QImage newImage;
     convertYUVToImage(currentFrameRawYUVData, newImage, srcPixelFormat, frameSize);
-    doubleBufferImage = newImage;
-    doubleBufferImageFrameIdx = frameIndex;
+    addFrameToDoubleBuffer(frameIndex, newImage);
   }
   else if (currentImageIdx != frameIndex)
   {
@@ -1695,8 +1786,10 @@ bool videoHandlerYUV::loadRawYUVData(int frameIndex)
     return false;
   }
 
+  currentImageSetMutex.lock();
   currentFrameRawYUVData = rawYUVData;
   currentFrameRawYUVData_frameIdx = frameIndex;
+  currentImageSetMutex.unlock();
   requestDataMutex.unlock();
   
   DEBUG_YUV("videoHandlerYUV::loadRawYUVData %d Done", frameIndex);
@@ -1805,6 +1898,93 @@ inline void setValueInBuffer(unsigned char * restrict dst, const int val, const
     dst[idx] = val;
 }
 
+// The position of one YUV component within a raw YUV buffer. The sample at position (x,y) (in the coordinates of
+// the component) is read using getValueFromSource(src, (y*componentWidth+x)*valSkip, ...). This works for planar, 
+// planar with interleaved U/V and packed formats, so that packed data can be read without first converting it
+// to a planar buffer.
+struct yuvComponentPointer
+{
+  const unsigned char *src;
+  int valSkip;
+};
+
+// Get the position of the Y, U and V component within the given raw YUV data. Return false if the format is not supported.
+// For 4:0:0 formats, the U and V pointers are set to the luma component.
+inline bool getYUVComponentPointers(const unsigned char *data, const yuvPixelFormat &format, const QSize &frameSize, yuvComponentPointer &compY, yuvComponentPointer &compU, yuvComponentPointer &compV)
+{
+  const int bytesPerSample = (format.bitsPerSample > 8) ? 2 : 1;
+  if (format.planar)
+  {
+    const int w = frameSize.width();
+    const int h = frameSize.height();
+    const int nrBytesLumaPlane = w * h * bytesPerSample;
+    const int nrBytesChromaPlane = (w / format.getSubsamplingHor()) * (h / format.getSubsamplingVer()) * bytesPerSample;
+    const bool uFirst = (format.planeOrder == Order_YUV || format.planeOrder == Order_YUVA);
+
+    compY.src = data;
+    compY.valSkip = 1;
+    if (format.subsampling == YUV_400)
+    {
+      compU = compY;
+      compV = compY;
+    }
+    else if (format.uvInterleaved)
+    {
+      // U, V (and alpha) are interleaved in one plane
+      const int valSkip = (format.planeOrder == Order_YUV || format.planeOrder == Order_YVU) ? 2 : 3;
+      compU.src = data + nrBytesLumaPlane + (uFirst ? 0 : bytesPerSample);
+      compV.src = data + nrBytesLumaPlane + (uFirst ? bytesPerSample : 0);
+      compU.valSkip = valSkip;
+      compV.valSkip = valSkip;
+    }
+    else
+    {
+      compU.src = data + nrBytesLumaPlane + (uFirst ? 0 : nrBytesChromaPlane);
+      compV.src = data + nrBytesLumaPlane + (uFirst ? nrBytesChromaPlane : 0);
+      compU.valSkip = 1;
+      compV.valSkip = 1;
+    }
+    return true;
+  }
+
+  const YUVPackingOrder packing = format.packingOrder;
+  if (format.subsampling == YUV_422)
+  {
+    // The data is arranged in blocks of 4 samples (2 luma samples and one U and V sample).
+    // What are the offsets withing the 4 samples for the components?
+    const int oY = (packing == Packing_YUYV || packing == Packing_YVYU) ? 0 : 1;
+    const int oU = (packing == Packing_UYVY) ? 0 : (packing == Packing_YUYV) ? 1 : (packing == Packing_VYUY) ? 2 : 3;
+    const int oV = (packing == Packing_VYUY) ? 0 : (packing == Packing_YVYU) ? 1 : (packing == Packing_UYVY) ? 2 : 3;
+
+    compY.src = data + oY * bytesPerSample;
+    compU.src = data + oU * bytesPerSample;
+    compV.src = data + oV * bytesPerSample;
+    compY.valSkip = 2;
+    compU.valSkip = 4;
+    compV.valSkip = 4;
+    return true;
+  }
+  if (format.subsampling == YUV_444)
+  {
+    // What are the offsets withing the 3 or 4 samples per pixel?
+    const int oY = (packing == Packing_AYUV) ? 1 : 0;
+    const int oU = (packing == Packing_YUV || packing == Packing_YUVA) ? 1 : 2;
+    const int oV = (packing == Packing_YVU) ? 1 : (packing == Packing_AYUV) ? 3 : 2;
+    const int valSkip = (packing == Packing_YUV || packing == Packing_YVU) ? 3 : 4;
+
+    compY.src = data + oY * bytesPerSample;
+    compU.src = data + oU * bytesPerSample;
+    compV.src = data + oV * bytesPerSample;
+    compY.valSkip = valSkip;
+    compU.valSkip = valSkip;
+    compV.valSkip = valSkip;
+    return true;
+  }
+
+  // Packed formats are only supported for 4:2:2 and 4:4:4
+  return false;
+}
+
 // For every input sample in src, apply YUV transformation, (scale to 8 bit if required) and set the value as RGB (monochrome).
 // inValSkip: skip this many values in the input for every value. For pure planar formats, this 1. If the UV components are interleaved, this is 2 or 3.
 inline void YUVPlaneToRGBMonochrome_444(const int componentSize, const yuvMathParameters math, const unsigned char * restrict src, unsigned char * restrict dst,
@@ -2161,16 +2341,18 @@ inline void UVPlaneResamplingChromaOffset(const yuvPixelFormat format, const int
   }
 }
 
+// lumaValSkip: skip this many values in the luma input for every value. This is 1 for planar formats. For packed formats,
+// the Y samples are read directly from the packed data and this is the distance between two luma samples.
 inline void YUVPlaneToRGB_444(const int componentSize, const yuvMathParameters mathY, const yuvMathParameters mathC,
                               const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const int bps, const bool bigEndian, const int inValSkip)
+                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const int bps, const bool bigEndian, const int inValSkip, const int lumaValSkip)
 {
   const bool applyMathLuma = mathY.yuvMathRequired();
   const bool applyMathChroma = mathC.yuvMathRequired();
 
   for (int i = 0; i < componentSize; ++i)
   {
-    unsigned int valY = getValueFromSource(srcY, i, bps, bigEndian);
+    unsigned int valY = getValueFromSource(srcY, i*lumaValSkip, bps, bigEndian);
     unsigned int valU = getValueFromSource(srcU, i*inValSkip, bps, bigEndian);
     unsigned int valV = getValueFromSource(srcV, i*inValSkip, bps, bigEndian);
 
@@ -2196,7 +2378,7 @@ inline void YUVPlaneToRGB_444(const int componentSize, const yuvMathParameters m
 
 inline void YUVPlaneToRGB_422(const int w, const int h, const yuvMathParameters mathY, const yuvMathParameters mathC,
                               const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const InterpolationMode interpolation, const int bps, const bool bigEndian, const int inValSkip)
+                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const InterpolationMode interpolation, const int bps, const bool bigEndian, const int inValSkip, const int lumaValSkip)
 {
   const bool applyMathLuma = mathY.yuvMathRequired();
   const bool applyMathChroma = mathC.yuvMathRequired();
@@ -2229,8 +2411,8 @@ inline void YUVPlaneToRGB_422(const int w, const int h, const yuvMathParameters
       int interpolatedV = interpolateUVSample(interpolation, curVSample, nextVSample);
 
       // Get the 2 Y samples
-      int valY1 = getValueFromSource(srcY, y*w+x*2,   bps, bigEndian);
-      int valY2 = getValueFromSource(srcY, y*w+x*2+1, bps, bigEndian);
+      int valY1 = getValueFromSource(srcY, (y*w+x*2)*lumaValSkip,   bps, bigEndian);
+      int valY2 = getValueFromSource(srcY, (y*w+x*2+1)*lumaValSkip, bps, bigEndian);
       if (applyMathLuma)
       {
         valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
@@ -2259,8 +2441,8 @@ inline void YUVPlaneToRGB_422(const int w, const int h, const yuvMathParameters
     // For the last row, there is no next sample. Just reuse the current one again. No interpolation required either.
 
     // Get the 2 Y samples
-    int valY1 = getValueFromSource(srcY, (y+1)*w-2, bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y+1)*w-1, bps, bigEndian);
+    int valY1 = getValueFromSource(srcY, ((y+1)*w-2)*lumaValSkip, bps, bigEndian);
+    int valY2 = getValueFromSource(srcY, ((y+1)*w-1)*lumaValSkip, bps, bigEndian);
     if (applyMathLuma)
     {
       valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
@@ -2838,115 +3020,85 @@ inline void YUVPlaneToRGB_411(const int w, const int h, const yuvMathParameters
   }
 }
 
-bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &curFrameSize, yuvPixelFormat &sourceBufferFormat)
+bool videoHandlerYUV::convertYUVPackedToRGB(const QByteArray &sourceBuffer, uchar *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat) const
 {
+  // These are constant for the runtime of this function. This way, the compiler can optimize the
+  // hell out of this function.
   const yuvPixelFormat format = sourceBufferFormat;
-  const YUVPackingOrder packing = format.packingOrder;
-
-  // Make sure that the target buffer is big enough. It should be as big as the input buffer.
-  if (targetBuffer.size() != sourceBuffer.size())
-    targetBuffer.resize(sourceBuffer.size());
-
+  const InterpolationMode interpolation = interpolationMode;
+  const ComponentDisplayMode component = componentDisplayMode;
   const int w = curFrameSize.width();
   const int h = curFrameSize.height();
 
-  // Bytes per sample
-  const int bps = (format.bitsPerSample > 8) ? 2 : 1;
+  const yuvMathParameters mathY = mathParameters[Luma];
+  const yuvMathParameters mathC = mathParameters[Chroma];
 
-  if (format.subsampling == YUV_422)
-  {
-    // The data is arranged in blocks of 4 samples. How many of these are there?
-    const int nr4Samples = w*h/2;
+  const int bps = format.bitsPerSample;
+  const bool fullRange = (yuvColorConversionType == BT709_FullRange || yuvColorConversionType == BT601_FullRange || yuvColorConversionType == BT2020_FullRange);
+  const int inputMax = (1<<bps)-1;
 
-    // What are the offsets withing the 4 samples for the components?
-    const int oY = (packing == Packing_YUYV || packing == Packing_YVYU) ? 0 : 1;
-    const int oU = (packing == Packing_UYVY) ? 0 : (packing == Packing_YUYV) ? 1 : (packing == Packing_VYUY) ? 2 : 3;
-    const int oV = (packing == Packing_VYUY) ? 0 : (packing == Packing_YVYU) ? 1 : (packing == Packing_UYVY) ? 2 : 3;
+  // Get the positions of the components directly within the packed data. No intermediate planar buffer is needed.
+  yuvComponentPointer compY, compU, compV;
+  if (!getYUVComponentPointers((const unsigned char*)sourceBuffer.data(), format, curFrameSize, compY, compU, compV))
+    return false;
 
-    if (bps == 1)
-    {
-      // One byte per sample.
-      const unsigned char * restrict src = (unsigned char*)sourceBuffer.data();
-      unsigned char * restrict dstY = (unsigned char*)targetBuffer.data();
-      unsigned char * restrict dstU = dstY + w*h;
-      unsigned char * restrict dstV = dstU + w/2*h;
+  const int componentSizeLuma = (w * h);
+  const int componentSizeChroma = (w / format.getSubsamplingHor()) * (h / format.getSubsamplingVer());
 
-      for (int i = 0; i < nr4Samples; i++)
-      {
-        *dstY++ = src[oY];
-        *dstY++ = src[oY+2];
-        *dstU++ = src[oU];
-        *dstV++ = src[oV];
-        src += 4; // Goto the next 4 samples
-      }
-    }
-    else
-    {
-      // Two bytes per sample.
-      const unsigned short * restrict src = (unsigned short*)sourceBuffer.data();
-      unsigned short * restrict dstY = (unsigned short*)targetBuffer.data();
-      unsigned short * restrict dstU = dstY + w*h;
-      unsigned short * restrict dstV = dstU + w/2*h;
+  // A pointer to the output
+  unsigned char * restrict dst = targetBuffer;
 
-      for (int i = 0; i < nr4Samples; i++)
-      {
-        *dstY++ = src[oY];
-        *dstY++ = src[oY+2];
-        *dstU++ = src[oU];
-        *dstV++ = src[oV];
-        src += 4; // Goto the next 4 samples
-      }
-    }
+  if (component == DisplayY)
+    YUVPlaneToRGBMonochrome_444(componentSizeLuma, mathY, compY.src, dst, inputMax, bps, format.bigEndian, compY.valSkip, fullRange);
+  else if (component == DisplayCb || component == DisplayCr)
+  {
+    const yuvComponentPointer compC = (component == DisplayCb) ? compU : compV;
+    if (format.subsampling == YUV_444)
+      YUVPlaneToRGBMonochrome_444(componentSizeChroma, mathC, compC.src, dst, inputMax, bps, format.bigEndian, compC.valSkip, fullRange);
+    else if (format.subsampling == YUV_422)
+      YUVPlaneToRGBMonochrome_422(componentSizeChroma, mathC, compC.src, dst, inputMax, bps, format.bigEndian, compC.valSkip, fullRange);
+    else
+      return false;
   }
-  else if (format.subsampling == YUV_444)
+  else
   {
-    // What are the offsets withing the 3 or 4 bytes per sample?
-    const int oY = (packing == Packing_AYUV) ? 1 : 0;
-    const int oU = (packing == Packing_YUV || packing == Packing_YUVA) ? 1 : 2;
-    const int oV = (packing == Packing_YVU) ? 1 : (packing == Packing_AYUV) ? 3 : 2;
+    // Get/set the parameters used for YUV -> RGB conversion
+    const int RGBConv[5] = { 
+      yuvRgbConvCoeffs[yuvColorConversionType][0],
+      yuvRgbConvCoeffs[yuvColorConversionType][1],
+      yuvRgbConvCoeffs[yuvColorConversionType][2],
+      yuvRgbConvCoeffs[yuvColorConversionType][3],
+      yuvRgbConvCoeffs[yuvColorConversionType][4]
+    };
 
-    // How many samples to the next sample?
-    const int offsetNext = (packing == Packing_YUV || packing == Packing_YVU ? 3 : 4);
+    const unsigned char * restrict srcU = compU.src;
+    const unsigned char * restrict srcV = compV.src;
+    int chromaValSkip = compU.valSkip;
 
-    if (bps == 1)
+    QByteArray uvPlaneChromaResampled[2];
+    if (format.chromaOffset[0] != 0 || format.chromaOffset[1] != 0)
     {
-      // One byte per sample.
-      const unsigned char * restrict src = (unsigned char*)sourceBuffer.data();
-      unsigned char * restrict dstY = (unsigned char*)targetBuffer.data();
-      unsigned char * restrict dstU = dstY + w*h;
-      unsigned char * restrict dstV = dstU + w*h;
+      // There is an offset between the luma and chroma sample positions. Resample the chroma components first.
+      // Only the (subsampled) chroma values are written to a temporary buffer. Luma is still read from the packed data.
+      const int nrBytesChromaPlane = (bps > 8) ? componentSizeChroma * 2 : componentSizeChroma;
+      uvPlaneChromaResampled[0].resize(nrBytesChromaPlane);
+      uvPlaneChromaResampled[1].resize(nrBytesChromaPlane);
+      unsigned char *restrict dstU = (unsigned char*)uvPlaneChromaResampled[0].data();
+      unsigned char *restrict dstV = (unsigned char*)uvPlaneChromaResampled[1].data();
+      UVPlaneResamplingChromaOffset(format, w / format.getSubsamplingHor(), h / format.getSubsamplingVer(), compU.src, compV.src, compU.valSkip, dstU, dstV);
 
-      for (int i = 0; i < w*h; i++)
-      {
-        *dstY++ = src[oY];
-        *dstU++ = src[oU];
-        *dstV++ = src[oV];
-        src += offsetNext; // Goto the next sample
-      }
+      srcU = dstU;
+      srcV = dstV;
+      chromaValSkip = 1;
     }
-    else
-    {
-      // Two bytes per sample.
-      const unsigned short * restrict src = (unsigned short*)sourceBuffer.data();
-      unsigned short * restrict dstY = (unsigned short*)targetBuffer.data();
-      unsigned short * restrict dstU = dstY + w*h;
-      unsigned short * restrict dstV = dstU + w*h;
 
-      for (int i = 0; i < w*h; i++)
-      {
-        *dstY++ = src[oY];
-        *dstU++ = src[oU];
-        *dstV++ = src[oV];
-        src += offsetNext; // Goto the next sample
-      }
-    }
+    if (format.subsampling == YUV_444)
+      YUVPlaneToRGB_444(componentSizeLuma, mathY, mathC, compY.src, srcU, srcV, dst, RGBConv, fullRange, inputMax, bps, format.bigEndian, chromaValSkip, compY.valSkip);
+    else if (format.subsampling == YUV_422)
+      YUVPlaneToRGB_422(w, h, mathY, mathC, compY.src, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, chromaValSkip, compY.valSkip);
+    else
+      return false;
   }
-  else
-    return false;
-
-  // The output buffer is planar with the same subsampling as before
-  sourceBufferFormat.planar = true;
-  sourceBufferFormat.planeOrder = Order_YUV;
 
   return true;
 }
@@ -3072,9 +3224,9 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
       UVPlaneResamplingChromaOffset(format, w / format.getSubsamplingHor(), h / format.getSubsamplingVer(), srcU, srcV, inputValSkip, dstU, dstV);
 
       if (format.subsampling == YUV_444)
-        YUVPlaneToRGB_444(componentSizeLuma, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, bps, format.bigEndian, 1);
+        YUVPlaneToRGB_444(componentSizeLuma, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, bps, format.bigEndian, 1, 1);
       else if (format.subsampling == YUV_422)
-        YUVPlaneToRGB_422(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1);
+        YUVPlaneToRGB_422(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1, 1);
       else if (format.subsampling == YUV_420)
         YUVPlaneToRGB_420(w, h, mathY, mathC, srcY, dstU, dstV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, 1);
       else if (format.subsampling == YUV_440)
@@ -3094,9 +3246,9 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
       const unsigned char * restrict srcV = uPlaneFirst ? srcY + nrBytesLumaPlane + nrBytesToNextChromaPlane: srcY + nrBytesLumaPlane;
 
       if (format.subsampling == YUV_444)
-        YUVPlaneToRGB_444(componentSizeLuma, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, bps, format.bigEndian, inputValSkip);
+        YUVPlaneToRGB_444(componentSizeLuma, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, bps, format.bigEndian, inputValSkip, 1);
       else if (format.subsampling == YUV_422)
-        YUVPlaneToRGB_422(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip);
+        YUVPlaneToRGB_422(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip, 1);
       else if (format.subsampling == YUV_420)
         YUVPlaneToRGB_420(w, h, mathY, mathC, srcY, srcU, srcV, dst, RGBConv, fullRange, inputMax, interpolation, bps, format.bigEndian, inputValSkip);
       else if (format.subsampling == YUV_440)
@@ -3160,16 +3312,8 @@ void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &
       convOK = convertYUVPlanarToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat);
   }
   else
-  {
-    // Convert to a planar format first
-    QByteArray tmpPlanarYUVSource;
-    // This is the current format of the buffer. The conversion function will change this.
-    yuvPixelFormat bufferPixelFormat = yuvFormat;
-    convOK &= convertYUVPackedToPlanar(sourceBuffer, tmpPlanarYUVSource, curFrameSize, bufferPixelFormat);
-
-    if (convOK)
-      convOK &= convertYUVPlanarToRGB(tmpPlanarYUVSource, outputImage.bits(), curFrameSize, bufferPixelFormat);
-  }
+    // Convert directly from the packed data. No intermediate planar buffer is used.
+    convOK = convertYUVPackedToRGB(sourceBuffer, outputImage.bits(), curFrameSize, yuvFormat);
 
   assert(convOK);
 
@@ -3189,90 +3333,26 @@ void videoHandlerYUV::getPixelValue(const QPoint &pixelPos, unsigned int &Y, uns
 {
   const yuvPixelFormat format = srcPixelFormat;
 
-  const int w = frameSize.width();
-  const int h = frameSize.height();
-
-  if (format.planar)
-  {
-    // The luma component has full resolution. The size of each chroma components depends on the subsampling.
-    const int componentSizeLuma = (w * h);
-    const int componentSizeChroma = (w / format.getSubsamplingHor()) * (h / format.getSubsamplingVer());
-
-    // How many bytes are in each component?
-    const int nrBytesLumaPlane = (format.bitsPerSample > 8) ? componentSizeLuma * 2 : componentSizeLuma;
-    const int nrBytesChromaPlane = (format.bitsPerSample > 8) ? componentSizeChroma * 2 : componentSizeChroma;
+  // Get the positions of the components within the raw data. This works for planar and packed formats.
+  Y = 0;
+  U = 0;
+  V = 0;
+  yuvComponentPointer compY, compU, compV;
+  if (!getYUVComponentPointers((const unsigned char*)currentFrameRawYUVData.data(), format, frameSize, compY, compU, compV))
+    return;
 
-    // Luma first
-    const unsigned char * restrict srcY = (unsigned char*)currentFrameRawYUVData.data();
-    const unsigned int offsetCoordinateY  = w * pixelPos.y() + pixelPos.x();
-    Y = getValueFromSource(srcY, offsetCoordinateY,  format.bitsPerSample, format.bigEndian);
+  const int w = frameSize.width();
 
-    U = 0;
-    V = 0;
-    if (format.subsampling != YUV_400)
-    {
-      // Now Chroma
-      const bool uFirst = (format.planeOrder == Order_YUV || format.planeOrder == Order_YUVA);
-      const bool hasAlpha = (format.planeOrder == Order_YUVA || format.planeOrder == Order_YVUA);
-      if (format.uvInterleaved)
-      {
-        // U, V (and alpha) are interleaved
-        const unsigned char * restrict srcUVA = srcY + nrBytesLumaPlane;
-        const unsigned int mult = hasAlpha ? 3 : 2;
-        const unsigned int offsetCoordinateUV = ((w / format.getSubsamplingHor() * (pixelPos.y() / format.getSubsamplingVer())) + pixelPos.x() / format.getSubsamplingHor()) * mult;
+  // Luma first
+  const unsigned int offsetCoordinateY = w * pixelPos.y() + pixelPos.x();
+  Y = getValueFromSource(compY.src, offsetCoordinateY * compY.valSkip, format.bitsPerSample, format.bigEndian);
 
-        U = getValueFromSource(srcUVA, offsetCoordinateUV + (uFirst ? 0 : 1), format.bitsPerSample, format.bigEndian);
-        V = getValueFromSource(srcUVA, offsetCoordinateUV + (uFirst ? 1 : 0), format.bitsPerSample, format.bigEndian);
-      }
-      else
-      {
-        const unsigned char * restrict srcU = uFirst ? srcY + nrBytesLumaPlane : srcY + nrBytesLumaPlane + nrBytesChromaPlane;
-        const unsigned char * restrict srcV = uFirst ? srcY + nrBytesLumaPlane + nrBytesChromaPlane: srcY + nrBytesLumaPlane;
-
-        // Get the YUV data from the currentFrameRawYUVData
-        const unsigned int offsetCoordinateUV = (w / format.getSubsamplingHor() * (pixelPos.y() / format.getSubsamplingVer())) + pixelPos.x() / format.getSubsamplingHor();
-        
-        U = getValueFromSource(srcU, offsetCoordinateUV, format.bitsPerSample, format.bigEndian);
-        V = getValueFromSource(srcV, offsetCoordinateUV, format.bitsPerSample, format.bigEndian);
-      }
-    }
-  }
-  else
+  if (format.subsampling != YUV_400)
   {
-    const YUVPackingOrder packing = format.packingOrder;
-    if (format.subsampling == YUV_422)
-    {
-      // The data is arranged in blocks of 4 samples. How many of these are there?
-      // What are the offsets withing the 4 samples for the components?
-      const int oY = (packing == Packing_YUYV || packing == Packing_YVYU) ? 0 : 1;
-      const int oU = (packing == Packing_UYVY) ? 0 : (packing == Packing_YUYV) ? 1 : (packing == Packing_VYUY) ? 2 : 3;
-      const int oV = (packing == Packing_VYUY) ? 0 : (packing == Packing_YVYU) ? 1 : (packing == Packing_UYVY) ? 2 : 3;
-
-      // The offset of the pixel in bytes
-      const unsigned int offsetCoordinate4Block = (w * 2 * pixelPos.y() + (pixelPos.x() / 2 * 4)) * (format.bitsPerSample > 8 ? 2 : 1);
-      const unsigned char * restrict src = (unsigned char*)currentFrameRawYUVData.data() + offsetCoordinate4Block;
-
-      Y = getValueFromSource(src, (pixelPos.x() % 2 == 0) ? oY : oY + 2,  format.bitsPerSample, format.bigEndian);
-      U = getValueFromSource(src, oU, format.bitsPerSample, format.bigEndian);
-      V = getValueFromSource(src, oV, format.bitsPerSample, format.bigEndian);
-    }
-    else if (format.subsampling == YUV_444)
-    {
-      // The samples are packed in 4:4:4.
-      // What are the offsets withing the 3 or 4 bytes per sample?
-      const int oY = (packing == Packing_AYUV) ? 1 : 0;
-      const int oU = (packing == Packing_YUV || packing == Packing_YUVA) ? 1 : 2;
-      const int oV = (packing == Packing_YVU) ? 1 : (packing == Packing_AYUV) ? 3 : 2;
-
-      // How many bytes to the next sample?
-      const int offsetNext = (packing == Packing_YUV || packing == Packing_YVU ? 3 : 4) * (format.bitsPerSample > 8 ? 2 : 1);
-      const int offsetSrc = (w * pixelPos.y() + pixelPos.x()) * offsetNext;
-      const unsigned char * restrict src = (unsigned char*)currentFrameRawYUVData.data() + offsetSrc;
-
-      Y = getValueFromSource(src, oY, format.bitsPerSample, format.bigEndian);
-      U = getValueFromSource(src, oU, format.bitsPerSample, format.bigEndian);
-      V = getValueFromSource(src, oV, format.bitsPerSample, format.bigEndian);
-    }
+    // Now Chroma
+    const unsigned int offsetCoordinateUV = (w / format.getSubsamplingHor() * (pixelPos.y() / format.getSubsamplingVer())) + pixelPos.x() / format.getSubsamplingHor();
+    U = getValueFromSource(compU.src, offsetCoordinateUV * compU.valSkip, format.bitsPerSample, format.bigEndian);
+    V = getValueFromSource(compV.src, offsetCoordinateUV * compV.valSkip, format.bitsPerSample, format.bigEndian);
   }
 }
 
@@ -3613,9 +3693,205 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
     // The two items have different subsampling modes. Compare RGB values instead.
     return videoHandler::calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference);
 
+  // Load the right raw YUV data (if not already loaded).
+  // This will just update the raw YUV data. No conversion to image (RGB) is performed. This is either
+  // done on request if the frame is actually shown or has already been done by the caching process.
+  if (!loadRawYUVData(frameIdxItem0))
+    return QImage();  // Loading failed
+  if (!yuvItem2->loadRawYUVData(frameIdxItem1))
+    return QImage();  // Loading failed
+
+  // Both YUV buffers are up to date. Really calculate the difference.
+  DEBUG_YUV("videoHandlerYUV::calculateDifference frame %d", frameIdxItem0);
+  QImage outputImage = calculateDifferenceYUV(currentFrameRawYUVData, srcPixelFormat, frameSize, yuvItem2->currentFrameRawYUVData, yuvItem2->srcPixelFormat, yuvItem2->frameSize, differenceInfoList, amplificationFactor, markDifference, diffYUV, diffYUVFormat);
+
+  // we have a yuv differance available
+  is_YUV_diff = !outputImage.isNull();
+  return outputImage;
+}
+
+QImage videoHandlerYUV::calculateDifferenceForCaching(videoHandlerYUV *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference)
+{
+  // Get the raw data of both frames like for caching. The current frames of the items are not changed.
+  QByteArray rawData[2];
+  yuvPixelFormat format[2];
+  QSize size[2];
+  if (!loadRawYUVDataForCaching(frameIdxItem0, rawData[0], format[0], size[0]))
+    return QImage();
+  if (!item2->loadRawYUVDataForCaching(frameIdxItem1, rawData[1], format[1], size[1]))
+    return QImage();
+  if (format[0].subsampling != format[1].subsampling)
+    // The YUV difference can only be calculated for identical subsamplings
+    return QImage();
+
+  QByteArray diffYUVData;
+  yuvPixelFormat diffYUVDataFormat;
+  return calculateDifferenceYUV(rawData[0], format[0], size[0], rawData[1], format[1], size[1], differenceInfoList, amplificationFactor, markDifference, diffYUVData, diffYUVDataFormat);
+}
+
+bool videoHandlerYUV::loadRawYUVDataForCaching(int frameIndex, QByteArray &rawData, yuvPixelFormat &format, QSize &size)
+{
+  // Get the YUV format and the size here, so that the caching process does not crash if this changes.
+  format = srcPixelFormat;
+  size = frameSize;
+  if (!isFormatValid())
+    return false;
+
+  QMutexLocker lock(&requestDataMutex);
+  emit signalRequestRawData(frameIndex, true);
+  if (frameIndex != rawYUVData_frameIdx)
+    // Loading failed
+    return false;
+  rawData = rawYUVData;
+  return true;
+}
+
+videoScopes videoHandlerYUV::getScopes(int frameIndex)
+{
+  {
+    // Are the scopes of this frame already calculated (with the current format)?
+    QMutexLocker lock(&scopesCacheAccess);
+    auto it = scopesCache.constFind(frameIndex);
+    if (it != scopesCache.constEnd() && it->frameSize == frameSize && it->formatName == srcPixelFormat.getName())
+      return *it;
+  }
+
+  // If this is the current frame, the raw data is already loaded. Don't load (decode) it again.
+  QByteArray rawData;
+  yuvPixelFormat format = srcPixelFormat;
+  QSize size = frameSize;
+  {
+    QMutexLocker imageLock(&currentImageSetMutex);
+    if (currentFrameRawYUVData_frameIdx == frameIndex && isFormatValid())
+      rawData = currentFrameRawYUVData;
+  }
+  if (rawData.isEmpty() && !loadRawYUVDataForCaching(frameIndex, rawData, format, size))
+    return videoScopes();
+
+  videoScopes scopes = calculateScopes(rawData, format, size);
+  if (!scopes.isValid())
+    return scopes;
+  scopes.frameIdx = frameIndex;
+
+  QMutexLocker lock(&scopesCacheAccess);
+  if (scopesCache.count() >= VIDEOSCOPES_CACHE_SIZE && !scopesCache.contains(frameIndex))
+  {
+    // Remove the scopes of the frame that is the farthest away from the requested frame
+    int removeIdx = scopesCache.firstKey();
+    if (qAbs(scopesCache.lastKey() - frameIndex) > qAbs(removeIdx - frameIndex))
+      removeIdx = scopesCache.lastKey();
+    scopesCache.remove(removeIdx);
+  }
+  scopesCache.insert(frameIndex, scopes);
+  return scopes;
+}
+
+videoScopes videoHandlerYUV::calculateScopes(const QByteArray &rawData, const yuvPixelFormat &format, const QSize &size) const
+{
+  const int w = size.width();
+  const int h = size.height();
+  const int bps = format.bitsPerSample;
+  const bool bigEndian = format.bigEndian;
+  if (w <= 0 || h <= 0 || rawData.size() < format.bytesPerFrame(size))
+    return videoScopes();
+
+  yuvComponentPointer compY, compU, compV;
+  if (!getYUVComponentPointers((const unsigned char*)rawData.constData(), format, size, compY, compU, compV))
+    return videoScopes();
+
+  const bool chroma = (format.subsampling != YUV_400);
+  const int subH = format.getSubsamplingHor();
+  const int subV = format.getSubsamplingVer();
+  const int wC = chroma ? w / subH : 0;
+  const int hC = chroma ? h / subV : 0;
+  const int waveformWidth = std::min(w, VIDEOSCOPES_WAVEFORM_MAX_WIDTH);
+  // All bit depths are mapped to VIDEOSCOPES_BINS (256) bins. Values with less than 8 bits are shifted up.
+  const int shiftUpToBins = std::max(8 - bps, 0);
+  const int shiftDownToBins = std::max(bps - 8, 0);
+
+  // The column of the waveform for every luma column
+  QVector<int> waveformColumn(w);
+  for (int x = 0; x < w; x++)
+    waveformColumn[x] = x * waveformWidth / w * VIDEOSCOPES_BINS;
+
+  // Split the frame into bands of chroma rows (and the corresponding luma rows). Each band is accumulated
+  // into its own scopes which are added up afterwards. For small frames, one band is enough.
+  struct scopesBand
+  {
+    int rowStart, rowEnd;
+    videoScopes scopes;
+  };
+  const int nrRowsC = chroma ? hC : h;
+  const int rowsPerUnit = chroma ? subV : 1;
+  const int nrBands = (qint64(w) * h < 256 * 256) ? 1 : clip(QThread::idealThreadCount(), 1, nrRowsC);
+  QVector<scopesBand> bands(nrBands);
+  for (int i = 0; i < nrBands; i++)
+  {
+    bands[i].rowStart = nrRowsC * i / nrBands;
+    bands[i].rowEnd = nrRowsC * (i + 1) / nrBands;
+  }
+
+  auto accumulateBand = [&](scopesBand &band)
+  {
+    videoScopes &s = band.scopes;
+    s.reset(waveformWidth, chroma);
+    quint32 *histY = s.histogram[0].data();
+    quint32 *waveform = s.waveform.data();
+    const int yStart = band.rowStart * rowsPerUnit;
+    const int yEnd = (band.rowEnd == nrRowsC) ? h : band.rowEnd * rowsPerUnit;
+    for (int y = yStart; y < yEnd; y++)
+    {
+      const int lineOffset = y * w;
+      for (int x = 0; x < w; x++)
+      {
+        const int val = getValueFromSource(compY.src, (lineOffset + x) * compY.valSkip, bps, bigEndian);
+        const int bin = std::min((val << shiftUpToBins) >> shiftDownToBins, VIDEOSCOPES_BINS - 1);
+        histY[bin]++;
+        waveform[waveformColumn[x] + bin]++;
+      }
+    }
+
+    if (!chroma)
+      return;
+    quint32 *histU = s.histogram[1].data();
+    quint32 *histV = s.histogram[2].data();
+    quint32 *vectorscope = s.vectorscope.data();
+    for (int y = band.rowStart; y < band.rowEnd; y++)
+    {
+      const int lineOffset = y * wC;
+      for (int x = 0; x < wC; x++)
+      {
+        const int valU = getValueFromSource(compU.src, (lineOffset + x) * compU.valSkip, bps, bigEndian);
+        const int valV = getValueFromSource(compV.src, (lineOffset + x) * compV.valSkip, bps, bigEndian);
+        const int binU = std::min((valU << shiftUpToBins) >> shiftDownToBins, VIDEOSCOPES_BINS - 1);
+        const int binV = std::min((valV << shiftUpToBins) >> shiftDownToBins, VIDEOSCOPES_BINS - 1);
+        histU[binU]++;
+        histV[binV]++;
+        vectorscope[binU + binV * VIDEOSCOPES_BINS]++;
+      }
+    }
+  };
+
+  if (nrBands == 1)
+    accumulateBand(bands[0]);
+  else
+    QtConcurrent::blockingMap(bands, accumulateBand);
+
+  videoScopes scopes = bands[0].scopes;
+  for (int i = 1; i < nrBands; i++)
+    scopes.add(bands[i].scopes);
+  scopes.frameIdx = 0;
+  scopes.formatName = format.getName();
+  scopes.frameSize = size;
+  scopes.bitDepth = bps;
+  return scopes;
+}
+
+QImage videoHandlerYUV::calculateDifferenceYUV(const QByteArray &rawData0, const yuvPixelFormat &format0, const QSize &size0, const QByteArray &rawData1, const yuvPixelFormat &format1, const QSize &size1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QByteArray &diffYUVOut, yuvPixelFormat &diffYUVFormatOut) const
+{
   // Get/Set the bit depth of the input and output
   // If the bit depth if the two items is different, we will scale the item with the lower bit depth up.
-  const int bps_in[2] = {srcPixelFormat.bitsPerSample, yuvItem2->srcPixelFormat.bitsPerSample};
+  const int bps_in[2] = {format0.bitsPerSample, format1.bitsPerSample};
   const int bps_out = std::max(bps_in[0], bps_in[1]);
   // Which of the two input values has to be scaled up? Only one of these (or neither) can be set.
   const bool bitDepthScaling[2] = {bps_in[0] != bps_out, bps_in[1] != bps_out};
@@ -3631,60 +3907,42 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
   // Do we amplify the values?
   const bool amplification = (amplificationFactor != 1 && !markDifference);
 
-  // Load the right raw YUV data (if not already loaded).
-  // This will just update the raw YUV data. No conversion to image (RGB) is performed. This is either
-  // done on request if the frame is actually shown or has already been done by the caching process.
-  if (!loadRawYUVData(frameIdxItem0))
-    return QImage();  // Loading failed
-  if (!yuvItem2->loadRawYUVData(frameIdxItem1))
-    return QImage();  // Loading failed
-
-  // Both YUV buffers are up to date. Really calculate the difference.
-  DEBUG_YUV("videoHandlerYUV::calculateDifference frame %d", frame);
-
   // The items can be of different size (we then calculate the difference of the top left aligned part)
-  const int w_in[2] = {frameSize.width(), yuvItem2->frameSize.width()};
-  const int h_in[2] = {frameSize.height(), yuvItem2->frameSize.height()};
+  const int w_in[2] = {size0.width(), size1.width()};
+  const int h_in[2] = {size0.height(), size1.height()};
   const int w_out = qMin(w_in[0], w_in[1]);
   const int h_out = qMin(h_in[0], h_in[1]);
   // Append a warning if the frame sizes are different
-  if (frameSize != yuvItem2->frameSize)
+  if (size0 != size1)
     differenceInfoList.append(infoItem("Warning", "The size of the two items differs.", "The size of the two input items is different. The difference of the top left aligned part that overlaps will be calculated."));
 
-  yuvPixelFormat tmpDiffYUVFormat(srcPixelFormat.subsampling, bps_out, Order_YUV, true);
-  diffYUVFormat = tmpDiffYUVFormat;
+  yuvPixelFormat tmpDiffYUVFormat(format0.subsampling, bps_out, Order_YUV, true);
+  diffYUVFormatOut = tmpDiffYUVFormat;
 
   if (!canConvertToRGB(tmpDiffYUVFormat, QSize(w_out, h_out)))
     return QImage();
 
 
   // Get subsampling modes (they are identical for both inputs and the output)
-  const int subH = srcPixelFormat.getSubsamplingHor();
-  const int subV = srcPixelFormat.getSubsamplingVer();
+  const int subH = format0.getSubsamplingHor();
+  const int subV = format0.getSubsamplingVer();
 
   // Get the endianess of the inputs
-  const bool bigEndian[2] = {srcPixelFormat.bigEndian, yuvItem2->srcPixelFormat.bigEndian};
-
-  // Get pointers to the inputs
-  const int componentSizeLuma_In[2] = {w_in[0]*h_in[0], w_in[1]*h_in[1]};
-  const int componentSizeChroma_In[2] = {(w_in[0]/subH)*(h_in[0]/subV), (w_in[1]/subH)*(h_in[1]/subV)};
-  const int nrBytesLumaPlane_In[2] = {bps_in[0] > 8 ? 2 * componentSizeLuma_In[0] : componentSizeLuma_In[0], bps_in[1] > 8 ? 2 * componentSizeLuma_In[1] : componentSizeLuma_In[1]};
-  const int nrBytesChromaPlane_In[2] = {bps_in[0] > 8 ? 2 * componentSizeChroma_In[0] : componentSizeChroma_In[0], bps_in[1] > 8 ? 2 * componentSizeChroma_In[1] : componentSizeChroma_In[1]};
-  // Current item
-  const unsigned char * restrict srcY1 = (unsigned char*)currentFrameRawYUVData.data();
-  const unsigned char * restrict srcU1 = (srcPixelFormat.planeOrder == Order_YUV || srcPixelFormat.planeOrder == Order_YUVA) ? srcY1 + nrBytesLumaPlane_In[0] : srcY1 + nrBytesLumaPlane_In[0] + nrBytesChromaPlane_In[0];
-  const unsigned char * restrict srcV1 = (srcPixelFormat.planeOrder == Order_YUV || srcPixelFormat.planeOrder == Order_YUVA) ? srcY1 + nrBytesLumaPlane_In[0] + nrBytesChromaPlane_In[0]: srcY1 + nrBytesLumaPlane_In[0];
-  // The other item
-  const unsigned char * restrict srcY2 = (unsigned char*)yuvItem2->currentFrameRawYUVData.data();
-  const unsigned char * restrict srcU2 = (yuvItem2->srcPixelFormat.planeOrder == Order_YUV || yuvItem2->srcPixelFormat.planeOrder == Order_YUVA) ? srcY2 + nrBytesLumaPlane_In[1] : srcY2 + nrBytesLumaPlane_In[1] + nrBytesChromaPlane_In[1];
-  const unsigned char * restrict srcV2 = (yuvItem2->srcPixelFormat.planeOrder == Order_YUV || yuvItem2->srcPixelFormat.planeOrder == Order_YUVA) ? srcY2 + nrBytesLumaPlane_In[1] + nrBytesChromaPlane_In[1]: srcY2 + nrBytesLumaPlane_In[1];
+  const bool bigEndian[2] = {format0.bigEndian, format1.bigEndian};
+
+  // Get pointers to the inputs. The inputs can be planar or packed. Packed data is read directly (no conversion to planar).
+  yuvComponentPointer compY[2], compU[2], compV[2];
+  if (!getYUVComponentPointers((const unsigned char*)rawData0.data(), format0, size0, compY[0], compU[0], compV[0]))
+    return QImage();
+  if (!getYUVComponentPointers((const unsigned char*)rawData1.data(), format1, size1, compY[1], compU[1], compV[1]))
+    return QImage();
 
   // Get pointers to the output
   const int componentSizeLuma_out = w_out*h_out * (bps_out > 8 ? 2 : 1); // Size in bytes
   const int componentSizeChroma_out = (w_out/subH) * (h_out/subV) * (bps_out > 8 ? 2 : 1);
   // Resize the output buffer to the right size
-  diffYUV.resize(componentSizeLuma_out + 2*componentSizeChroma_out);
-  unsigned char * restrict dstY = (unsigned char*)diffYUV.data();
+  diffYUVOut.resize(componentSizeLuma_out + 2*componentSizeChroma_out);
+  unsigned char * restrict dstY = (unsigned char*)diffYUVOut.data();
   unsigned char * restrict dstU = dstY + componentSizeLuma_out;
   unsigned char * restrict dstV = dstU + componentSizeChroma_out;
 
@@ -3693,13 +3951,12 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
   qint64 mseAdd[3] = {0, 0, 0};
 
   // Calculate Luma sample difference
-  const int stride_in[2] = {bps_in[0] > 8 ? w_in[0]*2 : w_in[0], bps_in[1] > 8 ? w_in[1]*2 : w_in[1]};  // How many bytes to the next y line?
   for (int y = 0; y < h_out; y++)
   {
     for (int x = 0; x < w_out; x++)
     {
-      int val1 = getValueFromSource(srcY1, x, bps_in[0], bigEndian[0]);
-      int val2 = getValueFromSource(srcY2, x, bps_in[1], bigEndian[1]);
+      int val1 = getValueFromSource(compY[0].src, (y*w_in[0]+x)*compY[0].valSkip, bps_in[0], bigEndian[0]);
+      int val2 = getValueFromSource(compY[1].src, (y*w_in[1]+x)*compY[1].valSkip, bps_in[1], bigEndian[1]);
 
       // Scale (if necessary)
       if (bitDepthScaling[0])
@@ -3717,22 +3974,19 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
       setValueInBuffer(dstY, diff, 0, bps_out, true);
       dstY += (bps_out > 8) ? 2 : 1;
     }
-
-    // Goto the next y line
-    srcY1 += stride_in[0];
-    srcY2 += stride_in[1];
   }
 
   // Next U/V
-  const int strideC_in[2] = {w_in[0] / subH * (bps_in[0] > 8 ? 2 : 1), w_in[1] / subH * (bps_in[1] > 8 ? 2 : 1)};  // How many bytes to the next U/V y line
+  const int wC_in[2] = {w_in[0] / subH, w_in[1] / subH};  // How many chroma samples to the next U/V y line
   for (int y = 0; y < h_out / subV; y++)
   {
     for (int x = 0; x < w_out / subH; x++)
     {
-      int valU1 = getValueFromSource(srcU1, x, bps_in[0], bigEndian[0]);
-      int valU2 = getValueFromSource(srcU2, x, bps_in[1], bigEndian[1]);
-      int valV1 = getValueFromSource(srcV1, x, bps_in[0], bigEndian[0]);
-      int valV2 = getValueFromSource(srcV2, x, bps_in[1], bigEndian[1]);
+      const int idxC[2] = {y*wC_in[0]+x, y*wC_in[1]+x};
+      int valU1 = getValueFromSource(compU[0].src, idxC[0]*compU[0].valSkip, bps_in[0], bigEndian[0]);
+      int valU2 = getValueFromSource(compU[1].src, idxC[1]*compU[1].valSkip, bps_in[1], bigEndian[1]);
+      int valV1 = getValueFromSource(compV[0].src, idxC[0]*compV[0].valSkip, bps_in[0], bigEndian[0]);
+      int valV2 = getValueFromSource(compV[1].src, idxC[1]*compV[1].valSkip, bps_in[1], bigEndian[1]);
 
       // Scale (if necessary)
       if (bitDepthScaling[0])
@@ -3764,12 +4018,6 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
       dstU += (bps_out > 8) ? 2 : 1;
       dstV += (bps_out > 8) ? 2 : 1;
     }
-
-    // Goto the next y line
-    srcU1 += strideC_in[0];
-    srcV1 += strideC_in[0];
-    srcU2 += strideC_in[1];
-    srcV2 += strideC_in[1];
   }
 
   // Next we convert the difference YUV image to RGB, either using the normal conversion function or
@@ -3795,14 +4043,14 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
 
   if (markDifference)
     // We don't want to see the actual difference but just where differences are.
-    markDifferencesYUVPlanarToRGB(diffYUV, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
+    markDifferencesYUVPlanarToRGB(diffYUVOut, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
   else
     // Get the format of the tmpDiffYUV buffer and convert it to RGB
-    convertYUVPlanarToRGB(diffYUV, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
+    convertYUVPlanarToRGB(diffYUVOut, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
 
   // Append the conversion information that will be returned
   QStringList yuvSubsamplings = QStringList() << "4:4:4" << "4:2:2" << "4:2:0" << "4:4:0" << "4:1:0" << "4:1:1" << "4:0:0";
-  differenceInfoList.append(infoItem("Difference Type",QString("YUV %1").arg(yuvSubsamplings[srcPixelFormat.subsampling])));
+  differenceInfoList.append(infoItem("Difference Type",QString("YUV %1").arg(yuvSubsamplings[format0.subsampling])));
   double mse[4];
   mse[0] = double(mseAdd[0]) / (w_out * h_out);
   mse[1] = double(mseAdd[1]) / (w_out * h_out);
@@ -3822,8 +4070,6 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
       return outputImage.convertToFormat(f);
   }  
 
-  // we have a yuv differance available
-  is_YUV_diff = true;
   return outputImage;
 }
 
@@ -3893,6 +4139,10 @@ void videoHandlerYUV::invalidateAllBuffers()
 {
   currentFrameRawYUVData_frameIdx = -1;
   rawYUVData_frameIdx = -1;
+  {
+    QMutexLocker lock(&scopesCacheAccess);
+    scopesCache.clear();
+  }
   videoHandler::invalidateAllBuffers();
 }
 
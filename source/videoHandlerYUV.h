@@ -34,6 +34,7 @@
 #define VIDEOHANDLERYUV_H
 
 #include "videoHandler.h"
+#include "videoScopes.h"
 #include "ui_videoHandlerYUV.h"
 #include "ui_videoHandlerYUV_CustomFormatDialog.h"
 
@@ -210,6 +211,10 @@ public:
   // we will use the playlistItemVideo::calculateDifference function to calculate the difference
   // using the RGB values.
   virtual QImage calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference) Q_DECL_OVERRIDE;
+  // Calculate the YUV difference to item2 for caching. The raw data of both frames is requested like for caching so
+  // that no internal buffers of either handler are modified. Returns a null image if the YUV difference cannot be
+  // calculated (e.g. the subsamplings differ).
+  QImage calculateDifferenceForCaching(videoHandlerYUV *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference);
 
   // Get the number of bytes for one YUV frame with the current format
   virtual qint64 getBytesPerFrame() const { return srcPixelFormat.bytesPerFrame(frameSize); }
@@ -230,12 +235,18 @@ public:
 
   // Get the name of the currently selected YUV pixel format
   virtual QString getRawYUVPixelFormatName() const { return srcPixelFormat.getName(); }
+  YUV_Internals::yuvPixelFormat getYUVPixelFormat() const { return srcPixelFormat; }
   // Set the current YUV format and update the control. Only emit a signalHandlerChanged signal
   // if emitSignal is true.
   virtual void setYUVPixelFormatByName(const QString &name, bool emitSignal=false) { setYUVPixelFormat(YUV_Internals::yuvPixelFormat(name), emitSignal); }
   virtual void setYUVPixelFormat(const YUV_Internals::yuvPixelFormat &fmt, bool emitSignal=false);
   virtual void setYUVColorConversion(YUV_Internals::ColorConversion conversion);
 
+  // Get the scopes (histograms, waveform and vectorscope) of the given frame. The scopes are calculated from the raw
+  // YUV data and the last VIDEOSCOPES_CACHE_SIZE results are kept. This is thread save and can be called from a
+  // background thread. An invalid videoScopes is returned if the raw data could not be loaded.
+  videoScopes getScopes(int frameIndex);
+
   // When loading a videoHandlerYUV from playlist file, this can be used to set all the parameters at once
   void loadValues(const QSize &frameSize, const QString &sourcePixelFormat);
 
@@ -333,6 +344,14 @@ private:
   // Return false is loading failed.
   bool loadRawYUVData(int frameIndex);
 
+  // Request the raw YUV data of the given frame like for caching (currentFrameRawYUVData is not modified).
+  // The format and size that the data was loaded with are returned as well. This is thread save.
+  bool loadRawYUVDataForCaching(int frameIndex, QByteArray &rawData, YUV_Internals::yuvPixelFormat &format, QSize &size);
+
+  // Calculate the difference of the two given raw YUV frames. The raw difference (planar) and its format are
+  // returned in diffYUVOut/diffYUVFormatOut. No members are modified.
+  QImage calculateDifferenceYUV(const QByteArray &rawData0, const YUV_Internals::yuvPixelFormat &format0, const QSize &size0, const QByteArray &rawData1, const YUV_Internals::yuvPixelFormat &format1, const QSize &size1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QByteArray &diffYUVOut, YUV_Internals::yuvPixelFormat &diffYUVFormatOut) const;
+
   // Convert from YUV (which ever format is selected) to image (RGB-888)
   void convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const YUV_Internals::yuvPixelFormat &yuvFormat, const QSize &curFrameSize);
 
@@ -347,7 +366,8 @@ private:
   bool convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const YUV_Internals::yuvPixelFormat format);
 #endif
 
-  bool convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &frameSize, YUV_Internals::yuvPixelFormat &sourceBufferFormat);
+  // Convert packed YUV data directly to RGB (without an intermediate planar buffer)
+  bool convertYUVPackedToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
   bool convertYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
   bool markDifferencesYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
 
@@ -358,6 +378,12 @@ private:
                            quint8 *rgb, quint32 srgb);
 #endif
 
+  // Calculate the scopes of the given raw YUV frame. The frame is split into bands of rows that are accumulated in parallel.
+  videoScopes calculateScopes(const QByteArray &rawData, const YUV_Internals::yuvPixelFormat &format, const QSize &size) const;
+  // The recently calculated scopes (by frame index)
+  QMap<int, videoScopes> scopesCache;
+  QMutex scopesCacheAccess;
+
   SafeUi<Ui::videoHandlerYUV> ui;
 
   bool is_YUV_diff;
@@ -0,0 +1,77 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "videoScopes.h"
+
+#include <algorithm>
+
+void videoScopes::reset(int newWaveformWidth, bool withChroma)
+{
+  chromaPresent = withChroma;
+  waveformWidth = newWaveformWidth;
+  histogram[0].fill(0, VIDEOSCOPES_BINS);
+  histogram[1].fill(0, withChroma ? VIDEOSCOPES_BINS : 0);
+  histogram[2].fill(0, withChroma ? VIDEOSCOPES_BINS : 0);
+  waveform.fill(0, waveformWidth * VIDEOSCOPES_BINS);
+  vectorscope.fill(0, withChroma ? VIDEOSCOPES_BINS * VIDEOSCOPES_BINS : 0);
+}
+
+void videoScopes::add(const videoScopes &other)
+{
+  for (int c = 0; c < 3; c++)
+    for (int i = 0; i < histogram[c].count() && i < other.histogram[c].count(); i++)
+      histogram[c][i] += other.histogram[c][i];
+  for (int i = 0; i < waveform.count() && i < other.waveform.count(); i++)
+    waveform[i] += other.waveform[i];
+  for (int i = 0; i < vectorscope.count() && i < other.vectorscope.count(); i++)
+    vectorscope[i] += other.vectorscope[i];
+}
+
+quint32 videoScopes::getHistogramMax() const
+{
+  quint32 maxVal = 0;
+  for (int c = 0; c < 3; c++)
+    if (!histogram[c].isEmpty())
+      maxVal = std::max(maxVal, *std::max_element(histogram[c].constBegin(), histogram[c].constEnd()));
+  return maxVal;
+}
+
+quint32 videoScopes::getWaveformMax() const
+{
+  return waveform.isEmpty() ? 0 : *std::max_element(waveform.constBegin(), waveform.constEnd());
+}
+
+quint32 videoScopes::getVectorscopeMax() const
+{
+  return vectorscope.isEmpty() ? 0 : *std::max_element(vectorscope.constBegin(), vectorscope.constEnd());
+}
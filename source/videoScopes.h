@@ -0,0 +1,86 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VIDEOSCOPES_H
+#define VIDEOSCOPES_H
+
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+// The number of bins of the histograms, the number of levels of the waveform and the size of the vectorscope.
+// Values with a higher bit depth are scaled to this range.
+#define VIDEOSCOPES_BINS 256
+// The maximum number of columns of the waveform. Wider frames are mapped onto this many columns.
+#define VIDEOSCOPES_WAVEFORM_MAX_WIDTH 256
+// The number of frames for which the scopes are kept in the videoHandlerYUV (about 400 kB per frame)
+#define VIDEOSCOPES_CACHE_SIZE 32
+
+/* The scopes of one raw YUV frame: The histograms of the Y, U and V component, the luma waveform (for every
+ * column of the frame the distribution of the luma levels) and the vectorscope (the distribution of the U/V pairs).
+ * The scopes are calculated directly from the raw YUV data by the videoHandlerYUV (see videoHandlerYUV::getScopes).
+*/
+class videoScopes
+{
+public:
+  videoScopes() : frameIdx(-1), bitDepth(0), chromaPresent(false), waveformWidth(0) {}
+
+  // Allocate (and reset) the accumulation buffers
+  void reset(int newWaveformWidth, bool withChroma);
+  // Add the accumulated values of another scope with the same dimensions. This is used to merge the
+  // results of the parts of a frame that were accumulated in parallel.
+  void add(const videoScopes &other);
+
+  bool isValid() const { return frameIdx >= 0; }
+  // Get the maximum value of the histograms/waveform/vectorscope (used for scaling the plots)
+  quint32 getHistogramMax() const;
+  quint32 getWaveformMax() const;
+  quint32 getVectorscopeMax() const;
+
+  // The frame that the scopes were calculated for and the format and size of the raw data
+  int frameIdx;
+  QString formatName;
+  QSize frameSize;
+  int bitDepth;
+  bool chromaPresent;
+
+  // The histograms of the Y, U and V component (VIDEOSCOPES_BINS values each). U and V are empty for 4:0:0.
+  QVector<quint32> histogram[3];
+  // The luma waveform. waveformWidth columns of VIDEOSCOPES_BINS levels each.
+  int waveformWidth;
+  QVector<quint32> waveform;
+  // The vectorscope. VIDEOSCOPES_BINS x VIDEOSCOPES_BINS values (index U + V * VIDEOSCOPES_BINS).
+  QVector<quint32> vectorscope;
+};
+
+#endif // VIDEOSCOPES_H
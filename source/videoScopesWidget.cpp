@@ -0,0 +1,271 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "videoScopesWidget.h"
+
+#include <cmath>
+#include <QPainter>
+#include <QPainterPath>
+#include <QtConcurrent>
+#include <QVBoxLayout>
+#include "playbackController.h"
+#include "playlistItem.h"
+#include "videoHandlerYUV.h"
+
+// The margin around the plot in pixels
+#define VIDEOSCOPES_PLOT_MARGIN 4
+
+// Map the number of samples in a bin of the waveform/vectorscope to a brightness. A logarithmic mapping is used so
+// that bins with only a few samples are still visible.
+inline int scopeBrightness(quint32 val, double logMax)
+{
+  if (val == 0 || logMax <= 0)
+    return 0;
+  return clip(int(64 + 191 * std::log(double(val)) / logMax), 0, 255);
+}
+
+videoScopesWidget::videoScopesWidget(QWidget *parent) : QWidget(parent)
+{
+  updatePending = false;
+
+  modeComboBox.addItems(QStringList() << "Histogram" << "Waveform" << "Vectorscope");
+  QVBoxLayout *topLayout = new QVBoxLayout(this);
+  topLayout->setContentsMargins(VIDEOSCOPES_PLOT_MARGIN, VIDEOSCOPES_PLOT_MARGIN, VIDEOSCOPES_PLOT_MARGIN, VIDEOSCOPES_PLOT_MARGIN);
+  topLayout->addWidget(&modeComboBox);
+  topLayout->addStretch();
+
+  connect(&modeComboBox, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, static_cast<void(QWidget::*)()>(&QWidget::update));
+  connect(&calculationWatcher, &QFutureWatcher<videoScopes>::finished, this, &videoScopesWidget::scopesCalculationFinished);
+}
+
+videoScopesWidget::~videoScopesWidget()
+{
+  calculationWatcher.waitForFinished();
+}
+
+void videoScopesWidget::currentSelectedItemsChanged(playlistItem *item1, playlistItem *item2)
+{
+  Q_UNUSED(item2);
+  if (currentItem == item1)
+    return;
+
+  currentItem = item1;
+  scopes = videoScopes();
+  update();
+  updateScopes();
+}
+
+void videoScopesWidget::itemAboutToBeDeleted(playlistItem *item)
+{
+  if (item != currentItem)
+    return;
+
+  // The running calculation uses the video handler of the item
+  calculationWatcher.waitForFinished();
+  currentItem.clear();
+  scopes = videoScopes();
+  update();
+}
+
+void videoScopesWidget::showEvent(QShowEvent *event)
+{
+  // The scopes are not updated while the widget is hidden
+  QWidget::showEvent(event);
+  updateScopes();
+}
+
+void videoScopesWidget::updateScopes()
+{
+  if (!isVisible())
+    return;
+  if (calculationWatcher.isRunning())
+  {
+    // Only calculate the most recent frame once the current calculation is done
+    updatePending = true;
+    return;
+  }
+
+  videoHandlerYUV *yuvVideo = currentItem ? dynamic_cast<videoHandlerYUV*>(currentItem->getFrameHandler()) : nullptr;
+  if (yuvVideo == nullptr)
+  {
+    if (scopes.isValid())
+    {
+      scopes = videoScopes();
+      update();
+    }
+    return;
+  }
+
+  int frameIdx = 0;
+  if (currentItem->isIndexedByFrame() && playback)
+    frameIdx = currentItem->getFrameIdxInternal(std::max(playback->getCurrentFrame(), 0));
+  if (scopes.isValid() && scopes.frameIdx == frameIdx && scopes.formatName == yuvVideo->getRawYUVPixelFormatName() && scopes.frameSize == yuvVideo->getFrameSize())
+    // Already up to date
+    return;
+
+  calculationWatcher.setFuture(QtConcurrent::run(yuvVideo, &videoHandlerYUV::getScopes, frameIdx));
+}
+
+void videoScopesWidget::scopesCalculationFinished()
+{
+  scopes = calculationWatcher.result();
+  update();
+
+  if (updatePending)
+  {
+    updatePending = false;
+    updateScopes();
+  }
+}
+
+void videoScopesWidget::paintEvent(QPaintEvent *event)
+{
+  Q_UNUSED(event);
+  QPainter painter(this);
+
+  const int top = modeComboBox.geometry().bottom() + VIDEOSCOPES_PLOT_MARGIN;
+  const QRect plotRect = QRect(VIDEOSCOPES_PLOT_MARGIN, top, width() - 2 * VIDEOSCOPES_PLOT_MARGIN, height() - top - VIDEOSCOPES_PLOT_MARGIN);
+  if (plotRect.width() <= 0 || plotRect.height() <= 0)
+    return;
+  painter.fillRect(plotRect, Qt::black);
+
+  if (!scopes.isValid())
+  {
+    painter.setPen(Qt::white);
+    painter.drawText(plotRect, Qt::AlignCenter | Qt::TextWordWrap, "Scopes are available for YUV items only");
+    return;
+  }
+
+  if (modeComboBox.currentIndex() == 0)
+    drawHistogram(painter, plotRect);
+  else if (modeComboBox.currentIndex() == 1)
+    drawWaveform(painter, plotRect);
+  else
+    drawVectorscope(painter, plotRect);
+}
+
+void videoScopesWidget::drawHistogram(QPainter &painter, const QRect &plotRect) const
+{
+  const quint32 maxVal = scopes.getHistogramMax();
+  if (maxVal == 0)
+    return;
+
+  // Draw the U and V histograms as lines over the filled luma histogram
+  const QColor colors[3] = {QColor(200, 200, 200), QColor(80, 120, 255), QColor(255, 80, 80)};
+  painter.setRenderHint(QPainter::Antialiasing);
+  for (int c = 0; c < 3; c++)
+  {
+    if (scopes.histogram[c].isEmpty())
+      continue;
+
+    QPainterPath path;
+    path.moveTo(plotRect.left(), plotRect.bottom());
+    for (int i = 0; i < VIDEOSCOPES_BINS; i++)
+    {
+      const double x = plotRect.left() + (i + 0.5) * plotRect.width() / VIDEOSCOPES_BINS;
+      const double y = plotRect.bottom() - double(scopes.histogram[c][i]) * plotRect.height() / maxVal;
+      path.lineTo(x, y);
+    }
+    path.lineTo(plotRect.right(), plotRect.bottom());
+
+    if (c == 0)
+      painter.fillPath(path, QColor(120, 120, 120));
+    painter.setPen(colors[c]);
+    painter.drawPath(path);
+  }
+  painter.setRenderHint(QPainter::Antialiasing, false);
+
+  painter.setPen(Qt::white);
+  painter.drawText(plotRect.adjusted(2, 2, -2, -2), Qt::AlignTop | Qt::AlignLeft, QString("Frame %1, %2 bit").arg(scopes.frameIdx).arg(scopes.bitDepth));
+}
+
+void videoScopesWidget::drawWaveform(QPainter &painter, const QRect &plotRect) const
+{
+  const quint32 maxVal = scopes.getWaveformMax();
+  if (maxVal == 0 || scopes.waveformWidth == 0)
+    return;
+
+  // The highest level is drawn at the top
+  const double logMax = std::log(double(maxVal));
+  QImage waveformImage(scopes.waveformWidth, VIDEOSCOPES_BINS, QImage::Format_RGB32);
+  for (int level = 0; level < VIDEOSCOPES_BINS; level++)
+  {
+    QRgb *line = (QRgb*)waveformImage.scanLine(VIDEOSCOPES_BINS - 1 - level);
+    for (int x = 0; x < scopes.waveformWidth; x++)
+    {
+      const int b = scopeBrightness(scopes.waveform[x * VIDEOSCOPES_BINS + level], logMax);
+      line[x] = qRgb(b / 2, b, b / 2);
+    }
+  }
+  painter.drawImage(plotRect, waveformImage);
+
+  // Mark the limited range (16 and 235 in 8 bit)
+  painter.setPen(QPen(Qt::darkGray, 1, Qt::DashLine));
+  for (int level : {16, 235})
+  {
+    const int y = plotRect.bottom() - (level * plotRect.height() / VIDEOSCOPES_BINS);
+    painter.drawLine(plotRect.left(), y, plotRect.right(), y);
+  }
+}
+
+void videoScopesWidget::drawVectorscope(QPainter &painter, const QRect &plotRect) const
+{
+  const quint32 maxVal = scopes.getVectorscopeMax();
+  if (maxVal == 0)
+  {
+    painter.setPen(Qt::white);
+    painter.drawText(plotRect, Qt::AlignCenter, "No chroma components");
+    return;
+  }
+
+  // U is drawn to the right and V to the top. The scope is kept square.
+  const int size = std::min(plotRect.width(), plotRect.height());
+  const QRect scopeRect(plotRect.left() + (plotRect.width() - size) / 2, plotRect.top() + (plotRect.height() - size) / 2, size, size);
+  const double logMax = std::log(double(maxVal));
+  QImage vectorscopeImage(VIDEOSCOPES_BINS, VIDEOSCOPES_BINS, QImage::Format_RGB32);
+  for (int v = 0; v < VIDEOSCOPES_BINS; v++)
+  {
+    QRgb *line = (QRgb*)vectorscopeImage.scanLine(VIDEOSCOPES_BINS - 1 - v);
+    for (int u = 0; u < VIDEOSCOPES_BINS; u++)
+    {
+      const int b = scopeBrightness(scopes.vectorscope[u + v * VIDEOSCOPES_BINS], logMax);
+      line[u] = qRgb(b / 2, b, b / 2);
+    }
+  }
+  painter.drawImage(scopeRect, vectorscopeImage);
+
+  painter.setPen(QPen(Qt::darkGray, 1, Qt::DashLine));
+  painter.drawLine(scopeRect.center().x(), scopeRect.top(), scopeRect.center().x(), scopeRect.bottom());
+  painter.drawLine(scopeRect.left(), scopeRect.center().y(), scopeRect.right(), scopeRect.center().y());
+  painter.drawEllipse(scopeRect);
+}
@@ -0,0 +1,98 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VIDEOSCOPESWIDGET_H
+#define VIDEOSCOPESWIDGET_H
+
+#include <QComboBox>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QWidget>
+#include "videoScopes.h"
+
+class PlaybackController;
+class playlistItem;
+
+/* This widget shows the histogram, the waveform or the vectorscope of the frame that is currently shown for
+ * the selected item. It is only available for items with a YUV video (videoHandlerYUV). The scopes are calculated
+ * in the background so that playback is not slowed down. If the frame changes while the scopes are calculated,
+ * only the most recent frame is calculated next (frames in between are skipped).
+*/
+class videoScopesWidget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  videoScopesWidget(QWidget *parent = 0);
+  ~videoScopesWidget();
+
+  void setPlaybackController(PlaybackController *p) { playback = p; }
+
+  virtual QSize sizeHint() const Q_DECL_OVERRIDE { return QSize(300, 300); }
+
+public slots:
+  // The selected item changed (only the first item is used)
+  void currentSelectedItemsChanged(playlistItem *item1, playlistItem *item2);
+  // The frame shown in the view changed (by the user or by playback)
+  void currentFrameChanged() { updateScopes(); }
+  // The properties of the selected item changed (e.g. the YUV format). The scopes have to be recalculated.
+  void selectedItemChanged() { updateScopes(); }
+  // The item is about to be deleted. Wait for a running calculation of the item to finish.
+  void itemAboutToBeDeleted(playlistItem *item);
+
+protected:
+  virtual void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
+  virtual void showEvent(QShowEvent *event) Q_DECL_OVERRIDE;
+
+private slots:
+  void scopesCalculationFinished();
+
+private:
+  // Start the calculation of the scopes of the current frame of the selected item (if the widget is visible)
+  void updateScopes();
+
+  void drawHistogram(QPainter &painter, const QRect &plotRect) const;
+  void drawWaveform(QPainter &painter, const QRect &plotRect) const;
+  void drawVectorscope(QPainter &painter, const QRect &plotRect) const;
+
+  QComboBox modeComboBox;
+  QPointer<playlistItem> currentItem;
+  QPointer<PlaybackController> playback;
+
+  QFutureWatcher<videoScopes> calculationWatcher;
+  // Was a new update requested while the calculation was running?
+  bool updatePending;
+  videoScopes scopes;
+};
+
+#endif // VIDEOSCOPESWIDGET_H
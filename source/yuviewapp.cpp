@@ -34,11 +34,16 @@
 
 #include "mainwindow.h"
 #include "singleInstanceHandler.h"
+#include "startupTrace.h"
 #include "typedef.h"
 #include <QSettings>
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
+  // Start the startup timer
+  startupTrace::instance();
+
 #if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
   QApplication::setAttribute(Qt::AA_EnableHighDpiScaling); // DPI support
   QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps); // DPI support
@@ -64,6 +69,11 @@ int main(int argc, char *argv[])
 
   QStringList args = app.arguments();
 
+  // With the -startupTrace parameter, the time that the individual phases of the startup take is printed.
+  if (args.removeAll("-startupTrace") > 0)
+    startupTrace::instance().enable();
+  startupTrace::instance().addPhase("Create the application");
+
   QScopedPointer<singleInstanceHandler> instance;
   if (WIN_LINUX_SINGLE_INSTANCE && (is_Q_OS_WIN || is_Q_OS_LINUX))
   {
@@ -77,6 +87,7 @@ int main(int argc, char *argv[])
     // This is the first instance of the program
     instance->listen(appName);
   }
+  startupTrace::instance().addPhase("Single instance check");
   
   // For Qt 5.8 there is a Bug in Qt that crashes the application if a certain type of proxy server is used.
   // With the -noUpdate parameter, we can disable automatic updates so that YUView can be used normally.
@@ -98,24 +109,34 @@ int main(int argc, char *argv[])
 
   MainWindow w(alternativeUpdateSource);
   app.installEventFilter(&w);
+  startupTrace::instance().addPhase("Create the main window");
 
   // If another application is opened, we will just add the given file to the playlist.
   if (WIN_LINUX_SINGLE_INSTANCE && (is_Q_OS_WIN || is_Q_OS_LINUX))
     w.connect(instance.data(), &singleInstanceHandler::newAppStarted, &w, &MainWindow::loadFiles);
 
+  bool updateCheck = true;
   if (UPDATE_FEATURE_ENABLE && is_Q_OS_WIN && args.size() == 2 && (args.last() == "updateElevated" || args.last() == "updateElevatedAltSource"))
   {
     // The process should now be elevated and we will force an update
     w.forceUpdateElevated();
     args.removeLast();
+    updateCheck = false;
   }
-  else
-    w.autoUpdateCheck();
-
-  QStringList fileList = args.mid(1);
-  if (!fileList.empty())
-    w.loadFiles(fileList);
 
   w.show();
+  startupTrace::instance().addPhase("Show the main window");
+
+  // Opening the files from the command line and checking for updates is not needed to show the main window.
+  // Do this once the event loop is running.
+  const QStringList fileList = args.mid(1);
+  QTimer::singleShot(0, &w, [&w, fileList, updateCheck]{
+    startupTrace::instance().finish();
+    if (!fileList.empty())
+      w.loadFiles(fileList);
+    if (updateCheck)
+      w.autoUpdateCheck();
+  });
+
   return app.exec();
 }